@@ -11,20 +11,11 @@ static uint32_t get_ticks(void) {
   return (uint32_t)((clock() * 1000) / CLOCKS_PER_SEC);
 }
 
-Controller *controller_create(GameModel *model) {
-  Controller *controller = malloc(sizeof(Controller));
-  if (!controller)
-    return NULL;
-
+void controller_init(Controller *controller, GameModel *model) {
   memset(controller, 0, sizeof(Controller));
   controller->model = model;
   controller->view_context = NULL;
-  controller->input_handler = input_handler_create();
-
-  if (!controller->input_handler) {
-    free(controller);
-    return NULL;
-  }
+  controller->input_handler = NULL;
 
 // Initialize default keybindings
 #ifdef USE_SDL_VIEW
@@ -40,8 +31,20 @@ Controller *controller_create(GameModel *model) {
 
   controller->quit_requested = false;
   controller->paused = false;
-  controller->last_input_time = get_ticks();
+}
+
+Controller *controller_create(GameModel *model) {
+  Controller *controller = malloc(sizeof(Controller));
+  if (!controller)
+    return NULL;
+
+  controller_init(controller, model);
+  controller->input_handler = input_handler_create();
 
+  if (!controller->input_handler) {
+    free(controller);
+    return NULL;
+  }
   return controller;
 }
 
@@ -159,8 +162,6 @@ void controller_execute_command(Controller *controller, Command cmd) {
   if (!controller || !controller->model)
     return;
 
-  controller->last_input_time = get_ticks();
-
   // Menu navigation
   if (controller->model->state == STATE_MENU) {
     switch (cmd) {
@@ -174,14 +175,14 @@ void controller_execute_command(Controller *controller, Command cmd) {
       return;
     case CMD_LEFT:
     case CMD_P2_MOVE_LEFT:
-      if (controller->model->menu_state == MENU_SETTINGS &&
-          controller->model->menu_selection == 1)
+      if (controller->model->ui.menu_state == MENU_SETTINGS &&
+          controller->model->ui.menu_selection == 1)
         model_adjust_music_volume(controller->model, -1);
       return;
     case CMD_RIGHT:
     case CMD_P2_MOVE_RIGHT:
-      if (controller->model->menu_state == MENU_SETTINGS &&
-          controller->model->menu_selection == 1)
+      if (controller->model->ui.menu_state == MENU_SETTINGS &&
+          controller->model->ui.menu_selection == 1)
         model_adjust_music_volume(controller->model, 1);
       return;
     case CMD_CONFIRM:
@@ -191,19 +192,19 @@ void controller_execute_command(Controller *controller, Command cmd) {
       model_process_menu_input(controller->model, 0);
       return;
     case CMD_BACK:
-      if (controller->model->menu_state == MENU_CONTROLS) {
-        controller->model->menu_state = MENU_SETTINGS;
-        controller->model->menu_selection = 0;
+      if (controller->model->ui.menu_state == MENU_CONTROLS) {
+        controller->model->ui.menu_state = MENU_SETTINGS;
+        controller->model->ui.menu_selection = 0;
         controller->model->needs_redraw = true;
-      } else if (controller->model->menu_state == MENU_SETTINGS) {
-        controller->model->menu_state = MENU_MAIN;
-        controller->model->menu_selection = 2;
+      } else if (controller->model->ui.menu_state == MENU_SETTINGS) {
+        controller->model->ui.menu_state = MENU_MAIN;
+        controller->model->ui.menu_selection = 2;
         controller->model->needs_redraw = true;
-      } else if (controller->model->menu_state == MENU_DIFFICULTY) {
-        controller->model->menu_state = MENU_MAIN;
-        controller->model->menu_selection = 0;
+      } else if (controller->model->ui.menu_state == MENU_DIFFICULTY) {
+        controller->model->ui.menu_state = MENU_MAIN;
+        controller->model->ui.menu_selection = 0;
         controller->model->needs_redraw = true;
-      } else if (controller->model->menu_state == MENU_MAIN) {
+      } else if (controller->model->ui.menu_state == MENU_MAIN) {
         controller->quit_requested = true;
       }
       return;
@@ -227,8 +228,8 @@ void controller_execute_command(Controller *controller, Command cmd) {
       controller->model->state == STATE_WIN) {
     if (cmd == CMD_RESET_GAME || cmd == CMD_BACK || cmd == CMD_CONFIRM || cmd == CMD_SHOOT) {
       controller->model->state = STATE_MENU;
-      controller->model->menu_state = MENU_MAIN;
-      controller->model->menu_selection = 0;
+      controller->model->ui.menu_state = MENU_MAIN;
+      controller->model->ui.menu_selection = 0;
       controller->model->needs_redraw = true;
     }
     return;
@@ -295,6 +296,26 @@ void controller_execute_command(Controller *controller, Command cmd) {
     controller->render_callback(controller->callback_data);
 }
 
+void controller_apply_input_mask(Controller *controller, InputMask mask) {
+  static const Command p1_commands[INPUT_BUTTON_COUNT] = {
+      CMD_MOVE_LEFT, CMD_MOVE_RIGHT, CMD_MOVE_UP, CMD_MOVE_DOWN, CMD_SHOOT};
+  static const Command p2_commands[INPUT_BUTTON_COUNT] = {
+      CMD_P2_MOVE_LEFT, CMD_P2_MOVE_RIGHT, CMD_P2_MOVE_UP, CMD_P2_MOVE_DOWN,
+      CMD_P2_SHOOT};
+
+  if (!controller || !mask)
+    return;
+
+  for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    if (mask & (1u << i))
+      controller_execute_command(controller, p1_commands[i]);
+    if (mask & INPUT_P2(1u << i))
+      controller_execute_command(controller, p2_commands[i]);
+  }
+  if (mask & INPUT_PAUSE)
+    controller_execute_command(controller, CMD_PAUSE);
+}
+
 void controller_process_input(Controller *controller) {
   if (!controller || !controller->input_handler)
     return;
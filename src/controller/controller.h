@@ -28,6 +28,20 @@ typedef struct {
   int value;    // Valeur axe/bouton
 } InputEvent;
 
+// Entrées de jeu d'un tick sous forme de masque (5 bits par joueur :
+// J1 sur les bits 0-4, J2 sur les bits 8-12). Toutes les boucles de jeu
+// appliquent un masque par tick, ce qui rend les parties rejouables (voir
+// replay.h).
+#define INPUT_LEFT (1u << 0)
+#define INPUT_RIGHT (1u << 1)
+#define INPUT_UP (1u << 2)
+#define INPUT_DOWN (1u << 3)
+#define INPUT_SHOOT (1u << 4)
+#define INPUT_PAUSE (1u << 5) // Bascule la pause, après les autres entrées
+#define INPUT_P2(bits) ((uint16_t)((bits) << 8))
+#define INPUT_BUTTON_COUNT 5
+typedef uint16_t InputMask;
+
 // Callback pour les événements de rendu
 typedef void (*RenderCallback)(void *data);
 typedef void (*AudioCallback)(void *data);
@@ -62,12 +76,15 @@ typedef struct {
   // État
   bool quit_requested;
   bool paused;
-  uint32_t last_input_time;
 } Controller;
 
 // Initialisation et gestion
 Controller *controller_create(GameModel *model);
 void controller_destroy(Controller *controller);
+// Initialise un contrôleur déjà alloué, sans gestionnaire d'entrées : il
+// n'est alors piloté que par controller_apply_input_mask et
+// controller_execute_command (serveur). Rien à libérer.
+void controller_init(Controller *controller, GameModel *model);
 void controller_set_view_context(Controller *controller, void *view_context);
 
 // Gestion des entrées
@@ -78,6 +95,7 @@ Command controller_translate_input(Controller *controller, InputEvent *event);
 
 // Exécution des commandes
 void controller_execute_command(Controller *controller, Command cmd);
+void controller_apply_input_mask(Controller *controller, InputMask mask);
 void controller_update(Controller *controller, float delta_time);
 
 // Configuration
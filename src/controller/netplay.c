@@ -0,0 +1,622 @@
+#include "netplay.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+#define NO_ROLLBACK UINT32_MAX
+#define PLAYER_BITS ((1u << INPUT_BUTTON_COUNT) - 1)
+#define HELLO_RETRY_NS 100000000ull // Guest: HELLO again until answered
+#define RESEND_NS 10000000ull       // Inputs again while idle
+#define FINISH_LINGER_NS 100000000ull
+
+typedef enum { PACKET_HELLO = 1, PACKET_START, PACKET_INPUT } PacketType;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// --- Wire format: little-endian fields after a magic and a type byte ---
+
+static void put_u8(uint8_t **p, uint8_t v) { *(*p)++ = v; }
+
+static void put_u16(uint8_t **p, uint16_t v) {
+  put_u8(p, (uint8_t)v);
+  put_u8(p, (uint8_t)(v >> 8));
+}
+
+static void put_u32(uint8_t **p, uint32_t v) {
+  put_u16(p, (uint16_t)v);
+  put_u16(p, (uint16_t)(v >> 16));
+}
+
+static void put_u64(uint8_t **p, uint64_t v) {
+  put_u32(p, (uint32_t)v);
+  put_u32(p, (uint32_t)(v >> 32));
+}
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool ok;
+} PacketReader;
+
+static uint8_t get_u8(PacketReader *r) {
+  if (r->p >= r->end) {
+    r->ok = false;
+    return 0;
+  }
+  return *r->p++;
+}
+
+static uint16_t get_u16(PacketReader *r) {
+  uint16_t lo = get_u8(r);
+  return (uint16_t)(lo | get_u8(r) << 8);
+}
+
+static uint32_t get_u32(PacketReader *r) {
+  uint32_t lo = get_u16(r);
+  return lo | (uint32_t)get_u16(r) << 16;
+}
+
+static uint64_t get_u64(PacketReader *r) {
+  uint64_t lo = get_u32(r);
+  return lo | (uint64_t)get_u32(r) << 32;
+}
+
+static uint8_t *begin_packet(uint8_t *buf, PacketType type) {
+  uint8_t *p = buf;
+  put_u32(&p, NETPLAY_MAGIC);
+  put_u8(&p, (uint8_t)type);
+  return p;
+}
+
+// --- Sending, through the simulated latency and loss ---
+
+static void send_now(NetplaySession *net, const uint8_t *data, size_t size) {
+  sendto(net->socket, data, size, 0, (const struct sockaddr *)&net->peer,
+         sizeof(net->peer));
+}
+
+static void send_packet(NetplaySession *net, const uint8_t *data,
+                        size_t size) {
+  if (!net->has_peer)
+    return;
+  net->last_send_ns = now_ns();
+  net->stats.packets_sent++;
+  if (net->config.loss_percent > 0 &&
+      rng_range(&net->loss_rng, 100) < net->config.loss_percent) {
+    net->stats.packets_dropped++;
+    return;
+  }
+  if (net->config.latency_ms <= 0) {
+    send_now(net, data, size);
+    return;
+  }
+  if (net->delayed_count == NETPLAY_DELAY_QUEUE) {
+    net->stats.packets_dropped++; // A saturated link loses packets too
+    return;
+  }
+  NetplayDelayedPacket *d =
+      &net->delayed[(net->delayed_head + net->delayed_count) %
+                    NETPLAY_DELAY_QUEUE];
+  d->due_ns = net->last_send_ns + (uint64_t)net->config.latency_ms * 1000000u;
+  d->size = (uint16_t)size;
+  memcpy(d->data, data, size);
+  net->delayed_count++;
+}
+
+static void flush_delayed(NetplaySession *net) {
+  uint64_t now = now_ns();
+  while (net->delayed_count > 0) {
+    NetplayDelayedPacket *d = &net->delayed[net->delayed_head];
+    if (d->due_ns > now)
+      break;
+    send_now(net, d->data, d->size);
+    net->delayed_head = (net->delayed_head + 1) % NETPLAY_DELAY_QUEUE;
+    net->delayed_count--;
+  }
+}
+
+static void send_hello(NetplaySession *net) {
+  uint8_t buf[NETPLAY_PACKET_MAX];
+  uint8_t *p = begin_packet(buf, PACKET_HELLO);
+  put_u16(&p, NETPLAY_VERSION);
+  send_packet(net, buf, (size_t)(p - buf));
+}
+
+// Every local input the peer has not acknowledged, plus our latest
+// confirmed state hash
+static void send_inputs(NetplaySession *net) {
+  uint8_t buf[NETPLAY_PACKET_MAX];
+  uint8_t *p = begin_packet(buf, PACKET_INPUT);
+  uint32_t count = net->local_count - net->remote_ack;
+  put_u32(&p, net->remote_count);
+  put_u32(&p, net->remote_ack);
+  put_u8(&p, (uint8_t)count);
+  for (uint32_t k = 0; k < count; k++)
+    put_u8(&p, net->local_inputs[(net->remote_ack + k) &
+                                 (NETPLAY_INPUT_WINDOW - 1)]);
+  int slot = (net->latest_check_tick / NETPLAY_HASH_INTERVAL) %
+             NETPLAY_CHECK_HISTORY;
+  put_u32(&p, net->latest_check_tick);
+  put_u64(&p, net->latest_check_tick ? net->check_hashes[slot] : 0);
+  send_packet(net, buf, (size_t)(p - buf));
+}
+
+// --- Session setup ---
+
+static bool session_open(NetplaySession *net, const NetplayConfig *config,
+                         bool is_host) {
+  memset(net, 0, sizeof(*net));
+  net->socket = -1;
+  net->config = *config;
+  if (net->config.input_delay < 0)
+    net->config.input_delay = 0;
+  if (net->config.input_delay > NETPLAY_MAX_ROLLBACK)
+    net->config.input_delay = NETPLAY_MAX_ROLLBACK;
+  net->is_host = is_host;
+  net->local_player = is_host ? 0 : 1;
+  net->state = NETPLAY_WAITING;
+  net->rollback_from = NO_ROLLBACK;
+  net->next_check_tick = NETPLAY_HASH_INTERVAL;
+  rng_seed(&net->loss_rng, now_ns(), is_host ? 1 : 2);
+
+  net->snapshots = malloc((size_t)NETPLAY_SNAPSHOT_SLOTS *
+                          MODEL_SNAPSHOT_MAX_SIZE);
+  net->delayed = malloc(NETPLAY_DELAY_QUEUE * sizeof(NetplayDelayedPacket));
+  if (!net->snapshots || !net->delayed) {
+    fprintf(stderr, "Failed to allocate netplay buffers\n");
+    netplay_close(net);
+    return false;
+  }
+  // Touch every page now rather than inside the first rollbacks
+  memset(net->snapshots, 0,
+         (size_t)NETPLAY_SNAPSHOT_SLOTS * MODEL_SNAPSHOT_MAX_SIZE);
+
+  net->socket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (net->socket < 0 ||
+      fcntl(net->socket, F_SETFL, fcntl(net->socket, F_GETFL) | O_NONBLOCK) <
+          0) {
+    perror("netplay socket");
+    netplay_close(net);
+    return false;
+  }
+  return true;
+}
+
+bool netplay_listen(NetplaySession *net, int port,
+                    const NetplayConfig *config) {
+  if (!session_open(net, config, true))
+    return false;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons((uint16_t)port);
+  if (bind(net->socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    fprintf(stderr, "Cannot listen on port %d\n", port);
+    netplay_close(net);
+    return false;
+  }
+  return true;
+}
+
+bool netplay_connect(NetplaySession *net, const char *host, int port,
+                     const NetplayConfig *config) {
+  if (!session_open(net, config, false))
+    return false;
+  struct addrinfo hints, *res = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (getaddrinfo(host, NULL, &hints, &res) != 0 || !res) {
+    fprintf(stderr, "Unknown host %s\n", host);
+    netplay_close(net);
+    return false;
+  }
+  memcpy(&net->peer, res->ai_addr, sizeof(net->peer));
+  net->peer.sin_port = htons((uint16_t)port);
+  net->has_peer = true;
+  freeaddrinfo(res);
+  send_hello(net);
+  return true;
+}
+
+int netplay_local_port(const NetplaySession *net) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(net->socket, (struct sockaddr *)&addr, &len) < 0)
+    return -1;
+  return ntohs(addr.sin_port);
+}
+
+// Both sides start from tick 0 of the same game; the first input_delay
+// local inputs are empty
+static void session_start(NetplaySession *net) {
+  net->state = NETPLAY_RUNNING;
+  net->tick = 0;
+  net->local_count = (uint32_t)net->config.input_delay;
+  memset(net->local_inputs, 0, sizeof(net->local_inputs));
+  net->last_receive_ns = now_ns();
+}
+
+// --- Simulation ---
+
+static uint8_t *snapshot_slot(NetplaySession *net, uint32_t tick) {
+  return net->snapshots + (size_t)(tick & (NETPLAY_SNAPSHOT_SLOTS - 1)) *
+                              MODEL_SNAPSHOT_MAX_SIZE;
+}
+
+static void save_snapshot(NetplaySession *net, const GameModel *model) {
+  int slot = net->tick & (NETPLAY_SNAPSHOT_SLOTS - 1);
+  net->snapshot_sizes[slot] =
+      model_snapshot(model, snapshot_slot(net, net->tick));
+  if (net->tick % NETPLAY_HASH_INTERVAL == 0)
+    net->snapshot_hashes[slot] = model_state_hash(model);
+}
+
+// The remote player is predicted to keep its last known input
+static uint8_t remote_input(const NetplaySession *net, uint32_t tick) {
+  if (tick < net->remote_count)
+    return net->remote_inputs[tick & (NETPLAY_INPUT_WINDOW - 1)];
+  if (net->remote_count == 0)
+    return 0;
+  return net->remote_inputs[(net->remote_count - 1) &
+                            (NETPLAY_INPUT_WINDOW - 1)];
+}
+
+static void simulate_tick(NetplaySession *net, GameModel *model,
+                          Controller *controller) {
+  uint32_t t = net->tick;
+  uint8_t remote = remote_input(net, t);
+  uint8_t local = net->local_inputs[t & (NETPLAY_INPUT_WINDOW - 1)];
+  net->used_remote[t & (NETPLAY_INPUT_WINDOW - 1)] = remote;
+
+  InputMask mask = net->local_player == 0 ? (InputMask)(local | INPUT_P2(remote))
+                                          : (InputMask)(remote | INPUT_P2(local));
+  float dt = 1.0f / model->config.tick_rate;
+  // Once the game is over inputs would lead back to the menu; a rollback
+  // can re-simulate past the end, so both sides ignore them there
+  if (model->state != STATE_GAME_OVER && model->state != STATE_WIN)
+    controller_apply_input_mask(controller, mask);
+  controller_update(controller, dt);
+  model_update(model, dt);
+  net->tick++;
+}
+
+// Rewinds to the first mispredicted tick and re-simulates up to the current
+// one with the inputs now known. Events of those ticks were delivered when
+// they were first simulated, so they stay muted.
+static void rollback(NetplaySession *net, GameModel *model,
+                     Controller *controller) {
+  uint32_t from = net->rollback_from;
+  net->rollback_from = NO_ROLLBACK;
+  if (from >= net->tick)
+    return;
+
+  uint64_t start = now_ns();
+  int slot = from & (NETPLAY_SNAPSHOT_SLOTS - 1);
+  if (!model_restore(model, snapshot_slot(net, from),
+                     net->snapshot_sizes[slot])) {
+    net->state = NETPLAY_DISCONNECTED;
+    return;
+  }
+  uint32_t end = net->tick;
+  net->tick = from;
+  model->events.muted = true;
+  simulate_tick(net, model, controller);
+  while (net->tick < end) {
+    save_snapshot(net, model);
+    simulate_tick(net, model, controller);
+  }
+  model->events.muted = false;
+
+  uint64_t elapsed = now_ns() - start;
+  int depth = (int)(end - from);
+  net->stats.rollbacks++;
+  net->stats.resimulated_ticks += (uint64_t)depth;
+  net->stats.rollback_ns += elapsed;
+  if (depth > net->stats.max_rollback)
+    net->stats.max_rollback = depth;
+  if (elapsed > net->stats.max_rollback_ns)
+    net->stats.max_rollback_ns = elapsed;
+}
+
+// --- Desync detection ---
+
+static void compare_check(NetplaySession *net, uint32_t tick, uint64_t hash) {
+  net->compared_check_tick = tick;
+  net->stats.hashes_checked++;
+  int slot = (tick / NETPLAY_HASH_INTERVAL) % NETPLAY_CHECK_HISTORY;
+  if (net->check_hashes[slot] != hash && !net->stats.desynced) {
+    net->stats.desynced = true;
+    net->stats.desync_tick = tick;
+    fprintf(stderr, "Netplay desync at tick %u\n", tick);
+  }
+}
+
+static bool have_check(const NetplaySession *net, uint32_t tick) {
+  int slot = (tick / NETPLAY_HASH_INTERVAL) % NETPLAY_CHECK_HISTORY;
+  return net->check_ticks[slot] == tick;
+}
+
+static void receive_check(NetplaySession *net, uint32_t tick, uint64_t hash) {
+  if (tick == 0 || tick <= net->compared_check_tick)
+    return;
+  if (have_check(net, tick)) {
+    compare_check(net, tick, hash);
+  } else {
+    net->pending_check_tick = tick;
+    net->pending_check_hash = hash;
+  }
+}
+
+// A tick's state is final once every remote input before it is known (any
+// rollback is done by then); its hash is then kept for the peer to compare
+static void update_checks(NetplaySession *net) {
+  while (net->next_check_tick < net->tick &&
+         net->next_check_tick <= net->remote_count) {
+    uint32_t tick = net->next_check_tick;
+    int slot = (tick / NETPLAY_HASH_INTERVAL) % NETPLAY_CHECK_HISTORY;
+    net->check_ticks[slot] = tick;
+    net->check_hashes[slot] =
+        net->snapshot_hashes[tick & (NETPLAY_SNAPSHOT_SLOTS - 1)];
+    net->latest_check_tick = tick;
+    net->next_check_tick += NETPLAY_HASH_INTERVAL;
+    if (net->pending_check_tick == tick) {
+      compare_check(net, tick, net->pending_check_hash);
+      net->pending_check_tick = 0;
+    }
+  }
+}
+
+// --- Receiving ---
+
+static void handle_hello(NetplaySession *net, PacketReader *r,
+                         GameModel *model) {
+  if (!net->is_host || get_u16(r) != NETPLAY_VERSION || !r->ok)
+    return;
+  if (net->state == NETPLAY_WAITING) {
+    // The host's settings make the game; the guest takes them from START
+    model->two_player_mode = true;
+    model_reset_game(model);
+    uint8_t *p = begin_packet(net->start_packet, PACKET_START);
+    put_u16(&p, NETPLAY_VERSION);
+    put_u64(&p, model->seed);
+    put_u8(&p, (uint8_t)model->difficulty);
+    put_u16(&p, (uint16_t)model->config.tick_rate);
+    put_u16(&p, (uint16_t)model->config.player_bullet_capacity);
+    put_u16(&p, (uint16_t)model->config.enemy_bullet_capacity);
+    net->start_size = (size_t)(p - net->start_packet);
+    session_start(net);
+  }
+  // Sent again for every HELLO in case the previous one was lost
+  send_packet(net, net->start_packet, net->start_size);
+}
+
+static void handle_start(NetplaySession *net, PacketReader *r,
+                         GameModel *model) {
+  if (net->is_host || net->state != NETPLAY_WAITING)
+    return;
+  uint16_t version = get_u16(r);
+  uint64_t seed = get_u64(r);
+  uint8_t difficulty = get_u8(r);
+  uint16_t tick_rate = get_u16(r);
+  uint16_t player_capacity = get_u16(r);
+  uint16_t enemy_capacity = get_u16(r);
+  if (!r->ok || version != NETPLAY_VERSION)
+    return;
+
+  model->config.tick_rate = tick_rate;
+  model->config.player_bullet_capacity = player_capacity;
+  model->config.enemy_bullet_capacity = enemy_capacity;
+  model->difficulty = (Difficulty)difficulty;
+  model->two_player_mode = true;
+  model_start_game(model, seed);
+  session_start(net);
+}
+
+static void handle_input(NetplaySession *net, PacketReader *r) {
+  if (net->state != NETPLAY_RUNNING)
+    return;
+  uint32_t ack = get_u32(r);
+  uint32_t start = get_u32(r);
+  uint8_t count = get_u8(r);
+  uint8_t inputs[256];
+  for (int k = 0; k < count; k++)
+    inputs[k] = get_u8(r);
+  uint32_t check_tick = get_u32(r);
+  uint64_t check_hash = get_u64(r);
+  if (!r->ok)
+    return;
+
+  if (ack > net->remote_ack && ack <= net->local_count)
+    net->remote_ack = ack;
+  for (uint32_t k = 0; k < count; k++) {
+    uint32_t tick = start + k;
+    if (tick < net->remote_count)
+      continue; // Already known
+    if (tick > net->remote_count ||
+        tick >= net->tick + NETPLAY_INPUT_WINDOW - NETPLAY_MAX_ROLLBACK)
+      break;
+    uint8_t input = inputs[k] & PLAYER_BITS;
+    net->remote_inputs[tick & (NETPLAY_INPUT_WINDOW - 1)] = input;
+    if (tick < net->tick &&
+        net->used_remote[tick & (NETPLAY_INPUT_WINDOW - 1)] != input &&
+        tick < net->rollback_from)
+      net->rollback_from = tick;
+    net->remote_count++;
+  }
+  receive_check(net, check_tick, check_hash);
+}
+
+static void handle_packet(NetplaySession *net, GameModel *model,
+                          const uint8_t *data, size_t size,
+                          const struct sockaddr_in *from) {
+  PacketReader r = {data, data + size, true};
+  if (get_u32(&r) != NETPLAY_MAGIC || !r.ok)
+    return;
+  PacketType type = (PacketType)get_u8(&r);
+
+  if (!net->has_peer) {
+    if (!net->is_host || type != PACKET_HELLO)
+      return;
+    net->peer = *from; // First guest to say hello
+    net->has_peer = true;
+  } else if (from->sin_addr.s_addr != net->peer.sin_addr.s_addr ||
+             from->sin_port != net->peer.sin_port) {
+    return; // Someone else
+  }
+  net->stats.packets_received++;
+  net->last_receive_ns = now_ns();
+
+  switch (type) {
+  case PACKET_HELLO:
+    handle_hello(net, &r, model);
+    break;
+  case PACKET_START:
+    handle_start(net, &r, model);
+    break;
+  case PACKET_INPUT:
+    handle_input(net, &r);
+    break;
+  default:
+    break;
+  }
+}
+
+void netplay_poll(NetplaySession *net, GameModel *model,
+                  Controller *controller) {
+  if (net->socket < 0)
+    return;
+  flush_delayed(net);
+
+  uint8_t buf[NETPLAY_PACKET_MAX];
+  struct sockaddr_in from;
+  for (;;) {
+    socklen_t len = sizeof(from);
+    ssize_t n = recvfrom(net->socket, buf, sizeof(buf), 0,
+                         (struct sockaddr *)&from, &len);
+    if (n < 0)
+      break;
+    handle_packet(net, model, buf, (size_t)n, &from);
+  }
+  rollback(net, model, controller);
+  update_checks(net);
+
+  uint64_t now = now_ns();
+  if (net->state == NETPLAY_WAITING && !net->is_host &&
+      now - net->last_send_ns >= HELLO_RETRY_NS)
+    send_hello(net);
+  // Idle or stalled sides keep sending: lost inputs and acks get through
+  // and the peer knows we are still here
+  if (net->state == NETPLAY_RUNNING && now - net->last_send_ns >= RESEND_NS)
+    send_inputs(net);
+  if (net->state == NETPLAY_RUNNING &&
+      now - net->last_receive_ns > NETPLAY_TIMEOUT_MS * 1000000ull) {
+    fprintf(stderr, "Netplay: the other player stopped answering\n");
+    net->state = NETPLAY_DISCONNECTED;
+  }
+}
+
+void netplay_wait(NetplaySession *net, int ms) {
+  if (net->socket < 0)
+    return;
+  // Wake up in time for the next delayed packet as well
+  if (net->delayed_count > 0) {
+    uint64_t due = net->delayed[net->delayed_head].due_ns;
+    uint64_t now = now_ns();
+    int until_due = due > now ? (int)((due - now + 999999u) / 1000000u) : 0;
+    if (until_due < ms)
+      ms = until_due;
+  }
+  struct pollfd pfd = {net->socket, POLLIN, 0};
+  poll(&pfd, 1, ms);
+}
+
+bool netplay_wait_connected(NetplaySession *net, GameModel *model,
+                            Controller *controller, int timeout_ms) {
+  uint64_t deadline = now_ns() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) *
+                                     1000000u;
+  while (net->state == NETPLAY_WAITING) {
+    if (timeout_ms >= 0 && now_ns() >= deadline) {
+      fprintf(stderr, "Netplay: no answer from the other player\n");
+      return false;
+    }
+    netplay_wait(net, 10);
+    netplay_poll(net, model, controller);
+  }
+  return net->state == NETPLAY_RUNNING;
+}
+
+bool netplay_advance(NetplaySession *net, GameModel *model,
+                     Controller *controller, InputMask local) {
+  netplay_poll(net, model, controller);
+  if (net->state != NETPLAY_RUNNING)
+    return false;
+  if (net->tick >= net->remote_count + NETPLAY_MAX_ROLLBACK ||
+      net->local_count - net->remote_ack >=
+          NETPLAY_INPUT_WINDOW - NETPLAY_MAX_ROLLBACK) {
+    if (!net->stalled)
+      net->stats.stalls++;
+    net->stalled = true;
+    return false;
+  }
+
+  net->stalled = false;
+  net->local_inputs[net->local_count++ & (NETPLAY_INPUT_WINDOW - 1)] =
+      (uint8_t)(local & PLAYER_BITS);
+  save_snapshot(net, model);
+  simulate_tick(net, model, controller);
+  update_checks(net);
+  send_inputs(net);
+  return true;
+}
+
+bool netplay_confirmed(const NetplaySession *net) {
+  return net->remote_count >= net->tick && net->rollback_from == NO_ROLLBACK;
+}
+
+void netplay_finish(NetplaySession *net, GameModel *model,
+                    Controller *controller, int timeout_ms) {
+  uint64_t deadline = now_ns() + (uint64_t)timeout_ms * 1000000u;
+  uint64_t done_at = 0;
+  while (net->state == NETPLAY_RUNNING && now_ns() < deadline) {
+    netplay_poll(net, model, controller);
+    bool done = netplay_confirmed(net) && net->remote_ack >= net->local_count;
+    if (done && !done_at)
+      done_at = now_ns();
+    // Keep answering a little longer so the peer gets our final ack too
+    if (done_at && now_ns() - done_at >= FINISH_LINGER_NS +
+                                             (uint64_t)net->config.latency_ms *
+                                                 2000000u)
+      break;
+    netplay_wait(net, 1);
+  }
+  netplay_close(net);
+}
+
+void netplay_close(NetplaySession *net) {
+  if (net->socket >= 0)
+    close(net->socket);
+  net->socket = -1;
+  free(net->snapshots);
+  net->snapshots = NULL;
+  free(net->delayed);
+  net->delayed = NULL;
+  net->delayed_count = 0;
+  if (net->state == NETPLAY_RUNNING)
+    net->state = NETPLAY_DISCONNECTED;
+}
@@ -0,0 +1,150 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "controller.h"
+#include "model.h"
+#include "rng.h"
+
+// Partie à deux joueurs en réseau (UDP) avec rollback, à la manière de
+// GGPO. Chaque côté simule sans attendre en prédisant l'entrée distante (la
+// dernière reçue). Quand l'entrée réelle arrive et ne correspond pas à la
+// prédiction, le modèle est restauré depuis l'instantané du tick concerné
+// (voir snapshot.h) puis resimulé jusqu'au tick courant, événements coupés.
+// L'hôte joue J1 et choisit la graine et la difficulté ; l'invité joue J2.
+//
+// Chaque paquet d'entrées reprend toutes les entrées locales que le pair
+// n'a pas encore acquittées : une perte est réparée par le paquet suivant.
+#define NETPLAY_MAGIC 0x504e4953u // "SINP"
+#define NETPLAY_VERSION 1
+#define NETPLAY_DEFAULT_PORT 7777
+#define NETPLAY_MAX_ROLLBACK 8    // Ticks prédits au plus avant d'attendre
+#define NETPLAY_INPUT_WINDOW 64   // Entrées gardées par côté (puissance de 2)
+#define NETPLAY_SNAPSHOT_SLOTS 16 // Puissance de 2, > NETPLAY_MAX_ROLLBACK
+#define NETPLAY_HASH_INTERVAL 60  // Ticks entre deux vérifications d'état
+#define NETPLAY_CHECK_HISTORY 4
+#define NETPLAY_TIMEOUT_MS 5000   // Silence du pair avant déconnexion
+#define NETPLAY_PACKET_MAX 128
+#define NETPLAY_DELAY_QUEUE 256   // Paquets retenus par la latence simulée
+
+typedef struct {
+  int input_delay;  // Ticks entre la saisie locale et son application
+  int latency_ms;   // Latence ajoutée à chaque envoi (tests)
+  int loss_percent; // Part des envois jetés volontairement (tests)
+} NetplayConfig;
+
+typedef enum {
+  NETPLAY_WAITING, // Poignée de main en cours
+  NETPLAY_RUNNING,
+  NETPLAY_DISCONNECTED
+} NetplayState;
+
+typedef struct {
+  uint32_t rollbacks;
+  uint64_t resimulated_ticks;
+  int max_rollback;         // Plus long rollback, en ticks
+  uint64_t rollback_ns;     // Restauration + resimulation, cumulé
+  uint64_t max_rollback_ns; // Plus long rollback (restauration + resimulation)
+  uint32_t stalls;          // Attentes d'entrées distantes
+  uint32_t packets_sent;
+  uint32_t packets_dropped; // Par la perte simulée
+  uint32_t packets_received;
+  uint32_t hashes_checked;
+  bool desynced;
+  uint32_t desync_tick; // Premier tick vérifié en désaccord
+} NetplayStats;
+
+typedef struct {
+  uint64_t due_ns;
+  uint16_t size;
+  uint8_t data[NETPLAY_PACKET_MAX];
+} NetplayDelayedPacket;
+
+typedef struct {
+  int socket;
+  bool is_host;
+  int local_player; // 0 pour l'hôte, 1 pour l'invité
+  struct sockaddr_in peer;
+  bool has_peer;
+  NetplayState state;
+  NetplayConfig config;
+
+  // Ticks : `tick` est le prochain à simuler. Les entrées sont des masques
+  // d'un joueur (bits 0-4, voir controller.h).
+  uint32_t tick;
+  uint32_t local_count;  // Entrées locales connues, ticks [0, local_count)
+  uint32_t remote_count; // Entrées distantes reçues sans trou
+  uint32_t remote_ack;   // Entrées locales reçues par le pair
+  uint8_t local_inputs[NETPLAY_INPUT_WINDOW];
+  uint8_t remote_inputs[NETPLAY_INPUT_WINDOW];
+  uint8_t used_remote[NETPLAY_INPUT_WINDOW]; // Entrée distante simulée
+  uint32_t rollback_from; // Premier tick mal prédit, UINT32_MAX sinon
+  bool stalled;
+
+  // Instantané du modèle au début de chaque tick récent
+  uint8_t *snapshots; // NETPLAY_SNAPSHOT_SLOTS * MODEL_SNAPSHOT_MAX_SIZE
+  size_t snapshot_sizes[NETPLAY_SNAPSHOT_SLOTS];
+  uint64_t snapshot_hashes[NETPLAY_SNAPSHOT_SLOTS]; // Ticks vérifiés seulement
+
+  // Vérification de synchronisation : hachages des derniers ticks confirmés
+  // (multiples de NETPLAY_HASH_INTERVAL), comparés à ceux du pair
+  uint32_t next_check_tick;
+  uint32_t latest_check_tick; // 0 : aucun
+  uint32_t check_ticks[NETPLAY_CHECK_HISTORY];
+  uint64_t check_hashes[NETPLAY_CHECK_HISTORY];
+  uint32_t compared_check_tick;
+  uint32_t pending_check_tick; // Reçu du pair avant le nôtre
+  uint64_t pending_check_hash;
+
+  // Poignée de main : paquet START de l'hôte, renvoyé à chaque HELLO
+  uint8_t start_packet[NETPLAY_PACKET_MAX];
+  size_t start_size;
+
+  uint64_t last_send_ns;
+  uint64_t last_receive_ns;
+  Rng loss_rng;
+  NetplayDelayedPacket *delayed; // File de la latence simulée
+  int delayed_head;
+  int delayed_count;
+
+  NetplayStats stats;
+} NetplaySession;
+
+// Hôte : écoute sur `port` (0 : port libre, voir netplay_local_port) et
+// démarre la partie quand un invité se présente.
+bool netplay_listen(NetplaySession *net, int port, const NetplayConfig *config);
+// Invité : contacte l'hôte, qui fournit la configuration de la partie.
+bool netplay_connect(NetplaySession *net, const char *host, int port,
+                     const NetplayConfig *config);
+int netplay_local_port(const NetplaySession *net);
+
+// Traite les paquets reçus : poignée de main (qui démarre la partie dans
+// `model`), entrées distantes et rollback éventuel. À appeler souvent.
+void netplay_poll(NetplaySession *net, GameModel *model,
+                  Controller *controller);
+// Attend la fin de la poignée de main ; timeout_ms < 0 : sans limite.
+bool netplay_wait_connected(NetplaySession *net, GameModel *model,
+                            Controller *controller, int timeout_ms);
+// Attend au plus `ms` millisecondes l'arrivée d'un paquet.
+void netplay_wait(NetplaySession *net, int ms);
+
+// Simule un tick avec `local` (masque J1, quel que soit le joueur local).
+// Renvoie false sans rien simuler quand la prédiction irait au-delà de
+// NETPLAY_MAX_ROLLBACK ticks ou si le pair est parti.
+bool netplay_advance(NetplaySession *net, GameModel *model,
+                     Controller *controller, InputMask local);
+// Vrai quand toutes les entrées distantes simulées sont confirmées : l'état
+// courant du modèle est alors définitif (une fin de partie aussi).
+bool netplay_confirmed(const NetplaySession *net);
+
+// Termine proprement : attend (au plus timeout_ms) que les deux côtés aient
+// toutes les entrées de l'autre, puis ferme la session.
+void netplay_finish(NetplaySession *net, GameModel *model,
+                    Controller *controller, int timeout_ms);
+void netplay_close(NetplaySession *net);
+
+#endif // NETPLAY_H
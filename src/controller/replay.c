@@ -0,0 +1,251 @@
+#include "replay.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+// Longest varint: 64 bits, 7 per byte
+#define VARINT_MAX_BYTES 10
+
+static int varint_encode(uint8_t *out, uint64_t v) {
+  int n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+static void write_varint(FILE *f, uint64_t v) {
+  uint8_t buf[VARINT_MAX_BYTES];
+  fwrite(buf, 1, (size_t)varint_encode(buf, v), f);
+}
+
+static bool read_varint(FILE *f, uint64_t *v) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 7 * VARINT_MAX_BYTES; shift += 7) {
+    int c = getc(f);
+    if (c == EOF)
+      return false;
+    result |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool game_in_progress(GameState state) {
+  return state == STATE_PLAYING || state == STATE_PAUSED ||
+         state == STATE_LEVEL_TRANSITION;
+}
+
+// --- Recording ---
+
+static void recorder_flush_run(ReplayRecorder *rec) {
+  if (rec->run == 0)
+    return;
+  write_varint(rec->file, (uint64_t)rec->run << 1);
+  write_varint(rec->file, rec->mask);
+  rec->run = 0;
+}
+
+// Extension records sit between two runs, at the tick they describe
+static void recorder_write_record(ReplayRecorder *rec, ReplayRecordType type,
+                                  const uint8_t *payload, int len) {
+  recorder_flush_run(rec);
+  write_varint(rec->file, ((uint64_t)type << 1) | 1u);
+  write_varint(rec->file, (uint64_t)len);
+  fwrite(payload, 1, (size_t)len, rec->file);
+}
+
+static void recorder_write_game_start(ReplayRecorder *rec,
+                                      const GameModel *model) {
+  uint8_t payload[3 * VARINT_MAX_BYTES];
+  int len = varint_encode(payload, model->seed);
+  len += varint_encode(payload + len, (uint64_t)model->difficulty);
+  len += varint_encode(payload + len, model->two_player_mode ? 1u : 0u);
+  recorder_write_record(rec, REPLAY_RECORD_GAME_START, payload, len);
+  // Earlier games survive a crash of this one
+  fflush(rec->file);
+}
+
+static void recorder_write_state_hash(ReplayRecorder *rec,
+                                      const GameModel *model) {
+  uint8_t payload[2 * VARINT_MAX_BYTES];
+  int len = varint_encode(payload, rec->ticks);
+  len += varint_encode(payload + len, model_state_hash(model));
+  recorder_write_record(rec, REPLAY_RECORD_STATE_HASH, payload, len);
+}
+
+bool replay_recorder_open(ReplayRecorder *rec, const char *path,
+                          const GameModel *model) {
+  memset(rec, 0, sizeof(*rec));
+  rec->file = fopen(path, "wb");
+  if (!rec->file) {
+    fprintf(stderr, "Cannot create replay %s\n", path);
+    return false;
+  }
+  uint32_t magic = REPLAY_MAGIC;
+  uint16_t fields[4] = {REPLAY_VERSION, (uint16_t)model->config.tick_rate,
+                        (uint16_t)model->config.player_bullet_capacity,
+                        (uint16_t)model->config.enemy_bullet_capacity};
+  fwrite(&magic, sizeof(magic), 1, rec->file);
+  fwrite(fields, sizeof(fields), 1, rec->file);
+  return true;
+}
+
+void replay_recorder_tick(ReplayRecorder *rec, const GameModel *model,
+                          InputMask mask) {
+  if (!rec->file)
+    return;
+  if (!game_in_progress(model->state)) {
+    replay_recorder_end_game(rec, model);
+    return;
+  }
+  if (!rec->in_game || model->seed != rec->game_seed) {
+    if (model->state != STATE_PLAYING)
+      return; // Joined mid-game: nothing to replay from
+    recorder_write_game_start(rec, model);
+    rec->in_game = true;
+    rec->game_seed = model->seed;
+  }
+  if (rec->ticks % REPLAY_HASH_INTERVAL == 0)
+    recorder_write_state_hash(rec, model);
+
+  if (mask != rec->mask || rec->run == UINT32_MAX) {
+    recorder_flush_run(rec);
+    rec->mask = mask;
+  }
+  rec->run++;
+  rec->ticks++;
+}
+
+void replay_recorder_end_game(ReplayRecorder *rec, const GameModel *model) {
+  if (!rec->file || !rec->in_game)
+    return;
+  // Final state of the game that just ended
+  recorder_write_state_hash(rec, model);
+  rec->in_game = false;
+}
+
+bool replay_recorder_close(ReplayRecorder *rec) {
+  if (!rec->file)
+    return false;
+  recorder_flush_run(rec);
+  bool ok = !ferror(rec->file);
+  if (fclose(rec->file) != 0)
+    ok = false;
+  rec->file = NULL;
+  if (!ok)
+    fprintf(stderr, "Failed to write replay\n");
+  return ok;
+}
+
+// --- Playback ---
+
+bool replay_player_open(ReplayPlayer *player, const char *path) {
+  memset(player, 0, sizeof(*player));
+  player->file = fopen(path, "rb");
+  if (!player->file) {
+    fprintf(stderr, "Cannot open replay %s\n", path);
+    return false;
+  }
+  uint32_t magic = 0;
+  uint16_t fields[4] = {0};
+  if (fread(&magic, sizeof(magic), 1, player->file) != 1 ||
+      fread(fields, sizeof(fields), 1, player->file) != 1 ||
+      magic != REPLAY_MAGIC || fields[0] != REPLAY_VERSION) {
+    fprintf(stderr, "%s: not a version %d replay\n", path, REPLAY_VERSION);
+    fclose(player->file);
+    player->file = NULL;
+    return false;
+  }
+  player->header.tick_rate = fields[1];
+  player->header.player_bullet_capacity = fields[2];
+  player->header.enemy_bullet_capacity = fields[3];
+  return true;
+}
+
+void replay_player_configure(const ReplayPlayer *player, GameModel *model) {
+  model->config.tick_rate = player->header.tick_rate;
+  model->config.player_bullet_capacity = player->header.player_bullet_capacity;
+  model->config.enemy_bullet_capacity = player->header.enemy_bullet_capacity;
+  model->config.persist_high_score = false;
+}
+
+static bool player_start_game(ReplayPlayer *player, GameModel *model,
+                              uint64_t len) {
+  long end = ftell(player->file) + (long)len;
+  uint64_t seed, difficulty, flags;
+  if (!read_varint(player->file, &seed) ||
+      !read_varint(player->file, &difficulty) ||
+      !read_varint(player->file, &flags) || ftell(player->file) > end)
+    return false;
+  fseek(player->file, end, SEEK_SET);
+
+  model->difficulty = (Difficulty)difficulty;
+  model->two_player_mode = (flags & 1u) != 0;
+  model_start_game(model, seed);
+  player->games++;
+  return true;
+}
+
+static bool player_check_state_hash(ReplayPlayer *player,
+                                    const GameModel *model, uint64_t len) {
+  long end = ftell(player->file) + (long)len;
+  uint64_t tick, hash;
+  if (!read_varint(player->file, &tick) || !read_varint(player->file, &hash) ||
+      ftell(player->file) > end)
+    return false;
+  fseek(player->file, end, SEEK_SET);
+
+  player->hashes_checked++;
+  uint64_t actual = model_state_hash(model);
+  if ((actual != hash || tick != player->ticks) && !player->diverged) {
+    player->diverged = true;
+    player->diverged_tick = player->ticks;
+    fprintf(stderr,
+            "Replay diverged at tick %" PRIu64 " (game %d): state hash "
+            "%016" PRIx64 ", recorded %016" PRIx64 " at tick %" PRIu64 "\n",
+            player->ticks, player->games, actual, hash, tick);
+  }
+  return true;
+}
+
+bool replay_player_next(ReplayPlayer *player, GameModel *model,
+                        InputMask *mask) {
+  if (!player->file)
+    return false;
+  while (player->run == 0) {
+    uint64_t key, value;
+    if (!read_varint(player->file, &key) ||
+        !read_varint(player->file, &value))
+      return false;
+    if ((key & 1u) == 0) {
+      player->run = (uint32_t)(key >> 1);
+      player->mask = (InputMask)value;
+    } else if ((key >> 1) == REPLAY_RECORD_GAME_START) {
+      if (!player_start_game(player, model, value))
+        return false;
+    } else if ((key >> 1) == REPLAY_RECORD_STATE_HASH) {
+      if (!player_check_state_hash(player, model, value))
+        return false;
+    } else {
+      fseek(player->file, (long)value, SEEK_CUR); // Unknown record type
+    }
+  }
+  player->run--;
+  player->ticks++;
+  *mask = player->mask;
+  return true;
+}
+
+void replay_player_close(ReplayPlayer *player) {
+  if (player->file)
+    fclose(player->file);
+  player->file = NULL;
+}
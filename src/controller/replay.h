@@ -0,0 +1,89 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "controller.h"
+#include "model.h"
+
+// Enregistrement d'une session : pour chaque partie, sa graine puis le
+// masque d'entrées de chaque tick. La simulation étant déterministe, cela
+// suffit à rejouer la session à l'identique.
+//
+// Format (entiers en varint LEB128 sauf l'en-tête, ordre d'octets de l'hôte) :
+//   en-tête  : magic u32, version u16, tick_rate u16, capacités des pools
+//              joueur et ennemi u16
+//   entrées  : (ticks << 1) puis le masque, pour une suite de ticks au
+//              même masque
+//   extension: (type << 1 | 1), longueur, contenu ; les types inconnus sont
+//              ignorés à la lecture
+#define REPLAY_MAGIC 0x50524953u // "SIRP"
+#define REPLAY_VERSION 1
+
+typedef enum {
+  REPLAY_RECORD_GAME_START = 1, // graine, difficulté, drapeaux (bit 0 : 2J)
+  REPLAY_RECORD_STATE_HASH = 2, // tick, model_state_hash avant ce tick
+} ReplayRecordType;
+
+// Un hachage de l'état est enregistré tous les REPLAY_HASH_INTERVAL ticks
+// et à la fin de chaque partie ; la lecture le compare à l'état rejoué.
+#define REPLAY_HASH_INTERVAL 60
+
+typedef struct {
+  uint16_t tick_rate;
+  uint16_t player_bullet_capacity;
+  uint16_t enemy_bullet_capacity;
+} ReplayHeader;
+
+// Écriture en flux : une suite de ticks identiques n'est écrite qu'au
+// changement de masque.
+typedef struct {
+  FILE *file;
+  bool in_game;
+  uint64_t game_seed;
+  InputMask mask;
+  uint32_t run; // Ticks en attente au masque `mask`
+  uint64_t ticks;
+} ReplayRecorder;
+
+typedef struct {
+  FILE *file;
+  ReplayHeader header;
+  InputMask mask;
+  uint32_t run; // Ticks restants au masque `mask`
+  uint64_t ticks;
+  int games;
+  uint32_t hashes_checked;
+  bool diverged;          // Un hachage ne correspondait pas
+  uint64_t diverged_tick; // Premier tick vérifié en désaccord
+} ReplayPlayer;
+
+// Enregistrement
+bool replay_recorder_open(ReplayRecorder *rec, const char *path,
+                          const GameModel *model);
+// À appeler à chaque tick, avant d'appliquer `mask` et model_update. Seuls
+// les ticks d'une partie en cours sont enregistrés ; une nouvelle partie
+// est détectée par son état initial (graine différente ou retour du menu).
+void replay_recorder_tick(ReplayRecorder *rec, const GameModel *model,
+                          InputMask mask);
+// À appeler à la fin de chaque partie, avant que le modèle n'en relance
+// une : enregistre le hachage de l'état final. Sans effet hors partie.
+void replay_recorder_end_game(ReplayRecorder *rec, const GameModel *model);
+bool replay_recorder_close(ReplayRecorder *rec);
+
+// Lecture
+bool replay_player_open(ReplayPlayer *player, const char *path);
+// Règle la configuration du modèle sur celle de l'enregistrement (et
+// désactive la sauvegarde du meilleur score)
+void replay_player_configure(const ReplayPlayer *player, GameModel *model);
+// Masque du tick suivant. Redémarre le modèle au début de chaque partie
+// enregistrée et vérifie les hachages d'état rencontrés (la première
+// divergence est signalée sur stderr). Renvoie false à la fin de
+// l'enregistrement.
+bool replay_player_next(ReplayPlayer *player, GameModel *model,
+                        InputMask *mask);
+void replay_player_close(ReplayPlayer *player);
+
+#endif // REPLAY_H
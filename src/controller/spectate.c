@@ -0,0 +1,189 @@
+#include "spectate.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert((SPECTATE_SLOTS & (SPECTATE_SLOTS - 1)) == 0,
+               "SPECTATE_SLOTS must be a power of 2");
+
+#define SHM_PREFIX "/space_invaders."
+
+static bool shm_path(char *out, size_t out_size, const char *name) {
+  if (!name[0] || strchr(name, '/') ||
+      snprintf(out, out_size, SHM_PREFIX "%s", name) >= (int)out_size) {
+    fprintf(stderr, "Invalid broadcast name '%s'\n", name);
+    return false;
+  }
+  return true;
+}
+
+// --- Publisher ---
+
+bool spectate_publisher_open(SpectatePublisher *pub, const char *name) {
+  memset(pub, 0, sizeof(*pub));
+  if (!shm_path(pub->name, sizeof(pub->name), name))
+    return false;
+
+  // A ring left behind by a crashed game is replaced; its viewers keep the
+  // old mapping and see the publisher gone
+  shm_unlink(pub->name);
+  int fd = shm_open(pub->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0 || ftruncate(fd, sizeof(SpectateRing)) < 0) {
+    fprintf(stderr, "Cannot create broadcast %s: %s\n", pub->name,
+            strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(pub->name);
+    }
+    return false;
+  }
+  SpectateRing *ring = mmap(NULL, sizeof(SpectateRing),
+                            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) {
+    fprintf(stderr, "Cannot map broadcast %s: %s\n", pub->name,
+            strerror(errno));
+    shm_unlink(pub->name);
+    return false;
+  }
+
+  // The mapping starts zeroed; the magic goes in last so a viewer attaching
+  // meanwhile never sees a half-written header
+  ring->version = SPECTATE_VERSION;
+  ring->slot_count = SPECTATE_SLOTS;
+  ring->image_max = MODEL_SNAPSHOT_MAX_SIZE;
+  ring->publisher = getpid();
+  atomic_thread_fence(memory_order_release);
+  ring->magic = SPECTATE_MAGIC;
+  pub->ring = ring;
+  return true;
+}
+
+void spectate_publish(SpectatePublisher *pub, const GameModel *model,
+                      uint64_t tick) {
+  SpectateRing *ring = pub->ring;
+  if (!ring)
+    return;
+  uint64_t n = pub->frames;
+  SpectateSlot *slot = &ring->slots[n & (SPECTATE_SLOTS - 1)];
+
+  // Seqlock write: odd while the image changes, even once it is whole
+  atomic_store_explicit(&slot->seq, 2 * n + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  slot->size = (uint32_t)model_snapshot(model, slot->image);
+  slot->tick = tick;
+  atomic_store_explicit(&slot->seq, 2 * n + 2, memory_order_release);
+  atomic_store_explicit(&ring->published, n + 1, memory_order_release);
+  pub->frames = n + 1;
+}
+
+void spectate_publisher_close(SpectatePublisher *pub) {
+  if (!pub->ring)
+    return;
+  atomic_store_explicit(&pub->ring->closed, 1, memory_order_release);
+  munmap(pub->ring, sizeof(SpectateRing));
+  shm_unlink(pub->name);
+  pub->ring = NULL;
+}
+
+// --- Viewer ---
+
+bool spectate_viewer_open(SpectateViewer *viewer, const char *name) {
+  char path[SPECTATE_NAME_MAX];
+  memset(viewer, 0, sizeof(*viewer));
+  if (!shm_path(path, sizeof(path), name))
+    return false;
+
+  int fd = shm_open(path, O_RDONLY, 0);
+  if (fd < 0) {
+    fprintf(stderr, "No broadcast named '%s' (start a game with --broadcast "
+                    "%s)\n",
+            name, name);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(SpectateRing)) {
+    fprintf(stderr, "Broadcast '%s' is not a compatible ring\n", name);
+    close(fd);
+    return false;
+  }
+  const SpectateRing *ring =
+      mmap(NULL, sizeof(SpectateRing), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) {
+    fprintf(stderr, "Cannot map broadcast '%s': %s\n", name, strerror(errno));
+    return false;
+  }
+
+  bool compatible = ring->magic == SPECTATE_MAGIC;
+  atomic_thread_fence(memory_order_acquire);
+  compatible = compatible && ring->version == SPECTATE_VERSION &&
+               ring->slot_count == SPECTATE_SLOTS &&
+               ring->image_max == MODEL_SNAPSHOT_MAX_SIZE;
+  if (!compatible) {
+    fprintf(stderr, "Broadcast '%s' comes from another version of the game\n",
+            name);
+    munmap((void *)ring, sizeof(SpectateRing));
+    return false;
+  }
+  viewer->ring = ring;
+  return true;
+}
+
+static bool publisher_gone(const SpectateRing *ring) {
+  if (atomic_load_explicit(&ring->closed, memory_order_acquire))
+    return true;
+  return kill(ring->publisher, 0) < 0 && errno == ESRCH;
+}
+
+SpectateResult spectate_viewer_poll(SpectateViewer *viewer, GameModel *model) {
+  const SpectateRing *ring = viewer->ring;
+  if (!ring)
+    return SPECTATE_ENDED;
+
+  // Each retry moves on to a newer frame, and the publisher writes one per
+  // tick: a few attempts always suffice unless the viewer is descheduled
+  for (int attempt = 0; attempt < 2 * SPECTATE_SLOTS; attempt++) {
+    uint64_t published =
+        atomic_load_explicit(&ring->published, memory_order_acquire);
+    if (published == viewer->last_frame)
+      return publisher_gone(ring) ? SPECTATE_ENDED : SPECTATE_NO_FRAME;
+
+    uint64_t n = published - 1;
+    const SpectateSlot *slot = &ring->slots[n & (SPECTATE_SLOTS - 1)];
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != 2 * n + 2) {
+      viewer->retries++;
+      continue;
+    }
+    uint32_t size = slot->size;
+    uint64_t tick = slot->tick;
+    if (size > sizeof(viewer->image))
+      size = sizeof(viewer->image); // Torn; the check below rejects it
+    memcpy(viewer->image, slot->image, size);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+      viewer->retries++;
+      continue;
+    }
+
+    if (!model_restore(model, viewer->image, size))
+      return SPECTATE_ENDED;
+    viewer->last_frame = published;
+    viewer->last_tick = tick;
+    return SPECTATE_NEW_FRAME;
+  }
+  return SPECTATE_NO_FRAME;
+}
+
+void spectate_viewer_close(SpectateViewer *viewer) {
+  if (viewer->ring)
+    munmap((void *)viewer->ring, sizeof(SpectateRing));
+  viewer->ring = NULL;
+}
@@ -0,0 +1,80 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "model.h"
+#include "snapshot.h"
+
+// Diffusion d'une partie vers des spectateurs locaux. Le processus du
+// joueur publie l'image de son modèle (voir snapshot.h) à chaque tick dans
+// un anneau en mémoire partagée POSIX ; chaque vue spectatrice (SDL ou
+// ncurses) projette l'anneau en lecture seule et affiche la dernière image.
+//
+// L'éditeur n'attend jamais : chaque case est protégée par un seqlock
+// (compteur impair pendant l'écriture) et un lecteur qui voit le compteur
+// changer pendant sa copie recommence avec une image plus récente. Le
+// nombre de spectateurs ne change donc rien au coût côté joueur.
+#define SPECTATE_MAGIC 0x53505349u // "ISPS"
+#define SPECTATE_VERSION 1
+#define SPECTATE_SLOTS 8 // Puissance de 2
+#define SPECTATE_NAME_MAX 64
+
+typedef struct {
+  _Atomic uint64_t seq; // 2n + 1 pendant l'écriture de l'image n, puis 2n + 2
+  uint64_t tick;
+  uint32_t size;
+  uint8_t image[MODEL_SNAPSHOT_MAX_SIZE];
+} SpectateSlot;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t image_max;   // MODEL_SNAPSHOT_MAX_SIZE de l'éditeur
+  pid_t publisher;
+  _Atomic uint64_t published; // Images publiées ; la dernière est published-1
+  _Atomic uint32_t closed;    // L'éditeur a terminé
+  SpectateSlot slots[SPECTATE_SLOTS];
+} SpectateRing;
+
+typedef struct {
+  SpectateRing *ring;
+  char name[SPECTATE_NAME_MAX];
+  uint64_t frames;
+} SpectatePublisher;
+
+typedef struct {
+  const SpectateRing *ring;
+  uint64_t last_frame; // Dernière image lue + 1, 0 : aucune
+  uint64_t last_tick;
+  uint32_t retries;    // Copies recommencées, écrasées pendant la lecture
+  uint8_t image[MODEL_SNAPSHOT_MAX_SIZE];
+} SpectateViewer;
+
+typedef enum {
+  SPECTATE_NO_FRAME,  // Rien de neuf depuis la dernière lecture
+  SPECTATE_NEW_FRAME, // Le modèle montre la dernière image
+  SPECTATE_ENDED,     // L'éditeur a fermé la diffusion ou a disparu
+} SpectateResult;
+
+// Crée (ou remplace) la diffusion `name`, un nom court sans '/'.
+bool spectate_publisher_open(SpectatePublisher *pub, const char *name);
+// Publie l'état de `model` après le tick `tick`. Sans effet si fermé.
+void spectate_publish(SpectatePublisher *pub, const GameModel *model,
+                      uint64_t tick);
+// Prévient les spectateurs puis supprime la diffusion.
+void spectate_publisher_close(SpectatePublisher *pub);
+
+// Se rattache à une diffusion en cours.
+bool spectate_viewer_open(SpectateViewer *viewer, const char *name);
+// Charge la dernière image publiée dans `model` (état de jeu seulement, l'UI
+// du spectateur est conservée).
+SpectateResult spectate_viewer_poll(SpectateViewer *viewer, GameModel *model);
+void spectate_viewer_close(SpectateViewer *viewer);
+
+#endif // SPECTATE_H
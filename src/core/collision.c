@@ -0,0 +1,141 @@
+#include "collision.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static int cell_coord(float v, int cells) {
+  int c = (int)(v / COLLISION_CELL_SIZE);
+  if (c < 0)
+    return 0;
+  if (c >= cells)
+    return cells - 1;
+  return c;
+}
+
+// Inclusive cell range covered by a rect
+static void cell_range(Rect r, int *x0, int *y0, int *x1, int *y1) {
+  *x0 = cell_coord(r.x, COLLISION_GRID_COLS);
+  *y0 = cell_coord(r.y, COLLISION_GRID_ROWS);
+  *x1 = cell_coord(r.x + r.width, COLLISION_GRID_COLS);
+  *y1 = cell_coord(r.y + r.height, COLLISION_GRID_ROWS);
+}
+
+void collision_grid_clear(CollisionGrid *grid) {
+  memset(grid->cell_head, 0xff, sizeof(grid->cell_head));
+  grid->entry_count = 0;
+  grid->oversize_count = 0;
+}
+
+void collision_grid_insert(CollisionGrid *grid, Rect rect, int id) {
+  if (id < 0 || id >= COLLISION_MAX_IDS)
+    return;
+
+  int x0, y0, x1, y1;
+  cell_range(rect, &x0, &y0, &x1, &y1);
+  int span = (x1 - x0 + 1) * (y1 - y0 + 1);
+  if (span > COLLISION_MAX_SPAN ||
+      grid->entry_count + span > COLLISION_MAX_ENTRIES) {
+    grid->oversize[grid->oversize_count++] = (uint16_t)id;
+    return;
+  }
+
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      int cell = cy * COLLISION_GRID_COLS + cx;
+      int e = grid->entry_count++;
+      grid->entry_id[e] = (uint16_t)id;
+      grid->entry_next[e] = grid->cell_head[cell];
+      grid->cell_head[cell] = (int16_t)e;
+    }
+  }
+}
+
+// Inserts id into the ascending list out[0..count), skipping duplicates.
+// Candidate lists are short, so a linear scan beats any marking scheme.
+static int insert_sorted(uint16_t *out, int count, int max_out, uint16_t id) {
+  int pos = count;
+  while (pos > 0 && out[pos - 1] >= id) {
+    if (out[pos - 1] == id)
+      return count;
+    pos--;
+  }
+  if (count == max_out)
+    return count;
+  memmove(&out[pos + 1], &out[pos], (size_t)(count - pos) * sizeof(*out));
+  out[pos] = id;
+  return count + 1;
+}
+
+int collision_grid_query(const CollisionGrid *grid, Rect rect, uint16_t *out,
+                         int max_out) {
+  int count = 0;
+  int x0, y0, x1, y1;
+  cell_range(rect, &x0, &y0, &x1, &y1);
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      int e = grid->cell_head[cy * COLLISION_GRID_COLS + cx];
+      for (; e >= 0; e = grid->entry_next[e])
+        count = insert_sorted(out, count, max_out, grid->entry_id[e]);
+    }
+  }
+  // Ascending ids keep hit order identical to a plain index loop
+  for (int i = 0; i < grid->oversize_count; i++)
+    count = insert_sorted(out, count, max_out, grid->oversize[i]);
+  return count;
+}
+
+int collision_batch_add(CollisionBatch *batch, Rect rect) {
+  if (batch->count == COLLISION_BATCH_MAX)
+    return -1;
+  int i = batch->count++;
+  batch->left[i] = rect.x;
+  batch->top[i] = rect.y;
+  batch->right[i] = rect.x + rect.width;
+  batch->bottom[i] = rect.y + rect.height;
+  return i;
+}
+
+int collision_batch_overlap(const CollisionBatch *batch, Rect rect,
+                            uint32_t *hits) {
+  float left = rect.x;
+  float top = rect.y;
+  float right = rect.x + rect.width;
+  float bottom = rect.y + rect.height;
+  int count = batch->count;
+  int found = 0;
+  int i = 0;
+
+  memset(hits, 0, COLLISION_MASK_WORDS(count) * sizeof(*hits));
+
+#ifdef __SSE2__
+  __m128 l = _mm_set1_ps(left);
+  __m128 t = _mm_set1_ps(top);
+  __m128 r = _mm_set1_ps(right);
+  __m128 b = _mm_set1_ps(bottom);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x_overlap =
+        _mm_and_ps(_mm_cmplt_ps(l, _mm_load_ps(&batch->right[i])),
+                   _mm_cmpgt_ps(r, _mm_load_ps(&batch->left[i])));
+    __m128 y_overlap =
+        _mm_and_ps(_mm_cmplt_ps(t, _mm_load_ps(&batch->bottom[i])),
+                   _mm_cmpgt_ps(b, _mm_load_ps(&batch->top[i])));
+    unsigned bits = (unsigned)_mm_movemask_ps(_mm_and_ps(x_overlap, y_overlap));
+    if (bits) {
+      hits[i >> 5] |= (uint32_t)bits << (i & 31);
+      found += __builtin_popcount(bits);
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    if (left < batch->right[i] && right > batch->left[i] &&
+        top < batch->bottom[i] && bottom > batch->top[i]) {
+      hits[i >> 5] |= 1u << (i & 31);
+      found++;
+    }
+  }
+  return found;
+}
@@ -0,0 +1,77 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "model.h"
+
+// Uniform grid broadphase over the logical play area. Targets are inserted
+// by id into every cell their rect overlaps; a query returns the ids sharing
+// a cell with the query rect, so narrowphase tests only run for nearby
+// pairs. Rects outside the area are clamped into the border cells.
+#define COLLISION_CELL_SIZE 40
+#define COLLISION_GRID_COLS                                                    \
+  ((GAME_AREA_WIDTH + COLLISION_CELL_SIZE - 1) / COLLISION_CELL_SIZE)
+#define COLLISION_GRID_ROWS                                                    \
+  ((SCREEN_HEIGHT + COLLISION_CELL_SIZE - 1) / COLLISION_CELL_SIZE)
+#define COLLISION_GRID_CELLS (COLLISION_GRID_COLS * COLLISION_GRID_ROWS)
+#define COLLISION_MAX_IDS 256      // Ids are 0..COLLISION_MAX_IDS-1
+#define COLLISION_MAX_ENTRIES 2048 // Cell entries across all ids
+#define COLLISION_MAX_SPAN 9       // Larger rects go to the oversize list
+// Below this many bullet/target pairs a plain scan is cheaper than
+// building the grid
+#define COLLISION_GRID_MIN_PAIRS 128
+
+typedef struct {
+  int16_t cell_head[COLLISION_GRID_CELLS]; // First entry per cell, -1 = empty
+  int16_t entry_next[COLLISION_MAX_ENTRIES];
+  uint16_t entry_id[COLLISION_MAX_ENTRIES];
+  int entry_count;
+
+  // Ids spanning too many cells (or inserted once entries ran out) are
+  // returned by every query instead
+  uint16_t oversize[COLLISION_MAX_IDS];
+  int oversize_count;
+} CollisionGrid;
+
+// Packed target rects (structure of arrays) for testing one rect against
+// many at once. Edges are stored pre-added so results match
+// model_check_collision exactly.
+#define COLLISION_BATCH_MAX 256
+#define COLLISION_MASK_WORDS(n) (((n) + 31) / 32)
+
+typedef struct {
+  _Alignas(16) float left[COLLISION_BATCH_MAX];
+  _Alignas(16) float top[COLLISION_BATCH_MAX];
+  _Alignas(16) float right[COLLISION_BATCH_MAX];
+  _Alignas(16) float bottom[COLLISION_BATCH_MAX];
+  int count;
+} CollisionBatch;
+
+void collision_grid_clear(CollisionGrid *grid);
+void collision_grid_insert(CollisionGrid *grid, Rect rect, int id);
+
+// Writes the ids of candidates near `rect` to `out` in ascending order,
+// without duplicates. Returns the number written (at most max_out).
+int collision_grid_query(const CollisionGrid *grid, Rect rect, uint16_t *out,
+                         int max_out);
+
+static inline void collision_batch_clear(CollisionBatch *batch) {
+  batch->count = 0;
+}
+
+// Appends a target; returns its index, or -1 when the batch is full
+int collision_batch_add(CollisionBatch *batch, Rect rect);
+
+// Sets bit i of hits (COLLISION_MASK_WORDS(batch->count) words) for every
+// target i overlapping `rect`. Returns the number of hits. Uses SSE2 when
+// the compiler targets it, four targets per step.
+int collision_batch_overlap(const CollisionBatch *batch, Rect rect,
+                            uint32_t *hits);
+
+static inline bool collision_mask_test(const uint32_t *hits, int i) {
+  return (hits[i >> 5] >> (i & 31)) & 1u;
+}
+
+#endif // COLLISION_H
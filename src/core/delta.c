@@ -0,0 +1,392 @@
+#include "delta.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// As in snapshot.c, one walk serves both directions: the encoder walks the
+// baseline next to the current model, writing each change and applying it
+// to the baseline; the decoder walks the client's model alone, reading the
+// same changes. Both end up with the same baseline by construction.
+#define DELTA_INLINE static inline __attribute__((always_inline))
+
+typedef struct {
+  uint8_t *p;
+  const uint8_t *end;
+  bool reading;
+  bool ok;
+  uint64_t bits; // Pending bits, least significant first
+  int count;
+} DeltaIo;
+
+DELTA_INLINE void put_bits(DeltaIo *io, uint32_t value, int n) {
+  io->bits |= (uint64_t)(value & (uint32_t)((1ull << n) - 1)) << io->count;
+  io->count += n;
+  while (io->count >= 8) {
+    if (io->p == io->end) {
+      io->ok = false;
+      io->count = 0;
+      return;
+    }
+    *io->p++ = (uint8_t)io->bits;
+    io->bits >>= 8;
+    io->count -= 8;
+  }
+}
+
+DELTA_INLINE uint32_t get_bits(DeltaIo *io, int n) {
+  while (io->count < n) {
+    if (io->p == io->end) {
+      io->ok = false;
+      return 0;
+    }
+    io->bits |= (uint64_t)*io->p++ << io->count;
+    io->count += 8;
+  }
+  uint32_t value = (uint32_t)(io->bits & ((1ull << n) - 1));
+  io->bits >>= n;
+  io->count -= n;
+  return value;
+}
+
+DELTA_INLINE uint32_t sign_extend(uint32_t value, int n) {
+  return (uint32_t)((int32_t)(value << (32 - n)) >> (32 - n));
+}
+
+// A change is coded by its size: 0 | 10 + 6 bits | 110 + 12 bits |
+// 111 + 32 bits. Arithmetic wraps, so any int goes through exactly.
+DELTA_INLINE uint32_t code_change(DeltaIo *io, uint32_t base,
+                                  uint32_t current) {
+  if (io->reading) {
+    if (!get_bits(io, 1))
+      return base;
+    if (!get_bits(io, 1))
+      return base + sign_extend(get_bits(io, 6), 6);
+    if (!get_bits(io, 1))
+      return base + sign_extend(get_bits(io, 12), 12);
+    return base + get_bits(io, 32);
+  }
+  uint32_t change = current - base;
+  int32_t signed_change = (int32_t)change;
+  if (change == 0) {
+    put_bits(io, 0, 1);
+  } else if (signed_change >= -32 && signed_change < 32) {
+    put_bits(io, 0x1, 2);
+    put_bits(io, change, 6);
+  } else if (signed_change >= -2048 && signed_change < 2048) {
+    put_bits(io, 0x3, 3);
+    put_bits(io, change, 12);
+  } else {
+    put_bits(io, 0x7, 3);
+    put_bits(io, change, 32);
+  }
+  return current;
+}
+
+DELTA_INLINE int32_t quantize(float value, float scale) {
+  float q = value * scale;
+  if (!(q > -1e9f && q < 1e9f))
+    return 0; // NaN or off any screen
+  return (int32_t)(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+DELTA_INLINE void dq_int(DeltaIo *io, int *base, int current) {
+  *base = (int)code_change(io, (uint32_t)*base, (uint32_t)current);
+}
+
+// Both sides store the dequantized value, so later changes are measured
+// from the same number
+DELTA_INLINE void dq_float(DeltaIo *io, float *base, float current,
+                           float scale) {
+  uint32_t q = code_change(io, (uint32_t)quantize(*base, scale),
+                           (uint32_t)quantize(current, scale));
+  *base = (float)(int32_t)q / scale;
+}
+
+DELTA_INLINE void dq_flag(DeltaIo *io, bool *base, bool current) {
+  if (io->reading) {
+    if (get_bits(io, 1))
+      *base = !*base;
+  } else {
+    put_bits(io, *base != current, 1);
+    *base = current;
+  }
+}
+
+// One bit when unchanged, else the whole set
+DELTA_INLINE void dq_bits(DeltaIo *io, uint32_t *base, uint32_t current,
+                          int n) {
+  if (io->reading) {
+    if (get_bits(io, 1))
+      *base = get_bits(io, n);
+  } else if (*base == current) {
+    put_bits(io, 0, 1);
+  } else {
+    put_bits(io, 1, 1);
+    put_bits(io, current, n);
+    *base = current;
+  }
+}
+
+// `c` is the current model's struct, NULL when decoding
+#define CUR(c, field) ((c) ? (c)->field : 0)
+#define SUB(c, field) ((c) ? &(c)->field : NULL)
+
+#define DQ_INT(io, s, c, field)                                                \
+  do {                                                                         \
+    int v_ = (int)(s)->field;                                                  \
+    dq_int((io), &v_, (int)CUR(c, field));                                     \
+    (s)->field = (__typeof__((s)->field))v_;                                   \
+  } while (0)
+#define DQ_POS(io, s, c, field)                                                \
+  dq_float((io), &(s)->field, CUR(c, field), DELTA_POSITION_SCALE)
+#define DQ_TIMER(io, s, c, field)                                              \
+  dq_float((io), &(s)->field, CUR(c, field), DELTA_TIMER_SCALE)
+#define DQ_FLAG(io, s, c, field) dq_flag((io), &(s)->field, CUR(c, field))
+
+DELTA_INLINE void dq_rect(DeltaIo *io, Rect *s, const Rect *c) {
+  DQ_POS(io, s, c, x);
+  DQ_POS(io, s, c, y);
+  DQ_POS(io, s, c, width);
+  DQ_POS(io, s, c, height);
+}
+
+// The fields of a dead entity are not sent: both sides know it is dead
+DELTA_INLINE void dq_player(DeltaIo *io, Player *s, const Player *c) {
+  DQ_FLAG(io, s, c, is_active);
+  if (!s->is_active)
+    return;
+  dq_rect(io, &s->hitbox, SUB(c, hitbox));
+  DQ_INT(io, s, c, lives);
+  DQ_INT(io, s, c, score);
+  DQ_INT(io, s, c, combo_count);
+  DQ_INT(io, s, c, active_powerup);
+  DQ_TIMER(io, s, c, powerup_timer);
+  DQ_TIMER(io, s, c, invincibility_timer);
+}
+
+DELTA_INLINE uint32_t row_alive_bits(const Invader *row) {
+  uint32_t bits = 0;
+  for (int j = 0; j < INVADER_COLS; j++)
+    bits |= (uint32_t)row[j].alive << j;
+  return bits;
+}
+
+DELTA_INLINE void dq_big_invader(DeltaIo *io, BigInvader *s,
+                                 const BigInvader *c) {
+  DQ_FLAG(io, s, c, alive);
+  if (!s->alive)
+    return;
+  dq_rect(io, &s->hitbox, SUB(c, hitbox));
+  DQ_INT(io, s, c, health);
+  DQ_INT(io, s, c, max_health);
+}
+
+// The other live-formation masks follow from the rows (see model.h)
+DELTA_INLINE void live_masks_from_rows(InvaderGrid *g) {
+  g->live_cols = 0;
+  g->live_rows = 0;
+  for (int j = 0; j < INVADER_COLS; j++)
+    g->col_mask[j] = 0;
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    uint32_t row = g->row_mask[i];
+    if (row)
+      g->live_rows |= (uint8_t)(1u << i);
+    g->live_cols |= (uint16_t)row;
+    for (; row; row &= row - 1)
+      g->col_mask[__builtin_ctz(row)] |= (uint8_t)(1u << i);
+  }
+  g->left_col = g->live_cols ? __builtin_ctz(g->live_cols) : -1;
+  g->right_col = g->live_cols ? 31 - __builtin_clz(g->live_cols) : -1;
+  g->bottom_row = g->live_rows ? 31 - __builtin_clz(g->live_rows) : -1;
+}
+
+// The lattice (offsets, types, points) only changes with the level, which
+// takes a key frame; per tick the grid is its origin plus three bitsets a
+// row: alive, exploding and drifting on their own. The live masks are
+// rebuilt from them rather than sent.
+DELTA_INLINE void dq_invader_grid(DeltaIo *io, InvaderGrid *s,
+                                  const InvaderGrid *c) {
+  DQ_POS(io, s, c, origin_x);
+  DQ_POS(io, s, c, origin_y);
+  DQ_INT(io, s, c, state);
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    uint32_t alive = row_alive_bits(s->invaders[i]);
+    uint32_t dying = s->dying_mask[i];
+    uint32_t custom = s->custom_speed_mask[i];
+    dq_bits(io, &alive, c ? row_alive_bits(c->invaders[i]) : 0, INVADER_COLS);
+    dq_bits(io, &dying, CUR(c, dying_mask[i]), INVADER_COLS);
+    dq_bits(io, &custom, CUR(c, custom_speed_mask[i]), INVADER_COLS);
+    s->dying_mask[i] = (uint16_t)dying;
+    s->custom_speed_mask[i] = (uint16_t)custom;
+    s->row_mask[i] = (uint16_t)(alive & ~dying);
+
+    for (int j = 0; j < INVADER_COLS; j++) {
+      Invader *inv = &s->invaders[i][j];
+      const Invader *cinv = SUB(c, invaders[i][j]);
+      inv->alive = (alive >> j) & 1u;
+      if ((dying >> j) & 1u)
+        DQ_INT(io, inv, cinv, dying_timer);
+      else
+        inv->dying_timer = 0;
+      if ((custom >> j) & 1u)
+        DQ_POS(io, inv, cinv, offset.x);
+    }
+  }
+  live_masks_from_rows(s);
+  dq_big_invader(io, &s->big_invader, SUB(c, big_invader));
+}
+
+DELTA_INLINE void dq_boss(DeltaIo *io, Boss *s, const Boss *c) {
+  DQ_FLAG(io, s, c, alive);
+  if (!s->alive)
+    return;
+  dq_rect(io, &s->hitbox, SUB(c, hitbox));
+  DQ_INT(io, s, c, health);
+  DQ_INT(io, s, c, max_health);
+  DQ_INT(io, s, c, anim_frame);
+}
+
+DELTA_INLINE void dq_saucer(DeltaIo *io, Saucer *s, const Saucer *c) {
+  DQ_FLAG(io, s, c, alive);
+  if (!s->alive)
+    return;
+  dq_rect(io, &s->hitbox, SUB(c, hitbox));
+}
+
+DELTA_INLINE void dq_powerup(DeltaIo *io, PowerUp *s, const PowerUp *c) {
+  DQ_FLAG(io, s, c, alive);
+  if (!s->alive)
+    return;
+  DQ_INT(io, s, c, type);
+  dq_rect(io, &s->hitbox, SUB(c, hitbox));
+}
+
+// Alive bitset (one bit when unchanged), then every live bullet by slot.
+// A bullet new to its slot is coded against a zeroed one. The baseline's
+// live list is rebuilt in slot order: views draw from it, and the order
+// only matters to the simulation.
+DELTA_INLINE void dq_bullet_pool(DeltaIo *io, BulletPool *s,
+                                 const BulletPool *c) {
+  const int capacity = s->capacity; // Same on both: a key frame otherwise
+  bool changed = false;
+  if (io->reading) {
+    changed = get_bits(io, 1);
+  } else {
+    for (int k = 0; k < capacity && !changed; k++)
+      changed = s->items[k].alive != c->items[k].alive;
+    put_bits(io, changed, 1);
+  }
+
+  s->live_count = 0;
+  s->free_count = 0;
+  for (int k = capacity - 1; k >= 0; k--) {
+    Bullet *b = &s->items[k];
+    bool alive = b->alive;
+    if (changed) {
+      if (io->reading) {
+        alive = get_bits(io, 1);
+      } else {
+        alive = c->items[k].alive;
+        put_bits(io, alive, 1);
+      }
+    }
+    if (!alive) {
+      b->alive = false;
+      s->free_slots[s->free_count++] = (uint16_t)k;
+      continue;
+    }
+    if (!b->alive) {
+      memset(b, 0, sizeof(*b));
+      b->alive = true;
+    }
+    const Bullet *cb = SUB(c, items[k]);
+    dq_rect(io, &b->hitbox, SUB(cb, hitbox));
+    DQ_FLAG(io, b, cb, is_player_bullet);
+    DQ_FLAG(io, b, cb, is_strong);
+    DQ_INT(io, b, cb, player_id);
+    DQ_INT(io, b, cb, type);
+    s->live[s->live_count++] = (uint16_t)k;
+  }
+  // Slots were visited from the top: flip the live list to slot order
+  for (int a = 0, z = s->live_count - 1; a < z; a++, z--) {
+    uint16_t t = s->live[a];
+    s->live[a] = s->live[z];
+    s->live[z] = t;
+  }
+  for (int k = 0; k < s->live_count; k++)
+    s->live_index[s->live[k]] = (uint16_t)k;
+}
+
+DELTA_INLINE void dq_model(DeltaIo *io, GameModel *s, const GameModel *c) {
+  DQ_INT(io, s, c, high_score);
+  for (int p = 0; p < 2; p++)
+    dq_player(io, &s->players[p], SUB(c, players[p]));
+  dq_invader_grid(io, &s->invaders, SUB(c, invaders));
+  dq_boss(io, &s->boss, SUB(c, boss));
+  dq_saucer(io, &s->saucer, SUB(c, saucer));
+  for (int i = 0; i < 10; i++)
+    dq_powerup(io, &s->powerups[i], SUB(c, powerups[i]));
+  for (int p = 0; p < 2; p++)
+    dq_bullet_pool(io, &s->player_bullets[p], SUB(c, player_bullets[p]));
+  dq_bullet_pool(io, &s->enemy_bullets, SUB(c, enemy_bullets));
+}
+
+// Changes a delta does not carry
+static bool needs_key_frame(const GameModel *base, const GameModel *cur) {
+  if (base->seed != cur->seed || base->state != cur->state ||
+      base->difficulty != cur->difficulty ||
+      base->two_player_mode != cur->two_player_mode)
+    return true;
+  for (int p = 0; p < 2; p++)
+    if (base->players[p].level != cur->players[p].level ||
+        base->player_bullets[p].capacity != cur->player_bullets[p].capacity)
+      return true;
+  return base->enemy_bullets.capacity != cur->enemy_bullets.capacity;
+}
+
+size_t delta_encode(GameModel *baseline, const GameModel *current, bool key,
+                    void *buf) {
+  uint8_t *out = buf;
+  if (!key && !needs_key_frame(baseline, current)) {
+    DeltaIo io = {out + 1, out + DELTA_FRAME_MAX_SIZE, false, true, 0, 0};
+    dq_model(&io, baseline, current);
+    if (io.count > 0)
+      put_bits(&io, 0, 8 - io.count);
+    if (io.ok) {
+      out[0] = DELTA_FRAME_DELTA;
+      return (size_t)(io.p - out);
+    }
+    // Too big to pay off; the key frame below resets the half-updated
+    // baseline
+  }
+  out[0] = DELTA_FRAME_KEY;
+  size_t size = model_snapshot(current, out + 1);
+  model_restore(baseline, out + 1, size);
+  return 1 + size;
+}
+
+bool delta_decode(GameModel *model, const void *buf, size_t size) {
+  const uint8_t *in = buf;
+  if (size < 1) {
+    fprintf(stderr, "Empty delta frame\n");
+    return false;
+  }
+  if (in[0] == DELTA_FRAME_KEY)
+    return model_restore(model, in + 1, size - 1);
+  if (in[0] != DELTA_FRAME_DELTA) {
+    fprintf(stderr, "Unknown delta frame type %d\n", in[0]);
+    return false;
+  }
+
+  // As in model_restore, decoded aside so a bad frame changes nothing
+  GameModel scratch = *model;
+  DeltaIo io = {(uint8_t *)in + 1, in + size, true, true, 0, 0};
+  dq_model(&io, &scratch, NULL);
+  if (!io.ok || io.p != in + size) {
+    fprintf(stderr, "Corrupt delta frame\n");
+    return false;
+  }
+  *model = scratch;
+  model->needs_redraw = true;
+  return true;
+}
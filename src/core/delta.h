@@ -0,0 +1,46 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model.h"
+#include "snapshot.h"
+
+// Delta-compressed state frames for network clients and spectators. Each
+// frame turns the client's copy of the model (its baseline) into the state
+// of the next tick, and the encoder keeps an identical copy of that baseline
+// to diff against.
+//
+// A key frame is a full snapshot image (see snapshot.h). A delta frame is a
+// bit stream over the state a view draws: positions quantized to
+// 1/DELTA_POSITION_SCALE pixel and coded as the change from the baseline,
+// alive bitsets for the invader grid and each bullet pool, and a single bit
+// for every field that did not change. Decoded models are for display only:
+// quantized positions and the fields left out (timers, random state) mean
+// they are not meant to be simulated further.
+#define DELTA_POSITION_SCALE 8.0f // Steps per pixel
+#define DELTA_TIMER_SCALE 100.0f  // Steps per second
+
+typedef enum {
+  DELTA_FRAME_KEY = 1,   // Snapshot image follows
+  DELTA_FRAME_DELTA = 2, // Bit stream against the baseline follows
+} DeltaFrameType;
+
+// Upper bound on a frame. A delta that would not fit is sent as a key frame.
+#define DELTA_FRAME_MAX_SIZE (1 + MODEL_SNAPSHOT_MAX_SIZE)
+
+// Writes the frame taking `baseline` to `current` and returns its size;
+// `baseline` is updated to what the client holds once it decodes the frame.
+// `key` forces a key frame (start of a stream). One is also sent whenever a
+// delta cannot express the change: a new game or level, a state change or
+// different pool capacities.
+size_t delta_encode(GameModel *baseline, const GameModel *current, bool key,
+                    void *buf);
+
+// Applies a frame to the client's baseline (an initialised model). Returns
+// false, leaving the model untouched, on a malformed frame.
+bool delta_decode(GameModel *model, const void *buf, size_t size);
+
+#endif // DELTA_H
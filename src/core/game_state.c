@@ -25,6 +25,8 @@ GameContext *game_context_create(void) {
   context->running = true;
   context->last_update = get_ticks();
   context->time_scale = 1.0f;
+  context->tick_accumulator = 0.0f;
+  context->tick_count = 0;
 
   return context;
 }
@@ -54,6 +56,42 @@ void game_context_update(GameContext *context) {
   }
 }
 
+void game_context_set_tick_rate(GameContext *context, int ticks_per_second) {
+  if (ticks_per_second > 0)
+    context->model->config.tick_rate = ticks_per_second;
+}
+
+void game_context_start_clock(GameContext *context, uint32_t now_ms) {
+  context->last_update = now_ms;
+  context->tick_accumulator = 0.0f;
+}
+
+/* Ajoute le temps réel écoulé depuis l'appel précédent et renvoie le nombre
+ * de ticks de simulation à exécuter pour cette image. */
+int game_context_advance(GameContext *context, uint32_t now_ms) {
+  float elapsed = (now_ms - context->last_update) / 1000.0f;
+  context->last_update = now_ms;
+  if (elapsed > GAME_MAX_FRAME_TIME)
+    elapsed = GAME_MAX_FRAME_TIME;
+
+  float dt = game_context_tick_dt(context);
+  context->tick_accumulator += elapsed * context->time_scale;
+  int ticks = (int)(context->tick_accumulator / dt);
+  context->tick_accumulator -= ticks * dt;
+  context->tick_count += (uint64_t)ticks;
+  return ticks;
+}
+
+float game_context_tick_dt(const GameContext *context) {
+  return 1.0f / (float)context->model->config.tick_rate;
+}
+
+/* Fraction du tick suivant déjà écoulée, pour interpoler le rendu */
+float game_context_interpolation(const GameContext *context) {
+  float alpha = context->tick_accumulator / game_context_tick_dt(context);
+  return alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+}
+
 void game_context_render(GameContext *context) {
   if (context->model->needs_redraw) {
     context->model->needs_redraw = false;
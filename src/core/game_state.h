@@ -11,14 +11,29 @@ typedef struct {
   bool running;
   uint32_t last_update;
   float time_scale;
+
+  // Boucle à pas fixe : temps réel accumulé, consommé par ticks de
+  // 1 / model->config.tick_rate secondes
+  float tick_accumulator;
+  uint64_t tick_count;
 } GameContext;
 
+// Temps réel maximal pris en compte par image (évite la spirale de la mort)
+#define GAME_MAX_FRAME_TIME 0.25f
+
 // Gestion du contexte
 GameContext *game_context_create(void);
 void game_context_destroy(GameContext *context);
 void game_context_update(GameContext *context);
 void game_context_render(GameContext *context);
 
+// Pas de simulation fixe
+void game_context_set_tick_rate(GameContext *context, int ticks_per_second);
+void game_context_start_clock(GameContext *context, uint32_t now_ms);
+int game_context_advance(GameContext *context, uint32_t now_ms);
+float game_context_tick_dt(const GameContext *context);
+float game_context_interpolation(const GameContext *context);
+
 // États du jeu
 typedef void (*StateFunction)(GameContext *);
 
@@ -1,10 +1,27 @@
 #include "model.h"
-#include "utils/platform.h"
+#include "collision.h"
+#include "../utils/perf_counters.h"
+#include "../utils/trace.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Explosion duration before an invader is removed
+#define INVADER_EXPLOSION_TIME (5.0f / 60.0f)
+
+// --- Tick Helpers ---
+
+// Converts a duration to whole simulation ticks (at least one)
+static int model_ticks(const GameModel *model, float seconds) {
+  int ticks = (int)(seconds * model->config.tick_rate + 0.5f);
+  return ticks > 0 ? ticks : 1;
+}
+
+static float model_tick_dt(const GameModel *model) {
+  return 1.0f / (float)model->config.tick_rate;
+}
+
 // --- Helper Init Functions ---
 
 static void init_player_params(Player *player, int id) {
@@ -51,8 +68,141 @@ static void init_boss(Boss *boss) {
   boss->attack_timer = 0;
 }
 
+// --- Formation Bitmasks ---
+
+_Static_assert(INVADER_COLS <= 16, "row_mask holds one bit per column");
+_Static_assert(INVADER_ROWS <= 8, "col_mask holds one bit per row");
+
+static int lowest_bit(uint32_t bits) { return bits ? __builtin_ctz(bits) : -1; }
+
+static int highest_bit(uint32_t bits) {
+  return bits ? 31 - __builtin_clz(bits) : -1;
+}
+
+static void formation_update_extents(InvaderGrid *g) {
+  g->left_col = lowest_bit(g->live_cols);
+  g->right_col = highest_bit(g->live_cols);
+  g->bottom_row = highest_bit(g->live_rows);
+}
+
+static void formation_fill(InvaderGrid *g) {
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    g->row_mask[i] = (uint16_t)((1u << INVADER_COLS) - 1);
+    g->custom_speed_mask[i] = 0;
+    g->dying_mask[i] = 0;
+  }
+  for (int j = 0; j < INVADER_COLS; j++)
+    g->col_mask[j] = (uint8_t)((1u << INVADER_ROWS) - 1);
+  g->live_cols = (uint16_t)((1u << INVADER_COLS) - 1);
+  g->live_rows = (uint8_t)((1u << INVADER_ROWS) - 1);
+  formation_update_extents(g);
+}
+
+// Removes a hit invader from the live formation
+static void formation_kill(InvaderGrid *g, int row, int col) {
+  g->dying_mask[row] |= (uint16_t)(1u << col);
+  g->row_mask[row] &= (uint16_t)~(1u << col);
+  g->col_mask[col] &= (uint8_t)~(1u << row);
+  if (!g->row_mask[row])
+    g->live_rows &= (uint8_t)~(1u << row);
+  if (!g->col_mask[col])
+    g->live_cols &= (uint16_t)~(1u << col);
+  formation_update_extents(g);
+}
+
+// Bottom-most live invader of a column, -1 if the column is empty
+static int formation_shooter_row(const InvaderGrid *g, int col) {
+  return highest_bit(g->col_mask[col]);
+}
+
+// Any live invader of a row. Every invader of a row shares its y offset.
+static const Invader *formation_row_sample(const InvaderGrid *g, int row) {
+  return &g->invaders[row][lowest_bit(g->row_mask[row])];
+}
+
+// Screen x of a lattice column
+static float formation_col_x(const InvaderGrid *g, int col) {
+  return g->origin_x + FORMATION_LEFT + col * INVADER_SPACING_X;
+}
+
+static int clamp_index(int v, int max) { return v < 0 ? 0 : v > max ? max : v; }
+
+static Invader *formation_invader(InvaderGrid *g, int id) {
+  return &g->invaders[id / INVADER_COLS][id % INVADER_COLS];
+}
+
+// Ids (row * INVADER_COLS + col, ascending) of the live invaders that may
+// overlap `r`. Lattice invaders are found from r's position relative to the
+// origin without touching the others; drifting ones are always included.
+static int formation_candidates(const InvaderGrid *g, Rect r, uint16_t *out) {
+  float lx = r.x - g->origin_x - FORMATION_LEFT;
+  float ly = r.y - g->origin_y - FORMATION_TOP;
+  int i0 = (int)floorf((ly - INVADER_HEIGHT) / INVADER_SPACING_Y);
+  int i1 = (int)floorf((ly + r.height) / INVADER_SPACING_Y);
+  int j0 = (int)floorf((lx - INVADER_WIDTH) / INVADER_SPACING_X);
+  int j1 = (int)floorf((lx + r.width) / INVADER_SPACING_X);
+  if (i1 < 0 || i0 >= INVADER_ROWS)
+    return 0;
+  i0 = clamp_index(i0, INVADER_ROWS - 1);
+  i1 = clamp_index(i1, INVADER_ROWS - 1);
+
+  uint16_t cols = 0;
+  if (j1 >= 0 && j0 < INVADER_COLS) {
+    j0 = clamp_index(j0, INVADER_COLS - 1);
+    j1 = clamp_index(j1, INVADER_COLS - 1);
+    cols = (uint16_t)(((1u << (j1 + 1)) - 1) & ~((1u << j0) - 1));
+  }
+
+  int count = 0;
+  for (int i = i0; i <= i1; i++) {
+    uint32_t bits = (cols | g->custom_speed_mask[i]) & g->row_mask[i];
+    for (; bits; bits &= bits - 1)
+      out[count++] = (uint16_t)(i * INVADER_COLS + lowest_bit(bits));
+  }
+  return count;
+}
+
+void invader_grid_set_speed_modifier(InvaderGrid *grid, int row, int col,
+                                     float modifier) {
+  grid->invaders[row][col].speed_modifier = modifier;
+  if (modifier != 1.0f)
+    grid->custom_speed_mask[row] |= (uint16_t)(1u << col);
+  else
+    grid->custom_speed_mask[row] &= (uint16_t)~(1u << col);
+}
+
+void invader_grid_rebuild_masks(InvaderGrid *grid) {
+  grid->live_cols = 0;
+  grid->live_rows = 0;
+  for (int j = 0; j < INVADER_COLS; j++)
+    grid->col_mask[j] = 0;
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    grid->row_mask[i] = 0;
+    grid->dying_mask[i] = 0;
+    grid->custom_speed_mask[i] = 0;
+    for (int j = 0; j < INVADER_COLS; j++) {
+      const Invader *inv = &grid->invaders[i][j];
+      uint16_t bit = (uint16_t)(1u << j);
+      if (inv->speed_modifier != 1.0f)
+        grid->custom_speed_mask[i] |= bit;
+      if (!inv->alive)
+        continue;
+      if (inv->dying_timer != 0) {
+        grid->dying_mask[i] |= bit;
+      } else {
+        grid->row_mask[i] |= bit;
+        grid->col_mask[j] |= (uint8_t)(1u << i);
+      }
+    }
+    if (grid->row_mask[i])
+      grid->live_rows |= (uint8_t)(1u << i);
+    grid->live_cols |= grid->row_mask[i];
+  }
+  formation_update_extents(grid);
+}
+
 static void init_invaders(InvaderGrid *invaders, int level,
-                          Difficulty difficulty) {
+                          Difficulty difficulty, uint32_t now) {
   invaders->direction = DIR_RIGHT;
   float base_speed = 0.5f + (level * 0.5f);
   invaders->shoot_chance = (level > 2) ? 150 : (300 - (level * 30));
@@ -67,9 +217,11 @@ static void init_invaders(InvaderGrid *invaders, int level,
   invaders->state = 0;
   invaders->killed = 0;
   invaders->state_speed = (level > 3) ? 200 : (1000 - (level * 150));
-  invaders->state_time = platform_get_ticks();
+  invaders->state_time = now;
 
   invaders->big_invader_spawn_timer = 0;
+  invaders->origin_x = 0;
+  invaders->origin_y = 0;
 
   // Initialize big invader as inactive
   invaders->big_invader.alive = false;
@@ -84,10 +236,10 @@ static void init_invaders(InvaderGrid *invaders, int level,
 
   for (int i = 0; i < INVADER_ROWS; i++) {
     for (int j = 0; j < INVADER_COLS; j++) {
-      invaders->invaders[i][j].hitbox.x = 20 + j * (INVADER_WIDTH + 15);
-      invaders->invaders[i][j].hitbox.y = 80 + i * (INVADER_HEIGHT + 10);
-      invaders->invaders[i][j].hitbox.width = INVADER_WIDTH;
-      invaders->invaders[i][j].hitbox.height = INVADER_HEIGHT;
+      invaders->invaders[i][j].offset.x = FORMATION_LEFT + j * INVADER_SPACING_X;
+      invaders->invaders[i][j].offset.y = FORMATION_TOP + i * INVADER_SPACING_Y;
+      invaders->invaders[i][j].offset.width = INVADER_WIDTH;
+      invaders->invaders[i][j].offset.height = INVADER_HEIGHT;
       invaders->invaders[i][j].alive = true;
       invaders->invaders[i][j].dying_timer = 0;
       invaders->invaders[i][j].row = i;
@@ -107,20 +259,108 @@ static void init_invaders(InvaderGrid *invaders, int level,
       }
     }
   }
+  formation_fill(invaders);
 }
 
-static void init_bullets(Bullet bullets[], int count, bool is_player,
-                         int p_id) {
-  for (int i = 0; i < count; i++) {
-    bullets[i].hitbox.width = BULLET_WIDTH;
-    bullets[i].hitbox.height = BULLET_HEIGHT;
-    bullets[i].alive = false;
-    bullets[i].is_player_bullet = is_player;
-    bullets[i].player_id = p_id;
-    bullets[i].speed_x = 0;
-    bullets[i].speed_y = is_player ? -600.0f : 300.0f;
-    bullets[i].is_strong = false;
+// --- Events ---
+
+static void model_emit(GameModel *model, GameEventType type, int player_id,
+                       float x, float y, int32_t value) {
+  GameEventRing *ring = &model->events;
+  if (ring->muted)
+    return;
+  GameEvent *e = &ring->events[ring->head & (GAME_EVENT_CAPACITY - 1)];
+  e->time = model->sim_time;
+  e->type = (uint8_t)type;
+  e->player_id = (int8_t)player_id;
+  e->entity = 0;
+  e->value = value;
+  e->x = x;
+  e->y = y;
+  ring->head++;
+}
+
+static void model_emit_kill(GameModel *model, int player_id, EntityType entity,
+                            Rect where, int32_t points) {
+  model_emit(model, EVENT_KILL, player_id, where.x + where.width / 2,
+             where.y + where.height / 2, points);
+  if (model->events.muted)
+    return;
+  model->events.events[(model->events.head - 1) & (GAME_EVENT_CAPACITY - 1)]
+      .entity = (uint8_t)entity;
+}
+
+const GameEvent *model_next_event(const GameModel *model, uint32_t *cursor) {
+  uint32_t head = model->events.head;
+  if (head - *cursor > GAME_EVENT_CAPACITY) // Fell behind: drop the oldest
+    *cursor = head - GAME_EVENT_CAPACITY;
+  if (*cursor == head)
+    return NULL;
+  return &model->events.events[(*cursor)++ & (GAME_EVENT_CAPACITY - 1)];
+}
+
+uint32_t model_event_head(const GameModel *model) { return model->events.head; }
+
+// --- Bullet Pools ---
+
+void bullet_pool_init(BulletPool *pool, int capacity) {
+  if (capacity < 1)
+    capacity = 1;
+  if (capacity > BULLET_POOL_MAX)
+    capacity = BULLET_POOL_MAX;
+  pool->capacity = capacity;
+  pool->live_count = 0;
+  pool->free_count = capacity;
+  // Pop order hands out slot 0 first
+  for (int i = 0; i < capacity; i++) {
+    pool->free_slots[i] = (uint16_t)(capacity - 1 - i);
+    pool->items[i].alive = false;
+  }
+}
+
+Bullet *bullet_pool_spawn(BulletPool *pool) {
+  if (pool->free_count == 0)
+    return NULL;
+  uint16_t slot = pool->free_slots[--pool->free_count];
+  pool->live_index[slot] = (uint16_t)pool->live_count;
+  pool->live[pool->live_count++] = slot;
+
+  Bullet *b = &pool->items[slot];
+  memset(b, 0, sizeof(*b));
+  b->alive = true;
+  return b;
+}
+
+void bullet_pool_release(BulletPool *pool, Bullet *bullet) {
+  uint16_t slot = (uint16_t)(bullet - pool->items);
+  if (!bullet->alive)
+    return;
+  bullet->alive = false;
+
+  uint16_t pos = pool->live_index[slot];
+  uint16_t last = pool->live[--pool->live_count];
+  pool->live[pos] = last;
+  pool->live_index[last] = pos;
+  pool->free_slots[pool->free_count++] = slot;
+}
+
+static void init_bullet_pools(GameModel *model) {
+  for (int p = 0; p < 2; p++)
+    bullet_pool_init(&model->player_bullets[p],
+                     model->config.player_bullet_capacity);
+  bullet_pool_init(&model->enemy_bullets, model->config.enemy_bullet_capacity);
+}
+
+static Bullet *spawn_enemy_bullet(GameModel *model, int type,
+                                  const Rect *shooter) {
+  Bullet *b = bullet_pool_spawn(&model->enemy_bullets);
+  if (b) {
+    b->player_id = -1;
+    b->type = type;
+    model_emit(model, EVENT_ENEMY_SHOT, -1, shooter->x + shooter->width / 2,
+               shooter->y + shooter->height, type);
   }
+  return b;
 }
 
 static void init_powerups(PowerUp powerups[], int count) {
@@ -133,7 +373,7 @@ static void init_powerups(PowerUp powerups[], int count) {
 }
 
 static void model_drop_powerup(GameModel *model, float x, float y) {
-  if ((rand() % 100) > 15) // Increased to 15% chance
+  if (rng_range(&model->rng, 100) > 15) // Increased to 15% chance
     return;
 
   for (int i = 0; i < 10; i++) {
@@ -141,7 +381,8 @@ static void model_drop_powerup(GameModel *model, float x, float y) {
       model->powerups[i].alive = true;
       model->powerups[i].hitbox.x = x;
       model->powerups[i].hitbox.y = y;
-      model->powerups[i].type = (PowerUpType)(1 + (rand() % (PWR_MAX - 1)));
+      model->powerups[i].type =
+          (PowerUpType)(1 + rng_range(&model->rng, PWR_MAX - 1));
       break;
     }
   }
@@ -157,69 +398,96 @@ static void init_saucer(Saucer *saucer) {
 
 // --- Public Init ---
 
-void model_init(GameModel *model) {
+ModelConfig model_default_config(void) {
+  ModelConfig config;
+  memset(&config, 0, sizeof(config));
+  config.persist_high_score = true;
+  config.seed = MODEL_DEFAULT_SEED;
+  config.tick_rate = SIM_TICK_RATE;
+  config.player_bullet_capacity = PLAYER_BULLETS;
+  config.enemy_bullet_capacity = ENEMY_BULLETS;
+  return config;
+}
+
+void model_init(GameModel *model) { model_init_with_config(model, NULL); }
+
+void model_init_with_config(GameModel *model, const ModelConfig *config) {
+  ModelConfig cfg = config ? *config : model_default_config();
+  if (cfg.tick_rate <= 0)
+    cfg.tick_rate = SIM_TICK_RATE;
+  if (cfg.player_bullet_capacity <= 0)
+    cfg.player_bullet_capacity = PLAYER_BULLETS;
+  if (cfg.enemy_bullet_capacity <= 0)
+    cfg.enemy_bullet_capacity = ENEMY_BULLETS;
   memset(model, 0, sizeof(GameModel));
+  model->config = cfg;
+  model_seed(model, cfg.seed);
 
   init_player_params(&model->players[0], 0);
   init_player_params(&model->players[1], 1);
   model->players[1].is_active = false; // Player 2 inactive unless chosen
 
-  init_invaders(&model->invaders, 1, DIFFICULTY_NORMAL);
+  init_invaders(&model->invaders, 1, DIFFICULTY_NORMAL, 0);
   init_boss(&model->boss);
 
-  for (int p = 0; p < 2; p++)
-    init_bullets(model->player_bullets[p], PLAYER_BULLETS, true, p);
-
-  init_bullets(model->enemy_bullets, ENEMY_BULLETS, false, -1);
+  init_bullet_pools(model);
   init_powerups(model->powerups, 10);
   init_saucer(&model->saucer);
 
   model->state = STATE_MENU;
   model->difficulty = DIFFICULTY_NORMAL;
-  model->menu_state = MENU_MAIN;
-  model->menu_selection = 0;
+  model->ui.menu_state = MENU_MAIN;
+  model->ui.menu_selection = 0;
   // Music volume is handled by persistence in reset_game or main
-  if (model->music_volume <= 0.05f) model->music_volume = 1.0f; // Default to MAX if 0 or too low
-  model->game_time = platform_get_ticks();
-  model->last_update_time = model->game_time;
+  if (model->ui.music_volume <= 0.05f) model->ui.music_volume = 1.0f; // Default to MAX if 0 or too low
+  model->game_time = 0;
+  model->last_update_time = 0;
   model->needs_redraw = true;
 
   // Default keybindings (SDL keycodes for arrows/WASD)
   // P1: Left=1073741904, Right=1073741903, Up=1073741906, Down=1073741905,
   // Shoot=32 (space) For ncurses: a=97, d=100, w=119, s=115, space=32
-  model->keybinds_p1[0] = 1073741904; // Left arrow
-  model->keybinds_p1[1] = 1073741903; // Right arrow
-  model->keybinds_p1[2] = 1073741906; // Up arrow
-  model->keybinds_p1[3] = 1073741905; // Down arrow
-  model->keybinds_p1[4] = 32;         // Space
-  model->keybinds_p2[0] = 97;         // A
-  model->keybinds_p2[1] = 100;        // D
-  model->keybinds_p2[2] = 119;        // W
-  model->keybinds_p2[3] = 115;        // S
-  model->keybinds_p2[4] = 1073742049; // Left Shift
-  model->editing_keybind = -1;
-  model->waiting_for_key = false;
+  model->ui.keybinds_p1[0] = 1073741904; // Left arrow
+  model->ui.keybinds_p1[1] = 1073741903; // Right arrow
+  model->ui.keybinds_p1[2] = 1073741906; // Up arrow
+  model->ui.keybinds_p1[3] = 1073741905; // Down arrow
+  model->ui.keybinds_p1[4] = 32;         // Space
+  model->ui.keybinds_p2[0] = 97;         // A
+  model->ui.keybinds_p2[1] = 100;        // D
+  model->ui.keybinds_p2[2] = 119;        // W
+  model->ui.keybinds_p2[3] = 115;        // S
+  model->ui.keybinds_p2[4] = 1073742049; // Left Shift
+  model->ui.editing_keybind = -1;
+  model->ui.waiting_for_key = false;
 
   model_load_high_score(model);
 }
 
 void model_reset_game(GameModel *model) {
+  // Each new game continues from the previous stream so games differ, while
+  // a fixed initial seed still reproduces the whole session
+  model_start_game(model, rng_next64(&model->rng));
+}
+
+void model_start_game(GameModel *model, uint64_t seed) {
   Difficulty old_diff = model->difficulty;
   bool old_2p = model->two_player_mode;
 
-  // Save keybindings and volume
-  int saved_p1[5];
-  int saved_p2[5];
-  float saved_vol = model->music_volume;
-  memcpy(saved_p1, model->keybinds_p1, sizeof(int) * 5);
-  memcpy(saved_p2, model->keybinds_p2, sizeof(int) * 5);
+  UiState saved_ui = model->ui;
+  ModelConfig saved_config = model->config;
+  // Views hold cursors into the event ring, so it survives the reset
+  GameEventRing saved_events = model->events;
 
-  model_init(model);
+  model_init_with_config(model, &saved_config);
+  model_seed(model, seed);
+  model->events = saved_events;
 
-  // Restore keybindings and volume
-  memcpy(model->keybinds_p1, saved_p1, sizeof(int) * 5);
-  memcpy(model->keybinds_p2, saved_p2, sizeof(int) * 5);
-  model->music_volume = saved_vol;
+  // Keybindings and volume carry over; menus start from the top
+  model->ui = saved_ui;
+  model->ui.menu_state = MENU_MAIN;
+  model->ui.menu_selection = 0;
+  model->ui.editing_keybind = -1;
+  model->ui.waiting_for_key = false;
 
   model->state = STATE_PLAYING;
   model->difficulty = old_diff;
@@ -227,6 +495,11 @@ void model_reset_game(GameModel *model) {
   model->players[1].is_active = old_2p;
 }
 
+void model_seed(GameModel *model, uint64_t seed) {
+  model->seed = seed;
+  rng_seed(&model->rng, seed, 0);
+}
+
 void model_next_level(GameModel *model) {
   model->players[0].level++;
   model->players[1].level = model->players[0].level;
@@ -235,11 +508,9 @@ void model_next_level(GameModel *model) {
   if (model->difficulty == DIFFICULTY_ROGUE)
     max_level = 999;
 
-  for (int p = 0; p < 2; p++) {
+  for (int p = 0; p < 2; p++)
     reset_player_pos(&model->players[p], p);
-    init_bullets(model->player_bullets[p], PLAYER_BULLETS, true, p);
-  }
-  init_bullets(model->enemy_bullets, ENEMY_BULLETS, false, -1);
+  init_bullet_pools(model);
 
   if (model->difficulty == DIFFICULTY_ROGUE) {
     if (model->players[0].level % 5 == 0) {
@@ -249,11 +520,12 @@ void model_next_level(GameModel *model) {
       model->boss.health = model->boss.max_health;
     } else {
       init_invaders(&model->invaders, model->players[0].level,
-                    model->difficulty);
+                    model->difficulty, model->sim_time);
     }
   } else {
     if (model->difficulty == DIFFICULTY_EASY && model->players[0].level > 3) {
       model->state = STATE_WIN;
+      model_emit(model, EVENT_WIN, -1, 0, 0, model_get_score(model));
       return;
     }
     if (model->players[0].level == 4 && model->difficulty != DIFFICULTY_EASY) {
@@ -261,10 +533,11 @@ void model_next_level(GameModel *model) {
       model->boss.alive = true;
     } else if (model->players[0].level > max_level) {
       model->state = STATE_WIN;
+      model_emit(model, EVENT_WIN, -1, 0, 0, model_get_score(model));
       return;
     } else {
       init_invaders(&model->invaders, model->players[0].level,
-                    model->difficulty);
+                    model->difficulty, model->sim_time);
     }
   }
 
@@ -281,6 +554,7 @@ void model_next_level(GameModel *model) {
 
   model->state = STATE_LEVEL_TRANSITION;
   model->needs_redraw = true;
+  model_emit(model, EVENT_LEVEL_UP, -1, 0, 0, model->players[0].level);
 }
 
 // --- Updates ---
@@ -288,10 +562,11 @@ void model_next_level(GameModel *model) {
 void model_update_boss(GameModel *model, float delta_time) {
   if (!model->boss.alive)
     return;
+  TRACE_SCOPE("model_update_boss");
   Boss *boss = &model->boss;
 
   boss->anim_counter++;
-  if (boss->anim_counter >= 15) {
+  if (boss->anim_counter >= model_ticks(model, 0.25f)) {
     boss->anim_counter = 0;
     boss->anim_frame = !boss->anim_frame;
   }
@@ -299,7 +574,7 @@ void model_update_boss(GameModel *model, float delta_time) {
   boss->attack_timer += delta_time;
   if (boss->attack_timer > 5.0f) {
     boss->attack_timer = 0;
-    boss->attack_pattern = rand() % 2;
+    boss->attack_pattern = rng_range(&model->rng, 2);
   }
 
   // Movement logic
@@ -317,150 +592,138 @@ void model_update_boss(GameModel *model, float delta_time) {
   }
 
   // Vertical Movement (Sinewave)
-  boss->hitbox.y = 80 + sinf(platform_get_ticks() / 1000.0f) * 30.0f;
+  boss->hitbox.y = 80 + sinf(model->sim_time / 1000.0f) * 30.0f;
 
   // Shooting
   boss->shoot_timer++;
 
   // Change attack pattern periodically
-  if (boss->shoot_timer > 60) {
+  if (boss->shoot_timer > model_ticks(model, 1.0f)) {
     boss->attack_pattern = (boss->attack_pattern + 1) % 4; // 4 patterns now
   }
 
-  if (boss->shoot_timer > 30) {
+  if (boss->shoot_timer > model_ticks(model, 0.5f)) {
     boss->shoot_timer = 0;
 
     if (boss->attack_pattern == 0) { // Circular burst (spinning)
       for (int i = 0; i < 12; i++) {
-        for (int b = 0; b < ENEMY_BULLETS; b++) {
-          if (!model->enemy_bullets[b].alive) {
-            model->enemy_bullets[b].alive = true;
-            model->enemy_bullets[b].type = 2; // Laser/Orb
-            model->enemy_bullets[b].hitbox.x =
-                boss->hitbox.x + boss->hitbox.width / 2;
-            model->enemy_bullets[b].hitbox.y =
-                boss->hitbox.y + boss->hitbox.height / 2;
-            model->enemy_bullets[b].hitbox.width = 8;
-            model->enemy_bullets[b].hitbox.height = 8;
-            float angle =
-                i * (3.14159f / 6.0f) + (boss->anim_counter * 0.15f); // Spin
-            model->enemy_bullets[b].speed_x = cosf(angle) * 250.0f;
-            model->enemy_bullets[b].speed_y = sinf(angle) * 250.0f;
-            break;
-          }
-        }
+        Bullet *eb = spawn_enemy_bullet(model, 2, &boss->hitbox); // Laser/Orb
+        if (!eb)
+          break;
+        eb->hitbox.x = boss->hitbox.x + boss->hitbox.width / 2;
+        eb->hitbox.y = boss->hitbox.y + boss->hitbox.height / 2;
+        eb->hitbox.width = 8;
+        eb->hitbox.height = 8;
+        // Spin at 9 rad/s
+        float angle = i * (3.14159f / 6.0f) +
+                      (boss->anim_counter * 9.0f * model_tick_dt(model));
+        eb->speed_x = cosf(angle) * 250.0f;
+        eb->speed_y = sinf(angle) * 250.0f;
       }
     } else if (boss->attack_pattern == 1) { // Bullet rain
       for (int i = 0; i < 5; i++) {
-        for (int b = 0; b < ENEMY_BULLETS; b++) {
-          if (!model->enemy_bullets[b].alive) {
-            model->enemy_bullets[b].alive = true;
-            model->enemy_bullets[b].type = 0;
-            model->enemy_bullets[b].hitbox.x =
-                boss->hitbox.x + (rand() % (int)boss->hitbox.width);
-            model->enemy_bullets[b].hitbox.y =
-                boss->hitbox.y + boss->hitbox.height;
-            model->enemy_bullets[b].hitbox.width = 5;
-            model->enemy_bullets[b].hitbox.height = 15;
-            model->enemy_bullets[b].speed_x = (rand() % 80) - 40;
-            model->enemy_bullets[b].speed_y = 400.0f + (rand() % 100);
-            break;
-          }
-        }
+        Bullet *eb = spawn_enemy_bullet(model, 0, &boss->hitbox);
+        if (!eb)
+          break;
+        eb->hitbox.x =
+            boss->hitbox.x + rng_range(&model->rng, (int)boss->hitbox.width);
+        eb->hitbox.y = boss->hitbox.y + boss->hitbox.height;
+        eb->hitbox.width = 5;
+        eb->hitbox.height = 15;
+        eb->speed_x = rng_range(&model->rng, 80) - 40;
+        eb->speed_y = 400.0f + rng_range(&model->rng, 100);
       }
     } else if (boss->attack_pattern == 2) { // BIG SLOW ATTACK - hard to dodge!
-      for (int b = 0; b < ENEMY_BULLETS; b++) {
-        if (!model->enemy_bullets[b].alive) {
-          model->enemy_bullets[b].alive = true;
-          model->enemy_bullets[b].type = 2; // Laser type for visual
-          model->enemy_bullets[b].hitbox.x =
-              boss->hitbox.x + boss->hitbox.width / 2 - 20;
-          model->enemy_bullets[b].hitbox.y =
-              boss->hitbox.y + boss->hitbox.height;
-          model->enemy_bullets[b].hitbox.width = 40; // BIG!
-          model->enemy_bullets[b].hitbox.height = 40;
-          model->enemy_bullets[b].speed_x = 0;
-          model->enemy_bullets[b].speed_y = 120.0f; // SLOW but deadly
-          break;
-        }
+      Bullet *eb = spawn_enemy_bullet(model, 2, &boss->hitbox); // Laser visual
+      if (eb) {
+        eb->hitbox.x = boss->hitbox.x + boss->hitbox.width / 2 - 20;
+        eb->hitbox.y = boss->hitbox.y + boss->hitbox.height;
+        eb->hitbox.width = 40; // BIG!
+        eb->hitbox.height = 40;
+        eb->speed_x = 0;
+        eb->speed_y = 120.0f; // SLOW but deadly
       }
     } else { // ZigZag spread
       for (int i = 0; i < 3; i++) {
-        for (int b = 0; b < ENEMY_BULLETS; b++) {
-          if (!model->enemy_bullets[b].alive) {
-            model->enemy_bullets[b].alive = true;
-            model->enemy_bullets[b].type = 1; // ZigZag
-            model->enemy_bullets[b].hitbox.x = boss->hitbox.x +
-                                               boss->hitbox.width / 4 +
-                                               i * (boss->hitbox.width / 4);
-            model->enemy_bullets[b].hitbox.y =
-                boss->hitbox.y + boss->hitbox.height;
-            model->enemy_bullets[b].hitbox.width = 6;
-            model->enemy_bullets[b].hitbox.height = 12;
-            model->enemy_bullets[b].speed_x = 0;
-            model->enemy_bullets[b].speed_y = 300.0f;
-            break;
-          }
-        }
+        Bullet *eb = spawn_enemy_bullet(model, 1, &boss->hitbox); // ZigZag
+        if (!eb)
+          break;
+        eb->hitbox.x = boss->hitbox.x + boss->hitbox.width / 4 +
+                       i * (boss->hitbox.width / 4);
+        eb->hitbox.y = boss->hitbox.y + boss->hitbox.height;
+        eb->hitbox.width = 6;
+        eb->hitbox.height = 12;
+        eb->speed_x = 0;
+        eb->speed_y = 300.0f;
       }
     }
   }
 }
 
 void model_update_invaders(GameModel *model, float delta_time) {
+  TRACE_SCOPE("model_update_invaders");
   InvaderGrid *g = &model->invaders;
-  bool any_alive = false;
-  for (int i = 0; i < INVADER_ROWS; i++)
-    for (int j = 0; j < INVADER_COLS; j++)
-      if (g->invaders[i][j].alive)
-        any_alive = true;
-
   // Include big invader in "any alive" check
-  if (g->big_invader.alive)
-    any_alive = true;
-
-  if (!any_alive && !g->big_invader.alive)
+  if (!g->live_cols && !g->big_invader.alive)
     return;
 
-  if (platform_get_ticks() > g->state_time + g->state_speed) {
-    g->state_time = platform_get_ticks();
+  if (model->sim_time > g->state_time + g->state_speed) {
+    g->state_time = model->sim_time;
     g->state = !g->state;
     model->needs_redraw = true;
   }
 
-  bool hit_edge = false;
   float shift = g->speed * delta_time;
+  float step = (g->direction == DIR_RIGHT) ? shift : -shift;
 
+  // Exploding invaders count down; only they need individual visits
   for (int i = 0; i < INVADER_ROWS; i++) {
-    for (int j = 0; j < INVADER_COLS; j++) {
+    for (uint32_t bits = g->dying_mask[i]; bits; bits &= bits - 1) {
+      int j = lowest_bit(bits);
       Invader *inv = &g->invaders[i][j];
-      if (inv->alive && inv->dying_timer > 0) {
-        inv->dying_timer--;
-        if (inv->dying_timer <= 0)
-          inv->alive = false;
-        continue;
-      }
-      if (inv->alive) {
-        float inv_shift = shift * inv->speed_modifier;
-        if (g->direction == DIR_RIGHT) {
-          inv->hitbox.x += inv_shift;
-          if (inv->hitbox.x + inv->hitbox.width >= GAME_AREA_WIDTH)
-            hit_edge = true;
-        } else {
-          inv->hitbox.x -= inv_shift;
-          if (inv->hitbox.x <= 0)
-            hit_edge = true;
-        }
+      if (--inv->dying_timer <= 0) {
+        inv->alive = false;
+        g->dying_mask[i] &= (uint16_t)~(1u << j);
       }
     }
   }
 
+  // The whole formation moves with its origin; custom-speed invaders also
+  // drift by their extra speed
+  g->origin_x += step;
+  bool hit_edge = false;
+  uint16_t lattice_cols = 0;
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    lattice_cols |= g->row_mask[i] & ~g->custom_speed_mask[i];
+    for (uint32_t bits = g->custom_speed_mask[i] & g->row_mask[i]; bits;
+         bits &= bits - 1) {
+      Invader *inv = &g->invaders[i][lowest_bit(bits)];
+      inv->offset.x += step * (inv->speed_modifier - 1.0f);
+      Rect r = invader_grid_rect(g, inv);
+      if (g->direction == DIR_RIGHT ? r.x + r.width >= GAME_AREA_WIDTH
+                                    : r.x <= 0)
+        hit_edge = true;
+    }
+  }
+
+  // Of the lattice, only the outermost live column can touch an edge. That
+  // is the cached extent unless drifting invaders alone hold a column.
+  if (lattice_cols) {
+    int left = g->left_col;
+    int right = g->right_col;
+    if (lattice_cols != g->live_cols) {
+      left = lowest_bit(lattice_cols);
+      right = highest_bit(lattice_cols);
+    }
+    if (g->direction == DIR_RIGHT)
+      hit_edge |= formation_col_x(g, right) + INVADER_WIDTH >= GAME_AREA_WIDTH;
+    else
+      hit_edge |= formation_col_x(g, left) <= 0;
+  }
+
   if (hit_edge) {
     g->direction = (g->direction == DIR_RIGHT) ? DIR_LEFT : DIR_RIGHT;
-    for (int i = 0; i < INVADER_ROWS; i++)
-      for (int j = 0; j < INVADER_COLS; j++)
-        if (g->invaders[i][j].alive)
-          g->invaders[i][j].hitbox.y += 15;
+    g->origin_y += 15;
   }
 
   // Big Invader spawning (spawn every ~15 seconds if not alive)
@@ -469,13 +732,14 @@ void model_update_invaders(GameModel *model, float delta_time) {
     if (g->big_invader_spawn_timer >= 15.0f) {
       g->big_invader_spawn_timer = 0;
       g->big_invader.alive = true;
-      g->big_invader.hitbox.x =
-          (rand() % 2 == 0) ? -BIG_INVADER_WIDTH : GAME_AREA_WIDTH;
+      g->big_invader.hitbox.x = (rng_range(&model->rng, 2) == 0)
+                                    ? -BIG_INVADER_WIDTH
+                                    : GAME_AREA_WIDTH;
       g->big_invader.hitbox.y = 80;
       g->big_invader.direction =
           (g->big_invader.hitbox.x < 0) ? DIR_RIGHT : DIR_LEFT;
       g->big_invader.health = g->big_invader.max_health;
-      g->big_invader.attack_type = rand() % 2;
+      g->big_invader.attack_type = rng_range(&model->rng, 2);
     }
   }
 
@@ -502,41 +766,28 @@ void model_update_invaders(GameModel *model, float delta_time) {
 
       if (bi->attack_type == 0) {
         // Big slow shot - hard to dodge!
-        for (int b = 0; b < ENEMY_BULLETS; b++) {
-          if (!model->enemy_bullets[b].alive) {
-            model->enemy_bullets[b].alive = true;
-            model->enemy_bullets[b].type = 2; // Laser type visual
-            model->enemy_bullets[b].hitbox.x =
-                bi->hitbox.x + bi->hitbox.width / 2 - 25;
-            model->enemy_bullets[b].hitbox.y = bi->hitbox.y + bi->hitbox.height;
-            model->enemy_bullets[b].hitbox.width =
-                35; // Smaller (was 50) to allow dodging
-            model->enemy_bullets[b].hitbox.height = 50;
-            model->enemy_bullets[b].speed_x = 0;
-            model->enemy_bullets[b].speed_y =
-                100.0f; // Faster (was 80) to clear screen
-            break;
-          }
+        Bullet *eb = spawn_enemy_bullet(model, 2, &bi->hitbox); // Laser type visual
+        if (eb) {
+          eb->hitbox.x = bi->hitbox.x + bi->hitbox.width / 2 - 25;
+          eb->hitbox.y = bi->hitbox.y + bi->hitbox.height;
+          eb->hitbox.width = 35; // Smaller (was 50) to allow dodging
+          eb->hitbox.height = 50;
+          eb->speed_x = 0;
+          eb->speed_y = 100.0f; // Faster (was 80) to clear screen
         }
       } else {
         // Spread shot - 5 shots in a fan pattern
         for (int s = 0; s < 5; s++) {
-          for (int b = 0; b < ENEMY_BULLETS; b++) {
-            if (!model->enemy_bullets[b].alive) {
-              model->enemy_bullets[b].alive = true;
-              model->enemy_bullets[b].type = 0;
-              model->enemy_bullets[b].hitbox.x =
-                  bi->hitbox.x + bi->hitbox.width / 2;
-              model->enemy_bullets[b].hitbox.y =
-                  bi->hitbox.y + bi->hitbox.height;
-              model->enemy_bullets[b].hitbox.width = 8;
-              model->enemy_bullets[b].hitbox.height = 8;
-              float angle = -0.4f + (s * 0.2f); // Fan from -0.4 to 0.4 radians
-              model->enemy_bullets[b].speed_x = sinf(angle) * 200.0f;
-              model->enemy_bullets[b].speed_y = cosf(angle) * 200.0f;
-              break;
-            }
-          }
+          Bullet *eb = spawn_enemy_bullet(model, 0, &bi->hitbox);
+          if (!eb)
+            break;
+          eb->hitbox.x = bi->hitbox.x + bi->hitbox.width / 2;
+          eb->hitbox.y = bi->hitbox.y + bi->hitbox.height;
+          eb->hitbox.width = 8;
+          eb->hitbox.height = 8;
+          float angle = -0.4f + (s * 0.2f); // Fan from -0.4 to 0.4 radians
+          eb->speed_x = sinf(angle) * 200.0f;
+          eb->speed_y = cosf(angle) * 200.0f;
         }
       }
     }
@@ -544,43 +795,38 @@ void model_update_invaders(GameModel *model, float delta_time) {
 }
 
 void model_update_bullets(GameModel *model, float delta_time) {
+  TRACE_SCOPE("model_update_bullets");
+  // Live lists are walked backwards so releases do not skip entries
   for (int p = 0; p < 2; p++) {
-    for (int i = 0; i < PLAYER_BULLETS; i++) {
-      if (model->player_bullets[p][i].alive) {
-        model->player_bullets[p][i].hitbox.x +=
-            model->player_bullets[p][i].speed_x * delta_time;
-        model->player_bullets[p][i].hitbox.y +=
-            model->player_bullets[p][i].speed_y * delta_time;
-        if (model->player_bullets[p][i].hitbox.y < 0 ||
-            model->player_bullets[p][i].hitbox.y > SCREEN_HEIGHT ||
-            model->player_bullets[p][i].hitbox.x < 0 ||
-            model->player_bullets[p][i].hitbox.x > GAME_AREA_WIDTH)
-          model->player_bullets[p][i].alive = false;
-      }
+    BulletPool *pool = &model->player_bullets[p];
+    for (int k = pool->live_count - 1; k >= 0; k--) {
+      Bullet *b = bullet_pool_at(pool, k);
+      b->hitbox.x += b->speed_x * delta_time;
+      b->hitbox.y += b->speed_y * delta_time;
+      if (b->hitbox.y < 0 || b->hitbox.y > SCREEN_HEIGHT || b->hitbox.x < 0 ||
+          b->hitbox.x > GAME_AREA_WIDTH)
+        bullet_pool_release(pool, b);
     }
   }
-  for (int i = 0; i < ENEMY_BULLETS; i++) {
-    if (model->enemy_bullets[i].alive) {
-      if (model->enemy_bullets[i].type == 1) { // ZigZag
-        model->enemy_bullets[i].speed_x =
-            sinf(model->enemy_bullets[i].hitbox.y * 0.05f) * 150.0f;
-      }
-      model->enemy_bullets[i].hitbox.x +=
-          model->enemy_bullets[i].speed_x * delta_time;
-      model->enemy_bullets[i].hitbox.y +=
-          model->enemy_bullets[i].speed_y * delta_time;
-      if (model->enemy_bullets[i].hitbox.y > SCREEN_HEIGHT ||
-          model->enemy_bullets[i].hitbox.y < 0 ||
-          model->enemy_bullets[i].hitbox.x < -50 ||
-          model->enemy_bullets[i].hitbox.x > GAME_AREA_WIDTH + 50)
-        model->enemy_bullets[i].alive = false;
+
+  BulletPool *pool = &model->enemy_bullets;
+  for (int k = pool->live_count - 1; k >= 0; k--) {
+    Bullet *b = bullet_pool_at(pool, k);
+    if (b->type == 1) { // ZigZag
+      b->speed_x = sinf(b->hitbox.y * 0.05f) * 150.0f;
     }
+    b->hitbox.x += b->speed_x * delta_time;
+    b->hitbox.y += b->speed_y * delta_time;
+    if (b->hitbox.y > SCREEN_HEIGHT || b->hitbox.y < 0 || b->hitbox.x < -50 ||
+        b->hitbox.x > GAME_AREA_WIDTH + 50)
+      bullet_pool_release(pool, b);
   }
 }
 
 void model_update_saucer(GameModel *model, float delta_time) {
   if (!model->saucer.alive)
     return;
+  TRACE_SCOPE("model_update_saucer");
   float speed = 250.0f * delta_time;
   if (model->saucer.direction == DIR_LEFT)
     speed = -speed;
@@ -591,13 +837,14 @@ void model_update_saucer(GameModel *model, float delta_time) {
 }
 
 void model_update(GameModel *model, float delta_time) {
+  TRACE_SCOPE("model_update");
   // Handle WIN state auto-return to menu
   if (model->state == STATE_WIN) {
     model->win_timer += delta_time;
     if (model->win_timer >= 5.0f) { // 5 seconds
       model->state = STATE_MENU;
-      model->menu_state = MENU_MAIN;
-      model->menu_selection = 0;
+      model->ui.menu_state = MENU_MAIN;
+      model->ui.menu_selection = 0;
       model->win_timer = 0;
     }
     return;
@@ -608,8 +855,8 @@ void model_update(GameModel *model, float delta_time) {
     model->win_timer += delta_time;
     if (model->win_timer >= 5.0f) { // 5 seconds
       model->state = STATE_MENU;
-      model->menu_state = MENU_MAIN;
-      model->menu_selection = 0;
+      model->ui.menu_state = MENU_MAIN;
+      model->ui.menu_selection = 0;
       model->win_timer = 0;
     }
     return;
@@ -618,10 +865,14 @@ void model_update(GameModel *model, float delta_time) {
   if (model->state != STATE_PLAYING)
     return;
 
-  uint32_t now = platform_get_ticks();
+  model->sim_time_carry += delta_time * 1000.0f;
+  uint32_t elapsed_ms = (uint32_t)model->sim_time_carry;
+  model->sim_time += elapsed_ms;
+  model->sim_time_carry -= (float)elapsed_ms;
+
   for (int p = 0; p < 2; p++) {
     if (model->players[p].combo_count > 0 &&
-        now - model->players[p].last_kill_time > 2000) {
+        model->sim_time - model->players[p].last_kill_time > 2000) {
       model->players[p].combo_count = 0;
     }
   }
@@ -642,22 +893,15 @@ void model_update(GameModel *model, float delta_time) {
     if (model->difficulty >= DIFFICULTY_HARD) attempts = INVADER_COLS; // Hard: check ALL columns
 
     for (int a = 0; a < attempts; a++) {
-      int col = (model->difficulty >= DIFFICULTY_HARD) ? a : (rand() % INVADER_COLS);
+      int col = (model->difficulty >= DIFFICULTY_HARD) ? a : rng_range(&model->rng, INVADER_COLS);
       
-      int row = -1;
-      // Find bottom-most alive invader in this column
-      for (int r = INVADER_ROWS - 1; r >= 0; r--) {
-        if (model->invaders.invaders[r][col].alive && 
-            model->invaders.invaders[r][col].dying_timer == 0) {
-          row = r;
-          break;
-        }
-      }
+      // Bottom-most live invader in this column
+      int row = formation_shooter_row(&model->invaders, col);
 
       if (row != -1) { 
         // Found a shooter. Check chance.
         // For Hard mode, we want a high volume of fire, so checks are per-column.
-        if (rand() % model->invaders.shoot_chance == 0) { 
+        if (rng_range(&model->rng, model->invaders.shoot_chance) == 0) { 
              
              // Dynamic Shot Type based on row
              int type = 0;
@@ -674,29 +918,26 @@ void model_update(GameModel *model, float delta_time) {
              }
              
              // Spawn Bullet
-             for (int b = 0; b < ENEMY_BULLETS; b++) {
-               if (!model->enemy_bullets[b].alive) {
-                 model->enemy_bullets[b].alive = true;
-                 model->enemy_bullets[b].hitbox.x = 
-                    model->invaders.invaders[row][col].hitbox.x + INVADER_WIDTH/2 - BULLET_WIDTH/2;
-                 model->enemy_bullets[b].hitbox.y = 
-                    model->invaders.invaders[row][col].hitbox.y + INVADER_HEIGHT;
-                 model->enemy_bullets[b].hitbox.width = BULLET_WIDTH;
-                 model->enemy_bullets[b].hitbox.height = BULLET_HEIGHT;
-                 model->enemy_bullets[b].type = type;
-                 model->enemy_bullets[b].speed_x = sx;
-                 model->enemy_bullets[b].speed_y = sy;
-                 break;
-               }
+             Rect shooter = invader_grid_rect(&model->invaders,
+                                              &model->invaders.invaders[row][col]);
+             Bullet *eb = spawn_enemy_bullet(model, type, &shooter);
+             if (eb) {
+               eb->hitbox.x = shooter.x + INVADER_WIDTH/2 - BULLET_WIDTH/2;
+               eb->hitbox.y = shooter.y + INVADER_HEIGHT;
+               eb->hitbox.width = BULLET_WIDTH;
+               eb->hitbox.height = BULLET_HEIGHT;
+               eb->speed_x = sx;
+               eb->speed_y = sy;
              }
         }
       }
     }
   }
 
-  if (!model->saucer.alive && (rand() % 1500 == 0)) {
+  if (!model->saucer.alive && (rng_range(&model->rng, 1500) == 0)) {
     model->saucer.alive = true;
-    model->saucer.direction = (rand() % 2 == 0) ? DIR_RIGHT : DIR_LEFT;
+    model->saucer.direction =
+        (rng_range(&model->rng, 2) == 0) ? DIR_RIGHT : DIR_LEFT;
     model->saucer.hitbox.x =
         (model->saucer.direction == DIR_RIGHT) ? -100 : GAME_AREA_WIDTH + 100;
     model->saucer.hitbox.y = 70;
@@ -718,6 +959,8 @@ void model_update(GameModel *model, float delta_time) {
           model->players[p].powerup_timer = 5.0f; // 5 seconds duration
           model->powerups[i].alive = false;
           model->needs_redraw = true;
+          model_emit(model, EVENT_POWERUP, p, model->powerups[i].hitbox.x,
+                     model->powerups[i].hitbox.y, model->powerups[i].type);
           break;
         }
       }
@@ -751,7 +994,7 @@ void model_update(GameModel *model, float delta_time) {
 void model_move_player(GameModel *model, int player_id, Direction dir) {
   if (player_id < 0 || player_id > 1 || !model->players[player_id].is_active)
     return;
-  float speed = 6.4f; // Pixels per frame at 60fps = 384 pixels/sec
+  float speed = PLAYER_SPEED * model_tick_dt(model); // Called once per tick
   Player *p = &model->players[player_id];
 
   if (dir == DIR_LEFT && p->hitbox.x > 0)
@@ -779,11 +1022,8 @@ void model_player_shoot(GameModel *model, int player_id) {
   bool is_strong = (p->active_powerup == PWR_STRONG_MISSILE);
 
   // Active bullet limit check
-  int active_bullets = 0;
-  for (int i = 0; i < PLAYER_BULLETS; i++) {
-    if (model->player_bullets[player_id][i].alive)
-      active_bullets++;
-  }
+  BulletPool *pool = &model->player_bullets[player_id];
+  int active_bullets = pool->live_count;
 
   // Strict 1 bullet limit unless powered up
   int max_allowed = 1;
@@ -796,36 +1036,41 @@ void model_player_shoot(GameModel *model, int player_id) {
   int shots = is_triple ? 3 : 1;
   int fired = 0;
 
-  for (int i = 0; i < PLAYER_BULLETS && fired < shots; i++) {
-    if (!model->player_bullets[player_id][i].alive) {
-      model->player_bullets[player_id][i].alive = true;
-      model->player_bullets[player_id][i].is_strong = is_strong;
-      model->player_bullets[player_id][i].hitbox.x =
-          p->hitbox.x + (PLAYER_WIDTH / 2) - (BULLET_WIDTH / 2);
-
-      if (is_triple) {
-        if (fired == 0)
-          model->player_bullets[player_id][i].speed_x = 0;
-        if (fired == 1) {
-          model->player_bullets[player_id][i].speed_x = -150;
-          model->player_bullets[player_id][i].hitbox.x -= 10;
-        }
-        if (fired == 2) {
-          model->player_bullets[player_id][i].speed_x = 150;
-          model->player_bullets[player_id][i].hitbox.x += 10;
-        }
-      } else {
-        model->player_bullets[player_id][i].speed_x = 0;
+  while (fired < shots) {
+    Bullet *b = bullet_pool_spawn(pool);
+    if (!b)
+      break;
+    b->is_player_bullet = true;
+    b->player_id = player_id;
+    b->is_strong = is_strong;
+    b->hitbox.width = BULLET_WIDTH;
+    b->hitbox.height = BULLET_HEIGHT;
+    b->hitbox.x = p->hitbox.x + (PLAYER_WIDTH / 2) - (BULLET_WIDTH / 2);
+
+    if (is_triple) {
+      if (fired == 0)
+        b->speed_x = 0;
+      if (fired == 1) {
+        b->speed_x = -150;
+        b->hitbox.x -= 10;
       }
-
-      model->player_bullets[player_id][i].hitbox.y = p->hitbox.y;
-      model->player_bullets[player_id][i].speed_y = -700.0f;
-      fired++;
+      if (fired == 2) {
+        b->speed_x = 150;
+        b->hitbox.x += 10;
+      }
+    } else {
+      b->speed_x = 0;
     }
+
+    b->hitbox.y = p->hitbox.y;
+    b->speed_y = -700.0f;
+    fired++;
   }
 
   if (fired > 0) {
     p->shots_fired++;
+    model_emit(model, EVENT_PLAYER_SHOT, player_id,
+               p->hitbox.x + p->hitbox.width / 2, p->hitbox.y, fired);
     p->shoot_timer = 0.09f; // 90ms cooldown (much faster)
   }
 }
@@ -851,27 +1096,38 @@ static int apply_difficulty_multiplier(GameModel *model, int base_score) {
 }
 
 void model_check_bullet_collisions(GameModel *model) {
+  TRACE_SCOPE("model_check_bullet_collisions");
+  PERF_SCOPE(PERF_PHASE_COLLISION);
+  // Invader candidates come from the formation lattice; enemy bullets use
+  // the broadphase grid below. Candidates are then tested in one batch.
+  CollisionGrid grid;
+  CollisionBatch batch;
+  uint16_t candidates[COLLISION_MAX_IDS];
+  uint32_t hits[COLLISION_MASK_WORDS(COLLISION_BATCH_MAX)];
+
   for (int p_idx = 0; p_idx < 2; p_idx++) {
     if (!model->players[p_idx].is_active)
       continue;
-    for (int b = 0; b < PLAYER_BULLETS; b++) {
-      Bullet *pb = &model->player_bullets[p_idx][b];
-      if (!pb->alive)
-        continue;
+    BulletPool *pool = &model->player_bullets[p_idx];
+    for (int k = pool->live_count - 1; k >= 0; k--) {
+      Bullet *pb = bullet_pool_at(pool, k);
 
       if (model->boss.alive &&
           model_check_collision(pb->hitbox, model->boss.hitbox)) {
         model->boss.health -= (pb->is_strong ? 5 : 1);
         model->needs_redraw = true; // Trigger HUD update
         if (!pb->is_strong)
-          pb->alive = false;
+          bullet_pool_release(pool, pb);
         model->players[p_idx].score += apply_difficulty_multiplier(model, 10);
         if (model->boss.health <= 0) {
           model->boss.alive = false;
           model->players[p_idx].score +=
               apply_difficulty_multiplier(model, 5000);
+          model_emit_kill(model, p_idx, ENTITY_BOSS, model->boss.hitbox,
+                          apply_difficulty_multiplier(model, 5000));
           model_drop_powerup(model, model->boss.hitbox.x, model->boss.hitbox.y);
           model_next_level(model);
+          return; // Pools were reset for the next level
         }
         continue;
       }
@@ -880,8 +1136,10 @@ void model_check_bullet_collisions(GameModel *model) {
           model_check_collision(pb->hitbox, model->saucer.hitbox)) {
         model->saucer.alive = false;
         if (!pb->is_strong)
-          pb->alive = false;
+          bullet_pool_release(pool, pb);
         model->players[p_idx].score += apply_difficulty_multiplier(model, 300);
+        model_emit_kill(model, p_idx, ENTITY_SAUCER, model->saucer.hitbox,
+                        apply_difficulty_multiplier(model, 300));
         model_drop_powerup(model, model->saucer.hitbox.x,
                            model->saucer.hitbox.y);
         continue;
@@ -895,71 +1153,123 @@ void model_check_bullet_collisions(GameModel *model) {
         bi->health -= (pb->is_strong ? 3 : 1);
         model->needs_redraw = true; // Trigger HUD update
         if (!pb->is_strong)
-          pb->alive = false;
+          bullet_pool_release(pool, pb);
         model->players[p_idx].score += apply_difficulty_multiplier(model, 15);
         if (bi->health <= 0) {
           bi->alive = false;
           model->players[p_idx].score +=
               apply_difficulty_multiplier(model, bi->points);
+          model_emit_kill(model, p_idx, ENTITY_BIG_INVADER, bi->hitbox,
+                          apply_difficulty_multiplier(model, bi->points));
           model_drop_powerup(model, bi->hitbox.x, bi->hitbox.y);
         }
         continue;
       }
 
-      for (int i = 0; i < INVADER_ROWS; i++) {
-        for (int j = 0; j < INVADER_COLS; j++) {
-          Invader *inv = &model->invaders.invaders[i][j];
-          if (inv->alive && inv->dying_timer == 0 &&
-              model_check_collision(pb->hitbox, inv->hitbox)) {
-            if (!pb->is_strong)
-              pb->alive = false;
-            inv->dying_timer = 5;
-            model->players[p_idx].score +=
-                apply_difficulty_multiplier(model, inv->points);
-            model->players[p_idx].combo_count++;
-            model->players[p_idx].last_kill_time = platform_get_ticks();
-            model->invaders.killed++;
-
-            model_drop_powerup(model, inv->hitbox.x, inv->hitbox.y);
-
-            if (model->invaders.killed >= INVADER_ROWS * INVADER_COLS)
-              model_next_level(model);
-            if (!pb->is_strong)
-              goto next_bullet;
+      int count =
+          formation_candidates(&model->invaders, pb->hitbox, candidates);
+      collision_batch_clear(&batch);
+      for (int c = 0; c < count; c++)
+        collision_batch_add(&batch,
+                            invader_grid_rect(&model->invaders,
+                                              formation_invader(&model->invaders,
+                                                                candidates[c])));
+      if (collision_batch_overlap(&batch, pb->hitbox, hits) == 0)
+        continue;
+
+      for (int c = 0; c < count; c++) {
+        Invader *inv = formation_invader(&model->invaders, candidates[c]);
+        Rect inv_rect = invader_grid_rect(&model->invaders, inv);
+        if (inv->alive && inv->dying_timer == 0 &&
+            collision_mask_test(hits, c)) {
+          if (!pb->is_strong)
+            bullet_pool_release(pool, pb);
+          inv->dying_timer = model_ticks(model, INVADER_EXPLOSION_TIME);
+          formation_kill(&model->invaders, inv->row, inv->col);
+          model->players[p_idx].score +=
+              apply_difficulty_multiplier(model, inv->points);
+          model_emit_kill(model, p_idx, ENTITY_INVADER, inv_rect,
+                          apply_difficulty_multiplier(model, inv->points));
+          model->players[p_idx].combo_count++;
+          model->players[p_idx].last_kill_time = model->sim_time;
+          model->invaders.killed++;
+
+          model_drop_powerup(model, inv_rect.x, inv_rect.y);
+
+          if (model->invaders.killed >= INVADER_ROWS * INVADER_COLS) {
+            model_next_level(model);
+            return; // Pools were reset for the next level
           }
+          if (!pb->is_strong)
+            break;
         }
       }
-    next_bullet:;
     }
   }
 
-  for (int b = 0; b < ENEMY_BULLETS; b++) {
-    if (!model->enemy_bullets[b].alive)
+  // Enemy bullets go in the grid by pool slot (BULLET_POOL_MAX fits in
+  // COLLISION_MAX_IDS) and each player queries it once
+  BulletPool *enemy_pool = &model->enemy_bullets;
+  int enemy_count = enemy_pool->live_count;
+  if (enemy_count == 0)
+    return;
+  // Releases reorder live[], so players scan a copy of it
+  uint16_t live_slots[BULLET_POOL_MAX];
+  memcpy(live_slots, enemy_pool->live, enemy_count * sizeof(*live_slots));
+  bool use_grid = enemy_count * 2 >= COLLISION_GRID_MIN_PAIRS;
+  if (use_grid) {
+    collision_grid_clear(&grid);
+    for (int k = 0; k < enemy_count; k++)
+      collision_grid_insert(&grid, enemy_pool->items[live_slots[k]].hitbox,
+                            live_slots[k]);
+  } else {
+    // Few enough to test them all: one batch shared by both players
+    collision_batch_clear(&batch);
+    for (int k = 0; k < enemy_count; k++)
+      collision_batch_add(&batch, enemy_pool->items[live_slots[k]].hitbox);
+  }
+
+  for (int p = 0; p < 2; p++) {
+    if (!model->players[p].is_active)
       continue;
-    for (int p = 0; p < 2; p++) {
-      if (model->players[p].is_active &&
-          model_check_collision(model->enemy_bullets[b].hitbox,
-                                model->players[p].hitbox)) {
-        model->enemy_bullets[b].alive = false;
+    const uint16_t *cand = live_slots;
+    int count = enemy_count;
+    if (use_grid) {
+      cand = candidates;
+      count = collision_grid_query(&grid, model->players[p].hitbox, candidates,
+                                   COLLISION_MAX_IDS);
+      collision_batch_clear(&batch);
+      for (int c = 0; c < count; c++)
+        collision_batch_add(&batch, enemy_pool->items[cand[c]].hitbox);
+    }
+    if (collision_batch_overlap(&batch, model->players[p].hitbox, hits) == 0)
+      continue;
+
+    for (int c = 0; c < count; c++) {
+      Bullet *eb = &enemy_pool->items[cand[c]];
+      if (collision_mask_test(hits, c)) {
+        bullet_pool_release(enemy_pool, eb);
         if (model->players[p].active_powerup == PWR_SHIELD) {
           model->players[p].active_powerup = PWR_NONE;
           model->players[p].powerup_timer = 0;
           model->players[p].invincibility_timer =
               2.0f; // Brief immunity after shield break
           model->needs_redraw = true;
+          model_emit(model, EVENT_PLAYER_HIT, p, eb->hitbox.x, eb->hitbox.y,
+                     model->players[p].lives);
         } else if (model->players[p].invincibility_timer <= 0) {
           model->players[p].lives--;
           model->players[p].invincibility_timer = 2.0f; // 2 seconds of immunity
           model->players[p].combo_count = 0;
+          model_emit(model, EVENT_PLAYER_HIT, p, eb->hitbox.x, eb->hitbox.y,
+                     model->players[p].lives);
 
           // Reposition player to center to avoid death loop in corner?
           // Optional: reset_player_pos(&model->players[p], p);
 
           if (model->players[0].lives <= 0 &&
-              (!model->two_player_mode || model->players[1].lives <= 0)) {
-            model->state = STATE_GAME_OVER;
-            model_save_high_score(model);
-          }
+              (!model->two_player_mode || model->players[1].lives <= 0))
+            model_game_over(model);
         }
       }
     }
@@ -967,26 +1277,40 @@ void model_check_bullet_collisions(GameModel *model) {
 }
 
 void model_check_player_invader_collision(GameModel *model) {
-  for (int i = 0; i < INVADER_ROWS; i++) {
-    for (int j = 0; j < INVADER_COLS; j++) {
-      Invader *inv = &model->invaders.invaders[i][j];
-      if (inv->alive) {
-        // 1. Check if ANY invader reaches the bottom (regardless of player position)
-        if (inv->hitbox.y + inv->hitbox.height >= SCREEN_HEIGHT - 50) {
-          model->state = STATE_GAME_OVER;
-          model_save_high_score(model);
-          return;
-        }
+  InvaderGrid *g = &model->invaders;
+  if (g->bottom_row >= 0) {
+    // 1. Check if ANY invader reaches the bottom (regardless of player position)
+    Rect low = invader_grid_rect(g, formation_row_sample(g, g->bottom_row));
+    if (low.y + low.height >= SCREEN_HEIGHT - 50) {
+      model_game_over(model);
+      return;
+    }
 
-        // 2. Check for actual AABB collision with each player
+    // 2. Check for actual AABB collision with each player, walking up from
+    // the lowest row until rows are entirely above both players
+    float player_top = SCREEN_HEIGHT;
+    for (int p = 0; p < 2; p++)
+      if (model->players[p].is_active &&
+          model->players[p].hitbox.y < player_top)
+        player_top = model->players[p].hitbox.y;
+
+    for (int i = g->bottom_row; i >= 0; i--) {
+      if (!g->row_mask[i])
+        continue;
+      Rect sample = invader_grid_rect(g, formation_row_sample(g, i));
+      if (sample.y + sample.height <= player_top)
+        break;
+      for (uint32_t bits = g->row_mask[i]; bits; bits &= bits - 1) {
+        Rect inv_rect = invader_grid_rect(g, &g->invaders[i][lowest_bit(bits)]);
         for (int p = 0; p < 2; p++) {
           if (model->players[p].is_active &&
-              model_check_collision(inv->hitbox, model->players[p].hitbox)) {
+              model_check_collision(inv_rect, model->players[p].hitbox)) {
+            if (model->players[p].lives > 0)
+              model_emit(model, EVENT_PLAYER_HIT, p, inv_rect.x, inv_rect.y, 0);
             model->players[p].lives = 0;
             if (model->players[0].lives <= 0 &&
                 (!model->two_player_mode || model->players[1].lives <= 0)) {
-              model->state = STATE_GAME_OVER;
-              model_save_high_score(model);
+              model_game_over(model);
               return;
             }
           }
@@ -1000,11 +1324,13 @@ void model_check_player_invader_collision(GameModel *model) {
     for (int p = 0; p < 2; p++) {
       if (model->players[p].is_active &&
           model_check_collision(model->boss.hitbox, model->players[p].hitbox)) {
+        if (model->players[p].lives > 0)
+          model_emit(model, EVENT_PLAYER_HIT, p, model->players[p].hitbox.x,
+                     model->players[p].hitbox.y, 0);
         model->players[p].lives = 0;
         if (model->players[0].lives <= 0 &&
             (!model->two_player_mode || model->players[1].lives <= 0)) {
-          model->state = STATE_GAME_OVER;
-          model_save_high_score(model);
+          model_game_over(model);
           return;
         }
       }
@@ -1012,6 +1338,15 @@ void model_check_player_invader_collision(GameModel *model) {
   }
 }
 
+void model_game_over(GameModel *model) {
+  // Several checks in one tick can each end the game: report it once
+  if (model->state == STATE_GAME_OVER)
+    return;
+  model->state = STATE_GAME_OVER;
+  model_save_high_score(model);
+  model_emit(model, EVENT_GAME_OVER, -1, 0, 0, model_get_score(model));
+}
+
 void model_set_state(GameModel *model, GameState state) {
   model->state = state;
 }
@@ -1025,6 +1360,8 @@ void model_save_high_score(GameModel *model) {
   int total = model->players[0].score + model->players[1].score;
   if (total > model->high_score) {
     model->high_score = total;
+    if (!model->config.persist_high_score)
+      return;
     FILE *f = fopen("highscore.dat", "wb");
     if (f) {
       fwrite(&model->high_score, 4, 1, f);
@@ -1033,6 +1370,8 @@ void model_save_high_score(GameModel *model) {
   }
 }
 void model_load_high_score(GameModel *model) {
+  if (!model->config.persist_high_score)
+    return;
   FILE *f = fopen("highscore.dat", "rb");
   if (f) {
     fread(&model->high_score, 4, 1, f);
@@ -1046,6 +1385,7 @@ int model_get_score(const GameModel *model) {
 int model_get_lives(const GameModel *model) { return model->players[0].lives; }
 int model_get_level(const GameModel *model) { return model->players[0].level; }
 GameState model_get_state(const GameModel *model) { return model->state; }
+uint32_t model_get_sim_time(const GameModel *model) { return model->sim_time; }
 void model_process_command(GameModel *model, int command, void *data) {
   (void)model;
   (void)command;
@@ -1053,7 +1393,7 @@ void model_process_command(GameModel *model, int command, void *data) {
 }
 
 int model_get_max_menu_items(const GameModel *model) {
-  switch (model->menu_state) {
+  switch (model->ui.menu_state) {
   case MENU_MAIN:
     return 4; // Start 1P, Start 2P, Settings, Quit
   case MENU_DIFFICULTY:
@@ -1069,56 +1409,56 @@ int model_get_max_menu_items(const GameModel *model) {
 
 void model_process_menu_input(GameModel *model, int direction) {
   // If waiting for key, don't process normal navigation
-  if (model->waiting_for_key)
+  if (model->ui.waiting_for_key)
     return;
 
   int max_items = model_get_max_menu_items(model);
   if (direction == -1) {
-    model->menu_selection--;
-    if (model->menu_selection < 0)
-      model->menu_selection = max_items - 1;
+    model->ui.menu_selection--;
+    if (model->ui.menu_selection < 0)
+      model->ui.menu_selection = max_items - 1;
   } else if (direction == 1) {
-    model->menu_selection++;
-    if (model->menu_selection >= max_items)
-      model->menu_selection = 0;
+    model->ui.menu_selection++;
+    if (model->ui.menu_selection >= max_items)
+      model->ui.menu_selection = 0;
   } else if (direction == 0) {
-    switch (model->menu_state) {
+    switch (model->ui.menu_state) {
     case MENU_MAIN:
-      if (model->menu_selection == 0) {
+      if (model->ui.menu_selection == 0) {
         model->two_player_mode = false;
-        model->menu_state = MENU_DIFFICULTY;
-      } else if (model->menu_selection == 1) {
+        model->ui.menu_state = MENU_DIFFICULTY;
+      } else if (model->ui.menu_selection == 1) {
         model->two_player_mode = true;
-        model->menu_state = MENU_DIFFICULTY;
-      } else if (model->menu_selection == 2) {
-        model->menu_state = MENU_SETTINGS;
-      } else if (model->menu_selection == 3) {
+        model->ui.menu_state = MENU_DIFFICULTY;
+      } else if (model->ui.menu_selection == 2) {
+        model->ui.menu_state = MENU_SETTINGS;
+      } else if (model->ui.menu_selection == 3) {
         model->state = STATE_QUIT;
       }
       break;
     case MENU_DIFFICULTY:
-      model->difficulty = (Difficulty)model->menu_selection;
+      model->difficulty = (Difficulty)model->ui.menu_selection;
       model_reset_game(model);
       model->state = STATE_PLAYING;
       break;
     case MENU_SETTINGS:
-      if (model->menu_selection == 0) {
-        model->menu_state = MENU_CONTROLS;
-        model->menu_selection = 0;
-      } else if (model->menu_selection == 1) { /* Volume handled by arrows */
-      } else if (model->menu_selection == 2) {
-        model->menu_state = MENU_MAIN;
-        model->menu_selection = 2;
+      if (model->ui.menu_selection == 0) {
+        model->ui.menu_state = MENU_CONTROLS;
+        model->ui.menu_selection = 0;
+      } else if (model->ui.menu_selection == 1) { /* Volume handled by arrows */
+      } else if (model->ui.menu_selection == 2) {
+        model->ui.menu_state = MENU_MAIN;
+        model->ui.menu_selection = 2;
       }
       break;
     case MENU_CONTROLS:
-      if (model->menu_selection == 10) {
-        model->menu_state = MENU_SETTINGS;
-        model->menu_selection = 0;
+      if (model->ui.menu_selection == 10) {
+        model->ui.menu_state = MENU_SETTINGS;
+        model->ui.menu_selection = 0;
       } else {
         // Start editing this keybind
-        model->editing_keybind = model->menu_selection;
-        model->waiting_for_key = true;
+        model->ui.editing_keybind = model->ui.menu_selection;
+        model->ui.waiting_for_key = true;
       }
       break;
     default:
@@ -1131,45 +1471,45 @@ void model_process_menu_input(GameModel *model, int direction) {
 void model_apply_difficulty(GameModel *model) { (void)model; }
 void model_adjust_music_volume(GameModel *model, int direction) {
   if (direction == -1)
-    model->music_volume = fmaxf(0.0f, model->music_volume - 0.1f);
+    model->ui.music_volume = fmaxf(0.0f, model->ui.music_volume - 0.1f);
   else if (direction == 1)
-    model->music_volume = fminf(1.0f, model->music_volume + 0.1f);
+    model->ui.music_volume = fminf(1.0f, model->ui.music_volume + 0.1f);
   model->needs_redraw = true;
 }
 
 void model_set_keybind(GameModel *model, int keycode) {
-  if (!model->waiting_for_key || model->editing_keybind < 0)
+  if (!model->ui.waiting_for_key || model->ui.editing_keybind < 0)
     return;
 
-  int idx = model->editing_keybind;
+  int idx = model->ui.editing_keybind;
   int old_key;
   // Get the old key currently assigned to the action we are editing
   if (idx < 5)
-    old_key = model->keybinds_p1[idx];
+    old_key = model->ui.keybinds_p1[idx];
   else
-    old_key = model->keybinds_p2[idx - 5];
+    old_key = model->ui.keybinds_p2[idx - 5];
 
   // Check for conflicts and SWAP
   // If another action uses the new key, give it our old key
   for (int i = 0; i < 5; i++) {
-    if (model->keybinds_p1[i] == keycode) {
-      model->keybinds_p1[i] = old_key;
+    if (model->ui.keybinds_p1[i] == keycode) {
+      model->ui.keybinds_p1[i] = old_key;
     }
   }
   for (int i = 0; i < 5; i++) {
-    if (model->keybinds_p2[i] == keycode) {
-      model->keybinds_p2[i] = old_key;
+    if (model->ui.keybinds_p2[i] == keycode) {
+      model->ui.keybinds_p2[i] = old_key;
     }
   }
 
   // Assign the new key
   if (idx < 5) {
-    model->keybinds_p1[idx] = keycode;
+    model->ui.keybinds_p1[idx] = keycode;
   } else if (idx < 10) {
-    model->keybinds_p2[idx - 5] = keycode;
+    model->ui.keybinds_p2[idx - 5] = keycode;
   }
 
-  model->waiting_for_key = false;
-  model->editing_keybind = -1;
+  model->ui.waiting_for_key = false;
+  model->ui.editing_keybind = -1;
   model->needs_redraw = true;
 }
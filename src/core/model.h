@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <time.h>
 
+#include "rng.h"
+
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
 #define GAME_AREA_WIDTH 600
@@ -18,10 +20,18 @@
 #define PLAYER_HEIGHT 20
 #define BULLET_WIDTH 5
 #define BULLET_HEIGHT 15
-#define PLAYER_BULLETS 20
-#define ENEMY_BULLETS 10
+#define PLAYER_BULLETS 20     // Default player pool capacity
+#define ENEMY_BULLETS 10      // Default enemy pool capacity
+#define BULLET_POOL_MAX 256   // Upper bound for a configured capacity
+#define INVADER_SPACING_X (INVADER_WIDTH + 15)  // Formation lattice pitch
+#define INVADER_SPACING_Y (INVADER_HEIGHT + 10)
+#define FORMATION_LEFT 20     // Lattice offset of invaders[0][0]
+#define FORMATION_TOP 80
 #define BIG_INVADER_WIDTH 60
 #define BIG_INVADER_HEIGHT 50
+#define MODEL_DEFAULT_SEED 0x853c49e6748fea9bULL
+#define SIM_TICK_RATE 60       // Default simulation ticks per second
+#define PLAYER_SPEED 384.0f    // Pixels per second
 
 // Directions
 typedef enum {
@@ -83,7 +93,9 @@ typedef enum {
   ENTITY_PLAYER,
   ENTITY_INVADER,
   ENTITY_SAUCER,
-  ENTITY_BULLET
+  ENTITY_BULLET,
+  ENTITY_BIG_INVADER,
+  ENTITY_BOSS
 } EntityType;
 
 typedef struct {
@@ -95,14 +107,14 @@ typedef struct {
 
 // Invader with animation and type support
 typedef struct {
-  Rect hitbox;
+  Rect offset;          // Hitbox relative to the formation origin
   ColorType color;
   bool alive;
   int points;
   int row;
   int col;
   int type;             // 0=Squid, 1=Crab, 2=Octopus, 3=Big Invader
-  int dying_timer;      // >0 means exploding
+  int dying_timer;      // >0 means exploding (ticks left)
   int health;           // For big invaders only
   float speed_modifier; // Individual speed for special invaders
 } Invader;
@@ -122,17 +134,55 @@ typedef struct {
 
 typedef struct {
   Invader invaders[INVADER_ROWS][INVADER_COLS];
+
+  // The formation marches as one: an invader's screen hitbox is its offset
+  // plus this origin (see invader_grid_rect). Offsets stay on the lattice
+  // except for invaders in custom_speed_mask, which drift by their extra
+  // speed.
+  float origin_x;
+  float origin_y;
+  uint16_t custom_speed_mask[INVADER_ROWS]; // Bit j: speed_modifier != 1
+  uint16_t dying_mask[INVADER_ROWS];        // Bit j: exploding
+
+  // Live formation (alive and not exploding) as bitmasks, set by
+  // init_invaders and cleared when an invader is hit.
+  uint16_t row_mask[INVADER_ROWS]; // Bit j: invaders[i][j] is live
+  uint8_t col_mask[INVADER_COLS];  // Bit i: invaders[i][j] is live
+  uint16_t live_cols;              // Bit j: column j has a live invader
+  uint8_t live_rows;               // Bit i: row i has a live invader
+  int left_col;   // Leftmost live column, -1 when the formation is empty
+  int right_col;  // Rightmost live column, -1 when empty
+  int bottom_row; // Lowest live row, -1 when empty
+
   Direction direction;
   float speed;
   int killed;
   int state; // 0 or 1 for animation frame
-  uint32_t state_time;
+  uint32_t state_time; // Simulated ms of the last animation toggle
   int state_speed;
   int shoot_chance;
   BigInvader big_invader; // Special big slow enemy
   float big_invader_spawn_timer;
 } InvaderGrid;
 
+// Screen-space hitbox of a formation invader
+static inline Rect invader_grid_rect(const InvaderGrid *grid,
+                                     const Invader *inv) {
+  Rect r = inv->offset;
+  r.x += grid->origin_x;
+  r.y += grid->origin_y;
+  return r;
+}
+
+// Gives one invader its own horizontal speed (1.0 = march with the
+// formation). Such invaders are tracked individually.
+void invader_grid_set_speed_modifier(InvaderGrid *grid, int row, int col,
+                                     float modifier);
+
+// Recomputes every mask and extent of the grid from its invaders' alive,
+// dying_timer and speed_modifier fields.
+void invader_grid_rebuild_masks(InvaderGrid *grid);
+
 // Boss Structure
 typedef struct {
   Rect hitbox;
@@ -142,9 +192,9 @@ typedef struct {
   Direction direction;
   float speed_x;
   float speed_y;
-  int shoot_timer;
+  int shoot_timer;     // Ticks since last volley
   int anim_frame;     // Animation frame (0 or 1)
-  int anim_counter;   // Counter for animation timing
+  int anim_counter;   // Ticks since last animation frame
   int attack_pattern; // 0=Horizontal, 1=Circular
   float attack_timer;
 } Boss;
@@ -167,6 +217,19 @@ typedef struct {
   int type; // 0=Standard, 1=ZigZag, 2=Laser
 } Bullet;
 
+// Fixed-storage bullet pool. Free slots are kept on a stack and live slots in
+// a dense list, so spawn/release are O(1) and updates only visit live
+// bullets. Live order changes on release (swap-remove).
+typedef struct {
+  Bullet items[BULLET_POOL_MAX];
+  uint16_t free_slots[BULLET_POOL_MAX]; // Stack of unused item indices
+  uint16_t live[BULLET_POOL_MAX];       // Item indices of live bullets
+  uint16_t live_index[BULLET_POOL_MAX]; // Position of each item in live[]
+  int capacity;
+  int free_count;
+  int live_count;
+} BulletPool;
+
 typedef struct {
   Rect hitbox;
   PowerUpType type;
@@ -181,7 +244,7 @@ typedef struct {
   int level;
   unsigned int shots_fired;
   int combo_count;
-  uint32_t last_kill_time;
+  uint32_t last_kill_time; // Simulated ms, see GameModel.sim_time
   bool is_active;
   int player_id;
 
@@ -196,20 +259,76 @@ typedef struct {
   float shoot_timer;
 } Player;
 
+// Gameplay events, appended by the model as they happen so views, audio and
+// telemetry can react without diffing state between frames
+typedef enum {
+  EVENT_PLAYER_SHOT, // player_id fired from (x, y), value = bullet count
+  EVENT_ENEMY_SHOT,  // Enemy fired from (x, y), value = bullet type
+  EVENT_KILL,        // player_id destroyed `entity`, value = points
+  EVENT_PLAYER_HIT,  // player_id was hit, value = lives left
+  EVENT_POWERUP,     // player_id collected PowerUpType `value`
+  EVENT_LEVEL_UP,    // value = new level
+  EVENT_GAME_OVER,   // value = final score
+  EVENT_WIN          // value = final score
+} GameEventType;
+
+typedef struct {
+  uint32_t time;    // sim_time when emitted
+  uint8_t type;     // GameEventType
+  int8_t player_id; // -1 when no player is involved
+  uint8_t entity;   // EntityType for EVENT_KILL
+  int32_t value;
+  float x;
+  float y;
+} GameEvent;
+
+// Ring of the most recent events. `head` counts every event ever emitted;
+// each consumer keeps its own cursor (see model_next_event).
+#define GAME_EVENT_CAPACITY 256 // Power of two
+typedef struct {
+  GameEvent events[GAME_EVENT_CAPACITY];
+  uint32_t head;
+  // While set, nothing is emitted: rollback re-simulates ticks whose events
+  // were already delivered
+  bool muted;
+} GameEventRing;
+
+// Menu, settings and keybinding state, kept apart from gameplay so that
+// snapshots and resets leave it alone
+typedef struct {
+  MenuState menu_state;
+  int menu_selection; // Current selected menu item
+  float music_volume; // 0.0 to 1.0
+
+  // Keybindings (key codes) - P1: left, right, up, down, shoot; P2: same
+  int keybinds_p1[5]; // left, right, up, down, shoot
+  int keybinds_p2[5];
+  int editing_keybind; // -1 = not editing, 0-4 = P1, 5-9 = P2
+  bool waiting_for_key;
+} UiState;
+
+// Construction-time options, preserved across model_reset_game
+typedef struct {
+  bool persist_high_score; // Read/write highscore.dat (off for simulations)
+  uint64_t seed;           // Seed of the first game's random stream
+  int tick_rate;           // Ticks per second model_update is called at
+  int player_bullet_capacity; // Per player, at most BULLET_POOL_MAX
+  int enemy_bullet_capacity;  // At most BULLET_POOL_MAX
+} ModelConfig;
+
 // The Complete Game Model
 typedef struct {
+  ModelConfig config;
+
   Player players[2];
   InvaderGrid invaders;
   Boss boss;
   Saucer saucer;
-  Bullet player_bullets[2][PLAYER_BULLETS];
-  Bullet enemy_bullets[ENEMY_BULLETS];
+  BulletPool player_bullets[2];
+  BulletPool enemy_bullets;
   PowerUp powerups[10];
   GameState state;
   Difficulty difficulty;
-  MenuState menu_state;
-  int menu_selection; // Current selected menu item
-  float music_volume; // 0.0 to 1.0
   uint32_t game_time;
   bool needs_redraw;
   int high_score;
@@ -217,19 +336,37 @@ typedef struct {
   uint32_t last_update_time;
   float win_timer; // Timer for auto-return to menu after win
 
-  // Keybindings (key codes) - P1: left, right, up, down, shoot; P2: same
-  int keybinds_p1[5]; // left, right, up, down, shoot
-  int keybinds_p2[5];
-  int editing_keybind; // -1 = not editing, 0-4 = P1, 5-9 = P2
-  bool waiting_for_key;
+  // Simulated clock: milliseconds of STATE_PLAYING accumulated from the
+  // delta_time passed to model_update. The model never reads wall time.
+  uint32_t sim_time;
+  float sim_time_carry; // Sub-millisecond remainder
+
+  // Event stream, kept across model_reset_game so cursors stay valid
+  GameEventRing events;
+
+  // Gameplay randomness: same seed + same inputs = same game
+  Rng rng;
+  uint64_t seed; // Seed the current game started from
+
+  // Menus and settings; not part of the simulation (see model_snapshot)
+  UiState ui;
 } GameModel;
 
 // Initialization
+ModelConfig model_default_config(void);
 void model_init(GameModel *model);
+void model_init_with_config(GameModel *model, const ModelConfig *config);
 void model_reset_game(GameModel *model);
+// Same as model_reset_game with an explicit seed for the game's random
+// stream (replays restart recorded games this way)
+void model_start_game(GameModel *model, uint64_t seed);
+void model_seed(GameModel *model, uint64_t seed);
 void model_next_level(GameModel *model);
 
 // Updates
+// Called once per simulation tick with delta_time = 1 / config.tick_rate.
+// Per-tick actions (movement, tick counters) are scaled by the tick rate so
+// gameplay speed does not depend on it.
 void model_update(GameModel *model, float delta_time);
 void model_process_command(GameModel *model, int command, void *data);
 
@@ -241,6 +378,23 @@ void model_update_bullets(GameModel *model, float delta_time);
 void model_update_saucer(GameModel *model, float delta_time);
 void model_update_boss(GameModel *model, float delta_time);
 
+// Bullet pools
+void bullet_pool_init(BulletPool *pool, int capacity);
+Bullet *bullet_pool_spawn(BulletPool *pool); // NULL when full
+void bullet_pool_release(BulletPool *pool, Bullet *bullet);
+
+// k-th live bullet, 0 <= k < live_count
+static inline Bullet *bullet_pool_at(BulletPool *pool, int k) {
+  return &pool->items[pool->live[k]];
+}
+
+// Events
+// Returns the next event after *cursor and advances it, or NULL when the
+// consumer is caught up. A consumer more than GAME_EVENT_CAPACITY events
+// behind skips ahead to the oldest one still stored.
+const GameEvent *model_next_event(const GameModel *model, uint32_t *cursor);
+uint32_t model_event_head(const GameModel *model);
+
 // Collisions
 bool model_check_collision(Rect a, Rect b);
 void model_check_bullet_collisions(GameModel *model);
@@ -248,6 +402,7 @@ void model_check_player_invader_collision(GameModel *model);
 
 // State Management
 void model_set_state(GameModel *model, GameState state);
+void model_game_over(GameModel *model);
 void model_toggle_pause(GameModel *model);
 void model_save_high_score(GameModel *model);
 void model_load_high_score(GameModel *model);
@@ -257,6 +412,7 @@ int model_get_score(const GameModel *model);
 int model_get_lives(const GameModel *model);
 int model_get_level(const GameModel *model);
 GameState model_get_state(const GameModel *model);
+uint32_t model_get_sim_time(const GameModel *model);
 
 // Menu and Difficulty
 void model_process_menu_input(GameModel *model,
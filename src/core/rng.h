@@ -0,0 +1,40 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// PCG32 (O'Neill, pcg-random.org): 64-bit state, 32-bit output.
+// Each GameModel owns one so simulations are reproducible from a seed and
+// independent of libc's shared rand() state.
+typedef struct {
+  uint64_t state;
+  uint64_t inc; // Stream selector, always odd
+} Rng;
+
+static inline uint32_t rng_next(Rng *rng) {
+  uint64_t old = rng->state;
+  rng->state = old * 6364136223846793005ULL + rng->inc;
+  uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+  uint32_t rot = (uint32_t)(old >> 59u);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+static inline void rng_seed(Rng *rng, uint64_t seed, uint64_t stream) {
+  rng->state = 0u;
+  rng->inc = (stream << 1u) | 1u;
+  rng_next(rng);
+  rng->state += seed;
+  rng_next(rng);
+}
+
+static inline uint64_t rng_next64(Rng *rng) {
+  uint64_t hi = rng_next(rng);
+  return (hi << 32) | rng_next(rng);
+}
+
+// Uniform-ish int in [0, n), same contract as the old `rand() % n`
+static inline int rng_range(Rng *rng, int n) {
+  return (int)(rng_next(rng) % (uint32_t)n);
+}
+
+#endif // RNG_H
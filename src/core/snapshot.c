@@ -0,0 +1,357 @@
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Slot indices are stored in one byte
+_Static_assert(BULLET_POOL_MAX <= 256, "pool slots must fit in a byte");
+
+// One walk over the state serves both directions: when writing, fields are
+// copied into the image; when reading, out of it. Keeping a single field
+// list means the two can never disagree on the layout. The same walk also
+// hashes the state without building an image.
+//
+// The walk is forced inline into each entry point so each gets its own
+// straight-line copy; left to itself the compiler keeps it out of line and
+// pays a call and a variable-length memcpy per field.
+#define SNAP_INLINE static inline __attribute__((always_inline))
+
+typedef struct {
+  uint8_t *p;
+  const uint8_t *end;
+  bool reading;
+  bool ok;
+  bool hashing;
+  uint32_t hashed; // Fields hashed so far
+  uint64_t lanes[4];
+} SnapIo;
+
+#define STATE_HASH_SEED 0xcbf29ce484222325ull  // FNV-1a offset basis
+#define STATE_HASH_PRIME 0x100000001b3ull      // FNV-1a prime
+
+// FNV-1a over whole fields (up to 8 bytes at a time) instead of single
+// bytes, dealt round-robin to four lanes so consecutive multiplies do not
+// wait on each other. Each step is a bijection of its lane, so a change to
+// any one field always changes the result.
+SNAP_INLINE void io_hash(SnapIo *io, const void *field, size_t n) {
+  const uint8_t *src = field;
+  while (n > 0) {
+    size_t chunk = n < 8 ? n : 8;
+    uint64_t v = 0;
+    memcpy(&v, src, chunk);
+    uint64_t *lane = &io->lanes[io->hashed++ & 3];
+    *lane = (*lane ^ v) * STATE_HASH_PRIME;
+    src += chunk;
+    n -= chunk;
+  }
+}
+
+SNAP_INLINE void io_bytes(SnapIo *io, void *field, size_t n) {
+  if (io->hashing) {
+    io_hash(io, field, n);
+    return;
+  }
+  if (!io->ok || (size_t)(io->end - io->p) < n) {
+    io->ok = false;
+    return;
+  }
+  if (io->reading)
+    memcpy(field, io->p, n);
+  else
+    memcpy(io->p, field, n);
+  io->p += n;
+}
+
+// Field stored at its own width
+#define IO(io, field) io_bytes((io), &(field), sizeof(field))
+
+// Field stored as type T (enums, bools and small counters)
+#define IO_AS(io, field, T)                                                    \
+  do {                                                                         \
+    T v_ = (T)(field);                                                         \
+    io_bytes((io), &v_, sizeof(v_));                                           \
+    if ((io)->reading)                                                         \
+      (field) = (__typeof__(field))v_;                                         \
+  } while (0)
+
+SNAP_INLINE void io_rect(SnapIo *io, Rect *r) {
+  IO(io, r->x);
+  IO(io, r->y);
+  IO(io, r->width);
+  IO(io, r->height);
+}
+
+SNAP_INLINE void io_player(SnapIo *io, Player *p) {
+  io_rect(io, &p->hitbox);
+  IO(io, p->lives);
+  IO(io, p->score);
+  IO(io, p->level);
+  IO(io, p->shots_fired);
+  IO(io, p->combo_count);
+  IO(io, p->last_kill_time);
+  IO_AS(io, p->is_active, uint8_t);
+  IO_AS(io, p->active_powerup, uint8_t);
+  IO(io, p->powerup_timer);
+  IO(io, p->invincibility_timer);
+  IO(io, p->shoot_timer);
+}
+
+SNAP_INLINE void io_invader(SnapIo *io, Invader *inv) {
+  io_rect(io, &inv->offset);
+  IO_AS(io, inv->color, uint8_t);
+  IO_AS(io, inv->alive, uint8_t);
+  IO_AS(io, inv->type, uint8_t);
+  IO(io, inv->points);
+  IO(io, inv->dying_timer);
+  IO(io, inv->health);
+  IO(io, inv->speed_modifier);
+}
+
+SNAP_INLINE void io_big_invader(SnapIo *io, BigInvader *bi) {
+  io_rect(io, &bi->hitbox);
+  IO_AS(io, bi->alive, uint8_t);
+  IO(io, bi->health);
+  IO(io, bi->max_health);
+  IO(io, bi->points);
+  IO_AS(io, bi->direction, uint8_t);
+  IO(io, bi->speed);
+  IO(io, bi->shoot_timer);
+  IO_AS(io, bi->attack_type, uint8_t);
+}
+
+// The masks and extents of an image restate its invaders. They are rebuilt
+// from the invaders and must match: a stray bit or extent would index past
+// the grid.
+static void check_grid_masks(SnapIo *io, InvaderGrid *g) {
+  uint16_t custom[INVADER_ROWS], dying[INVADER_ROWS], rows[INVADER_ROWS];
+  uint8_t cols[INVADER_COLS];
+  memcpy(custom, g->custom_speed_mask, sizeof(custom));
+  memcpy(dying, g->dying_mask, sizeof(dying));
+  memcpy(rows, g->row_mask, sizeof(rows));
+  memcpy(cols, g->col_mask, sizeof(cols));
+  uint16_t live_cols = g->live_cols;
+  uint8_t live_rows = g->live_rows;
+  int left_col = g->left_col, right_col = g->right_col;
+  int bottom_row = g->bottom_row;
+
+  invader_grid_rebuild_masks(g);
+  if (memcmp(custom, g->custom_speed_mask, sizeof(custom)) ||
+      memcmp(dying, g->dying_mask, sizeof(dying)) ||
+      memcmp(rows, g->row_mask, sizeof(rows)) ||
+      memcmp(cols, g->col_mask, sizeof(cols)) || live_cols != g->live_cols ||
+      live_rows != g->live_rows || left_col != g->left_col ||
+      right_col != g->right_col || bottom_row != g->bottom_row)
+    io->ok = false;
+}
+
+SNAP_INLINE void io_invader_grid(SnapIo *io, InvaderGrid *g) {
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    for (int j = 0; j < INVADER_COLS; j++) {
+      io_invader(io, &g->invaders[i][j]);
+      if (io->reading) {
+        g->invaders[i][j].row = i;
+        g->invaders[i][j].col = j;
+      }
+    }
+  }
+  IO(io, g->origin_x);
+  IO(io, g->origin_y);
+  IO(io, g->custom_speed_mask);
+  IO(io, g->dying_mask);
+  IO(io, g->row_mask);
+  IO(io, g->col_mask);
+  IO(io, g->live_cols);
+  IO(io, g->live_rows);
+  IO_AS(io, g->left_col, int8_t);
+  IO_AS(io, g->right_col, int8_t);
+  IO_AS(io, g->bottom_row, int8_t);
+  if (io->reading && io->ok)
+    check_grid_masks(io, g);
+  IO_AS(io, g->direction, uint8_t);
+  IO(io, g->speed);
+  IO(io, g->killed);
+  IO_AS(io, g->state, uint8_t);
+  IO(io, g->state_time);
+  IO(io, g->state_speed);
+  IO(io, g->shoot_chance);
+  io_big_invader(io, &g->big_invader);
+  IO(io, g->big_invader_spawn_timer);
+}
+
+SNAP_INLINE void io_boss(SnapIo *io, Boss *b) {
+  io_rect(io, &b->hitbox);
+  IO_AS(io, b->alive, uint8_t);
+  IO(io, b->health);
+  IO(io, b->max_health);
+  IO_AS(io, b->direction, uint8_t);
+  IO(io, b->speed_x);
+  IO(io, b->speed_y);
+  IO(io, b->shoot_timer);
+  IO_AS(io, b->anim_frame, uint8_t);
+  IO(io, b->anim_counter);
+  IO_AS(io, b->attack_pattern, uint8_t);
+  IO(io, b->attack_timer);
+}
+
+SNAP_INLINE void io_saucer(SnapIo *io, Saucer *s) {
+  io_rect(io, &s->hitbox);
+  IO_AS(io, s->alive, uint8_t);
+  IO_AS(io, s->direction, uint8_t);
+  IO(io, s->points);
+}
+
+SNAP_INLINE void io_powerup(SnapIo *io, PowerUp *pu) {
+  io_rect(io, &pu->hitbox);
+  IO_AS(io, pu->type, uint8_t);
+  IO(io, pu->speed_y);
+  IO_AS(io, pu->alive, uint8_t);
+}
+
+// MODEL_SNAPSHOT_BULLET_SIZE bytes
+SNAP_INLINE void io_bullet(SnapIo *io, Bullet *b) {
+  io_rect(io, &b->hitbox);
+  IO(io, b->speed_x);
+  IO(io, b->speed_y);
+  IO_AS(io, b->is_player_bullet, uint8_t);
+  IO_AS(io, b->is_strong, uint8_t);
+  IO_AS(io, b->player_id, int8_t);
+  IO_AS(io, b->type, uint8_t);
+}
+
+// Pools are stored as their live list, then the free stack, then the live
+// bullets. Both slot orders are kept since they decide which slot the next
+// spawn takes and the order collisions are resolved in.
+SNAP_INLINE void io_bullet_pool(SnapIo *io, BulletPool *pool) {
+  IO_AS(io, pool->capacity, uint16_t);
+  IO_AS(io, pool->live_count, uint16_t);
+  if (io->reading) {
+    if (pool->capacity < 1 || pool->capacity > BULLET_POOL_MAX ||
+        pool->live_count > pool->capacity) {
+      io->ok = false;
+      return;
+    }
+    pool->free_count = pool->capacity - pool->live_count;
+  }
+  for (int k = 0; k < pool->live_count; k++)
+    IO_AS(io, pool->live[k], uint8_t);
+  for (int k = 0; k < pool->free_count; k++)
+    IO_AS(io, pool->free_slots[k], uint8_t);
+
+  if (io->reading) {
+    // Every slot below capacity must appear exactly once
+    uint32_t seen[BULLET_POOL_MAX / 32] = {0};
+    for (int k = 0; k < pool->capacity; k++) {
+      uint16_t slot = k < pool->live_count
+                          ? pool->live[k]
+                          : pool->free_slots[k - pool->live_count];
+      if (slot >= pool->capacity || (seen[slot >> 5] >> (slot & 31)) & 1u) {
+        io->ok = false;
+        return;
+      }
+      seen[slot >> 5] |= 1u << (slot & 31);
+    }
+    for (int k = 0; k < pool->free_count; k++)
+      pool->items[pool->free_slots[k]].alive = false;
+  }
+
+  for (int k = 0; k < pool->live_count; k++) {
+    Bullet *b = &pool->items[pool->live[k]];
+    io_bullet(io, b);
+    if (io->reading) {
+      b->alive = true;
+      pool->live_index[pool->live[k]] = (uint16_t)k;
+    }
+  }
+}
+
+SNAP_INLINE void io_model(SnapIo *io, GameModel *m) {
+  // config.seed only picks the session's first game, which m->seed and the
+  // generator state already pin down
+  IO_AS(io, m->config.tick_rate, uint16_t);
+  IO_AS(io, m->config.player_bullet_capacity, uint16_t);
+  IO_AS(io, m->config.enemy_bullet_capacity, uint16_t);
+
+  IO_AS(io, m->state, uint8_t);
+  IO_AS(io, m->difficulty, uint8_t);
+  IO_AS(io, m->two_player_mode, uint8_t);
+  IO(io, m->high_score);
+  IO(io, m->win_timer);
+  IO(io, m->sim_time);
+  IO(io, m->sim_time_carry);
+  IO(io, m->rng.state);
+  IO(io, m->rng.inc);
+  IO(io, m->seed);
+
+  for (int p = 0; p < 2; p++) {
+    io_player(io, &m->players[p]);
+    if (io->reading)
+      m->players[p].player_id = p;
+  }
+  io_invader_grid(io, &m->invaders);
+  io_boss(io, &m->boss);
+  io_saucer(io, &m->saucer);
+  for (int i = 0; i < 10; i++)
+    io_powerup(io, &m->powerups[i]);
+  for (int p = 0; p < 2; p++)
+    io_bullet_pool(io, &m->player_bullets[p]);
+  io_bullet_pool(io, &m->enemy_bullets);
+}
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t size; // Whole image, header included
+} SnapshotHeader;
+
+size_t model_snapshot(const GameModel *model, void *buf) {
+  uint8_t *out = buf;
+  // Writing only reads the model; the walk is shared with model_restore
+  SnapIo io = {out + sizeof(SnapshotHeader), out + MODEL_SNAPSHOT_MAX_SIZE,
+               false, true, false, 0, {0}};
+  io_model(&io, (GameModel *)model);
+
+  SnapshotHeader header = {MODEL_SNAPSHOT_MAGIC, MODEL_SNAPSHOT_VERSION, 0,
+                           (uint32_t)(io.p - out)};
+  memcpy(out, &header, sizeof(header));
+  return header.size;
+}
+
+bool model_restore(GameModel *model, const void *buf, size_t size) {
+  SnapshotHeader header;
+  if (size < sizeof(header)) {
+    fprintf(stderr, "Snapshot truncated\n");
+    return false;
+  }
+  memcpy(&header, buf, sizeof(header));
+  if (header.magic != MODEL_SNAPSHOT_MAGIC ||
+      header.version != MODEL_SNAPSHOT_VERSION || header.size != size) {
+    fprintf(stderr, "Not a version %d snapshot\n", MODEL_SNAPSHOT_VERSION);
+    return false;
+  }
+
+  // Decoded aside, so a rejected image leaves the model as it was. The copy
+  // also carries over the host's fields, which images do not hold.
+  GameModel scratch = *model;
+  SnapIo io = {(uint8_t *)buf + sizeof(header), (const uint8_t *)buf + size,
+               true, true, false, 0, {0}};
+  io_model(&io, &scratch);
+  if (!io.ok || io.p != (const uint8_t *)buf + size) {
+    fprintf(stderr, "Corrupt snapshot\n");
+    return false;
+  }
+  *model = scratch;
+  model->needs_redraw = true;
+  return true;
+}
+
+uint64_t model_state_hash(const GameModel *model) {
+  SnapIo io = {NULL, NULL, false, true, true, 0,
+               {STATE_HASH_SEED, STATE_HASH_SEED + 1, STATE_HASH_SEED + 2,
+                STATE_HASH_SEED + 3}};
+  io_model(&io, (GameModel *)model);
+  uint64_t hash = STATE_HASH_SEED;
+  for (int i = 0; i < 4; i++)
+    hash = (hash ^ io.lanes[i]) * STATE_HASH_PRIME;
+  return hash;
+}
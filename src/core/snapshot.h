@@ -0,0 +1,40 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model.h"
+
+// Compact binary image of the simulation state of a GameModel: everything
+// model_update reads, field by field with narrow integer types, and only the
+// live bullets of each pool. UI state (GameModel.ui), the event ring,
+// config.seed and config.persist_high_score belong to the host and are
+// neither saved nor overwritten. Images hold no pointers and use host byte
+// order.
+#define MODEL_SNAPSHOT_MAGIC 0x4e534953u // "SISN"
+#define MODEL_SNAPSHOT_VERSION 2
+
+// Bytes per live bullet in an image
+#define MODEL_SNAPSHOT_BULLET_SIZE 28
+// Upper bound on an image: fixed state plus three full pools, each slot
+// listed once (1 byte) and live ones stored in full
+#define MODEL_SNAPSHOT_MAX_SIZE                                                \
+  (4096 + 3 * BULLET_POOL_MAX * (1 + MODEL_SNAPSHOT_BULLET_SIZE))
+
+// Writes the image of `model` to `buf` (MODEL_SNAPSHOT_MAX_SIZE bytes) and
+// returns its size.
+size_t model_snapshot(const GameModel *model, void *buf);
+
+// Loads an image written by model_snapshot into an initialised model.
+// Returns false, leaving the model untouched, if the image is truncated,
+// from another version or inconsistent.
+bool model_restore(GameModel *model, const void *buf, size_t size);
+
+// 64-bit hash of the state an image would hold, computed field by field
+// without building one. Two models with equal images hash the same; used to
+// find the first tick where two runs of the same inputs diverge.
+uint64_t model_state_hash(const GameModel *model);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,217 @@
+#include "raster.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+  uint8_t *planes[RASTER_PLANES];
+  uint8_t values[RASTER_PLANES];
+  int width;
+  int height;
+  float sx;
+  float sy;
+} Canvas;
+
+typedef struct {
+  int x0, x1, y0, y1; // Half-open pixel ranges, clamped to the canvas
+} Span;
+
+// floorf/ceilf are libm calls without SSE4.1, and spans are converted by
+// the hundred per image. Truncation only differs from floor below zero,
+// where spans are clamped to 0 anyway.
+static inline int span_floor(float v) { return (int)v; }
+
+static inline int span_ceil(float v) {
+  int i = (int)v;
+  return i + (i < v);
+}
+
+// Pixels [floor(lo * scale), ceil(hi * scale)) clamped to [0, size)
+static inline bool axis_span(float lo, float hi, float scale, int size,
+                             int *a, int *b) {
+  *a = span_floor(lo * scale);
+  *b = span_ceil(hi * scale);
+  if (*a < 0)
+    *a = 0;
+  if (*b > size)
+    *b = size;
+  return *a < *b;
+}
+
+static bool rect_span(const Canvas *c, Rect r, Span *s) {
+  if (r.width <= 0 || r.height <= 0)
+    return false;
+  return axis_span(r.x, r.x + r.width, c->sx, c->width, &s->x0, &s->x1) &&
+         axis_span(r.y, r.y + r.height, c->sy, c->height, &s->y0, &s->y1);
+}
+
+// Unclamped column spans of n rects given by their edges, four at a time
+static void column_spans(float sx, const float *left, const float *right,
+                         int n, int *x0, int *x1) {
+  int k = 0;
+#ifdef __SSE2__
+  __m128 scale = _mm_set1_ps(sx);
+  for (; k + 4 <= n; k += 4) {
+    __m128 l = _mm_mul_ps(_mm_loadu_ps(left + k), scale);
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(right + k), scale);
+    __m128i ceil = _mm_cvttps_epi32(r);
+    // The comparison is all ones (-1) where truncation rounded down
+    __m128 below = _mm_cmplt_ps(_mm_cvtepi32_ps(ceil), r);
+    ceil = _mm_sub_epi32(ceil, _mm_castps_si128(below));
+    _mm_storeu_si128((__m128i *)(x0 + k), _mm_cvttps_epi32(l));
+    _mm_storeu_si128((__m128i *)(x1 + k), ceil);
+  }
+#endif
+  for (; k < n; k++) {
+    x0[k] = span_floor(left[k] * sx);
+    x1[k] = span_ceil(right[k] * sx);
+  }
+}
+
+// --- Row primitives: dst = max(dst, value), 16 pixels at a time ---
+
+static void max_fill(uint8_t *dst, int n, uint8_t value) {
+  int i = 0;
+#ifdef __SSE2__
+  __m128i v = _mm_set1_epi8((char)value);
+  for (; i + 16 <= n; i += 16) {
+    __m128i *p = (__m128i *)(dst + i);
+    _mm_storeu_si128(p, _mm_max_epu8(_mm_loadu_si128(p), v));
+  }
+#endif
+  for (; i < n; i++)
+    if (dst[i] < value)
+      dst[i] = value;
+}
+
+static void max_copy(uint8_t *dst, const uint8_t *src, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 16 <= n; i += 16) {
+    __m128i *p = (__m128i *)(dst + i);
+    __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm_storeu_si128(p, _mm_max_epu8(_mm_loadu_si128(p), s));
+  }
+#endif
+  for (; i < n; i++)
+    if (dst[i] < src[i])
+      dst[i] = src[i];
+}
+
+static void fill_rect(const Canvas *c, RasterPlane plane, Rect r) {
+  Span s;
+  if (!rect_span(c, r, &s))
+    return;
+  uint8_t *row = c->planes[plane] + (size_t)s.y0 * c->width + s.x0;
+  for (int y = s.y0; y < s.y1; y++, row += c->width)
+    max_fill(row, s.x1 - s.x0, c->values[plane]);
+}
+
+static void fill_bullets(const Canvas *c, RasterPlane plane,
+                         const BulletPool *pool) {
+  for (int k = 0; k < pool->live_count; k++)
+    fill_rect(c, plane, pool->items[pool->live[k]].hitbox);
+}
+
+// Every invader of a formation row shares its y offset and height (the
+// model relies on it too), so the row is rasterized once into a pattern and
+// blended into each pixel row it covers
+static void fill_formation(const Canvas *c, const InvaderGrid *g) {
+  uint8_t pattern[RASTER_MAX_SIZE];
+  float left[INVADER_COLS], right[INVADER_COLS];
+  int x0[INVADER_COLS], x1[INVADER_COLS];
+  uint8_t value = c->values[RASTER_PLANE_INVADERS];
+  uint8_t *plane = c->planes[RASTER_PLANE_INVADERS];
+
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    uint32_t live = g->row_mask[i];
+    if (!live)
+      continue;
+    Rect first = invader_grid_rect(g, &g->invaders[i][__builtin_ctz(live)]);
+    int y0, y1;
+    if (first.height <= 0 ||
+        !axis_span(first.y, first.y + first.height, c->sy, c->height, &y0,
+                   &y1))
+      continue;
+
+    int n = 0;
+    for (uint32_t bits = live; bits; bits &= bits - 1) {
+      const Invader *inv = &g->invaders[i][__builtin_ctz(bits)];
+      if (inv->offset.width <= 0)
+        continue;
+      left[n] = g->origin_x + inv->offset.x;
+      right[n] = left[n] + inv->offset.width;
+      n++;
+    }
+    column_spans(c->sx, left, right, n, x0, x1);
+
+    memset(pattern, 0, (size_t)c->width);
+    int lo = c->width, hi = 0;
+    for (int k = 0; k < n; k++) {
+      int a = x0[k] < 0 ? 0 : x0[k];
+      int b = x1[k] > c->width ? c->width : x1[k];
+      if (a >= b)
+        continue;
+      memset(pattern + a, value, (size_t)(b - a));
+      if (a < lo)
+        lo = a;
+      if (b > hi)
+        hi = b;
+    }
+    if (lo >= hi)
+      continue;
+    uint8_t *row = plane + (size_t)y0 * c->width;
+    for (int y = y0; y < y1; y++, row += c->width)
+      max_copy(row + lo, pattern + lo, hi - lo);
+  }
+}
+
+bool raster_draw(const GameModel *model, int width, int height,
+                 RasterMode mode, uint8_t *out) {
+  if (width <= 0 || height <= 0 || width > RASTER_MAX_SIZE ||
+      height > RASTER_MAX_SIZE)
+    return false;
+  memset(out, 0, raster_image_size(width, height, mode));
+
+  Canvas c = {
+      .width = width,
+      .height = height,
+      .sx = (float)width / GAME_AREA_WIDTH,
+      .sy = (float)height / SCREEN_HEIGHT,
+  };
+  static const uint8_t gray[RASTER_PLANES] = {
+      [RASTER_PLANE_PLAYERS] = RASTER_GRAY_PLAYERS,
+      [RASTER_PLANE_INVADERS] = RASTER_GRAY_INVADERS,
+      [RASTER_PLANE_ENEMY_BULLETS] = RASTER_GRAY_ENEMY_BULLETS,
+      [RASTER_PLANE_PLAYER_BULLETS] = RASTER_GRAY_PLAYER_BULLETS,
+  };
+  size_t plane_size = (size_t)width * height;
+  for (int p = 0; p < RASTER_PLANES; p++) {
+    bool planar = mode == RASTER_MULTI_PLANE;
+    c.planes[p] = planar ? out + p * plane_size : out;
+    c.values[p] = planar ? 255 : gray[p];
+  }
+
+  const InvaderGrid *g = &model->invaders;
+  fill_formation(&c, g);
+  if (g->big_invader.alive)
+    fill_rect(&c, RASTER_PLANE_INVADERS, g->big_invader.hitbox);
+  if (model->boss.alive)
+    fill_rect(&c, RASTER_PLANE_INVADERS, model->boss.hitbox);
+  if (model->saucer.alive)
+    fill_rect(&c, RASTER_PLANE_INVADERS, model->saucer.hitbox);
+
+  fill_bullets(&c, RASTER_PLANE_ENEMY_BULLETS, &model->enemy_bullets);
+  for (int p = 0; p < 2; p++)
+    fill_bullets(&c, RASTER_PLANE_PLAYER_BULLETS, &model->player_bullets[p]);
+
+  for (int p = 0; p < 2; p++) {
+    const Player *player = &model->players[p];
+    if ((p == 0 || player->is_active) && player->lives > 0)
+      fill_rect(&c, RASTER_PLANE_PLAYERS, player->hitbox);
+  }
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model.h"
+
+// Rastérisation d'un GameModel en petite image pour les agents, sans SDL :
+// directement depuis les hitbox, dans une mémoire fournie par l'appelant.
+// L'aire de jeu (GAME_AREA_WIDTH x SCREEN_HEIGHT) est ramenée à
+// width x height pixels ; un rect couvre les colonnes
+// [floor(x * sx), ceil((x + w) * sx)) (de même en y), donc toujours au moins
+// un pixel, même un tir plus fin qu'une colonne.
+//
+// En plans (RASTER_MULTI_PLANE), chaque catégorie a son plan de
+// width * height octets, à la suite (ordre C, H, W), 255 là où elle est.
+// En niveaux de gris, tout va dans un seul plan avec l'intensité de sa
+// catégorie ; là où des entités se chevauchent, la plus claire l'emporte.
+#define RASTER_MAX_SIZE 1024
+
+typedef enum {
+  RASTER_PLANE_PLAYERS,
+  RASTER_PLANE_INVADERS, // Formation, gros envahisseur, boss, soucoupe
+  RASTER_PLANE_ENEMY_BULLETS,
+  RASTER_PLANE_PLAYER_BULLETS,
+  RASTER_PLANES
+} RasterPlane;
+
+typedef enum {
+  RASTER_MULTI_PLANE,
+  RASTER_GRAYSCALE,
+} RasterMode;
+
+// Intensités en niveaux de gris, par plan
+#define RASTER_GRAY_PLAYERS 255
+#define RASTER_GRAY_INVADERS 96
+#define RASTER_GRAY_ENEMY_BULLETS 160
+#define RASTER_GRAY_PLAYER_BULLETS 208
+
+static inline size_t raster_image_size(int width, int height,
+                                       RasterMode mode) {
+  return (size_t)width * (size_t)height *
+         (mode == RASTER_MULTI_PLANE ? RASTER_PLANES : 1);
+}
+
+// Dessine `model` dans `out` (raster_image_size octets). Renvoie false, sans
+// rien écrire, si la taille sort de 1..RASTER_MAX_SIZE.
+bool raster_draw(const GameModel *model, int width, int height,
+                 RasterMode mode, uint8_t *out);
+
+#endif // RASTER_H
@@ -0,0 +1,240 @@
+#include "si_env.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "controller.h"
+#include "model.h"
+#include "raster.h"
+
+_Static_assert(8 + INVADER_ROWS * INVADER_COLS == 58,
+               "observation layout in si_env.h assumes a 5x10 formation");
+_Static_assert(SI_ENV_RENDER_PLANES == RASTER_PLANES &&
+                   SI_ENV_RENDER_MAX_SIZE == RASTER_MAX_SIZE,
+               "si_env.h mirrors raster.h");
+
+// Each slot starts on its own cache line, so neighbouring games never share
+// one
+typedef struct {
+  _Alignas(64) GameModel model;
+  Controller controller;
+  int last_score;    // Score seen at the end of the previous step
+  int final_score;   // Of the last finished episode
+  uint32_t episodes; // Started so far, part of each game's seed
+} EnvSlot;
+
+_Static_assert(sizeof(EnvSlot) % 64 == 0, "slots must fill whole lines");
+
+struct SiEnv {
+  int num_envs;
+  uint64_t seed;
+  float dt;
+  EnvSlot *slots;
+};
+
+static const InputMask action_masks[SI_ENV_ACTION_COUNT] = {
+    [SI_ENV_NOOP] = 0,
+    [SI_ENV_LEFT] = INPUT_LEFT,
+    [SI_ENV_RIGHT] = INPUT_RIGHT,
+    [SI_ENV_SHOOT] = INPUT_SHOOT,
+    [SI_ENV_LEFT_SHOOT] = INPUT_LEFT | INPUT_SHOOT,
+    [SI_ENV_RIGHT_SHOOT] = INPUT_RIGHT | INPUT_SHOOT,
+};
+
+// SplitMix64 finaliser: nearby (env, episode) pairs get unrelated games
+static uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+static void slot_start(const SiEnv *env, EnvSlot *slot, int index) {
+  uint64_t game = ((uint64_t)(uint32_t)index << 32) | slot->episodes++;
+  model_start_game(&slot->model, mix64(env->seed ^ mix64(game)));
+  slot->last_score = 0;
+}
+
+// --- Observations ---
+
+static inline float norm_x(float x) { return x / GAME_AREA_WIDTH; }
+static inline float norm_y(float y) { return y / SCREEN_HEIGHT; }
+
+static void write_obs(const GameModel *m, float *obs) {
+  const Player *p = &m->players[0];
+  const InvaderGrid *g = &m->invaders;
+  float px = p->hitbox.x + p->hitbox.width / 2;
+
+  obs[0] = norm_x(px);
+  obs[1] = p->lives / 3.0f;
+  obs[2] = m->player_bullets[0].capacity
+               ? (float)m->player_bullets[0].live_count /
+                     m->player_bullets[0].capacity
+               : 0.0f;
+  obs[3] = p->active_powerup != PWR_NONE;
+  obs[4] = norm_x(g->origin_x);
+  obs[5] = norm_y(g->origin_y);
+  obs[6] = 0.0f;
+  if (g->bottom_row >= 0) {
+    const Invader *inv = &g->invaders[g->bottom_row][0];
+    obs[6] = norm_y(g->origin_y + inv->offset.y + inv->offset.height);
+  }
+  obs[7] = g->direction == DIR_LEFT ? -1.0f : 1.0f;
+
+  float *cells = obs + 8;
+  for (int i = 0; i < INVADER_ROWS; i++) {
+    uint32_t row = g->row_mask[i];
+    for (int j = 0; j < INVADER_COLS; j++)
+      cells[i * INVADER_COLS + j] = (float)((row >> j) & 1u);
+  }
+
+  const Boss *boss = &m->boss;
+  obs[58] = boss->alive;
+  obs[59] = boss->alive ? norm_x(boss->hitbox.x + boss->hitbox.width / 2) : 0;
+  obs[60] = boss->alive ? norm_y(boss->hitbox.y + boss->hitbox.height) : 0;
+  obs[61] = boss->alive && boss->max_health > 0
+                ? (float)boss->health / boss->max_health
+                : 0.0f;
+  obs[62] = m->saucer.alive;
+  obs[63] = m->saucer.alive
+                ? norm_x(m->saucer.hitbox.x + m->saucer.hitbox.width / 2)
+                : 0.0f;
+
+  const PowerUp *low = NULL;
+  for (int i = 0; i < 10; i++) {
+    const PowerUp *pu = &m->powerups[i];
+    if (pu->alive && (!low || pu->hitbox.y > low->hitbox.y))
+      low = pu;
+  }
+  obs[64] = low != NULL;
+  obs[65] = low ? norm_x(low->hitbox.x + low->hitbox.width / 2 - px) : 0.0f;
+  obs[66] = low ? norm_y(low->hitbox.y + low->hitbox.height) : 0.0f;
+
+  // The lowest enemy bullets are the threats; keep them sorted by y
+  const BulletPool *pool = &m->enemy_bullets;
+  const Bullet *near[SI_ENV_OBS_BULLETS];
+  int count = 0;
+  for (int k = 0; k < pool->live_count; k++) {
+    const Bullet *b = &pool->items[pool->live[k]];
+    float y = b->hitbox.y;
+    if (count == SI_ENV_OBS_BULLETS && y <= near[count - 1]->hitbox.y)
+      continue;
+    int at = count < SI_ENV_OBS_BULLETS ? count++ : count - 1;
+    while (at > 0 && near[at - 1]->hitbox.y < y) {
+      near[at] = near[at - 1];
+      at--;
+    }
+    near[at] = b;
+  }
+  float *bullets = obs + 67;
+  for (int k = 0; k < SI_ENV_OBS_BULLETS; k++) {
+    if (k < count) {
+      const Bullet *b = near[k];
+      bullets[2 * k] = norm_x(b->hitbox.x + b->hitbox.width / 2 - px);
+      bullets[2 * k + 1] = norm_y(b->hitbox.y + b->hitbox.height);
+    } else {
+      bullets[2 * k] = 0.0f;
+      bullets[2 * k + 1] = 0.0f;
+    }
+  }
+}
+
+// --- API ---
+
+int env_abi_version(void) { return SI_ENV_ABI_VERSION; }
+
+SiEnv *env_create(int num_envs, uint64_t seed) {
+  if (num_envs <= 0)
+    return NULL;
+  SiEnv *env = calloc(1, sizeof(SiEnv));
+  // One block; slots are whole cache lines, so its size is a multiple of
+  // the alignment as aligned_alloc requires
+  size_t size = (size_t)num_envs * sizeof(EnvSlot);
+  EnvSlot *slots = env ? aligned_alloc(64, size) : NULL;
+  if (!slots) {
+    free(env);
+    return NULL;
+  }
+  memset(slots, 0, size);
+
+  ModelConfig config = model_default_config();
+  config.persist_high_score = false;
+  env->num_envs = num_envs;
+  env->seed = seed;
+  env->dt = 1.0f / config.tick_rate;
+  env->slots = slots;
+  for (int i = 0; i < num_envs; i++) {
+    EnvSlot *slot = &slots[i];
+    model_init_with_config(&slot->model, &config);
+    // Nobody reads the event stream; muting it skips the bookkeeping
+    slot->model.events.muted = true;
+    controller_init(&slot->controller, &slot->model);
+    slot_start(env, slot, i);
+  }
+  return env;
+}
+
+void env_destroy(SiEnv *env) {
+  if (!env)
+    return;
+  free(env->slots);
+  free(env);
+}
+
+int env_num_envs(const SiEnv *env) { return env->num_envs; }
+
+void env_reset(SiEnv *env, float *obs_out) {
+  for (int i = 0; i < env->num_envs; i++) {
+    EnvSlot *slot = &env->slots[i];
+    slot_start(env, slot, i);
+    if (obs_out)
+      write_obs(&slot->model, obs_out + (size_t)i * SI_ENV_OBS_SIZE);
+  }
+}
+
+void env_step(SiEnv *env, const int32_t *actions, float *obs_out,
+              float *reward_out, uint8_t *done_out) {
+  const float dt = env->dt;
+  for (int i = 0; i < env->num_envs; i++) {
+    EnvSlot *slot = &env->slots[i];
+    GameModel *m = &slot->model;
+
+    int32_t action = actions[i];
+    InputMask mask = (uint32_t)action < SI_ENV_ACTION_COUNT
+                         ? action_masks[action]
+                         : 0;
+    if (m->state == STATE_LEVEL_TRANSITION)
+      mask |= INPUT_SHOOT; // Shooting moves on to the next level
+    controller_apply_input_mask(&slot->controller, mask);
+    model_update(m, dt);
+
+    int score = m->players[0].score;
+    reward_out[i] = (float)(score - slot->last_score);
+    slot->last_score = score;
+    bool done = m->state != STATE_PLAYING && m->state != STATE_LEVEL_TRANSITION;
+    if (done) {
+      slot->final_score = score;
+      slot_start(env, slot, i);
+    }
+    done_out[i] = done;
+    write_obs(m, obs_out + (size_t)i * SI_ENV_OBS_SIZE);
+  }
+}
+
+int env_render(const SiEnv *env, int width, int height, int grayscale,
+               uint8_t *out) {
+  RasterMode mode = grayscale ? RASTER_GRAYSCALE : RASTER_MULTI_PLANE;
+  size_t image = raster_image_size(width, height, mode);
+  for (int i = 0; i < env->num_envs; i++) {
+    if (!raster_draw(&env->slots[i].model, width, height, mode,
+                     out + (size_t)i * image))
+      return 0;
+  }
+  return 1;
+}
+
+int env_last_score(const SiEnv *env, int index) {
+  if (index < 0 || index >= env->num_envs)
+    return 0;
+  return env->slots[index].final_score;
+}
@@ -0,0 +1,100 @@
+#ifndef SI_ENV_H
+#define SI_ENV_H
+
+#include <stdint.h>
+
+// Environnement d'apprentissage par renforcement : N parties simulées en
+// lot, sans affichage, exposées par libsi_env.so avec une ABI C simple
+// (utilisable depuis ctypes/cffi). Chaque environnement est une partie à un
+// joueur avancée d'un tick par pas. Aucune allocation après env_create.
+//
+// Récompense : variation du score du joueur (Player.score) pendant le pas.
+// Fin d'épisode : partie perdue ou gagnée. L'environnement repart alors
+// aussitôt sur une nouvelle partie (graine dérivée de celle d'env_create) et
+// l'observation rendue est la première de ce nouvel épisode. Les passages
+// de niveau sont validés automatiquement.
+#define SI_ENV_ABI_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SI_ENV_API __attribute__((visibility("default")))
+#else
+#define SI_ENV_API
+#endif
+
+// Actions discrètes, une par environnement et par pas
+typedef enum {
+  SI_ENV_NOOP = 0,
+  SI_ENV_LEFT,
+  SI_ENV_RIGHT,
+  SI_ENV_SHOOT,
+  SI_ENV_LEFT_SHOOT,
+  SI_ENV_RIGHT_SHOOT,
+  SI_ENV_ACTION_COUNT
+} SiEnvAction;
+
+// Observation : SI_ENV_OBS_SIZE flottants par environnement, positions
+// divisées par la largeur de l'aire de jeu ou la hauteur de l'écran
+// (0 à 1), écarts horizontaux relatifs au joueur (-1 à 1).
+//   0  joueur : centre x          1  vies / 3
+//   2  tirs du joueur en vol / capacité
+//   3  bonus actif (0 ou 1)
+//   4  formation : origine x      5  origine y
+//   6  bas de la formation y      7  sens (1 droite, -1 gauche)
+//   8  envahisseurs vivants, INVADER_ROWS x INVADER_COLS (50) cases 0 ou 1
+//   58 boss : présent, x, y, santé / santé max
+//   62 soucoupe : présente, x
+//   64 bonus qui tombe le plus bas : présent, écart x, y
+//   67 SI_ENV_OBS_BULLETS tirs ennemis les plus bas : écart x, y
+//      (0, 0 pour les places vides)
+#define SI_ENV_OBS_BULLETS 8
+#define SI_ENV_OBS_SIZE (67 + 2 * SI_ENV_OBS_BULLETS)
+
+// Images (env_render) : l'aire de jeu réduite à width x height pixels
+// (84 x 84 par exemple), un octet par pixel. En plans, SI_ENV_RENDER_PLANES
+// plans à la suite : joueurs, envahisseurs (formation, gros envahisseur,
+// boss, soucoupe), tirs ennemis, tirs des joueurs ; 255 où il y a quelque
+// chose, 0 ailleurs. En niveaux de gris, un seul plan.
+#define SI_ENV_RENDER_PLANES 4
+#define SI_ENV_RENDER_MAX_SIZE 1024
+
+typedef struct SiEnv SiEnv;
+
+SI_ENV_API int env_abi_version(void);
+
+// Crée `num_envs` environnements ; NULL si num_envs <= 0 ou mémoire
+// insuffisante. Même graine, mêmes actions : mêmes épisodes.
+SI_ENV_API SiEnv *env_create(int num_envs, uint64_t seed);
+SI_ENV_API void env_destroy(SiEnv *env);
+SI_ENV_API int env_num_envs(const SiEnv *env);
+
+// Recommence une partie dans chaque environnement. obs_out :
+// num_envs * SI_ENV_OBS_SIZE flottants (ou NULL).
+SI_ENV_API void env_reset(SiEnv *env, float *obs_out);
+
+// Avance chaque environnement d'un tick. actions : num_envs entrées
+// (SiEnvAction, une valeur hors limites vaut SI_ENV_NOOP) ; obs_out,
+// reward_out et done_out : num_envs * SI_ENV_OBS_SIZE, num_envs et
+// num_envs éléments. done_out[i] vaut 1 quand l'épisode i vient de finir.
+SI_ENV_API void env_step(SiEnv *env, const int32_t *actions, float *obs_out,
+                         float *reward_out, uint8_t *done_out);
+
+// Dessine l'état courant de chaque environnement dans `out` : num_envs
+// images de width * height octets, multipliés par SI_ENV_RENDER_PLANES si
+// grayscale vaut 0. Renvoie 0, sans rien écrire, pour une taille hors de
+// 1..SI_ENV_RENDER_MAX_SIZE.
+SI_ENV_API int env_render(const SiEnv *env, int width, int height,
+                          int grayscale, uint8_t *out);
+
+// Score final du dernier épisode terminé de l'environnement `index` (0 tant
+// qu'aucun n'est fini), pour le suivi de l'apprentissage.
+SI_ENV_API int env_last_score(const SiEnv *env, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SI_ENV_H
@@ -0,0 +1,148 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/rng.h"
+#include "env/si_env.h"
+
+/*
+ * Throughput check for libsi_env.so, linked the way an outside trainer
+ * would: only through si_env.h. Plays every environment with random
+ * actions (each held for a few steps, like a sticky-action agent) and
+ * reports environment steps per second. With --render, every step is also
+ * drawn with env_render, as a pixel-based agent would need.
+ */
+
+#define ENVBENCH_DEFAULT_ENVS 64
+#define ENVBENCH_DEFAULT_STEPS 200000 // Batched steps: each one steps all envs
+#define ENVBENCH_ACTION_HOLD 4
+
+typedef struct {
+  int envs;
+  long steps;
+  uint64_t seed;
+  int render_width; // 0: no rendering
+  int render_height;
+} EnvBenchOptions;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --envs N      Environments stepped together (default %d)\n",
+         ENVBENCH_DEFAULT_ENVS);
+  printf("  --steps N     Batched steps to run (default %d)\n",
+         ENVBENCH_DEFAULT_STEPS);
+  printf("  --seed N      Seed passed to env_create (default 1)\n");
+  printf("  --render WxH  Also render every step into WxH planes (e.g. "
+         "84x84)\n");
+}
+
+static bool parse_options(int argc, char *argv[], EnvBenchOptions *opts) {
+  opts->envs = ENVBENCH_DEFAULT_ENVS;
+  opts->steps = ENVBENCH_DEFAULT_STEPS;
+  opts->seed = 1;
+  opts->render_width = 0;
+  opts->render_height = 0;
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--envs") == 0 && has_value) {
+      opts->envs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--steps") == 0 && has_value) {
+      opts->steps = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      opts->seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--render") == 0 && has_value) {
+      if (sscanf(argv[++i], "%dx%d", &opts->render_width,
+                 &opts->render_height) != 2 ||
+          opts->render_width <= 0 || opts->render_height <= 0 ||
+          opts->render_width > SI_ENV_RENDER_MAX_SIZE ||
+          opts->render_height > SI_ENV_RENDER_MAX_SIZE) {
+        fprintf(stderr, "Invalid render size: %s\n", argv[i]);
+        return false;
+      }
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return opts->envs > 0 && opts->steps > 0;
+}
+
+int main(int argc, char *argv[]) {
+  EnvBenchOptions opts;
+  if (!parse_options(argc, argv, &opts))
+    return 1;
+  if (env_abi_version() != SI_ENV_ABI_VERSION) {
+    fprintf(stderr, "libsi_env.so has ABI %d, expected %d\n",
+            env_abi_version(), SI_ENV_ABI_VERSION);
+    return 1;
+  }
+
+  size_t n = (size_t)opts.envs;
+  SiEnv *env = env_create(opts.envs, opts.seed);
+  int32_t *actions = calloc(n, sizeof(int32_t));
+  float *obs = malloc(n * SI_ENV_OBS_SIZE * sizeof(float));
+  float *rewards = malloc(n * sizeof(float));
+  uint8_t *dones = malloc(n);
+  size_t image = (size_t)opts.render_width * opts.render_height *
+                 SI_ENV_RENDER_PLANES;
+  uint8_t *pixels = image ? malloc(n * image) : NULL;
+  if (!env || !actions || !obs || !rewards || !dones || (image && !pixels)) {
+    fprintf(stderr, "Cannot create %d environments\n", opts.envs);
+    return 1;
+  }
+
+  Rng rng;
+  rng_seed(&rng, opts.seed, 0x454e5642u);
+  env_reset(env, obs);
+  long episodes = 0;
+  double reward_sum = 0, score_sum = 0, render_time = 0;
+  double start = now_seconds();
+  for (long step = 0; step < opts.steps; step++) {
+    if (step % ENVBENCH_ACTION_HOLD == 0) {
+      for (size_t i = 0; i < n; i++)
+        actions[i] = (int32_t)rng_range(&rng, SI_ENV_ACTION_COUNT);
+    }
+    env_step(env, actions, obs, rewards, dones);
+    if (pixels) {
+      double t = now_seconds();
+      env_render(env, opts.render_width, opts.render_height, 0, pixels);
+      render_time += now_seconds() - t;
+    }
+    for (size_t i = 0; i < n; i++) {
+      reward_sum += rewards[i];
+      if (dones[i]) {
+        episodes++;
+        score_sum += env_last_score(env, (int)i);
+      }
+    }
+  }
+  double elapsed = now_seconds() - start;
+
+  double total = (double)opts.steps * opts.envs;
+  printf("%d envs x %ld steps in %.3f s: %.0f env steps/s (%.0f ns per "
+         "step)\n",
+         opts.envs, opts.steps, elapsed, total / elapsed,
+         elapsed * 1e9 / total);
+  if (pixels)
+    printf("rendering %dx%d x %d planes: %.0f ns per env step (%.0f%% of the "
+           "time)\n",
+           opts.render_width, opts.render_height, SI_ENV_RENDER_PLANES,
+           render_time * 1e9 / total, 100.0 * render_time / elapsed);
+  printf("%ld episodes finished, mean final score %.1f, %.0f total reward\n",
+         episodes, episodes ? score_sum / episodes : 0.0, reward_sum);
+  env_destroy(env);
+  free(actions);
+  free(obs);
+  free(rewards);
+  free(dones);
+  free(pixels);
+  return 0;
+}
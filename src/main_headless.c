@@ -0,0 +1,667 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "controller/controller.h"
+#include "controller/netplay.h"
+#include "controller/replay.h"
+#include "core/delta.h"
+#include "core/game_state.h"
+#include "core/model.h"
+#include "core/snapshot.h"
+#include "utils/perf_counters.h"
+
+/*
+ * Headless simulation driver: runs the model as fast as the CPU allows with
+ * no window, no terminal and no frame cap. Inputs come from a built-in
+ * scripted player, a script file or recorded replays, so runs are
+ * repeatable and the reported ticks/second measure the simulation alone.
+ */
+
+#define HEADLESS_DEFAULT_GAMES 10
+#define HEADLESS_DEFAULT_MAX_TICKS (SIM_TICK_RATE * 60 * 10)
+#define SCRIPT_MAX_STEPS 4096
+#define HEADLESS_MAX_REPLAYS 1024
+
+typedef struct {
+  uint32_t ticks;
+  InputMask mask;
+} ScriptStep;
+
+typedef struct {
+  ScriptStep steps[SCRIPT_MAX_STEPS];
+  int count;
+  int index;
+  uint32_t remaining;
+} InputScript;
+
+typedef struct {
+  int games;
+  uint32_t max_ticks;
+  Difficulty difficulty;
+  bool two_player;
+  bool quiet;
+  uint64_t seed;
+  const char *script_path;
+  const char *record_path;
+  const char *hash_log_path;
+  const char *replay_paths[HEADLESS_MAX_REPLAYS];
+  int replay_count;
+  bool delta_stats;
+  int net_port;         // Network game on this port when > 0
+  const char *net_host; // Host to join, NULL to host the game
+  NetplayConfig net;
+} HeadlessOptions;
+
+/* Every tick encoded as a delta frame for a network client and decoded
+ * again, as a server would send it */
+typedef struct {
+  GameModel baseline; // Encoder's copy of the client's model
+  GameModel client;   // Built from the decoded frames only
+  uint8_t frame[DELTA_FRAME_MAX_SIZE];
+  bool started;
+  uint64_t frames;
+  uint64_t key_frames;
+  uint64_t bytes;
+  uint64_t key_bytes;
+  uint64_t snapshot_bytes; // Full snapshots of the same ticks
+  uint64_t encode_ns;
+  uint64_t decode_ns;
+  uint64_t mismatches; // Decoded state differing from the encoder's copy
+} DeltaStats;
+
+typedef struct {
+  int games;
+  uint64_t ticks;
+  long long score;
+  int best_level;
+  uint64_t event_counts[EVENT_WIN + 1];
+  uint64_t hashes_checked;
+  int diverged_replays;
+  FILE *hash_log; // "<tick> <state hash>" after every tick, or NULL
+  DeltaStats *delta; // NULL unless --delta-stats
+} RunTotals;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Script lines: "<ticks> <buttons>", buttons from LRUDS (P1) and lruds (P2),
+ * '-' for no input. '#' starts a comment. The script loops when exhausted. */
+static InputMask parse_buttons(const char *buttons) {
+  static const char p1_keys[INPUT_BUTTON_COUNT] = {'L', 'R', 'U', 'D', 'S'};
+  static const char p2_keys[INPUT_BUTTON_COUNT] = {'l', 'r', 'u', 'd', 's'};
+  InputMask mask = 0;
+  for (const char *c = buttons; *c; c++) {
+    for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+      if (*c == p1_keys[i])
+        mask |= (InputMask)(1u << i);
+      else if (*c == p2_keys[i])
+        mask |= INPUT_P2(1u << i);
+    }
+  }
+  return mask;
+}
+
+static bool script_load(InputScript *script, const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open input script %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  int line_no = 0;
+  script->count = 0;
+  while (fgets(line, sizeof(line), f)) {
+    line_no++;
+    char *comment = strchr(line, '#');
+    if (comment)
+      *comment = '\0';
+
+    unsigned int ticks;
+    char buttons[64];
+    int fields = sscanf(line, "%u %63s", &ticks, buttons);
+    if (fields <= 0)
+      continue;
+    if (fields != 2 || ticks == 0) {
+      fprintf(stderr, "%s:%d: expected '<ticks> <buttons>'\n", path, line_no);
+      fclose(f);
+      return false;
+    }
+    if (script->count == SCRIPT_MAX_STEPS) {
+      fprintf(stderr, "%s: more than %d steps\n", path, SCRIPT_MAX_STEPS);
+      fclose(f);
+      return false;
+    }
+    script->steps[script->count].ticks = ticks;
+    script->steps[script->count].mask = parse_buttons(buttons);
+    script->count++;
+  }
+  fclose(f);
+
+  if (script->count == 0) {
+    fprintf(stderr, "%s: empty input script\n", path);
+    return false;
+  }
+  script->index = 0;
+  script->remaining = script->steps[0].ticks;
+  return true;
+}
+
+static InputMask script_next(InputScript *script) {
+  if (script->remaining == 0) {
+    script->index = (script->index + 1) % script->count;
+    script->remaining = script->steps[script->index].ticks;
+  }
+  script->remaining--;
+  return script->steps[script->index].mask;
+}
+
+/* Built-in player: chase the nearest shootable target and keep firing. */
+static InputMask bot_input(const GameModel *model, int player_id) {
+  const Player *p = &model->players[player_id];
+  float px = p->hitbox.x + p->hitbox.width / 2;
+  float target = px;
+  float best = -1.0f;
+
+  if (model->boss.alive) {
+    target = model->boss.hitbox.x + model->boss.hitbox.width / 2;
+  } else {
+    for (int i = 0; i < INVADER_ROWS; i++) {
+      for (int j = 0; j < INVADER_COLS; j++) {
+        const Invader *inv = &model->invaders.invaders[i][j];
+        if (!inv->alive || inv->dying_timer > 0)
+          continue;
+        Rect r = invader_grid_rect(&model->invaders, inv);
+        float cx = r.x + r.width / 2;
+        float dist = cx > px ? cx - px : px - cx;
+        if (best < 0 || dist < best) {
+          best = dist;
+          target = cx;
+        }
+      }
+    }
+  }
+
+  InputMask mask = INPUT_SHOOT;
+  if (target < px - 4.0f)
+    mask |= INPUT_LEFT;
+  else if (target > px + 4.0f)
+    mask |= INPUT_RIGHT;
+  return mask;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --games N          Games to simulate (default %d)\n",
+         HEADLESS_DEFAULT_GAMES);
+  printf("  --max-ticks N      Tick limit per game (default %d)\n",
+         HEADLESS_DEFAULT_MAX_TICKS);
+  printf("  --difficulty D     easy, normal, hard or rogue (default normal)\n");
+  printf("  --two-player       Simulate both players\n");
+  printf("  --seed N           Seed of the first game (default fixed)\n");
+  printf("  --script FILE      Read inputs from FILE instead of the bot\n");
+  printf("  --record FILE      Record the games to a replay file\n");
+  printf("  --replay FILE      Play back a recorded session at full speed\n");
+  printf("                     instead of simulating (may be repeated)\n");
+  printf("  --hash-log FILE    Write the state hash after every tick to FILE\n");
+  printf("  --delta-stats      Encode every tick as a network delta frame and\n");
+  printf("                     report the bytes per tick\n");
+  printf("  --host PORT        Host a network game; the bot plays P1\n");
+  printf("  --connect H:PORT   Join a network game; the bot plays P2\n");
+  printf("  --latency MS       Network: delay every packet sent\n");
+  printf("  --loss PCT         Network: drop that share of packets sent\n");
+  printf("  --input-delay N    Network: ticks before local inputs apply\n");
+  printf("  --quiet            Only print the summary\n");
+}
+
+static bool parse_difficulty(const char *name, Difficulty *out) {
+  static const char *names[] = {"easy", "normal", "hard", "rogue"};
+  for (int i = 0; i < 4; i++) {
+    if (strcmp(name, names[i]) == 0) {
+      *out = (Difficulty)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parse_options(int argc, char *argv[], HeadlessOptions *opts) {
+  opts->games = HEADLESS_DEFAULT_GAMES;
+  opts->max_ticks = HEADLESS_DEFAULT_MAX_TICKS;
+  opts->difficulty = DIFFICULTY_NORMAL;
+  opts->two_player = false;
+  opts->quiet = false;
+  opts->seed = MODEL_DEFAULT_SEED;
+  opts->script_path = NULL;
+  opts->record_path = NULL;
+  opts->hash_log_path = NULL;
+  opts->delta_stats = false;
+  opts->replay_count = 0;
+  opts->net_port = 0;
+  opts->net_host = NULL;
+  opts->net = (NetplayConfig){0};
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--games") == 0 && has_value) {
+      opts->games = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-ticks") == 0 && has_value) {
+      opts->max_ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--difficulty") == 0 && has_value) {
+      if (!parse_difficulty(argv[++i], &opts->difficulty)) {
+        fprintf(stderr, "Unknown difficulty: %s\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--two-player") == 0) {
+      opts->two_player = true;
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      opts->seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--script") == 0 && has_value) {
+      opts->script_path = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+      opts->record_path = argv[++i];
+    } else if (strcmp(argv[i], "--hash-log") == 0 && has_value) {
+      opts->hash_log_path = argv[++i];
+    } else if (strcmp(argv[i], "--delta-stats") == 0) {
+      opts->delta_stats = true;
+    } else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+      if (opts->replay_count == HEADLESS_MAX_REPLAYS) {
+        fprintf(stderr, "At most %d replays\n", HEADLESS_MAX_REPLAYS);
+        return false;
+      }
+      opts->replay_paths[opts->replay_count++] = argv[++i];
+    } else if (strcmp(argv[i], "--host") == 0 && has_value) {
+      opts->net_port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--connect") == 0 && has_value) {
+      static char host[256];
+      snprintf(host, sizeof(host), "%s", argv[++i]);
+      char *colon = strrchr(host, ':');
+      opts->net_port = colon ? atoi(colon + 1) : NETPLAY_DEFAULT_PORT;
+      if (colon)
+        *colon = '\0';
+      opts->net_host = host;
+    } else if (strcmp(argv[i], "--latency") == 0 && has_value) {
+      opts->net.latency_ms = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--loss") == 0 && has_value) {
+      opts->net.loss_percent = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--input-delay") == 0 && has_value) {
+      opts->net.input_delay = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      opts->quiet = true;
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  if (opts->games <= 0 || opts->max_ticks == 0) {
+    fprintf(stderr, "--games and --max-ticks must be positive\n");
+    return false;
+  }
+  return true;
+}
+
+static const char *outcome_name(GameState state) {
+  return state == STATE_WIN         ? "win"
+         : state == STATE_GAME_OVER ? "game over"
+                                    : "tick limit";
+}
+
+static void count_events(const GameModel *model, uint32_t *cursor,
+                         RunTotals *totals) {
+  const GameEvent *e;
+  while ((e = model_next_event(model, cursor)) != NULL)
+    totals->event_counts[e->type]++;
+}
+
+/* One line per tick, numbered across the session like a recording, so the
+ * logs of a recorded run and its replay can be diffed line by line. */
+static void log_state_hash(RunTotals *totals, uint64_t tick,
+                           const GameModel *model) {
+  if (totals->hash_log)
+    fprintf(totals->hash_log, "%" PRIu64 " %016" PRIx64 "\n", tick,
+            model_state_hash(model));
+}
+
+static void measure_delta(RunTotals *totals, const GameModel *model) {
+  DeltaStats *d = totals->delta;
+  if (!d)
+    return;
+  uint64_t start = now_ns();
+  size_t size = delta_encode(&d->baseline, model, !d->started, d->frame);
+  uint64_t encoded = now_ns();
+  if (!delta_decode(&d->client, d->frame, size))
+    d->mismatches++;
+  d->decode_ns += now_ns() - encoded;
+  d->encode_ns += encoded - start;
+  d->started = true;
+
+  d->frames++;
+  d->bytes += size;
+  if (d->frame[0] == DELTA_FRAME_KEY) {
+    d->key_frames++;
+    d->key_bytes += size;
+  }
+  d->snapshot_bytes += model_snapshot(model, d->frame);
+  if (model_state_hash(&d->client) != model_state_hash(&d->baseline))
+    d->mismatches++;
+}
+
+static void print_delta_stats(const DeltaStats *d) {
+  if (d->frames == 0)
+    return;
+  uint64_t deltas = d->frames - d->key_frames;
+  double per_tick = (double)d->bytes / d->frames;
+  double snapshot = (double)d->snapshot_bytes / d->frames;
+  printf("delta frames: %.1f bytes/tick (%.1f per delta, %llu key frames of "
+         "%.0f bytes) vs %.1f for full snapshots, %.1fx smaller\n",
+         per_tick, deltas ? (double)(d->bytes - d->key_bytes) / deltas : 0.0,
+         (unsigned long long)d->key_frames,
+         d->key_frames ? (double)d->key_bytes / d->key_frames : 0.0, snapshot,
+         snapshot / per_tick);
+  printf("delta frames: encode %.2f us, decode %.2f us per tick, %llu "
+         "decoded states differed from the encoder's\n",
+         d->encode_ns / 1e3 / d->frames, d->decode_ns / 1e3 / d->frames,
+         (unsigned long long)d->mismatches);
+}
+
+static void finish_game(RunTotals *totals, const HeadlessOptions *opts,
+                        uint32_t ticks, int score, int level, GameState state) {
+  totals->games++;
+  totals->ticks += ticks;
+  totals->score += score;
+  if (level > totals->best_level)
+    totals->best_level = level;
+  if (!opts->quiet)
+    printf("game %3d: %7u ticks  score %7d  level %3d  %s\n", totals->games,
+           ticks, score, level, outcome_name(state));
+}
+
+static void simulate_games(GameModel *model, Controller *controller,
+                           const HeadlessOptions *opts, InputScript *script,
+                           ReplayRecorder *recorder, RunTotals *totals) {
+  const float dt = 1.0f / model->config.tick_rate;
+  uint32_t event_cursor = model_event_head(model);
+
+  for (int game = 0; game < opts->games; game++) {
+    model->difficulty = opts->difficulty;
+    model->two_player_mode = opts->two_player;
+    model_reset_game(model);
+
+    uint32_t ticks = 0;
+    while (ticks < opts->max_ticks && (model->state == STATE_PLAYING ||
+                                       model->state == STATE_PAUSED ||
+                                       model->state == STATE_LEVEL_TRANSITION)) {
+      PERF_SWITCH(PERF_PHASE_INPUT);
+      InputMask mask;
+      if (opts->script_path) {
+        mask = script_next(script);
+      } else {
+        mask = bot_input(model, 0);
+        if (opts->two_player)
+          mask |= INPUT_P2(bot_input(model, 1));
+      }
+      replay_recorder_tick(recorder, model, mask);
+      controller_apply_input_mask(controller, mask);
+      PERF_SWITCH(PERF_PHASE_UPDATE);
+      model_update(model, dt);
+      PERF_SWITCH(PERF_PHASE_IDLE);
+      if (PERF_TICK() && !opts->quiet)
+        perf_counters_print_interval(stdout);
+      ticks++;
+      count_events(model, &event_cursor, totals);
+      log_state_hash(totals, totals->ticks + ticks, model);
+      measure_delta(totals, model);
+    }
+    replay_recorder_end_game(recorder, model);
+
+    finish_game(totals, opts, ticks, model_get_score(model),
+                model_get_level(model), model->state);
+  }
+}
+
+/* Plays every recorded game of a replay file; a game ends where the next
+ * one starts or at the end of the file. */
+static bool replay_file(GameModel *model, Controller *controller,
+                        const HeadlessOptions *opts, const char *path,
+                        RunTotals *totals) {
+  ReplayPlayer player;
+  if (!replay_player_open(&player, path))
+    return false;
+  replay_player_configure(&player, model);
+
+  const float dt = 1.0f / model->config.tick_rate;
+  uint32_t event_cursor = model_event_head(model);
+  int game = 0;
+  uint32_t ticks = 0;
+  int score = 0, level = 0;
+  GameState state = STATE_MENU;
+  InputMask mask;
+  while (replay_player_next(&player, model, &mask)) {
+    if (player.games != game) {
+      if (game > 0)
+        finish_game(totals, opts, ticks, score, level, state);
+      game = player.games;
+      ticks = 0;
+    }
+    PERF_SWITCH(PERF_PHASE_INPUT);
+    controller_apply_input_mask(controller, mask);
+    PERF_SWITCH(PERF_PHASE_UPDATE);
+    model_update(model, dt);
+    PERF_SWITCH(PERF_PHASE_IDLE);
+    if (PERF_TICK() && !opts->quiet)
+      perf_counters_print_interval(stdout);
+    ticks++;
+    count_events(model, &event_cursor, totals);
+    log_state_hash(totals, player.ticks, model);
+    measure_delta(totals, model);
+    score = model_get_score(model);
+    level = model_get_level(model);
+    state = model->state;
+  }
+  if (game > 0)
+    finish_game(totals, opts, ticks, score, level, state);
+  totals->hashes_checked += player.hashes_checked;
+  if (player.diverged)
+    totals->diverged_replays++;
+  replay_player_close(&player);
+  return !player.diverged;
+}
+
+static bool game_in_progress(const GameModel *model) {
+  return model->state == STATE_PLAYING || model->state == STATE_PAUSED ||
+         model->state == STATE_LEVEL_TRANSITION;
+}
+
+/* One game against another process over UDP, paced at the tick rate like a
+ * real client. Runs until the game ends (as confirmed by both sides) or
+ * --max-ticks; the final state hash must match the other side's. */
+static bool play_network_game(GameModel *model, Controller *controller,
+                              const HeadlessOptions *opts,
+                              RunTotals *totals) {
+  NetplaySession net;
+  bool opened = opts->net_host
+                    ? netplay_connect(&net, opts->net_host, opts->net_port,
+                                      &opts->net)
+                    : netplay_listen(&net, opts->net_port, &opts->net);
+  if (!opened)
+    return false;
+  model->difficulty = opts->difficulty;
+  if (!opts->quiet && opts->net_host)
+    printf("Joining %s:%d...\n", opts->net_host, opts->net_port);
+  else if (!opts->quiet)
+    printf("Waiting on port %d...\n", opts->net_port);
+  if (!netplay_wait_connected(&net, model, controller,
+                              opts->net_host ? NETPLAY_TIMEOUT_MS : -1)) {
+    netplay_close(&net);
+    return false;
+  }
+
+  const uint64_t tick_ns = 1000000000ull / (uint64_t)model->config.tick_rate;
+  uint32_t event_cursor = model_event_head(model);
+  uint64_t next_tick = now_ns();
+  while (net.state == NETPLAY_RUNNING) {
+    if (!game_in_progress(model) || net.tick >= opts->max_ticks) {
+      if (netplay_confirmed(&net))
+        break; // Final on both sides
+      netplay_wait(&net, 1);
+      netplay_poll(&net, model, controller);
+      continue;
+    }
+    uint64_t now = now_ns();
+    if (now < next_tick) {
+      netplay_wait(&net, (int)((next_tick - now) / 1000000u));
+      netplay_poll(&net, model, controller);
+      continue;
+    }
+    if (netplay_advance(&net, model, controller,
+                        bot_input(model, net.local_player))) {
+      next_tick += tick_ns; // Stalled ticks are caught up later
+      count_events(model, &event_cursor, totals);
+      log_state_hash(totals, net.tick, model);
+    } else {
+      netplay_wait(&net, 1);
+    }
+  }
+  bool ok = net.state == NETPLAY_RUNNING;
+  uint32_t ticks = net.tick;
+  netplay_finish(&net, model, controller, 2000);
+
+  finish_game(totals, opts, ticks, model_get_score(model),
+              model_get_level(model), model->state);
+  const NetplayStats *st = &net.stats;
+  printf("netplay: player %d, %u rollbacks of up to %d ticks (%llu ticks "
+         "re-simulated, %.1f us average, %.1f us worst), %u stalls\n",
+         net.local_player + 1, st->rollbacks, st->max_rollback,
+         (unsigned long long)st->resimulated_ticks,
+         st->rollbacks ? st->rollback_ns / 1e3 / st->rollbacks : 0.0,
+         st->max_rollback_ns / 1e3, st->stalls);
+  printf("netplay: %u packets sent (%u dropped), %u received, "
+         "%u state hashes matched%s\n",
+         st->packets_sent, st->packets_dropped, st->packets_received,
+         st->hashes_checked - (st->desynced ? 1u : 0u),
+         st->desynced ? ", DESYNC" : "");
+  printf("final state hash %016" PRIx64 " at tick %u\n",
+         model_state_hash(model), ticks);
+  return ok && !st->desynced;
+}
+
+int main(int argc, char *argv[]) {
+  HeadlessOptions opts;
+  if (!parse_options(argc, argv, &opts))
+    return 1;
+
+  static InputScript script;
+  if (opts.script_path && !script_load(&script, opts.script_path))
+    return 1;
+
+  GameContext *context = game_context_create();
+  if (!context) {
+    fprintf(stderr, "Failed to create game context\n");
+    return 1;
+  }
+  GameModel *model = context->model;
+
+  /* Simulated games must not touch the player's highscore.dat */
+  ModelConfig config = model_default_config();
+  config.persist_high_score = false;
+  config.seed = opts.seed;
+  model_init_with_config(model, &config);
+
+  Controller *controller = controller_create(model);
+  if (!controller) {
+    fprintf(stderr, "Failed to create controller\n");
+    game_context_destroy(context);
+    return 1;
+  }
+
+  ReplayRecorder recorder = {0};
+  if (opts.record_path &&
+      !replay_recorder_open(&recorder, opts.record_path, model)) {
+    controller_destroy(controller);
+    game_context_destroy(context);
+    return 1;
+  }
+
+  RunTotals totals = {0};
+  if (opts.hash_log_path) {
+    totals.hash_log = fopen(opts.hash_log_path, "w");
+    if (!totals.hash_log) {
+      fprintf(stderr, "Cannot create hash log %s\n", opts.hash_log_path);
+      controller_destroy(controller);
+      game_context_destroy(context);
+      return 1;
+    }
+  }
+  if (opts.delta_stats) {
+    totals.delta = calloc(1, sizeof(DeltaStats));
+    if (!totals.delta) {
+      fprintf(stderr, "Out of memory\n");
+      controller_destroy(controller);
+      game_context_destroy(context);
+      return 1;
+    }
+    model_init_with_config(&totals.delta->baseline, &config);
+    model_init_with_config(&totals.delta->client, &config);
+  }
+  bool perf_counting = perf_counters_open(); // Profile builds only
+  bool ok = true;
+  uint64_t start = now_ns();
+  if (opts.net_port > 0) {
+    ok = play_network_game(model, controller, &opts, &totals);
+  } else if (opts.replay_count > 0) {
+    /* Keep going past a divergent replay to check the whole batch */
+    for (int i = 0; i < opts.replay_count; i++)
+      if (!replay_file(model, controller, &opts, opts.replay_paths[i],
+                       &totals))
+        ok = false;
+  } else {
+    simulate_games(model, controller, &opts, &script, &recorder, &totals);
+  }
+  double seconds = (now_ns() - start) / 1e9;
+
+  if (opts.record_path && !replay_recorder_close(&recorder))
+    ok = false;
+  if (totals.hash_log && fclose(totals.hash_log) != 0) {
+    fprintf(stderr, "Failed to write hash log\n");
+    ok = false;
+  }
+
+  double ticks_per_sec = seconds > 0 ? totals.ticks / seconds : 0.0;
+  printf("%d games, %llu ticks in %.3f s: %.0f ticks/s (%.1fx real time)\n",
+         totals.games, (unsigned long long)totals.ticks, seconds,
+         ticks_per_sec, ticks_per_sec / model->config.tick_rate);
+  printf("average score %.1f, best level %d\n",
+         totals.games > 0 ? (double)totals.score / totals.games : 0.0,
+         totals.best_level);
+  printf("%llu shots, %llu kills, %llu enemy shots, %llu hits taken, "
+         "%llu power-ups\n",
+         (unsigned long long)totals.event_counts[EVENT_PLAYER_SHOT],
+         (unsigned long long)totals.event_counts[EVENT_KILL],
+         (unsigned long long)totals.event_counts[EVENT_ENEMY_SHOT],
+         (unsigned long long)totals.event_counts[EVENT_PLAYER_HIT],
+         (unsigned long long)totals.event_counts[EVENT_POWERUP]);
+  if (opts.replay_count > 0)
+    printf("%llu state hashes checked, %d of %d replays diverged\n",
+           (unsigned long long)totals.hashes_checked, totals.diverged_replays,
+           opts.replay_count);
+  if (totals.delta) {
+    print_delta_stats(totals.delta);
+    if (totals.delta->mismatches > 0)
+      ok = false;
+    free(totals.delta);
+  }
+  if (perf_counting) {
+    perf_counters_print_summary(stdout);
+    perf_counters_close();
+  }
+
+  controller_destroy(controller);
+  game_context_destroy(context);
+  return ok ? 0 : 1;
+}
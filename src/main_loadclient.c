@@ -0,0 +1,275 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "controller/controller.h"
+#include "core/model.h"
+#include "core/rng.h"
+#include "core/delta.h"
+#include "server/protocol.h"
+
+/*
+ * Load generator for space_invaders_server: opens many sessions from one
+ * thread, plays them with changing inputs and reports how regularly each
+ * one receives its state frames. A session that keeps up with the server
+ * gets one frame per tick. Every frame is decoded, as a client would, into
+ * the session's copy of the game.
+ */
+
+#define LOADCLIENT_DEFAULT_SESSIONS 100
+#define LOADCLIENT_DEFAULT_SECONDS 10
+#define LOADCLIENT_INPUT_PERIOD 12 // Frames between two input changes
+#define LOADCLIENT_WARMUP_NS 1000000000ull
+
+typedef struct {
+  int sessions;
+  int seconds;
+  const char *host;
+  int port;
+} LoadOptions;
+
+typedef struct {
+  int fd;
+  uint32_t id;
+  uint8_t *rx; // SERVER_FRAME_MAX * 2
+  size_t rx_len;
+  GameModel *model; // Client's copy, kept up to date by the state frames
+  bool invalid;     // A frame failed to decode
+  uint64_t frames;         // After warm-up
+  uint64_t missed_ticks;   // Gaps in the tick numbers received
+  uint32_t last_tick;
+  uint64_t last_frame_ns;
+  uint64_t max_gap_ns;
+  uint64_t bytes;
+  uint64_t key_frames;
+  bool closed;
+  Rng rng;
+} LoadSession;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --sessions N       Concurrent sessions (default %d)\n",
+         LOADCLIENT_DEFAULT_SESSIONS);
+  printf("  --seconds S        Measured duration (default %d)\n",
+         LOADCLIENT_DEFAULT_SECONDS);
+  printf("  --host ADDR        Server address (default 127.0.0.1)\n");
+  printf("  --port N           Server port (default %d)\n",
+         SERVER_DEFAULT_PORT);
+  printf("More than about 1000 sessions needs a higher `ulimit -n`.\n");
+}
+
+static bool parse_options(int argc, char *argv[], LoadOptions *opts) {
+  opts->sessions = LOADCLIENT_DEFAULT_SESSIONS;
+  opts->seconds = LOADCLIENT_DEFAULT_SECONDS;
+  opts->host = "127.0.0.1";
+  opts->port = SERVER_DEFAULT_PORT;
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--sessions") == 0 && has_value) {
+      opts->sessions = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+      opts->seconds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--host") == 0 && has_value) {
+      opts->host = argv[++i];
+    } else if (strcmp(argv[i], "--port") == 0 && has_value) {
+      opts->port = atoi(argv[++i]);
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return opts->sessions > 0 && opts->seconds > 0;
+}
+
+static int open_session(const LoadOptions *opts) {
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)opts->port);
+  if (inet_pton(AF_INET, opts->host, &addr.sin_addr) != 1) {
+    fprintf(stderr, "Invalid address %s\n", opts->host);
+    return -1;
+  }
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    fprintf(stderr, "Cannot connect to %s:%d: %s\n", opts->host, opts->port,
+            strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+static void send_input(LoadSession *s) {
+  // Wander left and right, shooting most of the time
+  static const InputMask moves[] = {0, INPUT_LEFT, INPUT_RIGHT};
+  InputMask mask = moves[rng_range(&s->rng, 3)];
+  if (rng_range(&s->rng, 4) != 0)
+    mask |= INPUT_SHOOT;
+  uint8_t msg[SERVER_INPUT_SIZE];
+  server_frame_header(msg, SERVER_MSG_INPUT, sizeof(mask));
+  memcpy(msg + SERVER_FRAME_HEADER, &mask, sizeof(mask));
+  // Input frames are tiny; a full socket only delays the next change
+  send(s->fd, msg, sizeof(msg), MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static void handle_frame(LoadSession *s, const uint8_t *msg, size_t size,
+                         uint64_t now, bool measuring) {
+  if (msg[0] == SERVER_MSG_WELCOME && size >= 9) {
+    memcpy(&s->id, msg + 1, sizeof(s->id));
+    return;
+  }
+  if (msg[0] != SERVER_MSG_STATE || size < 5)
+    return;
+  uint32_t tick;
+  memcpy(&tick, msg + 1, sizeof(tick));
+  if (!delta_decode(s->model, msg + 5, size - 5))
+    s->invalid = true;
+
+  if (measuring) {
+    s->frames++;
+    s->bytes += 4 + size;
+    s->key_frames += (msg[5] == DELTA_FRAME_KEY);
+    if (s->last_tick && tick > s->last_tick + 1)
+      s->missed_ticks += tick - s->last_tick - 1;
+    if (s->last_frame_ns && now - s->last_frame_ns > s->max_gap_ns)
+      s->max_gap_ns = now - s->last_frame_ns;
+  }
+  s->last_tick = tick;
+  s->last_frame_ns = now;
+  if (tick % LOADCLIENT_INPUT_PERIOD == 0)
+    send_input(s);
+}
+
+static void read_session(LoadSession *s, uint64_t now, bool measuring) {
+  for (;;) {
+    ssize_t n = recv(s->fd, s->rx + s->rx_len, 2 * SERVER_FRAME_MAX - s->rx_len,
+                     0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                   errno != EINTR)) {
+      s->closed = true;
+      return;
+    }
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    s->rx_len += (size_t)n;
+
+    size_t pos = 0;
+    while (s->rx_len - pos >= SERVER_FRAME_HEADER) {
+      uint32_t size;
+      memcpy(&size, s->rx + pos, sizeof(size));
+      if (size < 1 || size > SERVER_FRAME_MAX) {
+        s->closed = true;
+        return;
+      }
+      if (s->rx_len - pos < 4 + size)
+        break;
+      handle_frame(s, s->rx + pos + 4, size, now, measuring);
+      pos += 4 + size;
+    }
+    memmove(s->rx, s->rx + pos, s->rx_len - pos);
+    s->rx_len -= pos;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  LoadOptions opts;
+  if (!parse_options(argc, argv, &opts))
+    return 1;
+
+  LoadSession *sessions = calloc((size_t)opts.sessions, sizeof(LoadSession));
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (!sessions || epoll_fd < 0) {
+    fprintf(stderr, "Cannot set up %d sessions\n", opts.sessions);
+    return 1;
+  }
+  for (int i = 0; i < opts.sessions; i++) {
+    LoadSession *s = &sessions[i];
+    s->fd = open_session(&opts);
+    s->rx = malloc(2 * SERVER_FRAME_MAX);
+    s->model = malloc(sizeof(GameModel));
+    if (s->fd < 0 || !s->rx || !s->model) {
+      fprintf(stderr, "Opened %d of %d sessions\n", i, opts.sessions);
+      return 1;
+    }
+    model_init(s->model);
+    rng_seed(&s->rng, (uint64_t)i, 0x4c4f4144u);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)i};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s->fd, &ev);
+  }
+
+  // Connecting staggers the sessions; measure once they all run
+  uint64_t start = now_ns() + LOADCLIENT_WARMUP_NS;
+  uint64_t end = start + (uint64_t)opts.seconds * 1000000000ull;
+  struct epoll_event events[256];
+  uint64_t now;
+  while ((now = now_ns()) < end) {
+    int n = epoll_wait(epoll_fd, events, 256, 10);
+    now = now_ns();
+    for (int i = 0; i < n; i++) {
+      LoadSession *s = &sessions[events[i].data.u32];
+      read_session(s, now, now >= start);
+      if (s->closed)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    }
+  }
+
+  // Every frame must have decoded into the session's game
+  int closed = 0, invalid = 0;
+  uint64_t frames = 0, bytes = 0, key_frames = 0, missed = 0, worst_gap = 0;
+  double min_rate = -1.0;
+  for (int i = 0; i < opts.sessions; i++) {
+    LoadSession *s = &sessions[i];
+    closed += s->closed;
+    invalid += s->invalid;
+    double rate = s->frames / (double)opts.seconds;
+    if (min_rate < 0 || rate < min_rate)
+      min_rate = rate;
+    frames += s->frames;
+    bytes += s->bytes;
+    key_frames += s->key_frames;
+    missed += s->missed_ticks;
+    if (s->max_gap_ns > worst_gap)
+      worst_gap = s->max_gap_ns;
+    close(s->fd);
+    free(s->rx);
+    free(s->model);
+  }
+  free(sessions);
+  close(epoll_fd);
+
+  printf("%d sessions for %d s: %.1f frames/s per session on average, %.1f "
+         "at worst\n",
+         opts.sessions, opts.seconds,
+         frames / (double)opts.seconds / opts.sessions, min_rate);
+  printf("%llu ticks missed, longest gap %.1f ms, %.2f MB/s (%.0f bytes per "
+         "frame)\n",
+         (unsigned long long)missed, worst_gap / 1e6,
+         bytes / (double)opts.seconds / 1e6,
+         frames ? bytes / (double)frames : 0.0);
+  printf("%llu key frames, %d sessions closed by the server, %d sessions with "
+         "invalid states\n",
+         (unsigned long long)key_frames, closed, invalid);
+  return closed == 0 && invalid == 0 ? 0 : 1;
+}
@@ -34,7 +34,13 @@
 #include "core/model.h"
 #include "core/game_state.h"
 #include "controller/controller.h"
+#include "controller/replay.h"
+#include "controller/spectate.h"
 #include "views/view_ncurses.h"
+#include "utils/flight_recorder.h"
+#include "utils/frame_timer.h"
+#include "utils/perf_counters.h"
+#include "utils/trace.h"
 #include "utils/platform.h"
 
 
@@ -54,26 +60,31 @@ static Direction current_move_dir_p2 = DIR_STATIONARY;
 static uint32_t last_input_time_p2 = 0;
 static const uint32_t INPUT_TIMEOUT_MS = 100; // Large buffer for smooth movement on all terminals
 
-/* Process a single key for gameplay - updates state only */
-static void process_gameplay_key(GameModel *model, Controller *controller, int ch) {
+/* Ticks simulated per loop when replaying at full speed */
+#define REPLAY_MAX_BATCH 6000
+
+/* Process a single key for gameplay - updates state only. Shots and pause
+ * are queued in `pending` and applied on the next tick. */
+static void process_gameplay_key(GameModel *model, Controller *controller, int ch,
+                                 InputMask *pending) {
     uint32_t now = platform_get_ticks();
     
     /* Check P1 keybinds */
-    if (ch == model->keybinds_p1[0]) { current_move_dir_p1 = DIR_LEFT; last_input_time_p1 = now; }
-    else if (ch == model->keybinds_p1[1]) { current_move_dir_p1 = DIR_RIGHT; last_input_time_p1 = now; }
-    else if (ch == model->keybinds_p1[2]) { current_move_dir_p1 = DIR_UP; last_input_time_p1 = now; }
-    else if (ch == model->keybinds_p1[3]) { current_move_dir_p1 = DIR_DOWN; last_input_time_p1 = now; }
-    else if (ch == model->keybinds_p1[4]) { model_player_shoot(model, 0); }
+    if (ch == model->ui.keybinds_p1[0]) { current_move_dir_p1 = DIR_LEFT; last_input_time_p1 = now; }
+    else if (ch == model->ui.keybinds_p1[1]) { current_move_dir_p1 = DIR_RIGHT; last_input_time_p1 = now; }
+    else if (ch == model->ui.keybinds_p1[2]) { current_move_dir_p1 = DIR_UP; last_input_time_p1 = now; }
+    else if (ch == model->ui.keybinds_p1[3]) { current_move_dir_p1 = DIR_DOWN; last_input_time_p1 = now; }
+    else if (ch == model->ui.keybinds_p1[4]) { *pending |= INPUT_SHOOT; }
     
     /* P2 keybinds */
-    else if (ch == model->keybinds_p2[0]) { current_move_dir_p2 = DIR_LEFT; last_input_time_p2 = now; }
-    else if (ch == model->keybinds_p2[1]) { current_move_dir_p2 = DIR_RIGHT; last_input_time_p2 = now; }
-    else if (ch == model->keybinds_p2[2]) { current_move_dir_p2 = DIR_UP; last_input_time_p2 = now; }
-    else if (ch == model->keybinds_p2[3]) { current_move_dir_p2 = DIR_DOWN; last_input_time_p2 = now; }
-    else if (ch == model->keybinds_p2[4]) { model_player_shoot(model, 1); }
+    else if (ch == model->ui.keybinds_p2[0]) { current_move_dir_p2 = DIR_LEFT; last_input_time_p2 = now; }
+    else if (ch == model->ui.keybinds_p2[1]) { current_move_dir_p2 = DIR_RIGHT; last_input_time_p2 = now; }
+    else if (ch == model->ui.keybinds_p2[2]) { current_move_dir_p2 = DIR_UP; last_input_time_p2 = now; }
+    else if (ch == model->ui.keybinds_p2[3]) { current_move_dir_p2 = DIR_DOWN; last_input_time_p2 = now; }
+    else if (ch == model->ui.keybinds_p2[4]) { *pending |= INPUT_P2(INPUT_SHOOT); }
     
     /* Hardcoded controls */
-    else if (ch == 'p' || ch == 'P') { model_toggle_pause(model); }
+    else if (ch == 'p' || ch == 'P') { *pending |= INPUT_PAUSE; }
     else if (ch == 'q' || ch == 'Q' || ch == 27) { controller->quit_requested = true; }
     else if (ch == 'r' || ch == 'R') {
         if (model->state == STATE_GAME_OVER || model->state == STATE_WIN) {
@@ -83,14 +94,76 @@ static void process_gameplay_key(GameModel *model, Controller *controller, int c
     }
 }
 
+/* Spectator: mirrors a game broadcast by another process, read-only */
+static void run_spectator(NcursesView *view, GameModel *model,
+                          SpectateViewer *viewer, float frame_delay) {
+    int ch;
+    bool running = true;
+    while (running) {
+        uint32_t frame_start = platform_get_ticks();
+        while (ncurses_view_poll_event(view, &ch)) {
+            if (ch == 'q' || ch == 'Q' || ch == 27)
+                running = false;
+        }
+        if (spectate_viewer_poll(viewer, model) == SPECTATE_ENDED)
+            break;
+        ncurses_view_render(view, model);
+        uint32_t frame_time = platform_get_ticks() - frame_start;
+        if (frame_time < frame_delay)
+            sleep_ms((uint32_t)(frame_delay - frame_time));
+    }
+}
+
+/* Held direction of a player as input bits, while its key repeat is recent */
+static InputMask direction_mask(Direction dir, uint32_t last_input, uint32_t now) {
+    if (dir == DIR_STATIONARY || (now - last_input) >= INPUT_TIMEOUT_MS)
+        return 0;
+    return (InputMask)(1u << dir); /* DIR_LEFT..DIR_DOWN match INPUT_LEFT..INPUT_DOWN */
+}
+
 int main(int argc, char* argv[]) {
     bool valgrind_test = false;
+    int tick_rate = SIM_TICK_RATE;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    float replay_speed = 1.0f; /* 0 = as fast as possible, no rendering */
+    const char* broadcast_name = NULL; /* Publish every tick for spectators */
+    const char* spectate_name = NULL;  /* Watch a broadcast instead of playing */
+    const char* perf_log_path = NULL;  /* Per-frame phase timings as CSV */
+    const char* trace_path = NULL;     /* Chrome trace of the whole run */
+    int hitch_ms = FLIGHT_DEFAULT_BUDGET_MS; /* Flight recorder dump threshold */
+    const char* flight_dir = NULL;           /* Where dumps go, default "." */
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--valgrind-test") == 0) {
             valgrind_test = true;
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tick_rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            i++;
+            replay_speed = strcmp(argv[i], "max") == 0 ? 0.0f : (float)atof(argv[i]);
+        } else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+            broadcast_name = argv[++i];
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectate_name = argv[++i];
+        } else if (strcmp(argv[i], "--perf-log") == 0 && i + 1 < argc) {
+            perf_log_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc) {
+            hitch_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--flight-dir") == 0 && i + 1 < argc) {
+            flight_dir = argv[++i];
         }
     }
     
+    if (trace_path && trace_start(trace_path))
+        trace_thread_name("main");
+    bool perf_counting = perf_counters_open(); /* Profile builds only */
+    
     printf("Space Invaders MVC - NCURSES Version\n");
     printf("Initializing...\n");
     
@@ -100,18 +173,64 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Failed to create game context\n");
         return 1;
     }
+    model_seed(context->model, (uint64_t)time(NULL));
+    game_context_set_tick_rate(context, tick_rate);
+
+    /* Spectators only draw what the broadcasting game publishes */
+    static SpectateViewer viewer;
+    if (spectate_name) {
+        replay_path = record_path = NULL;
+        if (!spectate_viewer_open(&viewer, spectate_name)) {
+            game_context_destroy(context);
+            return 1;
+        }
+    }
+    SpectatePublisher broadcast = {0};
+    if (broadcast_name && !spectate_publisher_open(&broadcast, broadcast_name)) {
+        game_context_destroy(context);
+        return 1;
+    }
+
+    /* Always timed: F3 shows the overlay, --perf-log keeps every frame */
+    static FrameTimer frame_timer;
+    bool show_timing = false;
+    if (!frame_timer_init(&frame_timer, perf_log_path)) {
+        game_context_destroy(context);
+        return 1;
+    }
+    /* Always recording: a hitch or SIGUSR1 dumps the last frames. Paths are
+     * only printed at exit, the terminal belongs to ncurses until then. */
+    static FlightRecorder flight;
+    flight_recorder_init(&flight, flight_dir, hitch_ms);
+
+    /* Replays bring their own tick rate and drive every gameplay input */
+    ReplayPlayer replay = {0};
+    ReplayRecorder recorder = {0};
+    if (replay_path) {
+        if (!replay_player_open(&replay, replay_path)) {
+            game_context_destroy(context);
+            return 1;
+        }
+        replay_player_configure(&replay, context->model);
+        if (replay_speed > 0)
+            context->time_scale = replay_speed;
+    } else if (record_path &&
+               !replay_recorder_open(&recorder, record_path, context->model)) {
+        game_context_destroy(context);
+        return 1;
+    }
     
     /* Set ncurses-compatible default keybindings in model */
-    context->model->keybinds_p1[0] = KEY_LEFT;
-    context->model->keybinds_p1[1] = KEY_RIGHT;
-    context->model->keybinds_p1[2] = KEY_UP;
-    context->model->keybinds_p1[3] = KEY_DOWN;
-    context->model->keybinds_p1[4] = ' ';  // Space to shoot
-    context->model->keybinds_p2[0] = 'a';
-    context->model->keybinds_p2[1] = 'd';
-    context->model->keybinds_p2[2] = 'w';
-    context->model->keybinds_p2[3] = 's';
-    context->model->keybinds_p2[4] = 'f';
+    context->model->ui.keybinds_p1[0] = KEY_LEFT;
+    context->model->ui.keybinds_p1[1] = KEY_RIGHT;
+    context->model->ui.keybinds_p1[2] = KEY_UP;
+    context->model->ui.keybinds_p1[3] = KEY_DOWN;
+    context->model->ui.keybinds_p1[4] = ' ';  // Space to shoot
+    context->model->ui.keybinds_p2[0] = 'a';
+    context->model->ui.keybinds_p2[1] = 'd';
+    context->model->ui.keybinds_p2[2] = 'w';
+    context->model->ui.keybinds_p2[3] = 's';
+    context->model->ui.keybinds_p2[4] = 'f';
     
     /* Create controller */
     Controller* controller = controller_create(context->model);
@@ -144,22 +263,50 @@ int main(int argc, char* argv[]) {
     controller_set_keybindings(controller, 0, KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT, ' ', 'p', 'q');
     controller_set_keybindings(controller, 1, 'w', 's', 'a', 'd', 'f', 0, 0);
 
+    if (spectate_name) {
+        run_spectator(view, context->model, &viewer, 1000.0f / 60);
+        ncurses_view_destroy(view);
+        printf("Watched '%s' up to tick %llu, %u torn reads retried\n",
+               spectate_name, (unsigned long long)viewer.last_tick, viewer.retries);
+        spectate_viewer_close(&viewer);
+        trace_stop();
+        trace_shutdown();
+        controller_destroy(controller);
+        game_context_destroy(context);
+        return 0;
+    }
+
+    uint64_t sim_ticks = 0;
+
     /* Main game loop */
     int ch;
     const int TARGET_FPS = 60; // 60 FPS for smooth movement
-    uint32_t last_update = platform_get_ticks();
     const float FRAME_DELAY = 1000.0f / TARGET_FPS;
+    game_context_start_clock(context, platform_get_ticks());
     
     int frame_count = 0;
+    InputMask pending_input = 0; /* Key presses waiting for the next tick */
     while (!controller_is_quit_requested(controller) && context->model->state != STATE_QUIT) {
         if (valgrind_test && frame_count++ >= 60) {
             break;
         }
+        TRACE_SCOPE("frame");
         uint32_t frame_start = platform_get_ticks();
+        frame_timer_begin_frame(&frame_timer);
+        PERF_SWITCH(PERF_PHASE_INPUT);
         
         /* Handle input */
         while (ncurses_view_poll_event(view, &ch)) {
-            if (context->model->waiting_for_key) {
+            if (ch == KEY_F(3)) {
+                show_timing = !show_timing;
+                ncurses_view_set_frame_timer(view, show_timing ? &frame_timer : NULL);
+            }
+            else if (replay_path) {
+                /* Playback owns the inputs; only leaving is allowed */
+                if (ch == 'q' || ch == 'Q' || ch == 27)
+                    controller->quit_requested = true;
+            }
+            else if (context->model->ui.waiting_for_key) {
                 /* Settings: capture new keybind */
                 model_set_keybind(context->model, ch);
             }
@@ -176,7 +323,16 @@ int main(int argc, char* argv[]) {
             }
             else if (context->model->state == STATE_PLAYING) {
                 /* Gameplay - use model keybindings */
-                process_gameplay_key(context->model, controller, ch);
+                process_gameplay_key(context->model, controller, ch, &pending_input);
+            }
+            else if (context->model->state == STATE_PAUSED && (ch == 'p' || ch == 'P')) {
+                pending_input |= INPUT_PAUSE;
+            }
+            else if (context->model->state == STATE_LEVEL_TRANSITION &&
+                     (ch == context->model->ui.keybinds_p1[4] ||
+                      ch == context->model->ui.keybinds_p2[4] || ch == '\n' || ch == 13)) {
+                /* Continuing to the next level goes through the tick input too */
+                pending_input |= INPUT_SHOOT;
             }
             else {
                 /* Other states */
@@ -187,39 +343,97 @@ int main(int argc, char* argv[]) {
             }
         }
         
-        /* Frame timing */
-        uint32_t current_time = platform_get_ticks();
-        float delta_time = (current_time - last_update) / 1000.0f;
-        if (delta_time > 0.1f) delta_time = 0.1f;
-        last_update = current_time;
+        frame_timer_end(&frame_timer, FRAME_PHASE_EVENTS);
         
-        /* Update game */
-        controller_update(controller, delta_time);
+        /* Fixed-step simulation: run the ticks due for this frame */
+        uint32_t current_time = platform_get_ticks();
+        bool fast_replay = replay_path && replay_speed <= 0;
+        int ticks = fast_replay ? REPLAY_MAX_BATCH : game_context_advance(context, current_time);
+        float tick_dt = game_context_tick_dt(context);
         
-        /* Apply smooth movement if inputs are active */
-        if (context->model->state == STATE_PLAYING) {
-            if ((current_time - last_input_time_p1) < INPUT_TIMEOUT_MS && current_move_dir_p1 != DIR_STATIONARY) {
-                model_move_player(context->model, 0, current_move_dir_p1);
-            }
-            if ((current_time - last_input_time_p2) < INPUT_TIMEOUT_MS && current_move_dir_p2 != DIR_STATIONARY) {
-                model_move_player(context->model, 1, current_move_dir_p2);
+        for (int t = 0; t < ticks; t++) {
+            frame_timer_begin(&frame_timer);
+            PERF_SWITCH(PERF_PHASE_UPDATE);
+            controller_update(controller, tick_dt);
+            frame_timer_end(&frame_timer, FRAME_PHASE_UPDATE);
+            PERF_SWITCH(PERF_PHASE_INPUT);
+            
+            /* One input mask per tick: queued presses plus smooth movement */
+            InputMask mask;
+            if (replay_path) {
+                if (!replay_player_next(&replay, context->model, &mask)) {
+                    controller->quit_requested = true;
+                    break;
+                }
+            } else {
+                mask = pending_input;
+                pending_input = 0;
+                if (context->model->state == STATE_PLAYING) {
+                    mask |= direction_mask(current_move_dir_p1, last_input_time_p1, current_time);
+                    mask |= INPUT_P2(direction_mask(current_move_dir_p2, last_input_time_p2, current_time));
+                }
+                replay_recorder_tick(&recorder, context->model, mask);
             }
+            controller_apply_input_mask(controller, mask);
+            frame_timer_end(&frame_timer, FRAME_PHASE_INPUT);
+            PERF_SWITCH(PERF_PHASE_UPDATE);
+            
+            model_update(context->model, tick_dt);
+            spectate_publish(&broadcast, context->model, ++sim_ticks);
+            frame_timer_end(&frame_timer, FRAME_PHASE_UPDATE);
+            frame_timer_add_ticks(&frame_timer, 1);
+        }
+        if (fast_replay) {
+            frame_timer_end_frame(&frame_timer);
+            flight_recorder_end_frame(&flight, &frame_timer, context->model);
+            continue; /* Rendering skipped */
         }
-        
-        model_update(context->model, delta_time);
         
         /* Render */
+        frame_timer_begin(&frame_timer);
+        PERF_SWITCH(PERF_PHASE_RENDER);
         ncurses_view_render(view, context->model);
+        frame_timer_end(&frame_timer, FRAME_PHASE_RENDER);
+        frame_timer_end_frame(&frame_timer);
+        flight_recorder_end_frame(&flight, &frame_timer, context->model);
+        PERF_SWITCH(PERF_PHASE_IDLE);
         
         /* Cap framerate */
         uint32_t frame_time = platform_get_ticks() - frame_start;
         if (frame_time < FRAME_DELAY) {
+            TRACE_SCOPE("sleep_ms");
             sleep_ms((uint32_t)(FRAME_DELAY - frame_time));
         }
     }
     
     /* Cleanup */
+    spectate_publisher_close(&broadcast);
     ncurses_view_destroy(view);
+    if (perf_log_path)
+        printf("Frame timings of %llu frames written to %s\n",
+               (unsigned long long)frame_timer.frames, perf_log_path);
+    frame_timer_close(&frame_timer);
+    if (flight.dumps)
+        printf("Flight recorder: last dump in %s (%u in all)\n",
+               flight.last_path, flight.dumps);
+    trace_stop();
+    trace_shutdown();
+    if (perf_counting) {
+        perf_counters_print_summary(stdout);
+        perf_counters_close();
+    }
+    if (replay_path) {
+        printf("Replay: %d games, %llu ticks, final score %d\n", replay.games,
+               (unsigned long long)replay.ticks, model_get_score(context->model));
+        if (replay.diverged)
+            printf("Diverged from the recording at tick %llu\n",
+                   (unsigned long long)replay.diverged_tick);
+        else
+            printf("%u state hashes matched\n", replay.hashes_checked);
+        replay_player_close(&replay);
+    }
+    if (record_path && !replay_path)
+        replay_recorder_close(&recorder);
     controller_destroy(controller);
     game_context_destroy(context);
     
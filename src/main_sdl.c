@@ -1,33 +1,242 @@
 #include "controller/controller.h"
 #include "controller/input_handler.h"
+#include "controller/netplay.h"
+#include "controller/replay.h"
+#include "controller/spectate.h"
 #include "core/game_state.h"
 #include "core/model.h"
+#include "utils/flight_recorder.h"
+#include "utils/frame_timer.h"
+#include "utils/perf_counters.h"
+#include "utils/trace.h"
 #include "views/view_sdl.h"
 #include <SDL3/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+/* Ticks simulated between event polls when replaying at full speed */
+#define REPLAY_MAX_BATCH 6000
+
+/* Network play: either keyset steers the local ship (sent as P1 bits) */
+static InputMask local_player_mask(InputMask mask) {
+  return (InputMask)((mask | mask >> 8) & ((1u << INPUT_BUTTON_COUNT) - 1));
+}
+
+static bool game_in_progress(const GameModel *model) {
+  return model->state == STATE_PLAYING || model->state == STATE_PAUSED ||
+         model->state == STATE_LEVEL_TRANSITION;
+}
+
+/* Spectator: mirrors a game broadcast by another process, read-only */
+static void run_spectator(SDLView *view, GameModel *model,
+                          SpectateViewer *viewer, uint32_t frame_delay) {
+  sdl_view_set_interpolation(view, NULL, 1.0f);
+
+  bool running = true;
+  SDL_Event event;
+  while (running) {
+    uint32_t frame_start = SDL_GetTicks();
+    while (sdl_view_poll_event(view, &event)) {
+      if (event.type == SDL_EVENT_QUIT ||
+          (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_ESCAPE))
+        running = false;
+    }
+    if (spectate_viewer_poll(viewer, model) == SPECTATE_ENDED) {
+      printf("Broadcast ended\n");
+      break;
+    }
+    sdl_view_render(view, model);
+    uint32_t frame_time = SDL_GetTicks() - frame_start;
+    if (frame_time < frame_delay)
+      SDL_Delay(frame_delay - frame_time);
+  }
+}
+
+static void print_netplay_stats(const NetplaySession *net) {
+  const NetplayStats *st = &net->stats;
+  printf("Netplay: %u rollbacks of up to %d ticks (%.1f us worst), "
+         "%u stalls, %u packets sent, %u received, %u state checks%s\n",
+         st->rollbacks, st->max_rollback, st->max_rollback_ns / 1e3,
+         st->stalls, st->packets_sent, st->packets_received,
+         st->hashes_checked, st->desynced ? ", DESYNC" : "");
+}
+
+/* After frame_timer_end_frame: files the frame, says where a dump went */
+static void record_flight(FlightRecorder *flight, const FrameTimer *timer,
+                          const GameModel *model) {
+  if (flight_recorder_end_frame(flight, timer, model))
+    printf("Flight recorder: last %d frames written to %s\n",
+           FLIGHT_RECORDER_FRAMES, flight->last_path);
+}
+
+/* Gameplay bits bound to `key` in the model keybindings */
+static InputMask keybind_mask(const GameModel *model, int key) {
+  InputMask mask = 0;
+  for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    if (key == model->ui.keybinds_p1[i])
+      mask |= (InputMask)(1u << i);
+    if (key == model->ui.keybinds_p2[i])
+      mask |= INPUT_P2(1u << i);
+  }
+  return mask;
+}
+
+static bool key_held(int keycode, const bool *state, int num_keys) {
+  SDL_Scancode sc = SDL_GetScancodeFromKey(keycode, NULL);
+  return (int)sc < num_keys && state[sc];
+}
+
+/* Gameplay bits of the keys currently held down */
+static InputMask held_mask(const GameModel *model, const bool *state,
+                           int num_keys) {
+  InputMask mask = 0;
+  for (int i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    if (key_held(model->ui.keybinds_p1[i], state, num_keys))
+      mask |= (InputMask)(1u << i);
+    if (key_held(model->ui.keybinds_p2[i], state, num_keys))
+      mask |= INPUT_P2(1u << i);
+  }
+  return mask;
+}
+
 int main(int argc, char *argv[]) {
-  srand((unsigned int)time(NULL)); // Initialize random seed once
+  srand((unsigned int)time(NULL)); // Star field only; gameplay uses model RNG
   bool valgrind_test = false;
+  int tick_rate = SIM_TICK_RATE;
+  int target_fps = 60; // 0 = uncapped
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  float replay_speed = 1.0f; // 0 = as fast as possible, no rendering
+  int net_port = 0;           // Network game when > 0
+  char net_host[256] = "";    // Host to join, empty to host the game
+  NetplayConfig net_config = {0};
+  const char *broadcast_name = NULL; // Publish every tick for spectators
+  const char *spectate_name = NULL;  // Watch a broadcast instead of playing
+  const char *perf_log_path = NULL;  // Per-frame phase timings as CSV
+  const char *trace_path = NULL;     // Chrome trace of the whole run
+  int hitch_ms = FLIGHT_DEFAULT_BUDGET_MS; // Flight recorder dump threshold
+  const char *flight_dir = NULL;           // Where dumps go, default "."
   for (int i = 1; i < argc; i++) {
     if (SDL_strcmp(argv[i], "--valgrind-test") == 0) {
       valgrind_test = true;
+    } else if (SDL_strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+      tick_rate = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      target_fps = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      i++;
+      replay_speed =
+          SDL_strcmp(argv[i], "max") == 0 ? 0.0f : (float)SDL_atof(argv[i]);
+    } else if (SDL_strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      net_port = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+      SDL_strlcpy(net_host, argv[++i], sizeof(net_host));
+      char *colon = SDL_strrchr(net_host, ':');
+      net_port = colon ? SDL_atoi(colon + 1) : NETPLAY_DEFAULT_PORT;
+      if (colon)
+        *colon = '\0';
+    } else if (SDL_strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+      net_config.latency_ms = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+      net_config.loss_percent = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--input-delay") == 0 && i + 1 < argc) {
+      net_config.input_delay = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+      broadcast_name = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+      spectate_name = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--perf-log") == 0 && i + 1 < argc) {
+      perf_log_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc) {
+      hitch_ms = SDL_atoi(argv[++i]);
+    } else if (SDL_strcmp(argv[i], "--flight-dir") == 0 && i + 1 < argc) {
+      flight_dir = argv[++i];
     }
   }
 
+  /* Started first so resource loading shows up in the trace */
+  if (trace_path && trace_start(trace_path))
+    trace_thread_name("main");
+  bool perf_counting = perf_counters_open(); // Profile builds only
+
   /* Create game context */
   GameContext *context = game_context_create();
   if (!context) {
     fprintf(stderr, "Failed to create game context\n");
     return 1;
   }
+  model_seed(context->model, (uint64_t)time(NULL));
+  game_context_set_tick_rate(context, tick_rate);
+
+  /* Spectators only draw what the broadcasting game publishes */
+  static SpectateViewer viewer;
+  if (spectate_name) {
+    replay_path = record_path = NULL;
+    net_port = 0;
+    if (!spectate_viewer_open(&viewer, spectate_name)) {
+      game_context_destroy(context);
+      return 1;
+    }
+  }
+  SpectatePublisher broadcast = {0};
+  if (broadcast_name) {
+    if (!spectate_publisher_open(&broadcast, broadcast_name)) {
+      game_context_destroy(context);
+      return 1;
+    }
+    printf("Broadcasting as '%s': watch with --spectate %s\n", broadcast_name,
+           broadcast_name);
+  }
+
+  /* Always timed: F3 shows the overlay, --perf-log keeps every frame */
+  static FrameTimer frame_timer;
+  bool show_timing = false;
+  if (!frame_timer_init(&frame_timer, perf_log_path)) {
+    game_context_destroy(context);
+    return 1;
+  }
+  /* Always recording: a hitch or SIGUSR1 dumps the last frames */
+  static FlightRecorder flight;
+  flight_recorder_init(&flight, flight_dir, hitch_ms);
+
+  /* Replays bring their own tick rate and drive every gameplay input */
+  ReplayPlayer replay = {0};
+  ReplayRecorder recorder = {0};
+  if (replay_path) {
+    if (!replay_player_open(&replay, replay_path)) {
+      game_context_destroy(context);
+      return 1;
+    }
+    replay_player_configure(&replay, context->model);
+    if (replay_speed > 0)
+      context->time_scale = replay_speed;
+  } else if (record_path &&
+             !replay_recorder_open(&recorder, record_path, context->model)) {
+    game_context_destroy(context);
+    return 1;
+  }
+
+  /* Previous tick's state, for render interpolation */
+  GameModel *previous = malloc(sizeof(GameModel));
+  if (!previous) {
+    fprintf(stderr, "Failed to allocate interpolation state\n");
+    game_context_destroy(context);
+    return 1;
+  }
+  *previous = *context->model;
 
   /* Create controller */
   Controller *controller = controller_create(context->model);
   if (!controller) {
     fprintf(stderr, "Failed to create controller\n");
+    free(previous);
     game_context_destroy(context);
     return 1;
   }
@@ -38,10 +247,39 @@ int main(int argc, char *argv[]) {
   input_handler_set_keybindings(controller->input_handler, 0, 0, 0, SDLK_P,
                                 SDLK_ESCAPE);
 
+  /* Network game: the host waits for a guest, the guest takes the host's
+   * settings; both start a two-player game right away */
+  NetplaySession net = {0};
+  net.socket = -1;
+  bool netplay = net_port > 0 && !replay_path;
+  if (netplay) {
+    bool opened =
+        net_host[0] ? netplay_connect(&net, net_host, net_port, &net_config)
+                    : netplay_listen(&net, net_port, &net_config);
+    if (opened) {
+      if (net_host[0])
+        printf("Joining %s:%d...\n", net_host, net_port);
+      else
+        printf("Waiting for the other player on port %d...\n", net_port);
+    }
+    if (!opened || !netplay_wait_connected(&net, context->model, controller,
+                                           net_host[0] ? NETPLAY_TIMEOUT_MS
+                                                       : -1)) {
+      netplay_close(&net);
+      free(previous);
+      controller_destroy(controller);
+      game_context_destroy(context);
+      return 1;
+    }
+    game_context_set_tick_rate(context, context->model->config.tick_rate);
+    printf("Connected: you are player %d\n", net.local_player + 1);
+  }
+
   /* Create SDL view */
   SDLView *view = sdl_view_create();
   if (!view) {
     fprintf(stderr, "Failed to create SDL view\n");
+    free(previous);
     controller_destroy(controller);
     game_context_destroy(context);
     return 1;
@@ -51,14 +289,36 @@ int main(int argc, char *argv[]) {
   if (!sdl_view_init(view, SCREEN_WIDTH, SCREEN_HEIGHT)) {
     fprintf(stderr, "Failed to initialize SDL view\n");
     sdl_view_destroy(view);
+    free(previous);
     controller_destroy(controller);
     game_context_destroy(context);
     return 1;
   }
 
+  sdl_view_set_flight_recorder(view, &flight);
+
   // Set window title correctly
   SDL_SetWindowTitle(view->window, "Space Invader");
 
+  if (spectate_name) {
+    printf("Watching '%s' (ESC to leave)\n", spectate_name);
+    run_spectator(view, context->model, &viewer,
+                  target_fps > 0 ? 1000 / target_fps : 0);
+    printf("Watched '%s' up to tick %llu, %u torn reads retried\n",
+           spectate_name, (unsigned long long)viewer.last_tick,
+           viewer.retries);
+    spectate_viewer_close(&viewer);
+    trace_stop();
+    sdl_view_destroy(view);
+    trace_shutdown();
+    free(previous);
+    controller_destroy(controller);
+    game_context_destroy(context);
+    return 0;
+  }
+
+  uint64_t sim_ticks = 0;
+
   /* Setup Default Keybindings - Clear gameplay keys so only Model binds work */
   /* We keep Pause(P) for fallback, but remove movement/shoot defaults */
   controller_set_keybindings(controller, 0, 0, 0, 0, 0, 0, SDLK_P, 0);
@@ -67,15 +327,16 @@ int main(int argc, char *argv[]) {
   /* Set view context */
   controller_set_view_context(controller, view);
 
-  /* Game loop timing */
-  const int TARGET_FPS = 60;
-  const uint32_t FRAME_DELAY = 1000 / TARGET_FPS;
-  uint32_t last_update = SDL_GetTicks();
+  /* Game loop timing: rendering is capped at target_fps, the simulation
+   * always advances in fixed ticks of 1 / tick_rate seconds */
+  const uint32_t FRAME_DELAY = target_fps > 0 ? 1000 / target_fps : 0;
+  game_context_start_clock(context, SDL_GetTicks());
 
   /* Main loop */
   bool running = true;
   SDL_Event event;
   int frame_count = 0;
+  InputMask pending_input = 0; // Key presses waiting for the next tick
 
   printf("Game Running.\n");
   printf("P1: Arrows to Move, Space to Shoot\n");
@@ -87,15 +348,37 @@ int main(int argc, char *argv[]) {
     if (valgrind_test && frame_count++ >= 60) {
       break;
     }
+    TRACE_SCOPE("frame");
     uint32_t frame_start = SDL_GetTicks();
+    frame_timer_begin_frame(&frame_timer);
+    PERF_SWITCH(PERF_PHASE_INPUT);
 
     /* Handle SDL events */
     while (sdl_view_poll_event(view, &event)) {
       if (event.type == SDL_EVENT_QUIT) {
         running = false;
       } else if (event.type == SDL_EVENT_KEY_DOWN) {
+        if (event.key.key == SDLK_F3) {
+          show_timing = !show_timing;
+          sdl_view_set_frame_timer(view, show_timing ? &frame_timer : NULL);
+          continue;
+        }
+        if (replay_path) {
+          // Playback owns the inputs; only leaving is allowed
+          if (event.key.key == SDLK_ESCAPE)
+            running = false;
+          continue;
+        }
+        if (netplay) {
+          // No pause or menus while the other side keeps playing
+          if (event.key.key == SDLK_ESCAPE)
+            running = false;
+          else
+            pending_input |= keybind_mask(context->model, (int)event.key.key);
+          continue;
+        }
         // Check if we're waiting for a keybind
-        if (context->model->waiting_for_key) {
+        if (context->model->ui.waiting_for_key) {
           model_set_keybind(context->model, (int)event.key.key);
         } else {
           // If playing, check model keybindings first to support custom
@@ -110,20 +393,29 @@ int main(int argc, char *argv[]) {
     handled = true;                                                            \
   }
 
-          // Always check model keybindings for P1 commands (Menu & Gameplay)
-          CHECK_EVENT_KEY(context->model->keybinds_p1[0], CMD_LEFT);
-          CHECK_EVENT_KEY(context->model->keybinds_p1[1], CMD_RIGHT);
-          CHECK_EVENT_KEY(context->model->keybinds_p1[2], CMD_UP);
-          CHECK_EVENT_KEY(context->model->keybinds_p1[3], CMD_DOWN);
-          CHECK_EVENT_KEY(context->model->keybinds_p1[4], CMD_SHOOT);
-
-          if (context->model->state == STATE_PLAYING) {
-            // Player 2
-            CHECK_EVENT_KEY(context->model->keybinds_p2[0], CMD_P2_MOVE_LEFT);
-            CHECK_EVENT_KEY(context->model->keybinds_p2[1], CMD_P2_MOVE_RIGHT);
-            CHECK_EVENT_KEY(context->model->keybinds_p2[2], CMD_P2_MOVE_UP);
-            CHECK_EVENT_KEY(context->model->keybinds_p2[3], CMD_P2_MOVE_DOWN);
-            CHECK_EVENT_KEY(context->model->keybinds_p2[4], CMD_P2_SHOOT);
+          GameState game_state = context->model->state;
+          InputMask bits = keybind_mask(context->model, key);
+          if (bits && (game_state == STATE_PLAYING ||
+                       game_state == STATE_LEVEL_TRANSITION)) {
+            // In game, presses act on the next tick so they are recorded
+            pending_input |= bits;
+            handled = true;
+          } else if (key == SDLK_RETURN &&
+                     game_state == STATE_LEVEL_TRANSITION) {
+            pending_input |= INPUT_SHOOT; // Same as shooting: next level
+            handled = true;
+          } else if (key == controller->key_pause &&
+                     (game_state == STATE_PLAYING ||
+                      game_state == STATE_PAUSED)) {
+            pending_input |= INPUT_PAUSE;
+            handled = true;
+          } else {
+            // Menus: P1 model keybindings navigate
+            CHECK_EVENT_KEY(context->model->ui.keybinds_p1[0], CMD_LEFT);
+            CHECK_EVENT_KEY(context->model->ui.keybinds_p1[1], CMD_RIGHT);
+            CHECK_EVENT_KEY(context->model->ui.keybinds_p1[2], CMD_UP);
+            CHECK_EVENT_KEY(context->model->ui.keybinds_p1[3], CMD_DOWN);
+            CHECK_EVENT_KEY(context->model->ui.keybinds_p1[4], CMD_SHOOT);
           }
 
           // Fallback to controller mappings (e.g. Pause, Quit, Menu Nav) if not
@@ -140,59 +432,142 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    /* Process continuous input (held keys) using SDL state and model
-     * keybindings */
+    frame_timer_end(&frame_timer, FRAME_PHASE_EVENTS);
+
+    /* Run the simulation ticks due for this frame */
     int num_keys;
     const bool *state = SDL_GetKeyboardState(&num_keys);
+    bool fast_replay = replay_path && replay_speed <= 0;
+    int ticks = fast_replay ? REPLAY_MAX_BATCH
+                            : game_context_advance(context, SDL_GetTicks());
+    float tick_dt = game_context_tick_dt(context);
 
-// Helper to check key by keycode from model
-#define CHECK_MODEL_KEY(keycode, cmd)                                          \
-  {                                                                            \
-    SDL_Scancode sc = SDL_GetScancodeFromKey(keycode, NULL);                   \
-    if ((int)sc < num_keys && state[sc])                                       \
-      controller_execute_command(controller, cmd);                             \
-  }
-
-    if (context->model->state == STATE_PLAYING) {
-      // P1 Model Keybinds (Continuous input for movement)
-      CHECK_MODEL_KEY(context->model->keybinds_p1[0], CMD_LEFT);
-      CHECK_MODEL_KEY(context->model->keybinds_p1[1], CMD_RIGHT);
-      CHECK_MODEL_KEY(context->model->keybinds_p1[2], CMD_UP);
-      CHECK_MODEL_KEY(context->model->keybinds_p1[3], CMD_DOWN);
-      CHECK_MODEL_KEY(context->model->keybinds_p1[4], CMD_SHOOT);
-
-      // P2 uses model keybindings
-      CHECK_MODEL_KEY(context->model->keybinds_p2[0], CMD_P2_MOVE_LEFT);
-      CHECK_MODEL_KEY(context->model->keybinds_p2[1], CMD_P2_MOVE_RIGHT);
-      CHECK_MODEL_KEY(context->model->keybinds_p2[2], CMD_P2_MOVE_UP);
-      CHECK_MODEL_KEY(context->model->keybinds_p2[3], CMD_P2_MOVE_DOWN);
-      CHECK_MODEL_KEY(context->model->keybinds_p2[4], CMD_P2_SHOOT);
-    }
+    int t;
+    for (t = 0; t < ticks; t++) {
+      frame_timer_begin(&frame_timer);
+      // Only the last tick of a rendered frame is blended from
+      if (t == ticks - 1 && !fast_replay)
+        *previous = *context->model;
 
-    /* Calculate delta time */
-    uint32_t current_time = SDL_GetTicks();
-    float delta_time = (current_time - last_update) / 1000.0f;
-    if (delta_time > 0.1f)
-      delta_time = 0.1f;
-    last_update = current_time;
+      if (netplay) {
+        if (!game_in_progress(context->model) && netplay_confirmed(&net)) {
+          // The end of the game is final on both sides
+          netplay_finish(&net, context->model, controller, 2000);
+          print_netplay_stats(&net);
+          netplay = false;
+          break;
+        }
+        if (!game_in_progress(context->model)) {
+          // Ended on a prediction: wait for it to be confirmed or undone
+          netplay_poll(&net, context->model, controller);
+          break;
+        }
+        InputMask mask = local_player_mask(pending_input);
+        if (context->model->state == STATE_PLAYING)
+          mask |= local_player_mask(held_mask(context->model, state, num_keys));
+        frame_timer_end(&frame_timer, FRAME_PHASE_INPUT);
+        PERF_SWITCH(PERF_PHASE_UPDATE);
+        bool advanced = netplay_advance(&net, context->model, controller, mask);
+        frame_timer_end(&frame_timer, FRAME_PHASE_UPDATE);
+        PERF_SWITCH(PERF_PHASE_INPUT);
+        if (!advanced) {
+          if (net.state != NETPLAY_RUNNING) {
+            print_netplay_stats(&net);
+            netplay_close(&net);
+            netplay = false;
+          }
+          break; // Waiting for the other side
+        }
+        pending_input = 0;
+        spectate_publish(&broadcast, context->model, ++sim_ticks);
+        frame_timer_add_ticks(&frame_timer, 1);
+        continue;
+      }
 
-    /* Update game */
-    controller_update(controller, delta_time);
-    model_update(context->model, delta_time);
+      /* One input mask per tick: recorded presses plus held keys */
+      InputMask mask;
+      if (replay_path) {
+        if (!replay_player_next(&replay, context->model, &mask)) {
+          running = false;
+          break;
+        }
+      } else {
+        mask = pending_input;
+        pending_input = 0;
+        if (context->model->state == STATE_PLAYING)
+          mask |= held_mask(context->model, state, num_keys);
+        replay_recorder_tick(&recorder, context->model, mask);
+      }
+      controller_apply_input_mask(controller, mask);
+      frame_timer_end(&frame_timer, FRAME_PHASE_INPUT);
+      PERF_SWITCH(PERF_PHASE_UPDATE);
+
+      controller_update(controller, tick_dt);
+      model_update(context->model, tick_dt);
+      spectate_publish(&broadcast, context->model, ++sim_ticks);
+      frame_timer_end(&frame_timer, FRAME_PHASE_UPDATE);
+      PERF_SWITCH(PERF_PHASE_INPUT);
+      frame_timer_add_ticks(&frame_timer, 1);
+    }
+    if (t < ticks - 1 && !fast_replay)
+      *previous = *context->model; // Stopped early: nothing to blend
+    if (fast_replay) {
+      frame_timer_end_frame(&frame_timer);
+      record_flight(&flight, &frame_timer, context->model);
+      continue; // Rendering skipped
+    }
 
-    /* Render */
+    /* Render, blending the last two ticks */
+    frame_timer_begin(&frame_timer);
+    PERF_SWITCH(PERF_PHASE_RENDER);
+    sdl_view_set_interpolation(view, previous,
+                               game_context_interpolation(context));
     sdl_view_render(view, context->model);
+    frame_timer_end(&frame_timer, FRAME_PHASE_RENDER);
+    frame_timer_end_frame(&frame_timer);
+    record_flight(&flight, &frame_timer, context->model);
+    PERF_SWITCH(PERF_PHASE_IDLE);
 
     /* Cap framerate */
     uint32_t frame_time = SDL_GetTicks() - frame_start;
     if (frame_time < FRAME_DELAY) {
+      TRACE_SCOPE("SDL_Delay");
       SDL_Delay((uint32_t)(FRAME_DELAY - frame_time));
     }
   }
 
+  if (replay_path) {
+    printf("Replay: %d games, %llu ticks, final score %d\n", replay.games,
+           (unsigned long long)replay.ticks, model_get_score(context->model));
+    if (replay.diverged)
+      printf("Diverged from the recording at tick %llu\n",
+             (unsigned long long)replay.diverged_tick);
+    else
+      printf("%u state hashes matched\n", replay.hashes_checked);
+    replay_player_close(&replay);
+  }
+  if (record_path && !replay_path)
+    replay_recorder_close(&recorder);
+  if (netplay) {
+    netplay_finish(&net, context->model, controller, 500);
+    print_netplay_stats(&net);
+  }
+  spectate_publisher_close(&broadcast);
+  if (perf_log_path)
+    printf("Frame timings of %llu frames written to %s\n",
+           (unsigned long long)frame_timer.frames, perf_log_path);
+  frame_timer_close(&frame_timer);
+  trace_stop();
+  if (perf_counting) {
+    perf_counters_print_summary(stdout);
+    perf_counters_close();
+  }
+
   /* Cleanup */
   printf("Cleaning up...\n");
   sdl_view_destroy(view);
+  trace_shutdown(); // The audio thread has stopped with the view
+  free(previous);
   controller_destroy(controller);
   game_context_destroy(context);
 
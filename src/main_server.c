@@ -0,0 +1,189 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server/server.h"
+
+/*
+ * Game server: hosts one independent game per TCP connection on localhost
+ * and prints its load every second, to find how many sessions one machine
+ * sustains at the tick rate. Drive it with space_invaders_loadclient.
+ */
+
+typedef struct {
+  ServerConfig server;
+  int duration; // Seconds, 0 to run until interrupted
+  bool quiet;
+} ServerOptions;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop(int sig) {
+  (void)sig;
+  stop_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  --port N           TCP port on 127.0.0.1 (default %d)\n",
+         SERVER_DEFAULT_PORT);
+  printf("  --workers N        Simulation threads (default: one per CPU)\n");
+  printf("  --max-sessions N   Concurrent sessions (default %d)\n",
+         SERVER_DEFAULT_MAX_SESSIONS);
+  printf("  --tick-rate N      Ticks per second (default %d)\n",
+         SIM_TICK_RATE);
+  printf("  --difficulty D     easy, normal, hard or rogue (default normal)\n");
+  printf("  --seed N           Base seed of the sessions' games\n");
+  printf("  --duration S       Stop after S seconds (default: on Ctrl-C)\n");
+  printf("  --quiet            Only print the summary\n");
+}
+
+static bool parse_difficulty(const char *name, Difficulty *out) {
+  static const char *names[] = {"easy", "normal", "hard", "rogue"};
+  for (int i = 0; i < 4; i++) {
+    if (strcmp(name, names[i]) == 0) {
+      *out = (Difficulty)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parse_options(int argc, char *argv[], ServerOptions *opts) {
+  opts->server = server_default_config();
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  opts->server.workers = cpus < 1                    ? 1
+                         : cpus > SERVER_MAX_WORKERS ? SERVER_MAX_WORKERS
+                                                     : (int)cpus;
+  opts->duration = 0;
+  opts->quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (strcmp(argv[i], "--port") == 0 && has_value) {
+      opts->server.port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--workers") == 0 && has_value) {
+      opts->server.workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-sessions") == 0 && has_value) {
+      opts->server.max_sessions = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tick-rate") == 0 && has_value) {
+      opts->server.tick_rate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--difficulty") == 0 && has_value) {
+      if (!parse_difficulty(argv[++i], &opts->server.difficulty)) {
+        fprintf(stderr, "Unknown difficulty: %s\n", argv[i]);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      opts->server.seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--duration") == 0 && has_value) {
+      opts->duration = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      opts->quiet = true;
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Worker time per session tick, from the busiest worker's share of the
+ * interval; the capacity is how many sessions fill every worker. */
+static void print_interval(const ServerStats *prev, const ServerStats *cur,
+                           double seconds, int tick_rate) {
+  double max_load = 0.0, total_load = 0.0;
+  for (int i = 0; i < cur->workers; i++) {
+    double load =
+        (cur->worker_busy_ns[i] - prev->worker_busy_ns[i]) / (seconds * 1e9);
+    total_load += load;
+    if (load > max_load)
+      max_load = load;
+  }
+  uint64_t session_ticks = cur->session_ticks - prev->session_ticks;
+  uint64_t busy = 0;
+  for (int i = 0; i < cur->workers; i++)
+    busy += cur->worker_busy_ns[i] - prev->worker_busy_ns[i];
+  double per_session_us = session_ticks ? busy / 1e3 / session_ticks : 0.0;
+  double capacity =
+      per_session_us > 0 ? cur->workers * 1e6 / tick_rate / per_session_us
+                         : 0.0;
+
+  printf("%4d sessions | load %5.1f%% avg %5.1f%% max | %6.2f us/session "
+         "tick, ~%.0f sessions | %5.0f frames/s, %llu dropped | %6.1f MB/s "
+         "| %llu overruns, %llu skipped\n",
+         cur->sessions, 100.0 * total_load / cur->workers, 100.0 * max_load,
+         per_session_us, capacity,
+         (cur->frames_sent - prev->frames_sent) / seconds,
+         (unsigned long long)(cur->frames_dropped - prev->frames_dropped),
+         (cur->bytes_sent - prev->bytes_sent) / seconds / 1e6,
+         (unsigned long long)(cur->overruns - prev->overruns),
+         (unsigned long long)(cur->skipped_ticks - prev->skipped_ticks));
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  ServerOptions opts;
+  if (!parse_options(argc, argv, &opts))
+    return 1;
+
+  static GameServer server;
+  if (!server_start(&server, &opts.server))
+    return 1;
+  signal(SIGINT, handle_stop);
+  signal(SIGTERM, handle_stop);
+  printf("Serving on 127.0.0.1:%d: %d workers, up to %d sessions at %d "
+         "ticks/s\n",
+         server_port(&server), opts.server.workers, opts.server.max_sessions,
+         opts.server.tick_rate);
+  fflush(stdout);
+
+  ServerStats first, prev, cur;
+  server_stats(&server, &first);
+  prev = first;
+  uint64_t start = now_ns();
+  uint64_t last_report = start;
+  int peak_sessions = 0;
+  while (!stop_requested) {
+    server_poll(&server, 100);
+    uint64_t now = now_ns();
+    if (opts.duration > 0 && now - start >= opts.duration * 1000000000ull)
+      break;
+    if (now - last_report < 1000000000ull)
+      continue;
+    server_stats(&server, &cur);
+    if (cur.sessions > peak_sessions)
+      peak_sessions = cur.sessions;
+    if (!opts.quiet)
+      print_interval(&prev, &cur, (now - last_report) / 1e9,
+                     opts.server.tick_rate);
+    prev = cur;
+    last_report = now;
+  }
+
+  server_stats(&server, &cur);
+  double seconds = (now_ns() - start) / 1e9;
+  printf("%llu connections (%llu rejected), peak %d sessions, %llu session "
+         "ticks in %.1f s\n",
+         (unsigned long long)cur.accepted, (unsigned long long)cur.rejected,
+         peak_sessions > cur.sessions ? peak_sessions : cur.sessions,
+         (unsigned long long)cur.session_ticks, seconds);
+  printf("%llu frames sent, %llu dropped, %.1f MB; %llu overruns, %llu "
+         "ticks skipped\n",
+         (unsigned long long)cur.frames_sent,
+         (unsigned long long)cur.frames_dropped, cur.bytes_sent / 1e6,
+         (unsigned long long)cur.overruns,
+         (unsigned long long)cur.skipped_ticks);
+  printf("session arena: %zu of %d bytes used at most\n",
+         cur.arena_high_water, SERVER_SESSION_ARENA_SIZE);
+  server_stop(&server);
+  return 0;
+}
@@ -0,0 +1,33 @@
+#include "arena.h"
+
+#include <string.h>
+
+void arena_init(Arena *arena, void *memory, size_t size) {
+  arena->base = memory;
+  arena->size = size;
+  arena->used = 0;
+  arena->high_water = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size, size_t align) {
+  // Align the address, not the offset: the block itself may be unaligned
+  uintptr_t start = (uintptr_t)(arena->base + arena->used);
+  size_t pad = (size_t)(-start & (uintptr_t)(align - 1));
+  if (pad > arena->size - arena->used ||
+      size > arena->size - arena->used - pad)
+    return NULL;
+  void *ptr = arena->base + arena->used + pad;
+  arena->used += pad + size;
+  if (arena->used > arena->high_water)
+    arena->high_water = arena->used;
+  return ptr;
+}
+
+void *arena_calloc(Arena *arena, size_t size, size_t align) {
+  void *ptr = arena_alloc(arena, size, align);
+  if (ptr)
+    memset(ptr, 0, size);
+  return ptr;
+}
+
+void arena_reset(Arena *arena) { arena->used = 0; }
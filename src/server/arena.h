@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocateur linéaire sur un bloc fourni par l'appelant : chaque allocation
+// avance un curseur, et tout est libéré d'un coup par arena_reset. Sert à
+// la mémoire d'une session du serveur, pour que créer et détruire une
+// session ne passe jamais par malloc/free.
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+  size_t high_water; // Plus grande occupation depuis arena_init
+} Arena;
+
+void arena_init(Arena *arena, void *memory, size_t size);
+// `align` : puissance de 2. Renvoie NULL quand le bloc est plein (l'arène
+// reste utilisable pour des demandes plus petites).
+void *arena_alloc(Arena *arena, size_t size, size_t align);
+// Comme arena_alloc, mémoire remise à zéro
+void *arena_calloc(Arena *arena, size_t size, size_t align);
+void arena_reset(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,37 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "delta.h"
+
+// Protocole entre space_invaders_server et ses clients, sur TCP. Chaque
+// message : taille u32 (type + contenu), type u8, contenu. Entiers dans
+// l'ordre d'octets de l'hôte : le serveur ne sert que sur localhost.
+#define SERVER_PROTOCOL_VERSION 2
+#define SERVER_DEFAULT_PORT 7878
+
+typedef enum {
+  SERVER_MSG_WELCOME = 1, // Serveur : session u32, tick_rate u16, version u16
+  SERVER_MSG_STATE = 2,   // Serveur : tick u32, trame delta_encode (la
+                          // première est une trame clé)
+  SERVER_MSG_INPUT = 3,   // Client : masque u16 (InputMask), gardé jusqu'au
+                          // suivant
+} ServerMessageType;
+
+#define SERVER_FRAME_HEADER 5
+#define SERVER_WELCOME_SIZE (SERVER_FRAME_HEADER + 8)
+#define SERVER_INPUT_SIZE (SERVER_FRAME_HEADER + 2)
+#define SERVER_STATE_HEADER (SERVER_FRAME_HEADER + 4)
+#define SERVER_FRAME_MAX (SERVER_STATE_HEADER + DELTA_FRAME_MAX_SIZE)
+
+static inline void server_frame_header(uint8_t *out, ServerMessageType type,
+                                       size_t payload_size) {
+  uint32_t size = (uint32_t)(1 + payload_size);
+  memcpy(out, &size, sizeof(size));
+  out[4] = (uint8_t)type;
+}
+
+#endif // SERVER_PROTOCOL_H
@@ -0,0 +1,497 @@
+#include "server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "delta.h"
+
+#define POLL_EVENTS 64
+#define LISTEN_BACKLOG 512
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline) {
+  struct timespec ts = {(time_t)(deadline / 1000000000ull),
+                        (long)(deadline % 1000000000ull)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+static inline void stat_add(_Atomic uint64_t *counter, uint64_t n) {
+  atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+static inline uint64_t stat_get(_Atomic uint64_t *counter) {
+  return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+ServerConfig server_default_config(void) {
+  ServerConfig config = {
+      .port = SERVER_DEFAULT_PORT,
+      .workers = 4,
+      .max_sessions = SERVER_DEFAULT_MAX_SESSIONS,
+      .tick_rate = SIM_TICK_RATE,
+      .difficulty = DIFFICULTY_NORMAL,
+      .seed = MODEL_DEFAULT_SEED,
+  };
+  return config;
+}
+
+// --- Sessions ---
+
+static ServerWorker *session_worker(GameServer *server, int slot) {
+  return &server->workers[slot % server->config.workers];
+}
+
+// Runs on the polling thread; the session's worker only sees it once the
+// state turns ACTIVE.
+static bool session_open(GameServer *server, int slot, int fd) {
+  ServerSession *s = &server->sessions[slot];
+  arena_reset(&s->arena);
+  s->model = arena_alloc(&s->arena, sizeof(GameModel), _Alignof(GameModel));
+  s->baseline =
+      arena_alloc(&s->arena, sizeof(GameModel), _Alignof(GameModel));
+  s->controller =
+      arena_alloc(&s->arena, sizeof(Controller), _Alignof(Controller));
+  s->out = arena_alloc(&s->arena, SERVER_FRAME_MAX, 64);
+  if (!s->model || !s->baseline || !s->controller || !s->out) {
+    fprintf(stderr, "Session arena too small (%d bytes)\n",
+            SERVER_SESSION_ARENA_SIZE);
+    return false;
+  }
+
+  s->fd = fd;
+  s->id = server->next_id++;
+  s->rx_len = 0;
+  s->out_len = 0;
+  s->out_sent = 0;
+  s->send_failed = false;
+  s->tick = 0;
+  atomic_store_explicit(&s->input, 0, memory_order_relaxed);
+
+  model_init_with_config(s->model, &server->model_config);
+  s->model->difficulty = server->config.difficulty;
+  // Distinct games per connection, reproducible from the server seed
+  model_start_game(s->model,
+                   server->config.seed + s->id * 0x9e3779b97f4a7c15ull);
+  model_init_with_config(s->baseline, &server->model_config);
+  controller_init(s->controller, s->model);
+
+  // A fresh socket has room for it: the welcome always precedes the states
+  uint8_t welcome[SERVER_WELCOME_SIZE];
+  uint16_t tick_rate = (uint16_t)server->config.tick_rate;
+  uint16_t version = SERVER_PROTOCOL_VERSION;
+  server_frame_header(welcome, SERVER_MSG_WELCOME, 8);
+  memcpy(welcome + SERVER_FRAME_HEADER, &s->id, 4);
+  memcpy(welcome + SERVER_FRAME_HEADER + 4, &tick_rate, 2);
+  memcpy(welcome + SERVER_FRAME_HEADER + 6, &version, 2);
+  if (send(fd, welcome, sizeof(welcome), MSG_NOSIGNAL) !=
+      (ssize_t)sizeof(welcome))
+    return false;
+
+  struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP,
+                           .data.u32 = (uint32_t)slot + 1};
+  if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    return false;
+  atomic_store_explicit(&s->state, SESSION_ACTIVE, memory_order_release);
+  return true;
+}
+
+static int session_acquire(GameServer *server) {
+  // The least loaded worker takes the new session
+  int slot = -1;
+  pthread_mutex_lock(&server->free_lock);
+  ServerWorker *best = NULL;
+  for (int i = 0; i < server->config.workers; i++) {
+    ServerWorker *w = &server->workers[i];
+    if (w->free_count > 0 && (!best || w->free_count > best->free_count))
+      best = w;
+  }
+  if (best)
+    slot = best->free_slots[--best->free_count];
+  pthread_mutex_unlock(&server->free_lock);
+  return slot;
+}
+
+// Runs on the session's worker, which is the only one touching it by now
+static void session_release(GameServer *server, ServerWorker *w, int slot) {
+  ServerSession *s = &server->sessions[slot];
+  close(s->fd);
+  s->fd = -1;
+  s->model = NULL;
+  s->baseline = NULL;
+  s->controller = NULL;
+  s->out = NULL;
+  arena_reset(&s->arena);
+  atomic_store_explicit(&s->state, SESSION_FREE, memory_order_relaxed);
+
+  pthread_mutex_lock(&server->free_lock);
+  w->free_slots[w->free_count++] = slot;
+  pthread_mutex_unlock(&server->free_lock);
+}
+
+// Polling thread: stop reading, then hand the session back to its worker
+static void session_hang_up(GameServer *server, int slot) {
+  ServerSession *s = &server->sessions[slot];
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+  atomic_store_explicit(&s->state, SESSION_CLOSING, memory_order_release);
+}
+
+static void session_read(GameServer *server, int slot) {
+  ServerSession *s = &server->sessions[slot];
+  for (;;) {
+    ssize_t n = recv(s->fd, s->rx + s->rx_len, sizeof(s->rx) - s->rx_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                   errno != EINTR)) {
+      session_hang_up(server, slot);
+      return;
+    }
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    s->rx_len += (size_t)n;
+
+    size_t pos = 0;
+    while (s->rx_len - pos >= SERVER_FRAME_HEADER) {
+      uint32_t size;
+      memcpy(&size, s->rx + pos, sizeof(size));
+      if (size < 1 || size > sizeof(s->rx) - 4) {
+        session_hang_up(server, slot); // Not a client of ours
+        return;
+      }
+      if (s->rx_len - pos < 4 + size)
+        break;
+      const uint8_t *msg = s->rx + pos + 4;
+      if (msg[0] == SERVER_MSG_INPUT && size >= 3) {
+        uint16_t mask;
+        memcpy(&mask, msg + 1, sizeof(mask));
+        // Held masks re-apply every tick, so a pause toggle would flicker
+        atomic_store_explicit(&s->input, (uint16_t)(mask & ~INPUT_PAUSE),
+                              memory_order_relaxed);
+      }
+      pos += 4 + size;
+    }
+    memmove(s->rx, s->rx + pos, s->rx_len - pos);
+    s->rx_len -= pos;
+  }
+}
+
+static void server_accept(GameServer *server) {
+  for (;;) {
+    int fd = accept4(server->listen_fd, NULL, NULL,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+      return;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int slot = session_acquire(server);
+    if (slot < 0) {
+      server->rejected++;
+      close(fd);
+      continue;
+    }
+    if (!session_open(server, slot, fd)) {
+      close(fd);
+      pthread_mutex_lock(&server->free_lock);
+      ServerWorker *w = session_worker(server, slot);
+      w->free_slots[w->free_count++] = slot;
+      pthread_mutex_unlock(&server->free_lock);
+    }
+  }
+}
+
+void server_poll(GameServer *server, int timeout_ms) {
+  struct epoll_event events[POLL_EVENTS];
+  int n = epoll_wait(server->epoll_fd, events, POLL_EVENTS, timeout_ms);
+  for (int i = 0; i < n; i++) {
+    uint32_t key = events[i].data.u32;
+    if (key == 0)
+      server_accept(server);
+    else
+      session_read(server, (int)key - 1);
+  }
+}
+
+// --- Workers ---
+
+// Finishes the frame in flight; false while the socket is full
+static bool session_flush(ServerWorker *w, ServerSession *s) {
+  while (s->out_sent < s->out_len) {
+    ssize_t n = send(s->fd, s->out + s->out_sent, s->out_len - s->out_sent,
+                     MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0) {
+      s->out_sent += (size_t)n;
+      stat_add(&w->stats.bytes_sent, (uint64_t)n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return false;
+    } else {
+      // The polling thread sees the shutdown and hangs up
+      shutdown(s->fd, SHUT_RDWR);
+      s->send_failed = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void session_send_state(ServerWorker *w, ServerSession *s) {
+  if (s->send_failed)
+    return;
+  // A slow client skips states rather than queueing them
+  if (!session_flush(w, s)) {
+    stat_add(&w->stats.frames_dropped, 1);
+    return;
+  }
+  // TCP delivers every frame handed to it, so the last one sent is the
+  // client's baseline; the first frame is a key frame
+  size_t size = delta_encode(s->baseline, s->model, s->out_len == 0,
+                             s->out + SERVER_STATE_HEADER);
+  server_frame_header(s->out, SERVER_MSG_STATE, 4 + size);
+  memcpy(s->out + SERVER_FRAME_HEADER, &s->tick, sizeof(s->tick));
+  s->out_len = SERVER_STATE_HEADER + size;
+  s->out_sent = 0;
+  stat_add(&w->stats.frames_sent, 1);
+  session_flush(w, s);
+}
+
+static void session_tick(ServerWorker *w, ServerSession *s, float dt) {
+  // Sessions never leave play: a finished game starts the next one
+  GameState state = s->model->state;
+  if (state != STATE_PLAYING && state != STATE_LEVEL_TRANSITION)
+    model_reset_game(s->model);
+
+  controller_apply_input_mask(
+      s->controller, atomic_load_explicit(&s->input, memory_order_relaxed));
+  model_update(s->model, dt);
+  s->tick++;
+  session_send_state(w, s);
+}
+
+static void *worker_main(void *arg) {
+  ServerWorker *w = arg;
+  GameServer *server = w->server;
+  const int stride = server->config.workers;
+  const uint64_t period = 1000000000ull / (uint64_t)server->config.tick_rate;
+  const float dt = 1.0f / server->config.tick_rate;
+
+  uint64_t tick = 0;
+  while (atomic_load_explicit(&server->running, memory_order_relaxed)) {
+    uint64_t deadline = server->epoch_ns + tick * period;
+    sleep_until_ns(deadline);
+    uint64_t start = now_ns();
+    // Past a few ticks of delay, catching up would only make it worse
+    if (start > deadline + SERVER_MAX_CATCHUP * period) {
+      uint64_t current = (start - server->epoch_ns) / period;
+      stat_add(&w->stats.skipped_ticks, current - tick);
+      tick = current;
+      deadline = server->epoch_ns + tick * period;
+    }
+
+    uint64_t sessions = 0;
+    for (int slot = w->index; slot < server->config.max_sessions;
+         slot += stride) {
+      ServerSession *s = &server->sessions[slot];
+      int state = atomic_load_explicit(&s->state, memory_order_acquire);
+      if (state == SESSION_ACTIVE) {
+        session_tick(w, s, dt);
+        sessions++;
+      } else if (state == SESSION_CLOSING) {
+        session_release(server, w, slot);
+      }
+    }
+
+    uint64_t end = now_ns();
+    stat_add(&w->stats.ticks, 1);
+    stat_add(&w->stats.session_ticks, sessions);
+    stat_add(&w->stats.busy_ns, end - start);
+    if (end > deadline + period)
+      stat_add(&w->stats.overruns, 1);
+    tick++;
+  }
+  return NULL;
+}
+
+// --- Lifecycle ---
+
+static bool server_listen(GameServer *server) {
+  server->listen_fd =
+      socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (server->listen_fd < 0) {
+    perror("socket");
+    return false;
+  }
+  int one = 1;
+  setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons((uint16_t)server->config.port);
+  if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(server->listen_fd, LISTEN_BACKLOG) < 0) {
+    fprintf(stderr, "Cannot listen on port %d: %s\n", server->config.port,
+            strerror(errno));
+    return false;
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(server->listen_fd, (struct sockaddr *)&addr, &len);
+  server->port = ntohs(addr.sin_port);
+
+  server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev = {.events = EPOLLIN, .data.u32 = 0};
+  if (server->epoll_fd < 0 ||
+      epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev) < 0) {
+    perror("epoll");
+    return false;
+  }
+  return true;
+}
+
+bool server_start(GameServer *server, const ServerConfig *config) {
+  memset(server, 0, sizeof(*server));
+  server->config = *config;
+  server->listen_fd = -1;
+  server->epoll_fd = -1;
+  if (config->workers < 1 || config->workers > SERVER_MAX_WORKERS ||
+      config->max_sessions < 1 || config->tick_rate < 1) {
+    fprintf(stderr, "Invalid server configuration\n");
+    return false;
+  }
+  server->model_config = model_default_config();
+  server->model_config.persist_high_score = false;
+  server->model_config.tick_rate = config->tick_rate;
+  pthread_mutex_init(&server->free_lock, NULL);
+
+  // All per-session memory, reserved once; pages are only backed when used
+  const int max = config->max_sessions;
+  server->arena_block_size = (size_t)max * SERVER_SESSION_ARENA_SIZE;
+  server->arena_block = mmap(NULL, server->arena_block_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  server->sessions = calloc((size_t)max, sizeof(ServerSession));
+  server->free_slots = malloc((size_t)max * sizeof(int));
+  if (server->arena_block == MAP_FAILED || !server->sessions ||
+      !server->free_slots) {
+    server->arena_block = NULL;
+    fprintf(stderr, "Cannot reserve memory for %d sessions\n", max);
+    server_stop(server);
+    return false;
+  }
+
+  int *stack = server->free_slots;
+  for (int i = 0; i < config->workers; i++) {
+    ServerWorker *w = &server->workers[i];
+    w->server = server;
+    w->index = i;
+    w->free_slots = stack;
+    // Pushed in reverse so the lowest slots are handed out first
+    for (int slot = i + ((max - 1 - i) / config->workers) * config->workers;
+         slot >= i; slot -= config->workers)
+      w->free_slots[w->free_count++] = slot;
+    w->slot_count = w->free_count;
+    stack += w->slot_count;
+  }
+  for (int i = 0; i < max; i++) {
+    server->sessions[i].fd = -1;
+    arena_init(&server->sessions[i].arena,
+               server->arena_block + (size_t)i * SERVER_SESSION_ARENA_SIZE,
+               SERVER_SESSION_ARENA_SIZE);
+  }
+
+  if (!server_listen(server)) {
+    server_stop(server);
+    return false;
+  }
+
+  atomic_store(&server->running, true);
+  server->epoch_ns = now_ns();
+  for (int i = 0; i < config->workers; i++) {
+    ServerWorker *w = &server->workers[i];
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+      fprintf(stderr, "Cannot start worker thread %d\n", i);
+      server_stop(server);
+      return false;
+    }
+    w->started = true;
+  }
+  return true;
+}
+
+int server_port(const GameServer *server) { return server->port; }
+
+void server_stats(GameServer *server, ServerStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->workers = server->config.workers;
+  stats->accepted = server->next_id;
+  stats->rejected = server->rejected;
+
+  pthread_mutex_lock(&server->free_lock);
+  for (int i = 0; i < server->config.workers; i++) {
+    ServerWorker *w = &server->workers[i];
+    stats->worker_sessions[i] = w->slot_count - w->free_count;
+    stats->sessions += stats->worker_sessions[i];
+  }
+  pthread_mutex_unlock(&server->free_lock);
+
+  for (int i = 0; i < server->config.workers; i++) {
+    ServerWorkerStats *ws = &server->workers[i].stats;
+    stats->worker_ticks[i] = stat_get(&ws->ticks);
+    stats->worker_busy_ns[i] = stat_get(&ws->busy_ns);
+    stats->overruns += stat_get(&ws->overruns);
+    stats->skipped_ticks += stat_get(&ws->skipped_ticks);
+    stats->session_ticks += stat_get(&ws->session_ticks);
+    stats->frames_sent += stat_get(&ws->frames_sent);
+    stats->frames_dropped += stat_get(&ws->frames_dropped);
+    stats->bytes_sent += stat_get(&ws->bytes_sent);
+  }
+  // Arenas are only grown here, on the polling thread
+  for (int i = 0; i < server->config.max_sessions; i++)
+    if (server->sessions[i].arena.high_water > stats->arena_high_water)
+      stats->arena_high_water = server->sessions[i].arena.high_water;
+}
+
+void server_stop(GameServer *server) {
+  atomic_store(&server->running, false);
+  for (int i = 0; i < server->config.workers && i < SERVER_MAX_WORKERS; i++) {
+    if (server->workers[i].started)
+      pthread_join(server->workers[i].thread, NULL);
+    server->workers[i].started = false;
+  }
+  if (server->sessions) {
+    for (int i = 0; i < server->config.max_sessions; i++)
+      if (server->sessions[i].fd >= 0)
+        close(server->sessions[i].fd);
+  }
+  if (server->epoll_fd >= 0)
+    close(server->epoll_fd);
+  if (server->listen_fd >= 0)
+    close(server->listen_fd);
+  if (server->arena_block)
+    munmap(server->arena_block, server->arena_block_size);
+  free(server->sessions);
+  free(server->free_slots);
+  pthread_mutex_destroy(&server->free_lock);
+  server->sessions = NULL;
+  server->free_slots = NULL;
+  server->arena_block = NULL;
+  server->epoll_fd = -1;
+  server->listen_fd = -1;
+}
@@ -0,0 +1,141 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "controller.h"
+#include "model.h"
+#include "protocol.h"
+
+// Serveur de parties : des centaines de sessions GameModel indépendantes,
+// une par connexion TCP. Un nombre fixe de threads de travail simulent les
+// sessions ; la session i appartient au thread i % workers. Tous les
+// threads suivent la même horloge : le tick n de chacun démarre à
+// epoch + n * période. Le thread appelant server_poll gère les connexions
+// et la réception des entrées.
+//
+// Toute la mémoire d'une session (modèle, copie du client, contrôleur,
+// tampon d'envoi) vient de son arène, taillée une fois au démarrage dans un
+// seul bloc mmap : ouvrir et fermer des sessions ne touche jamais au tas.
+#define SERVER_MAX_WORKERS 64
+#define SERVER_DEFAULT_MAX_SESSIONS 1024
+#define SERVER_SESSION_ARENA_SIZE (128 * 1024)
+#define SERVER_MAX_CATCHUP 4 // Ticks de retard rattrapés avant d'en sauter
+
+typedef struct {
+  int port; // 0 : port libre (voir server_port)
+  int workers;
+  int max_sessions;
+  int tick_rate;
+  Difficulty difficulty;
+  uint64_t seed; // Graine de base, combinée au numéro de session
+} ServerConfig;
+
+typedef enum {
+  SESSION_FREE,
+  SESSION_ACTIVE,  // Simulée par son thread
+  SESSION_CLOSING, // Client parti : son thread la ferme au prochain tick
+} ServerSessionState;
+
+typedef struct {
+  _Atomic int state; // ServerSessionState
+  int fd;
+  uint32_t id; // Numéro de connexion, unique sur la vie du serveur
+  _Atomic uint16_t input; // Dernier masque reçu, appliqué à chaque tick
+
+  // Réception, côté server_poll
+  uint8_t rx[4 * SERVER_INPUT_SIZE];
+  size_t rx_len;
+
+  // Côté thread de travail, dans l'arène
+  Arena arena;
+  GameModel *model;
+  GameModel *baseline; // Copie du modèle du client, base des deltas
+  Controller *controller;
+  uint8_t *out; // Trame STATE en cours d'envoi
+  size_t out_len;
+  size_t out_sent;
+  bool send_failed;
+  uint32_t tick;
+} ServerSession;
+
+// Compteurs cumulés d'un thread de travail, lus par server_stats. Alignés
+// pour que deux threads n'écrivent jamais la même ligne de cache.
+typedef struct {
+  _Alignas(64) _Atomic uint64_t ticks;
+  _Atomic uint64_t busy_ns; // Temps passé à simuler et envoyer
+  _Atomic uint64_t overruns; // Ticks finis après le début du suivant
+  _Atomic uint64_t skipped_ticks; // Sautés après un retard trop long
+  _Atomic uint64_t session_ticks;
+  _Atomic uint64_t frames_sent;
+  _Atomic uint64_t frames_dropped; // Trame précédente pas encore partie
+  _Atomic uint64_t bytes_sent;
+} ServerWorkerStats;
+
+struct GameServer;
+
+typedef struct {
+  struct GameServer *server;
+  int index;
+  pthread_t thread;
+  bool started;
+  int slot_count;  // Sessions i telles que i % workers == index
+  int *free_slots; // Pile des sessions libres du thread (sous free_lock)
+  int free_count;
+  ServerWorkerStats stats;
+} ServerWorker;
+
+typedef struct GameServer {
+  ServerConfig config;
+  ModelConfig model_config;
+  int listen_fd;
+  int epoll_fd;
+  int port;
+  atomic_bool running;
+  uint64_t epoch_ns; // Début du tick 0, commun à tous les threads
+
+  ServerSession *sessions; // config.max_sessions
+  uint8_t *arena_block;    // config.max_sessions * SERVER_SESSION_ARENA_SIZE
+  size_t arena_block_size;
+  pthread_mutex_t free_lock;
+  int *free_slots; // Piles des threads de travail, bout à bout
+  uint32_t next_id;
+  uint64_t rejected; // Connexions refusées, serveur plein
+
+  ServerWorker workers[SERVER_MAX_WORKERS];
+} GameServer;
+
+typedef struct {
+  int sessions;
+  int workers;
+  uint64_t accepted;
+  uint64_t rejected;
+  size_t arena_high_water; // Plus grande arène de session utilisée
+  // Sommes sur les threads de travail
+  uint64_t overruns;
+  uint64_t skipped_ticks;
+  uint64_t session_ticks;
+  uint64_t frames_sent;
+  uint64_t frames_dropped;
+  uint64_t bytes_sent;
+  uint64_t worker_ticks[SERVER_MAX_WORKERS];
+  uint64_t worker_busy_ns[SERVER_MAX_WORKERS];
+  int worker_sessions[SERVER_MAX_WORKERS];
+} ServerStats;
+
+ServerConfig server_default_config(void);
+// Écoute sur 127.0.0.1 et lance les threads de travail
+bool server_start(GameServer *server, const ServerConfig *config);
+int server_port(const GameServer *server);
+// Accepte les connexions et lit les entrées pendant au plus `timeout_ms`
+void server_poll(GameServer *server, int timeout_ms);
+void server_stats(GameServer *server, ServerStats *stats);
+// Arrête les threads et ferme toutes les connexions
+void server_stop(GameServer *server);
+
+#endif // SERVER_H
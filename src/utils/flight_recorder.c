@@ -0,0 +1,237 @@
+#include "flight_recorder.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static volatile sig_atomic_t dump_requested;
+
+static void on_sigusr1(int sig) {
+  (void)sig;
+  dump_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static const char *state_name(int state) {
+  static const char *names[] = {
+      [STATE_MENU] = "menu",       [STATE_PLAYING] = "playing",
+      [STATE_PAUSED] = "paused",   [STATE_GAME_OVER] = "game_over",
+      [STATE_LEVEL_TRANSITION] = "level_transition",
+      [STATE_WIN] = "win",         [STATE_QUIT] = "quit",
+  };
+  if (state < 0 || state > STATE_QUIT)
+    return "?";
+  return names[state];
+}
+
+static const char *sound_name(int type) {
+  static const char *names[] = {
+      [EVENT_PLAYER_SHOT] = "shot", [EVENT_ENEMY_SHOT] = "enemy_shot",
+      [EVENT_KILL] = "kill",        [EVENT_PLAYER_HIT] = "hit",
+      [EVENT_POWERUP] = "powerup",  [EVENT_LEVEL_UP] = "level_up",
+      [EVENT_GAME_OVER] = "game_over", [EVENT_WIN] = "win",
+  };
+  if (type < 0 || type > EVENT_WIN)
+    return "?";
+  return names[type];
+}
+
+static const char *music_name(int track) {
+  static const char *names[] = {"none", "game", "boss", "victory", "none"};
+  if (track < 0 || track > 4)
+    return "?";
+  return names[track];
+}
+
+void flight_recorder_init(FlightRecorder *rec, const char *dir,
+                          int budget_ms) {
+  memset(rec, 0, sizeof(*rec));
+  snprintf(rec->dir, sizeof(rec->dir), "%s", dir ? dir : ".");
+  rec->budget_us = budget_ms > 0 ? (uint32_t)budget_ms * 1000 : 0;
+  rec->start_ns = now_ns();
+  rec->last_state = -1;
+  rec->last_level = -1;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_sigusr1;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR1, &sa, NULL);
+}
+
+void flight_recorder_note(FlightRecorder *rec, FlightEventType type, int arg,
+                          uint32_t us) {
+  FlightFrame *f = &rec->next;
+  if (f->event_count == FLIGHT_FRAME_EVENTS) {
+    if (f->events_lost < UINT8_MAX)
+      f->events_lost++;
+    return;
+  }
+  f->events[f->event_count++] = (FlightEvent){(uint8_t)type, (int16_t)arg, us};
+}
+
+static int live_invaders(const GameModel *model) {
+  int n = 0;
+  for (int i = 0; i < INVADER_ROWS; i++)
+    n += __builtin_popcount(model->invaders.row_mask[i]);
+  return n;
+}
+
+bool flight_recorder_end_frame(FlightRecorder *rec, const FrameTimer *timer,
+                               const GameModel *model) {
+  // Changes are read off the model, which never reports them to the view
+  int level = model->players[0].level;
+  if ((int)model->state != rec->last_state) {
+    flight_recorder_note(rec, FLIGHT_EVENT_STATE, model->state, 0);
+    rec->last_state = model->state;
+  }
+  if (level != rec->last_level) {
+    flight_recorder_note(rec, FLIGHT_EVENT_LEVEL, level, 0);
+    rec->last_level = level;
+  }
+
+  FlightFrame *f = &rec->next;
+  f->frame = timer->frames;
+  f->time_ms = (uint32_t)((timer->frame_start_ns - rec->start_ns) / 1000000);
+  f->gap_us = rec->last_frame_start_ns
+                  ? (uint32_t)((timer->frame_start_ns -
+                                rec->last_frame_start_ns) / 1000)
+                  : 0;
+  rec->last_frame_start_ns = timer->frame_start_ns;
+  for (int p = 0; p <= FRAME_PHASE_COUNT; p++)
+    f->phase_us[p] = frame_timer_last(timer, (FramePhase)p);
+  f->ticks = (uint16_t)timer->ticks;
+  f->state = (uint8_t)model->state;
+  f->level = (uint8_t)level;
+  f->invaders = (uint16_t)live_invaders(model);
+  f->player_bullets = (uint16_t)(model->player_bullets[0].live_count +
+                                 model->player_bullets[1].live_count);
+  f->enemy_bullets = (uint16_t)model->enemy_bullets.live_count;
+  f->powerups = 0;
+  for (size_t i = 0; i < sizeof(model->powerups) / sizeof(model->powerups[0]);
+       i++)
+    f->powerups += model->powerups[i].alive;
+  f->saucer = model->saucer.alive;
+  f->big_invader = model->invaders.big_invader.alive;
+  f->boss_health = model->boss.alive ? (int16_t)model->boss.health : -1;
+
+  rec->ring[rec->recorded % FLIGHT_RECORDER_FRAMES] = *f;
+  rec->recorded++;
+  memset(f, 0, sizeof(*f));
+
+  const FlightFrame *last =
+      &rec->ring[(rec->recorded - 1) % FLIGHT_RECORDER_FRAMES];
+  char reason[96];
+  if (dump_requested) {
+    dump_requested = 0;
+    snprintf(reason, sizeof(reason), "SIGUSR1 at frame %llu",
+             (unsigned long long)last->frame);
+  } else {
+    uint32_t took = last->phase_us[FRAME_PHASE_TOTAL];
+    uint32_t worst = took > last->gap_us ? took : last->gap_us;
+    if (!rec->budget_us || worst <= rec->budget_us ||
+        rec->recorded < rec->quiet_until)
+      return false;
+    // One dump per ring: the frames around a burst of hitches are in it
+    rec->quiet_until = rec->recorded + FLIGHT_RECORDER_FRAMES;
+    snprintf(reason, sizeof(reason), "frame %llu %s %.1f ms%s (budget %.1f ms)",
+             (unsigned long long)last->frame,
+             worst == took ? "took" : "started", worst / 1000.0,
+             worst == took ? "" : " after the previous one",
+             rec->budget_us / 1000.0);
+  }
+  return flight_recorder_dump(rec, reason);
+}
+
+static void write_events(FILE *out, const FlightFrame *f) {
+  for (int i = 0; i < f->event_count; i++) {
+    const FlightEvent *e = &f->events[i];
+    if (i > 0)
+      fputc(' ', out);
+    switch (e->type) {
+    case FLIGHT_EVENT_STATE:
+      fprintf(out, "state=%s", state_name(e->arg));
+      break;
+    case FLIGHT_EVENT_LEVEL:
+      fprintf(out, "level=%d", e->arg);
+      break;
+    case FLIGHT_EVENT_MUSIC:
+      fprintf(out, "music=%s", music_name(e->arg));
+      break;
+    case FLIGHT_EVENT_SOUND:
+      fprintf(out, "sound=%s", sound_name(e->arg));
+      break;
+    default:
+      fprintf(out, "event%d=%d", e->type, e->arg);
+      break;
+    }
+    if (e->us)
+      fprintf(out, "(%uus)", e->us);
+  }
+  if (f->events_lost)
+    fprintf(out, "%s+%u more", f->event_count ? " " : "", f->events_lost);
+}
+
+bool flight_recorder_dump(FlightRecorder *rec, const char *reason) {
+  if (rec->recorded == 0)
+    return false;
+  const FlightFrame *newest =
+      &rec->ring[(rec->recorded - 1) % FLIGHT_RECORDER_FRAMES];
+  time_t now = time(NULL);
+  struct tm tm;
+  localtime_r(&now, &tm);
+  char stamp[32];
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+  snprintf(rec->last_path, sizeof(rec->last_path), "%s/flight_%s_%llu.csv",
+           rec->dir, stamp, (unsigned long long)newest->frame);
+
+  FILE *out = fopen(rec->last_path, "w");
+  if (!out) {
+    fprintf(stderr, "Flight recorder: %s: %s\n", rec->last_path,
+            strerror(errno));
+    return false;
+  }
+  uint64_t count = rec->recorded < FLIGHT_RECORDER_FRAMES
+                       ? rec->recorded
+                       : FLIGHT_RECORDER_FRAMES;
+  strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+  fprintf(out, "# Space Invaders flight recorder, %s\n", stamp);
+  fprintf(out, "# %s\n", reason);
+  fprintf(out, "# Last %llu frames, oldest first; times in microseconds\n",
+          (unsigned long long)count);
+  fprintf(out, "frame,time_ms,gap_us");
+  for (int p = 0; p <= FRAME_PHASE_COUNT; p++)
+    fprintf(out, ",%s_us", frame_timer_phase_name((FramePhase)p));
+  fprintf(out, ",ticks,state,level,invaders,player_bullets,enemy_bullets,"
+               "powerups,saucer,big_invader,boss_health,events\n");
+  for (uint64_t i = rec->recorded - count; i < rec->recorded; i++) {
+    const FlightFrame *f = &rec->ring[i % FLIGHT_RECORDER_FRAMES];
+    fprintf(out, "%llu,%u,%u", (unsigned long long)f->frame, f->time_ms,
+            f->gap_us);
+    for (int p = 0; p <= FRAME_PHASE_COUNT; p++)
+      fprintf(out, ",%u", f->phase_us[p]);
+    fprintf(out, ",%u,%s,%u,%u,%u,%u,%u,%d,%d,%d,", f->ticks,
+            state_name(f->state), f->level, f->invaders, f->player_bullets,
+            f->enemy_bullets, f->powerups, f->saucer, f->big_invader,
+            f->boss_health);
+    write_events(out, f);
+    fputc('\n', out);
+  }
+  bool ok = !ferror(out);
+  if (fclose(out) != 0)
+    ok = false;
+  if (!ok) {
+    fprintf(stderr, "Flight recorder: failed to write %s\n", rec->last_path);
+    return false;
+  }
+  rec->dumps++;
+  return true;
+}
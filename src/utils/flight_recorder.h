@@ -0,0 +1,89 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../core/model.h"
+#include "frame_timer.h"
+
+// Flight recorder for the interactive front ends: the last
+// FLIGHT_RECORDER_FRAMES frames stay in a fixed ring, each with its phase
+// timings, live entity counts, model state and what happened during it
+// (state and level changes, music switches, sound starts). When a frame or
+// the gap since the previous one goes over the budget, or on SIGUSR1, the
+// ring is written to flight_YYYYMMDD_HHMMSS_<frame>.csv. Recording copies
+// about a hundred bytes per frame and never allocates.
+
+#define FLIGHT_RECORDER_FRAMES 600  // 10 s at 60 fps
+#define FLIGHT_FRAME_EVENTS 6       // Per frame; more are only counted
+#define FLIGHT_DEFAULT_BUDGET_MS 25 // Hitch threshold when not configured
+
+typedef enum {
+  FLIGHT_EVENT_STATE, // arg = new GameState
+  FLIGHT_EVENT_LEVEL, // arg = new level
+  FLIGHT_EVENT_MUSIC, // arg = new track: 1 game, 2 boss, 3 victory, 4 none
+  FLIGHT_EVENT_SOUND, // arg = GameEventType whose effect was started
+} FlightEventType;
+
+typedef struct {
+  uint8_t type;    // FlightEventType
+  int16_t arg;
+  uint32_t us;     // Time spent doing it, 0 when not timed
+} FlightEvent;
+
+typedef struct {
+  uint64_t frame;
+  uint32_t time_ms; // Since flight_recorder_init
+  uint32_t gap_us;  // Start of the previous frame to the start of this one
+  uint32_t phase_us[FRAME_PHASE_COUNT + 1]; // As in FrameTimer, plus total
+  uint16_t ticks;
+  uint8_t state; // GameState at the end of the frame
+  uint8_t level;
+  uint16_t invaders; // Live formation invaders
+  uint16_t player_bullets;
+  uint16_t enemy_bullets;
+  uint8_t powerups;
+  bool saucer;
+  bool big_invader;
+  int16_t boss_health; // -1 without a boss
+  uint8_t event_count;
+  uint8_t events_lost; // Beyond FLIGHT_FRAME_EVENTS
+  FlightEvent events[FLIGHT_FRAME_EVENTS];
+} FlightFrame;
+
+typedef struct {
+  FlightFrame ring[FLIGHT_RECORDER_FRAMES];
+  uint64_t recorded;  // Frames recorded; the newest is at (recorded - 1) % N
+  FlightFrame next;   // Events noted for the frame in progress
+  uint32_t budget_us; // 0 disables hitch dumps; SIGUSR1 still works
+  char dir[256];
+  uint64_t start_ns;
+  uint64_t last_frame_start_ns;
+  uint64_t quiet_until; // No hitch dump before this frame: one per ring
+  int last_state;
+  int last_level;
+  uint32_t dumps;
+  char last_path[320]; // Of the latest dump
+} FlightRecorder;
+
+// Dumps go to `dir` (NULL for the working directory). Installs the SIGUSR1
+// handler.
+void flight_recorder_init(FlightRecorder *rec, const char *dir,
+                          int budget_ms);
+
+// Adds an event to the frame in progress
+void flight_recorder_note(FlightRecorder *rec, FlightEventType type, int arg,
+                          uint32_t us);
+
+// Records the frame `timer` just closed with frame_timer_end_frame, then
+// dumps the ring if it was a hitch or SIGUSR1 arrived. Returns true when a
+// dump was written, to last_path.
+bool flight_recorder_end_frame(FlightRecorder *rec, const FrameTimer *timer,
+                               const GameModel *model);
+
+// Writes the ring, oldest frame first, under a reason line. Returns false
+// on a write error, after saying why.
+bool flight_recorder_dump(FlightRecorder *rec, const char *reason);
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,134 @@
+#include "frame_timer.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char *phase_names[FRAME_PHASE_COUNT + 1] = {
+    [FRAME_PHASE_EVENTS] = "events", [FRAME_PHASE_INPUT] = "input",
+    [FRAME_PHASE_UPDATE] = "update", [FRAME_PHASE_RENDER] = "render",
+    [FRAME_PHASE_TOTAL] = "frame",
+};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_of(uint32_t us) {
+  uint32_t b = us / FRAME_TIMER_BUCKET_US;
+  return b < FRAME_TIMER_BUCKETS ? (int)b : FRAME_TIMER_BUCKETS - 1;
+}
+
+bool frame_timer_init(FrameTimer *timer, const char *csv_path) {
+  memset(timer, 0, sizeof(*timer));
+  if (!csv_path)
+    return true;
+  timer->csv = fopen(csv_path, "w");
+  if (!timer->csv) {
+    perror(csv_path);
+    return false;
+  }
+  fprintf(timer->csv,
+          "frame,ticks,events_us,input_us,update_us,render_us,frame_us\n");
+  return true;
+}
+
+void frame_timer_close(FrameTimer *timer) {
+  if (timer->csv)
+    fclose(timer->csv);
+  timer->csv = NULL;
+}
+
+void frame_timer_begin_frame(FrameTimer *timer) {
+  memset(timer->phase_ns, 0, sizeof(timer->phase_ns));
+  timer->ticks = 0;
+  timer->frame_start_ns = now_ns();
+  timer->phase_start_ns = timer->frame_start_ns;
+}
+
+void frame_timer_begin(FrameTimer *timer) { timer->phase_start_ns = now_ns(); }
+
+void frame_timer_end(FrameTimer *timer, FramePhase phase) {
+  uint64_t now = now_ns();
+  timer->phase_ns[phase] += now - timer->phase_start_ns;
+  timer->phase_start_ns = now;
+}
+
+void frame_timer_add_ticks(FrameTimer *timer, int ticks) {
+  timer->ticks += ticks;
+}
+
+void frame_timer_end_frame(FrameTimer *timer) {
+  uint32_t us[FRAME_PHASE_COUNT + 1];
+  for (int p = 0; p < FRAME_PHASE_COUNT; p++)
+    us[p] = (uint32_t)(timer->phase_ns[p] / 1000);
+  us[FRAME_PHASE_TOTAL] = (uint32_t)((now_ns() - timer->frame_start_ns) / 1000);
+
+  // The oldest frame leaves the window as this one enters it
+  int slot = timer->head;
+  bool full = timer->count == FRAME_TIMER_WINDOW;
+  if (full && timer->samples[FRAME_PHASE_TOTAL][slot] > FRAME_TIMER_BUDGET_US)
+    timer->over_budget--;
+  for (int p = 0; p <= FRAME_PHASE_COUNT; p++) {
+    if (full) {
+      uint32_t old = timer->samples[p][slot];
+      timer->histogram[p][bucket_of(old)]--;
+      timer->sum_us[p] -= old;
+    }
+    timer->samples[p][slot] = us[p];
+    timer->histogram[p][bucket_of(us[p])]++;
+    timer->sum_us[p] += us[p];
+  }
+  if (us[FRAME_PHASE_TOTAL] > FRAME_TIMER_BUDGET_US)
+    timer->over_budget++;
+  timer->head = (slot + 1) % FRAME_TIMER_WINDOW;
+  if (!full)
+    timer->count++;
+  timer->frames++;
+
+  if (timer->csv)
+    fprintf(timer->csv, "%llu,%d,%u,%u,%u,%u,%u\n",
+            (unsigned long long)timer->frames, timer->ticks,
+            us[FRAME_PHASE_EVENTS], us[FRAME_PHASE_INPUT],
+            us[FRAME_PHASE_UPDATE], us[FRAME_PHASE_RENDER],
+            us[FRAME_PHASE_TOTAL]);
+}
+
+uint32_t frame_timer_last(const FrameTimer *timer, FramePhase phase) {
+  if (timer->count == 0)
+    return 0;
+  int slot = (timer->head + FRAME_TIMER_WINDOW - 1) % FRAME_TIMER_WINDOW;
+  return timer->samples[phase][slot];
+}
+
+FramePhaseStats frame_timer_stats(const FrameTimer *timer, FramePhase phase) {
+  FramePhaseStats st = {0};
+  if (timer->count == 0)
+    return st;
+  const uint32_t *samples = timer->samples[phase];
+  uint32_t min = UINT32_MAX, max = 0;
+  for (int i = 0; i < timer->count; i++) {
+    if (samples[i] < min)
+      min = samples[i];
+    if (samples[i] > max)
+      max = samples[i];
+  }
+  // First bucket reaching 99% of the window
+  int need = (timer->count * 99 + 99) / 100, seen = 0, b = 0;
+  for (; b < FRAME_TIMER_BUCKETS - 1; b++) {
+    seen += timer->histogram[phase][b];
+    if (seen >= need)
+      break;
+  }
+  float p99 = (b + 1) * FRAME_TIMER_BUCKET_US / 1000.0f;
+  st.min_ms = min / 1000.0f;
+  st.max_ms = max / 1000.0f;
+  st.avg_ms = (float)timer->sum_us[phase] / timer->count / 1000.0f;
+  st.p99_ms = p99 < st.max_ms ? p99 : st.max_ms;
+  return st;
+}
+
+const char *frame_timer_phase_name(FramePhase phase) {
+  return phase_names[phase];
+}
@@ -0,0 +1,74 @@
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Per-phase frame timing for the interactive front ends. Each frame is
+// split into phases timed with the monotonic clock; the last
+// FRAME_TIMER_WINDOW frames are kept in a rolling window with a histogram
+// per phase, from which min / avg / p99 are read for the overlay. With a
+// CSV file open, every frame is also written out as one row.
+
+typedef enum {
+  FRAME_PHASE_EVENTS, // Polling and dispatching input events
+  FRAME_PHASE_INPUT,  // Per-tick input masks (held keys, replays, records)
+  FRAME_PHASE_UPDATE, // controller_update + model_update for every tick
+  FRAME_PHASE_RENDER, // Drawing, including the present
+  FRAME_PHASE_COUNT,
+  FRAME_PHASE_TOTAL = FRAME_PHASE_COUNT // Whole frame, before the cap delay
+} FramePhase;
+
+#define FRAME_TIMER_WINDOW 240      // Frames in the rolling statistics
+#define FRAME_TIMER_BUCKET_US 100   // Histogram resolution
+#define FRAME_TIMER_BUCKETS 500     // Up to 50 ms; slower frames share the last
+#define FRAME_TIMER_BUDGET_US 16667 // One frame at 60 Hz
+
+typedef struct {
+  float min_ms;
+  float avg_ms;
+  float p99_ms; // Upper edge of the bucket holding the 99th percentile
+  float max_ms;
+} FramePhaseStats;
+
+typedef struct {
+  // Rolling window: microseconds per phase, plus the whole frame
+  uint32_t samples[FRAME_PHASE_COUNT + 1][FRAME_TIMER_WINDOW];
+  uint16_t histogram[FRAME_PHASE_COUNT + 1][FRAME_TIMER_BUCKETS];
+  uint64_t sum_us[FRAME_PHASE_COUNT + 1];
+  int head;  // Next slot to overwrite
+  int count; // Frames in the window
+
+  // Frame in progress
+  uint64_t frame_start_ns;
+  uint64_t phase_start_ns;
+  uint64_t phase_ns[FRAME_PHASE_COUNT];
+  int ticks; // Simulation ticks run this frame
+
+  uint64_t frames;      // Frames completed
+  uint32_t over_budget; // Frames in the window above FRAME_TIMER_BUDGET_US
+  FILE *csv;
+} FrameTimer;
+
+// Opens `csv_path` for the per-frame log when not NULL. Returns false when
+// the file cannot be created.
+bool frame_timer_init(FrameTimer *timer, const char *csv_path);
+void frame_timer_close(FrameTimer *timer);
+
+void frame_timer_begin_frame(FrameTimer *timer);
+// Phases may run several times per frame (once per tick); their times add up
+void frame_timer_begin(FrameTimer *timer);
+void frame_timer_end(FrameTimer *timer, FramePhase phase);
+void frame_timer_add_ticks(FrameTimer *timer, int ticks);
+// Closes the frame: rolls it into the window and logs it
+void frame_timer_end_frame(FrameTimer *timer);
+
+// Microseconds of FRAME_PHASE_* or FRAME_PHASE_TOTAL in the last frame
+// closed, 0 before the first
+uint32_t frame_timer_last(const FrameTimer *timer, FramePhase phase);
+// Statistics of FRAME_PHASE_* or FRAME_PHASE_TOTAL over the window
+FramePhaseStats frame_timer_stats(const FrameTimer *timer, FramePhase phase);
+const char *frame_timer_phase_name(FramePhase phase);
+
+#endif // FRAME_TIMER_H
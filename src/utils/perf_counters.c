@@ -0,0 +1,314 @@
+#include "perf_counters.h"
+
+#ifdef ENABLE_PERF_COUNTERS
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static const struct {
+  uint32_t type;
+  uint64_t config;
+  const char *name;
+} counter_events[PERF_COUNTER_COUNT] = {
+    [PERF_CYCLES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    [PERF_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+                           "instructions"},
+    [PERF_CACHE_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,
+                           "cache misses"},
+    [PERF_BRANCH_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,
+                            "branch misses"},
+};
+
+static const char *phase_names[PERF_PHASE_COUNT] = {
+    [PERF_PHASE_INPUT] = "input",         [PERF_PHASE_UPDATE] = "update",
+    [PERF_PHASE_COLLISION] = "collision", [PERF_PHASE_RENDER] = "render",
+    [PERF_PHASE_PRESENT] = "present",
+};
+
+// Layout of a PERF_FORMAT_GROUP read
+typedef struct {
+  uint64_t nr;
+  uint64_t time_enabled;
+  uint64_t time_running;
+  uint64_t values[PERF_COUNTER_COUNT];
+} GroupRead;
+
+static struct {
+  int fd[PERF_COUNTER_COUNT];
+  // User-space reads: one mapped page per event, valid when use_rdpmc
+  struct perf_event_mmap_page *page[PERF_COUNTER_COUNT];
+  bool use_rdpmc;
+  PerfPhase current;
+  uint64_t last[PERF_COUNTER_COUNT]; // Group values at the last switch
+  uint64_t totals[PERF_PHASE_COUNT][PERF_COUNTER_COUNT];
+  uint64_t entries[PERF_PHASE_COUNT];
+  uint64_t time_enabled, time_running;
+
+  uint64_t ticks;
+  uint64_t interval_ticks; // Ticks at the previous interval line
+  uint64_t interval_start_ns;
+  uint64_t opened_ns;
+  uint64_t interval_totals[PERF_PHASE_COUNT][PERF_COUNTER_COUNT];
+} perf = {.fd = {-1, -1, -1, -1}};
+
+static long page_size;
+
+// Only the opening thread reads the group; others see false here
+static _Thread_local bool perf_owner;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int open_event(int counter, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = counter_events[counter].type;
+  attr.config = counter_events[counter].config;
+  attr.disabled = group_fd < 0; // The leader starts the whole group
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static bool read_group(uint64_t values[PERF_COUNTER_COUNT]) {
+  GroupRead r;
+  if (read(perf.fd[0], &r, sizeof(r)) != (ssize_t)sizeof(r))
+    return false;
+  memcpy(values, r.values, sizeof(r.values));
+  perf.time_enabled = r.time_enabled;
+  perf.time_running = r.time_running;
+  return true;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t rdpmc(uint32_t counter) {
+  uint32_t lo, hi;
+  __asm__ volatile("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+  return (uint64_t)hi << 32 | lo;
+}
+
+// Reads one counter without a system call, as described for
+// perf_event_mmap_page: retried while the kernel updates the page
+static uint64_t read_mapped(const volatile struct perf_event_mmap_page *pc) {
+  uint32_t seq;
+  uint64_t count;
+  do {
+    seq = pc->lock;
+    atomic_signal_fence(memory_order_seq_cst);
+    uint32_t index = pc->index;
+    count = pc->offset;
+    if (index) { // 0 while the event is off the PMU: offset is the total
+      unsigned shift = 64 - pc->pmc_width;
+      count += (uint64_t)((int64_t)(rdpmc(index - 1) << shift) >> shift);
+    }
+    atomic_signal_fence(memory_order_seq_cst);
+  } while (pc->lock != seq);
+  return count;
+}
+#endif
+
+// Maps every event; user-space reads only when the kernel allows all four
+static bool map_events(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  page_size = sysconf(_SC_PAGESIZE);
+  for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+    void *page =
+        mmap(NULL, (size_t)page_size, PROT_READ, MAP_SHARED, perf.fd[c], 0);
+    if (page == MAP_FAILED)
+      return false;
+    perf.page[c] = page;
+    if (!perf.page[c]->cap_user_rdpmc)
+      return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+static void unmap_events(void) {
+  for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+    if (perf.page[c])
+      munmap(perf.page[c], (size_t)page_size);
+    perf.page[c] = NULL;
+  }
+  perf.use_rdpmc = false;
+}
+
+static bool read_counters(uint64_t values[PERF_COUNTER_COUNT]) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (perf.use_rdpmc) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+      values[c] = read_mapped(perf.page[c]);
+    return true;
+  }
+#endif
+  return read_group(values);
+}
+
+bool perf_counters_open(void) {
+  for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+    perf.fd[c] = open_event(c, c == 0 ? -1 : perf.fd[0]);
+    if (perf.fd[c] < 0) {
+      fprintf(stderr, "Hardware counters unavailable (%s: %s)\n",
+              counter_events[c].name, strerror(errno));
+      perf_counters_close();
+      return false;
+    }
+  }
+  // A system call per phase switch costs microseconds and evicts cache
+  // lines the next phase would count as misses; rdpmc avoids both
+  perf.use_rdpmc = map_events();
+  if (!perf.use_rdpmc)
+    unmap_events();
+  memset(perf.totals, 0, sizeof(perf.totals));
+  memset(perf.entries, 0, sizeof(perf.entries));
+  memset(perf.interval_totals, 0, sizeof(perf.interval_totals));
+  perf.current = PERF_PHASE_IDLE;
+  perf.ticks = perf.interval_ticks = 0;
+  perf.opened_ns = perf.interval_start_ns = now_ns();
+  ioctl(perf.fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(perf.fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  perf_owner = read_counters(perf.last);
+  return perf_owner;
+}
+
+void perf_counters_close(void) {
+  unmap_events();
+  for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+    if (perf.fd[c] >= 0)
+      close(perf.fd[c]);
+    perf.fd[c] = -1;
+  }
+  perf_owner = false;
+}
+
+static PerfPhase switch_phase(PerfPhase phase) {
+  PerfPhase previous = perf.current;
+  uint64_t values[PERF_COUNTER_COUNT];
+  if (!read_counters(values))
+    return previous;
+  if (previous != PERF_PHASE_IDLE)
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+      perf.totals[previous][c] += values[c] - perf.last[c];
+  memcpy(perf.last, values, sizeof(values));
+  perf.current = phase;
+  return previous;
+}
+
+PerfPhase perf_counters_switch(PerfPhase phase) {
+  if (!perf_owner)
+    return PERF_PHASE_IDLE;
+  PerfPhase previous = switch_phase(phase);
+  if (phase != PERF_PHASE_IDLE && phase != previous)
+    perf.entries[phase]++;
+  return previous;
+}
+
+void perf_counters_restore(PerfPhase *previous) {
+  if (perf_owner)
+    switch_phase(*previous);
+}
+
+bool perf_counters_tick(void) {
+  if (!perf_owner)
+    return false;
+  // The clock is only read every 1024 ticks
+  return (++perf.ticks & 1023) == 0 &&
+         now_ns() - perf.interval_start_ns >= PERF_INTERVAL_NS;
+}
+
+static double ratio(uint64_t num, uint64_t den) {
+  return den ? (double)num / den : 0.0;
+}
+
+void perf_counters_print_interval(FILE *out) {
+  if (!perf_owner)
+    return;
+  switch_phase(perf.current); // Charge what is running
+  uint64_t now = now_ns();
+  uint64_t ticks = perf.ticks - perf.interval_ticks;
+  fprintf(out, "perf %6.1f s, %8llu ticks, per tick:",
+          (now - perf.opened_ns) / 1e9, (unsigned long long)ticks);
+  for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+    uint64_t d[PERF_COUNTER_COUNT];
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+      d[c] = perf.totals[p][c] - perf.interval_totals[p][c];
+    if (d[PERF_CYCLES] == 0)
+      continue;
+    fprintf(out, "  %s %.0f cyc %.2f IPC %.2f CM %.2f BM", phase_names[p],
+            ratio(d[PERF_CYCLES], ticks),
+            ratio(d[PERF_INSTRUCTIONS], d[PERF_CYCLES]),
+            ratio(d[PERF_CACHE_MISSES], ticks),
+            ratio(d[PERF_BRANCH_MISSES], ticks));
+  }
+  fputc('\n', out);
+  memcpy(perf.interval_totals, perf.totals, sizeof(perf.totals));
+  perf.interval_ticks = perf.ticks;
+  perf.interval_start_ns = now;
+}
+
+void perf_counters_print_summary(FILE *out) {
+  if (!perf_owner)
+    return;
+  switch_phase(perf.current);
+  uint64_t values[PERF_COUNTER_COUNT];
+  read_group(values); // For the enabled and running times
+  fprintf(out, "\nHardware counters per phase (user space, read with %s):\n",
+          perf.use_rdpmc ? "rdpmc" : "read()");
+  fprintf(out, "%-10s %10s %14s %14s %5s %12s %6s %12s %6s\n", "phase",
+          "entries", "cycles", "instructions", "IPC", "cache-miss", "/kinst",
+          "branch-miss", "/kinst");
+  for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+    const uint64_t *t = perf.totals[p];
+    if (perf.entries[p] == 0)
+      continue;
+    fprintf(out, "%-10s %10llu %14llu %14llu %5.2f %12llu %6.2f %12llu %6.2f\n",
+            phase_names[p], (unsigned long long)perf.entries[p],
+            (unsigned long long)t[PERF_CYCLES],
+            (unsigned long long)t[PERF_INSTRUCTIONS],
+            ratio(t[PERF_INSTRUCTIONS], t[PERF_CYCLES]),
+            (unsigned long long)t[PERF_CACHE_MISSES],
+            1000.0 * ratio(t[PERF_CACHE_MISSES], t[PERF_INSTRUCTIONS]),
+            (unsigned long long)t[PERF_BRANCH_MISSES],
+            1000.0 * ratio(t[PERF_BRANCH_MISSES], t[PERF_INSTRUCTIONS]));
+  }
+  if (perf.time_running < perf.time_enabled)
+    fprintf(out, "Counters were scheduled %.0f%% of the time (multiplexed); "
+                 "totals are undercounted\n",
+            100.0 * ratio(perf.time_running, perf.time_enabled));
+}
+
+#else
+
+bool perf_counters_open(void) { return false; }
+
+void perf_counters_close(void) {}
+
+PerfPhase perf_counters_switch(PerfPhase phase) {
+  (void)phase;
+  return PERF_PHASE_IDLE;
+}
+
+void perf_counters_restore(PerfPhase *previous) { (void)previous; }
+
+bool perf_counters_tick(void) { return false; }
+
+void perf_counters_print_interval(FILE *out) { (void)out; }
+
+void perf_counters_print_summary(FILE *out) { (void)out; }
+
+#endif // ENABLE_PERF_COUNTERS
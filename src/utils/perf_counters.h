@@ -0,0 +1,81 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Hardware counters per main loop phase, read with Linux perf_event_open:
+// cycles, instructions, cache misses and branch misses, user space only,
+// opened as one group so the four always cover the same instructions.
+//
+// The loop marks which phase runs next with PERF_SWITCH; everything until
+// the next switch is charged to that phase. PERF_SCOPE charges the rest of a
+// block to a phase nested in the current one (collisions inside the model
+// update) and switches back at the end of the block.
+//
+// Only builds with ENABLE_PERF_COUNTERS (make profile) have the markers.
+// Counters follow the thread that opened them; markers on other threads are
+// ignored.
+
+typedef enum {
+  PERF_PHASE_INPUT,     // Events and per-tick input masks
+  PERF_PHASE_UPDATE,    // controller_update + model_update, minus collisions
+  PERF_PHASE_COLLISION, // model_check_bullet_collisions
+  PERF_PHASE_RENDER,    // Drawing, minus the present
+  PERF_PHASE_PRESENT,   // SDL_RenderPresent or the terminal refresh
+  PERF_PHASE_COUNT,
+  PERF_PHASE_IDLE = PERF_PHASE_COUNT // Not counted: frame cap, bookkeeping
+} PerfPhase;
+
+typedef enum {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_COUNTER_COUNT
+} PerfCounter;
+
+#define PERF_INTERVAL_NS 1000000000ull // Between perf_counters_tick reports
+
+// Opens the counters for the calling thread, starting in PERF_PHASE_IDLE.
+// Returns false, after saying why, when the kernel or the machine has no
+// such counters (containers, VMs, perf_event_paranoid), and always in
+// builds without ENABLE_PERF_COUNTERS.
+bool perf_counters_open(void);
+void perf_counters_close(void);
+
+// Charges the counts since the last switch to the current phase and makes
+// `phase` current. Returns the phase that was current.
+PerfPhase perf_counters_switch(PerfPhase phase);
+// Back to `*previous` without counting a new entry; for PERF_SCOPE
+void perf_counters_restore(PerfPhase *previous);
+
+// Counts one simulation tick. Returns true once every PERF_INTERVAL_NS, when
+// an interval line is due.
+bool perf_counters_tick(void);
+// Counts per tick since the previous interval line, on one line
+void perf_counters_print_interval(FILE *out);
+// Totals per phase since perf_counters_open, as a table
+void perf_counters_print_summary(FILE *out);
+
+#ifdef ENABLE_PERF_COUNTERS
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_SWITCH(phase) ((void)perf_counters_switch(phase))
+#define PERF_SCOPE(phase)                                                      \
+  PerfPhase PERF_CONCAT(perf_previous_, __LINE__)                              \
+      __attribute__((cleanup(perf_counters_restore))) =                        \
+          perf_counters_switch(phase)
+#define PERF_TICK() perf_counters_tick()
+
+#else
+
+#define PERF_SWITCH(phase) ((void)0)
+#define PERF_SCOPE(phase) ((void)0)
+#define PERF_TICK() false
+
+#endif // ENABLE_PERF_COUNTERS
+
+#endif // PERF_COUNTERS_H
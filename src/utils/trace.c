@@ -0,0 +1,205 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef ENABLE_TRACE
+
+#define TRACE_CHUNK_EVENTS 4096
+
+typedef struct {
+  const char *name;
+  const char *detail;
+  uint64_t start_ns;
+  uint64_t end_ns;
+} TraceEvent;
+
+// Written by one thread only; the count is published after each event so
+// trace_stop can read a consistent prefix while the thread keeps going
+typedef struct TraceChunk {
+  _Atomic(struct TraceChunk *) next;
+  atomic_uint count;
+  TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+typedef struct TraceBuffer {
+  struct TraceBuffer *next; // Set before the buffer is published
+  long tid;
+  char name[32];
+  TraceChunk *head;
+  TraceChunk *tail; // Owner thread only
+} TraceBuffer;
+
+atomic_bool trace_active;
+
+static _Atomic(TraceBuffer *) buffers; // Lock-free push-only list
+static _Thread_local TraceBuffer *local_buffer;
+static atomic_bool started;
+static const char *trace_path;
+static uint64_t epoch_ns;
+
+uint64_t trace_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// The name is fixed before the buffer is published, so the writer of the
+// file never sees it change
+static TraceBuffer *thread_buffer(const char *name) {
+  if (local_buffer)
+    return local_buffer;
+  TraceBuffer *buf = calloc(1, sizeof(TraceBuffer));
+  TraceChunk *chunk = calloc(1, sizeof(TraceChunk));
+  if (!buf || !chunk) {
+    free(buf);
+    free(chunk);
+    return NULL;
+  }
+  buf->tid = (long)syscall(SYS_gettid);
+  if (name)
+    snprintf(buf->name, sizeof(buf->name), "%s", name);
+  buf->head = buf->tail = chunk;
+  buf->next = atomic_load_explicit(&buffers, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&buffers, &buf->next, buf,
+                                                memory_order_release,
+                                                memory_order_relaxed))
+    ;
+  local_buffer = buf;
+  return buf;
+}
+
+void trace_record(const char *name, const char *detail, uint64_t start_ns,
+                  uint64_t end_ns) {
+  TraceBuffer *buf = thread_buffer(NULL);
+  if (!buf)
+    return;
+  TraceChunk *chunk = buf->tail;
+  unsigned n = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+  if (n == TRACE_CHUNK_EVENTS) {
+    TraceChunk *fresh = calloc(1, sizeof(TraceChunk));
+    if (!fresh)
+      return; // Event dropped
+    atomic_store_explicit(&chunk->next, fresh, memory_order_release);
+    buf->tail = chunk = fresh;
+    n = 0;
+  }
+  chunk->events[n] = (TraceEvent){name, detail, start_ns, end_ns};
+  atomic_store_explicit(&chunk->count, n + 1, memory_order_release);
+}
+
+void trace_thread_name(const char *name) { thread_buffer(name); }
+
+bool trace_start(const char *path) {
+  if (atomic_exchange(&started, true)) {
+    fprintf(stderr, "Trace: only one trace per run\n");
+    return false;
+  }
+  trace_path = path;
+  epoch_ns = trace_now_ns();
+  atomic_store(&trace_active, true);
+  return true;
+}
+
+static void write_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      fputc('\\', f);
+    if ((unsigned char)*s >= 0x20)
+      fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+bool trace_stop(void) {
+  if (!atomic_exchange(&trace_active, false))
+    return false;
+  FILE *f = fopen(trace_path, "w");
+  if (!f) {
+    perror(trace_path);
+    return false;
+  }
+  int pid = (int)getpid();
+  unsigned long long written = 0;
+  const char *sep = "";
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (TraceBuffer *buf = atomic_load_explicit(&buffers, memory_order_acquire);
+       buf; buf = buf->next) {
+    if (buf->name[0]) {
+      fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                 "\"tid\":%ld,\"args\":{\"name\":",
+              sep, pid, buf->tid);
+      write_string(f, buf->name);
+      fprintf(f, "}}");
+      sep = ",";
+    }
+    for (TraceChunk *chunk = buf->head; chunk;
+         chunk = atomic_load_explicit(&chunk->next, memory_order_acquire)) {
+      unsigned n = atomic_load_explicit(&chunk->count, memory_order_acquire);
+      for (unsigned i = 0; i < n; i++) {
+        const TraceEvent *e = &chunk->events[i];
+        fprintf(f, "%s\n{\"name\":", sep);
+        write_string(f, e->name);
+        fprintf(f, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f,"
+                   "\"dur\":%.3f",
+                pid, buf->tid, (e->start_ns - epoch_ns) / 1000.0,
+                (e->end_ns - e->start_ns) / 1000.0);
+        if (e->detail) {
+          fprintf(f, ",\"args\":{\"detail\":");
+          write_string(f, e->detail);
+          fputc('}', f);
+        }
+        fputc('}', f);
+        sep = ",";
+        written++;
+      }
+    }
+  }
+  fprintf(f, "\n]}\n");
+  bool ok = !ferror(f);
+  if (fclose(f) != 0)
+    ok = false;
+  if (ok)
+    printf("Trace: %llu events written to %s\n", written, trace_path);
+  else
+    fprintf(stderr, "Trace: failed to write %s\n", trace_path);
+  return ok;
+}
+
+void trace_shutdown(void) {
+  atomic_store(&trace_active, false);
+  TraceBuffer *buf = atomic_exchange(&buffers, NULL);
+  while (buf) {
+    TraceBuffer *next_buf = buf->next;
+    TraceChunk *chunk = buf->head;
+    while (chunk) {
+      TraceChunk *next_chunk = atomic_load(&chunk->next);
+      free(chunk);
+      chunk = next_chunk;
+    }
+    free(buf);
+    buf = next_buf;
+  }
+  local_buffer = NULL;
+}
+
+#else
+
+bool trace_start(const char *path) {
+  fprintf(stderr, "Trace: %s not written, this build has no trace markers "
+                  "(make trace)\n",
+          path);
+  return false;
+}
+
+bool trace_stop(void) { return false; }
+
+void trace_shutdown(void) {}
+
+void trace_thread_name(const char *name) { (void)name; }
+
+#endif // ENABLE_TRACE
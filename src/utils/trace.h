@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Timeline tracing in the Chrome trace-event format (chrome://tracing,
+// ui.perfetto.dev). Code is marked with TRACE_SCOPE, which times the rest of
+// the enclosing block. Each thread appends to its own buffer without locks;
+// trace_stop writes every buffer to one JSON file.
+//
+// The markers only exist in builds with ENABLE_TRACE (make trace). There,
+// a marker costs one relaxed atomic load while no trace is running.
+
+// Starts recording; events are written to `path` by trace_stop. One trace
+// per run: returns false on a second call or when the build has no markers.
+bool trace_start(const char *path);
+// Stops recording and writes the file. Returns false on a write error.
+bool trace_stop(void);
+// Frees every thread's buffer. Only once the traced threads have stopped.
+void trace_shutdown(void);
+
+// Names the calling thread in the viewer. Only before its first event: the
+// name cannot change afterwards.
+void trace_thread_name(const char *name);
+
+#ifdef ENABLE_TRACE
+
+#include <stdatomic.h>
+
+typedef struct {
+  const char *name;   // String literal: kept until the file is written
+  const char *detail; // Shown as args.detail, or NULL; same lifetime
+  uint64_t start_ns;  // 0 when the trace was off at the start of the scope
+} TraceScope;
+
+extern atomic_bool trace_active;
+
+uint64_t trace_now_ns(void);
+void trace_record(const char *name, const char *detail, uint64_t start_ns,
+                  uint64_t end_ns);
+
+static inline TraceScope trace_scope_begin(const char *name,
+                                           const char *detail) {
+  TraceScope scope = {name, detail, 0};
+  if (__builtin_expect(
+          atomic_load_explicit(&trace_active, memory_order_relaxed), 0))
+    scope.start_ns = trace_now_ns();
+  return scope;
+}
+
+static inline void trace_scope_end(TraceScope *scope) {
+  if (__builtin_expect(scope->start_ns != 0, 0))
+    trace_record(scope->name, scope->detail, scope->start_ns, trace_now_ns());
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE_ARG(name, detail)                                          \
+  TraceScope TRACE_CONCAT(trace_scope_, __LINE__)                              \
+      __attribute__((cleanup(trace_scope_end))) =                              \
+          trace_scope_begin(name, detail)
+
+#else
+
+#define TRACE_SCOPE_ARG(name, detail) ((void)0)
+
+#endif // ENABLE_TRACE
+
+#define TRACE_SCOPE(name) TRACE_SCOPE_ARG(name, NULL)
+
+#endif // TRACE_H
@@ -1,4 +1,6 @@
 #include "view_ncurses.h"
+#include "../utils/perf_counters.h"
+#include "../utils/trace.h"
 #include <ncurses.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -187,8 +189,9 @@ static void ncurses_draw_aliens(NcursesView *view, const GameModel *model) {
   for (int i = 0; i < INVADER_ROWS; ++i) {
     for (int j = 0; j < INVADER_COLS; ++j) {
       const Invader *inv = &model->invaders.invaders[i][j];
-      int x = view->game_start_x + ncurses_scale_x(inv->hitbox.x + INVADER_WIDTH/2);
-      int y = view->game_start_y + ncurses_scale_y(inv->hitbox.y + INVADER_HEIGHT/2);
+      Rect r = invader_grid_rect(&model->invaders, inv);
+      int x = view->game_start_x + ncurses_scale_x(r.x + INVADER_WIDTH/2);
+      int y = view->game_start_y + ncurses_scale_y(r.y + INVADER_HEIGHT/2);
       
       if (inv->alive && inv->dying_timer == 0) {
         char c = (inv->row == 0) ? 'Y' : (inv->row < 3 ? 'X' : 'W');
@@ -295,44 +298,67 @@ static void ncurses_draw_saucer(NcursesView *view, const GameModel *model) {
 // Draw bullets
 static void ncurses_draw_bullets(NcursesView *view, const GameModel *model) {
   for (int p = 0; p < 2; p++) {
+    const BulletPool *pool = &model->player_bullets[p];
     attron(COLOR_PAIR(p == 0 ? 1 : 4));
-    for (int i = 0; i < PLAYER_BULLETS; ++i) {
-      if (model->player_bullets[p][i].alive) {
-        int x = view->game_start_x +
-                ncurses_scale_x(model->player_bullets[p][i].hitbox.x);
-        int y = view->game_start_y +
-                ncurses_scale_y(model->player_bullets[p][i].hitbox.y);
-        mvaddch(y, x, '|');
-      }
+    for (int k = 0; k < pool->live_count; ++k) {
+      const Bullet *b = &pool->items[pool->live[k]];
+      int x = view->game_start_x + ncurses_scale_x(b->hitbox.x);
+      int y = view->game_start_y + ncurses_scale_y(b->hitbox.y);
+      mvaddch(y, x, '|');
     }
     attroff(COLOR_PAIR(p == 0 ? 1 : 4));
   }
 
   // Enemy bullets with different types
-  for (int i = 0; i < ENEMY_BULLETS; ++i) {
-    if (model->enemy_bullets[i].alive) {
-      int x = view->game_start_x +
-              ncurses_scale_x(model->enemy_bullets[i].hitbox.x);
-      int y = view->game_start_y +
-              ncurses_scale_y(model->enemy_bullets[i].hitbox.y);
-
-      if (model->enemy_bullets[i].type == 2) { // Laser
-        attron(COLOR_PAIR(5));                 // Magenta
-        mvaddch(y, x, '!');
-        attroff(COLOR_PAIR(5));
-      } else if (model->enemy_bullets[i].type == 1) { // ZigZag
-        attron(COLOR_PAIR(4));                        // Yellow
-        mvaddch(y, x, '~');
-        attroff(COLOR_PAIR(4));
-      } else {                 // Standard
-        attron(COLOR_PAIR(3)); // Red
-        mvaddch(y, x, 'o');
-        attroff(COLOR_PAIR(3));
-      }
+  const BulletPool *enemy_pool = &model->enemy_bullets;
+  for (int k = 0; k < enemy_pool->live_count; ++k) {
+    const Bullet *b = &enemy_pool->items[enemy_pool->live[k]];
+    int x = view->game_start_x + ncurses_scale_x(b->hitbox.x);
+    int y = view->game_start_y + ncurses_scale_y(b->hitbox.y);
+
+    if (b->type == 2) {      // Laser
+      attron(COLOR_PAIR(5)); // Magenta
+      mvaddch(y, x, '!');
+      attroff(COLOR_PAIR(5));
+    } else if (b->type == 1) { // ZigZag
+      attron(COLOR_PAIR(4));   // Yellow
+      mvaddch(y, x, '~');
+      attroff(COLOR_PAIR(4));
+    } else {                 // Standard
+      attron(COLOR_PAIR(3)); // Red
+      mvaddch(y, x, 'o');
+      attroff(COLOR_PAIR(3));
     }
   }
 }
 
+// Rolling min / avg / p99 of each frame phase, in place of the game info
+static void ncurses_draw_frame_timing(const FrameTimer *timer, int sx, int sy) {
+  const float budget_ms = FRAME_TIMER_BUDGET_US / 1000.0f;
+  attron(COLOR_PAIR(8) | A_BOLD);
+  mvprintw(sy, sx, "ms  min  avg  p99");
+  attroff(COLOR_PAIR(8) | A_BOLD);
+  for (int p = 0; p <= FRAME_PHASE_COUNT; p++) {
+    FramePhaseStats st = frame_timer_stats(timer, (FramePhase)p);
+    int color = st.p99_ms > budget_ms ? 3 : 6;
+    attron(COLOR_PAIR(color));
+    mvprintw(sy + 1 + p, sx, "%-3.3s%5.1f%5.1f%5.1f",
+             frame_timer_phase_name((FramePhase)p), st.min_ms, st.avg_ms,
+             st.p99_ms);
+    attroff(COLOR_PAIR(color));
+  }
+  attron(COLOR_PAIR(timer->over_budget ? 3 : 6));
+  mvprintw(sy + 2 + FRAME_PHASE_COUNT, sx, "slow: %u/%d", timer->over_budget,
+           timer->count);
+  attroff(COLOR_PAIR(timer->over_budget ? 3 : 6));
+}
+
+// Pushes the frame to the terminal
+static void ncurses_present(void) {
+  PERF_SCOPE(PERF_PHASE_PRESENT);
+  refresh();
+}
+
 // Draw HUD
 static void ncurses_draw_hud(NcursesView *view, const GameModel *model) {
   // Draw HUD Box
@@ -408,6 +434,11 @@ static void ncurses_draw_hud(NcursesView *view, const GameModel *model) {
   sy = view->game_start_y + 11;
   attron(COLOR_PAIR(6));
   mvhline(sy - 1, sx, '-', w - 1);
+  if (view->frame_timer) {
+    attroff(COLOR_PAIR(6));
+    ncurses_draw_frame_timing(view->frame_timer, sx, sy);
+    return;
+  }
   
   mvprintw(sy, sx, "LEVEL: %d", model->players[0].level);
   mvprintw(sy + 1, sx, "HI-SCORE:");
@@ -458,12 +489,17 @@ void ncurses_view_render_game(NcursesView *view, const GameModel *model) {
   ncurses_draw_powerups(view, model);
   ncurses_draw_hud(view, model);
 
-  refresh();
+  ncurses_present();
+}
+
+void ncurses_view_set_frame_timer(NcursesView *view, const FrameTimer *timer) {
+  view->frame_timer = timer;
 }
 
 void ncurses_view_render(NcursesView *view, const GameModel *model) {
   if (!view || !model)
     return;
+  TRACE_SCOPE("ncurses_view_render");
 
   switch (model->state) {
   case STATE_MENU:
@@ -489,7 +525,7 @@ void ncurses_view_render(NcursesView *view, const GameModel *model) {
     mvprintw(view->game_start_y + NCURSES_GAME_HEIGHT / 2,
              view->game_start_x + (NCURSES_GAME_WIDTH / 2) - 10,
              "LEVEL %d - PRESS SPACE", model->players[0].level);
-    refresh();
+    ncurses_present();
     break;
   default:
     ncurses_view_render_game(view, model);
@@ -504,7 +540,7 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
   int cx = view->width / 2;
   int cy = 2;
 
-  switch (model->menu_state) {
+  switch (model->ui.menu_state) {
   case MENU_MAIN:
     box(stdscr, 0, 0);              // Add border
     attron(COLOR_PAIR(2) | A_BOLD); // Green Title
@@ -514,7 +550,7 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
 
     const char *main_items[] = {"START 1P", "START 2P", "SETTINGS", "QUIT"};
     for (int i = 0; i < 4; i++) {
-      if (i == model->menu_selection) {
+      if (i == model->ui.menu_selection) {
         attron(COLOR_PAIR(1) | A_REVERSE | A_BOLD); // Cyan Highlight
         mvprintw(cy + 5 + i * 2, cx - 8, "  %s  ", main_items[i]);
         attroff(COLOR_PAIR(1) | A_REVERSE | A_BOLD);
@@ -533,7 +569,7 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
     const char *diff_desc[] = {"3 Levels, No Boss", "4 Levels, Boss Fight",
                                "Faster & Aggressive", "Random & Endless"};
     for (int i = 0; i < 4; i++) {
-      if (i == model->menu_selection) {
+      if (i == model->ui.menu_selection) {
         attron(COLOR_PAIR(1));
         mvprintw(cy + 5 + i * 3, cx - 7, "> %s <", diff_items[i]);
         mvprintw(cy + 6 + i * 3, cx - (int)strlen(diff_desc[i]) / 2, "%s",
@@ -548,16 +584,16 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
     mvprintw(cy, cx - 4, "SETTINGS");
     const char *set_items[] = {"CONTROLS", "MUSIC VOLUME", "BACK"};
     for (int i = 0; i < 3; i++) {
-      if (i == model->menu_selection) {
+      if (i == model->ui.menu_selection) {
         if (i == 1)
           mvprintw(cy + 5 + i * 2, cx - 12, "> MUSIC VOLUME: %.0f%% <",
-                   model->music_volume * 100);
+                   model->ui.music_volume * 100);
         else
           mvprintw(cy + 5 + i * 2, cx - 8, "> %s <", set_items[i]);
       } else {
         if (i == 1)
           mvprintw(cy + 5 + i * 2, cx - 10, "  MUSIC VOLUME: %.0f%%  ",
-                   model->music_volume * 100);
+                   model->ui.music_volume * 100);
         else
           mvprintw(cy + 5 + i * 2, cx - 6, "  %s  ", set_items[i]);
       }
@@ -567,7 +603,7 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
   case MENU_CONTROLS: {
     mvprintw(cy, cx - 4, "CONTROLS");
 
-    if (model->waiting_for_key) {
+    if (model->ui.waiting_for_key) {
       attron(COLOR_PAIR(4) | A_BOLD);
       mvprintw(cy + 2, cx - 8, "PRESS ANY KEY...");
       attroff(COLOR_PAIR(4) | A_BOLD);
@@ -580,11 +616,11 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
     mvprintw(cy + 4, cx - 6, "PLAYER 1");
     attroff(COLOR_PAIR(1));
     for (int i = 0; i < 5; i++) {
-      if (model->menu_selection == i)
+      if (model->ui.menu_selection == i)
         attron(A_REVERSE);
-      const char *keyname = get_ncurses_key_name(model->keybinds_p1[i]);
+      const char *keyname = get_ncurses_key_name(model->ui.keybinds_p1[i]);
       mvprintw(cy + 5 + i, cx - 10, "%s: %s", actions[i], keyname);
-      if (model->menu_selection == i)
+      if (model->ui.menu_selection == i)
         attroff(A_REVERSE);
     }
 
@@ -593,31 +629,31 @@ void ncurses_view_render_menu(NcursesView *view, const GameModel *model) {
     mvprintw(cy + 11, cx - 6, "PLAYER 2");
     attroff(COLOR_PAIR(3));
     for (int i = 0; i < 5; i++) {
-      if (model->menu_selection == 5 + i)
+      if (model->ui.menu_selection == 5 + i)
         attron(A_REVERSE);
-      const char *keyname = get_ncurses_key_name(model->keybinds_p2[i]);
+      const char *keyname = get_ncurses_key_name(model->ui.keybinds_p2[i]);
       mvprintw(cy + 12 + i, cx - 10, "%s: %s", actions[i], keyname);
-      if (model->menu_selection == 5 + i)
+      if (model->ui.menu_selection == 5 + i)
         attroff(A_REVERSE);
     }
 
     // Back button
-    if (model->menu_selection == 10)
+    if (model->ui.menu_selection == 10)
       attron(A_REVERSE);
     mvprintw(cy + 18, cx - 4, "> BACK <");
-    if (model->menu_selection == 10)
+    if (model->ui.menu_selection == 10)
       attroff(A_REVERSE);
     break;
   }
   }
 
-  refresh();
+  ncurses_present();
 }
 
 void ncurses_view_render_pause(NcursesView *view) {
   mvprintw(view->game_start_y + NCURSES_GAME_HEIGHT / 2,
            view->game_start_x + (NCURSES_GAME_WIDTH / 2) - 3, "PAUSED");
-  refresh();
+  ncurses_present();
 }
 
 void ncurses_view_render_game_over(NcursesView *view, int win) {
@@ -628,7 +664,7 @@ void ncurses_view_render_game_over(NcursesView *view, int win) {
   else
     mvprintw(cy - 1, cx - 5, "GAME OVER");
   mvprintw(cy + 1, cx - 11, "Press any key for Menu");
-  refresh();
+  ncurses_present();
 }
 
 bool ncurses_view_poll_event(NcursesView *view, int *key) {
@@ -2,6 +2,7 @@
 #define VIEW_NCURSES_H
 
 #include "../core/model.h"
+#include "../utils/frame_timer.h"
 #include "view_base.h"
 #include <ncurses.h>
 #include <stdbool.h>
@@ -35,6 +36,8 @@ typedef struct {
   int score_start_x;
   // Animation frame counter
   int frame_count;
+  // Timing overlay in the HUD, NULL when off
+  const FrameTimer *frame_timer;
 } NcursesView;
 
 // Creation/destruction
@@ -51,6 +54,8 @@ void ncurses_view_render_game(NcursesView *view, const GameModel *model);
 void ncurses_view_render_menu(NcursesView *view, const GameModel *model);
 void ncurses_view_render_pause(NcursesView *view);
 void ncurses_view_render_game_over(NcursesView *view, int win);
+// Shows the per-phase timing of `timer` in the HUD (NULL hides it)
+void ncurses_view_set_frame_timer(NcursesView *view, const FrameTimer *timer);
 
 // Event polling
 bool ncurses_view_poll_event(NcursesView *view, int *key);
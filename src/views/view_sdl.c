@@ -1,5 +1,7 @@
 #include "view_sdl.h"
 #include "rect_utils.h"
+#include "../utils/perf_counters.h"
+#include "../utils/trace.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -50,11 +52,8 @@ SDLView *sdl_view_create(void) {
     view->last_frame_time = SDL_GetTicks();
     view->frame_count = 0;
     view->fps = 0;
-    view->last_shots_fired = 0;
-    view->last_score = 0;
-    view->last_enemy_bullet_count = 0;
-    view->last_player_lives = 3; // Initialize with starting lives
-    view->game_over_played = false;
+    view->event_cursor = 0;
+    view->applied_volume = -1.0f;
     view->current_music_track = 0;
   }
   return view;
@@ -134,51 +133,53 @@ void sdl_view_destroy(SDLView *view) {
   free(view);
 }
 
+// Decodes a whole sound file up front
+static ma_result sdl_view_load_sound(SDLView *view, const char *path,
+                                     ma_sound *sound) {
+  TRACE_SCOPE_ARG("ma_sound_init_from_file", path);
+  return ma_sound_init_from_file(&view->audio_engine, path,
+                                 MA_SOUND_FLAG_DECODE, NULL, NULL, sound);
+}
+
 bool sdl_view_load_resources(SDLView *view) {
   if (!view)
     return false;
+  TRACE_SCOPE("sdl_view_load_resources");
   bool success = true;
 
   // --- LOAD AUDIO (Miniaudio) ---
-  if (ma_sound_init_from_file(
-          &view->audio_engine, "assets/shooting_improved.wav",
-          MA_SOUND_FLAG_DECODE, NULL, NULL, &view->sfx_shoot) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/shooting_improved.wav",
+                          &view->sfx_shoot) != MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/shooting_improved.wav\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/explosion.mp3",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->sfx_death) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/explosion.mp3", &view->sfx_death) !=
+      MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/explosion.mp3\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/enemy_bullet.wav",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->sfx_enemy_bullet) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/enemy_bullet.wav",
+                          &view->sfx_enemy_bullet) != MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/enemy_bullet.wav\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/gameover.wav",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->sfx_gameover) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/gameover.wav", &view->sfx_gameover) !=
+      MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/gameover.wav\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/damage.wav",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->sfx_damage) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/damage.wav", &view->sfx_damage) !=
+      MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/damage.wav\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/select.wav",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->sfx_select) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/select.wav", &view->sfx_select) !=
+      MA_SUCCESS) {
     fprintf(stderr, "Warning: Failed to load assets/select.wav\n");
   }
 
-  if (ma_sound_init_from_file(&view->audio_engine, "assets/music_game.mp3",
-                              MA_SOUND_FLAG_DECODE, NULL, NULL,
-                              &view->music_game) != MA_SUCCESS) {
+  if (sdl_view_load_sound(view, "assets/music_game.mp3", &view->music_game) !=
+      MA_SUCCESS) {
     fprintf(stderr, "AUDIO ERROR: Failed to load assets/music_game.mp3\n");
   } else {
     printf("AUDIO: Loaded assets/music_game.mp3 successfully\n");
@@ -186,13 +187,10 @@ bool sdl_view_load_resources(SDLView *view) {
   ma_sound_set_looping(&view->music_game, MA_TRUE);
   ma_sound_set_volume(&view->music_game, 1.0f); // Default initial volume, will be updated by model
 
-  ma_sound_init_from_file(&view->audio_engine, "assets/music_boss.wav",
-                          MA_SOUND_FLAG_DECODE, NULL, NULL, &view->music_boss);
+  sdl_view_load_sound(view, "assets/music_boss.wav", &view->music_boss);
   ma_sound_set_looping(&view->music_boss, MA_TRUE);
 
-  ma_sound_init_from_file(&view->audio_engine, "assets/music_victory.wav",
-                          MA_SOUND_FLAG_DECODE, NULL, NULL,
-                          &view->music_victory);
+  sdl_view_load_sound(view, "assets/music_victory.wav", &view->music_victory);
   ma_sound_set_looping(&view->music_victory, MA_TRUE);
 
   // --- LOAD FONTS ---
@@ -222,7 +220,11 @@ bool sdl_view_load_resources(SDLView *view) {
 // --- LOAD TEXTURES ---
 #define LOAD_TEXTURE_SAFE(path, dest)                                          \
   {                                                                            \
-    SDL_Surface *s = IMG_Load(path);                                           \
+    SDL_Surface *s;                                                            \
+    {                                                                          \
+      TRACE_SCOPE_ARG("IMG_Load", path);                                       \
+      s = IMG_Load(path);                                                      \
+    }                                                                          \
     if (s) {                                                                   \
       SDL_SetSurfaceColorKey(                                                  \
           s, true,                                                             \
@@ -303,6 +305,19 @@ bool sdl_view_load_resources(SDLView *view) {
   return success;
 }
 
+#ifdef ENABLE_TRACE
+// Same as miniaudio's own device callback, timed on the audio thread
+static void sdl_view_traced_audio_callback(ma_device *device, void *output,
+                                           const void *input,
+                                           ma_uint32 frame_count) {
+  (void)input;
+  trace_thread_name("miniaudio");
+  TRACE_SCOPE("ma_engine_read_pcm_frames");
+  ma_engine_read_pcm_frames((ma_engine *)device->pUserData, output,
+                            frame_count, NULL);
+}
+#endif
+
 bool sdl_view_init(SDLView *view, int width, int height) {
   if (!SDL_Init(SDL_INIT_VIDEO)) {
     fprintf(stderr, "SDL_Init Failed: %s\n", SDL_GetError());
@@ -312,7 +327,11 @@ bool sdl_view_init(SDLView *view, int width, int height) {
     return false;
 
   // --- INIT MINIAUDIO ---
-  ma_result result = ma_engine_init(NULL, &view->audio_engine);
+  ma_engine_config audio_config = ma_engine_config_init();
+#ifdef ENABLE_TRACE
+  audio_config.dataCallback = sdl_view_traced_audio_callback;
+#endif
+  ma_result result = ma_engine_init(&audio_config, &view->audio_engine);
   if (result != MA_SUCCESS) {
     fprintf(stderr,
             "AUDIO ERROR: Failed to initialize audio engine (error %d). Game "
@@ -409,6 +428,28 @@ void draw_particle_effect(SDLView *view, float x, float y, float size,
   SDL_SetRenderDrawBlendMode(view->renderer, SDL_BLENDMODE_BLEND);
 }
 
+// Rolling min / avg / p99 of each frame phase, red past the frame budget
+static void sdl_view_draw_frame_timing(SDLView *view, const FrameTimer *timer) {
+  SDL_Color title_col = {COLOR_TEXT_HIGHLIGHT};
+  SDL_Color val_col = {COLOR_TEXT_SECONDARY};
+  SDL_Color over_col = {255, 80, 80, 255};
+  const float budget_ms = FRAME_TIMER_BUDGET_US / 1000.0f;
+  char buf[64];
+
+  draw_text(view, "ms   min / avg / p99", 606, 450, title_col);
+  for (int p = 0; p <= FRAME_PHASE_COUNT; p++) {
+    FramePhaseStats st = frame_timer_stats(timer, (FramePhase)p);
+    snprintf(buf, sizeof(buf), "%-6s %.2f %.2f %.2f",
+             frame_timer_phase_name((FramePhase)p), st.min_ms, st.avg_ms,
+             st.p99_ms);
+    draw_text(view, buf, 606, 470 + p * 20,
+              st.p99_ms > budget_ms ? over_col : val_col);
+  }
+  snprintf(buf, sizeof(buf), "over %.1f ms: %u/%d", budget_ms,
+           timer->over_budget, timer->count);
+  draw_text(view, buf, 606, 572, timer->over_budget ? over_col : val_col);
+}
+
 void sdl_view_draw_hud(SDLView *view, const GameModel *model) {
   SDL_SetRenderDrawColor(view->renderer, 0, 0, 0, 255); // PURE BLACK
   SDL_FRect hud_bg = {600.0f, 0.0f, 200.0f, 600.0f};
@@ -524,6 +565,11 @@ void sdl_view_draw_hud(SDLView *view, const GameModel *model) {
     draw_text(view, hp_txt, 620, 428, (SDL_Color){255, 255, 255, 255});
   }
 
+  if (view->frame_timer) {
+    sdl_view_draw_frame_timing(view, view->frame_timer);
+    return; // In place of the high score
+  }
+
   snprintf(buf, 64, "HIGH SCORE");
   draw_text(view, buf, 620, 450, title_col);
   snprintf(buf, 64, "%06d", model->high_score);
@@ -532,6 +578,7 @@ void sdl_view_draw_hud(SDLView *view, const GameModel *model) {
 
 // Menu rendering helper functions
 static void sdl_view_render_main_menu(SDLView *view, const GameModel *model) {
+  TRACE_SCOPE("sdl_view_render_main_menu");
   // Background gradient
   for (int i = 0; i < view->height; i++) {
     SDL_SetRenderDrawColor(view->renderer, 10, 15 + i / 20, 30 + i / 10, 255);
@@ -560,11 +607,11 @@ static void sdl_view_render_main_menu(SDLView *view, const GameModel *model) {
   int y_spacing = 60;
 
   for (int i = 0; i < 4; i++) {
-    SDL_Color color = (model->menu_selection == i)
+    SDL_Color color = (model->ui.menu_selection == i)
                           ? (SDL_Color){255, 255, 0, 255}
                           : (SDL_Color){COLOR_TEXT_PRIMARY};
 
-    const char *prefix = (model->menu_selection == i) ? "> " : "  ";
+    const char *prefix = (model->ui.menu_selection == i) ? "> " : "  ";
     char text[64];
     snprintf(text, sizeof(text), "%s%s", prefix, items[i]);
     draw_text_centered(view, text, y_start + i * y_spacing, color, false);
@@ -577,6 +624,7 @@ static void sdl_view_render_main_menu(SDLView *view, const GameModel *model) {
 
 static void sdl_view_render_difficulty_menu(SDLView *view,
                                             const GameModel *model) {
+  TRACE_SCOPE("sdl_view_render_difficulty_menu");
   // Background gradient
   for (int i = 0; i < view->height; i++) {
     SDL_SetRenderDrawColor(view->renderer, 10, 15 + i / 20, 30 + i / 10, 255);
@@ -595,11 +643,11 @@ static void sdl_view_render_difficulty_menu(SDLView *view,
   int y_spacing = 60;
 
   for (int i = 0; i < 4; i++) {
-    SDL_Color color = (model->menu_selection == i)
+    SDL_Color color = (model->ui.menu_selection == i)
                           ? (SDL_Color){255, 255, 0, 255}
                           : (SDL_Color){COLOR_TEXT_PRIMARY};
 
-    const char *prefix = (model->menu_selection == i) ? "> " : "  ";
+    const char *prefix = (model->ui.menu_selection == i) ? "> " : "  ";
     char text[128];
     snprintf(text, sizeof(text), "%s%s", prefix, items[i]);
     draw_text_centered(view, text, y_start + i * y_spacing, color, false);
@@ -611,6 +659,7 @@ static void sdl_view_render_difficulty_menu(SDLView *view,
 
 static void sdl_view_render_settings_menu(SDLView *view,
                                           const GameModel *model) {
+  TRACE_SCOPE("sdl_view_render_settings_menu");
   // Background gradient
   for (int i = 0; i < view->height; i++) {
     SDL_SetRenderDrawColor(view->renderer, 10, 15 + i / 20, 30 + i / 10, 255);
@@ -626,25 +675,25 @@ static void sdl_view_render_settings_menu(SDLView *view,
   int y_spacing = 70;
 
   // Controls
-  SDL_Color color0 = (model->menu_selection == 0)
+  SDL_Color color0 = (model->ui.menu_selection == 0)
                          ? (SDL_Color){255, 255, 0, 255}
                          : (SDL_Color){COLOR_TEXT_PRIMARY};
   draw_text_centered(view,
-                     model->menu_selection == 0 ? "> CONTROLS" : "  CONTROLS",
+                     model->ui.menu_selection == 0 ? "> CONTROLS" : "  CONTROLS",
                      y_start, color0, false);
 
   // Music Volume with slider
-  SDL_Color color1 = (model->menu_selection == 1)
+  SDL_Color color1 = (model->ui.menu_selection == 1)
                          ? (SDL_Color){255, 255, 0, 255}
                          : (SDL_Color){COLOR_TEXT_PRIMARY};
   char vol_text[64];
-  int vol_percent = (int)(model->music_volume * 100);
+  int vol_percent = (int)(model->ui.music_volume * 100);
   snprintf(vol_text, sizeof(vol_text), "%s MUSIC VOLUME: %d%%",
-           model->menu_selection == 1 ? ">" : " ", vol_percent);
+           model->ui.menu_selection == 1 ? ">" : " ", vol_percent);
   draw_text_centered(view, vol_text, y_start + y_spacing, color1, false);
 
   // Volume slider bar
-  if (model->menu_selection == 1) {
+  if (model->ui.menu_selection == 1) {
     int bar_width = 300;
     int bar_x = (view->width - bar_width) / 2;
     int bar_y = y_start + y_spacing + 40;
@@ -657,7 +706,7 @@ static void sdl_view_render_settings_menu(SDLView *view,
     // Filled portion
     SDL_SetRenderDrawColor(view->renderer, 0, 255, 100, 255);
     SDL_FRect bar_fill = {(float)bar_x, (float)bar_y,
-                          bar_width * model->music_volume, 20};
+                          bar_width * model->ui.music_volume, 20};
     SDL_RenderFillRect(view->renderer, &bar_fill);
 
     draw_text_centered(view, "Use LEFT/RIGHT to adjust", bar_y + 40,
@@ -665,10 +714,10 @@ static void sdl_view_render_settings_menu(SDLView *view,
   }
 
   // Back
-  SDL_Color color2 = (model->menu_selection == 2)
+  SDL_Color color2 = (model->ui.menu_selection == 2)
                          ? (SDL_Color){255, 255, 0, 255}
                          : (SDL_Color){COLOR_TEXT_PRIMARY};
-  draw_text_centered(view, model->menu_selection == 2 ? "> BACK" : "  BACK",
+  draw_text_centered(view, model->ui.menu_selection == 2 ? "> BACK" : "  BACK",
                      y_start + 2 * y_spacing + 80, color2, false);
 
   draw_text_centered(view, "ENTER to select, ESC to go back", view->height - 50,
@@ -756,6 +805,7 @@ static const char *get_key_name(int keycode) {
 
 static void sdl_view_render_controls_menu(SDLView *view,
                                           const GameModel *model) {
+  TRACE_SCOPE("sdl_view_render_controls_menu");
   // Background gradient (Black to Dark Blue)
   for (int i = 0; i < view->height; i++) {
     SDL_SetRenderDrawColor(view->renderer, 0, 0, i / 20, 255);
@@ -766,7 +816,7 @@ static void sdl_view_render_controls_menu(SDLView *view,
   draw_text_centered(view, "CONTROLS", 60, (SDL_Color){COLOR_TEXT_HIGHLIGHT},
                      true);
 
-  if (model->waiting_for_key) {
+  if (model->ui.waiting_for_key) {
     draw_text_centered(view, "PRESS A KEY...", 100,
                        (SDL_Color){255, 255, 0, 255}, false);
   }
@@ -785,9 +835,9 @@ static void sdl_view_render_controls_menu(SDLView *view,
   for (int i = 0; i < 5; i++) {
     char buf[64];
     snprintf(buf, 64, "%s: %s", actions[i],
-             get_key_name(model->keybinds_p1[i]));
-    SDL_Color c = (model->menu_selection == i) ? sel : wht;
-    if (model->waiting_for_key && model->editing_keybind == i)
+             get_key_name(model->ui.keybinds_p1[i]));
+    SDL_Color c = (model->ui.menu_selection == i) ? sel : wht;
+    if (model->ui.waiting_for_key && model->ui.editing_keybind == i)
       c = (SDL_Color){0, 255, 100, 255};
     draw_text_centered(view, buf, y_start + 30 + i * y_spacing, c, false);
   }
@@ -797,15 +847,15 @@ static void sdl_view_render_controls_menu(SDLView *view,
   for (int i = 0; i < 5; i++) {
     char buf[64];
     snprintf(buf, 64, "%s: %s", actions[i],
-             get_key_name(model->keybinds_p2[i]));
-    SDL_Color c = (model->menu_selection == 5 + i) ? sel : wht;
-    if (model->waiting_for_key && model->editing_keybind == 5 + i)
+             get_key_name(model->ui.keybinds_p2[i]));
+    SDL_Color c = (model->ui.menu_selection == 5 + i) ? sel : wht;
+    if (model->ui.waiting_for_key && model->ui.editing_keybind == 5 + i)
       c = (SDL_Color){0, 255, 100, 255};
     draw_text_centered(view, buf, y_start + 230 + i * y_spacing, c, false);
   }
 
   // Back button
-  SDL_Color color = (model->menu_selection == 10) ? sel : wht;
+  SDL_Color color = (model->ui.menu_selection == 10) ? sel : wht;
   draw_text_centered(view, "> BACK <", view->height - 80, color, false);
 
   draw_text_centered(view, "ENTER to edit, ESC to go back", view->height - 40,
@@ -813,6 +863,7 @@ static void sdl_view_render_controls_menu(SDLView *view,
 }
 
 void sdl_view_render_game_scene(SDLView *view, const GameModel *model) {
+  TRACE_SCOPE("sdl_view_render_game_scene");
   if (!view || !view->renderer || !model)
     return;
 
@@ -919,54 +970,51 @@ void sdl_view_render_game_scene(SDLView *view, const GameModel *model) {
 
   // Bullets
   for (int pIdx = 0; pIdx < 2; pIdx++) {
-    for (int i = 0; i < PLAYER_BULLETS; i++) {
-      if (model->player_bullets[pIdx][i].alive) {
-        SDL_FRect b = {(float)model->player_bullets[pIdx][i].hitbox.x,
-                       (float)model->player_bullets[pIdx][i].hitbox.y,
-                       (float)model->player_bullets[pIdx][i].hitbox.width,
-                       (float)model->player_bullets[pIdx][i].hitbox.height};
-        if (view->bullet_player_tex)
-          SDL_RenderTexture(view->renderer, view->bullet_player_tex, NULL, &b);
-        else {
-          SDL_SetRenderDrawColor(view->renderer, COLOR_BULLET_PLAYER);
-          SDL_RenderFillRect(view->renderer, &b);
-        }
+    const BulletPool *pool = &model->player_bullets[pIdx];
+    for (int k = 0; k < pool->live_count; k++) {
+      const Bullet *pb = &pool->items[pool->live[k]];
+      SDL_FRect b = {(float)pb->hitbox.x, (float)pb->hitbox.y,
+                     (float)pb->hitbox.width, (float)pb->hitbox.height};
+      if (view->bullet_player_tex)
+        SDL_RenderTexture(view->renderer, view->bullet_player_tex, NULL, &b);
+      else {
+        SDL_SetRenderDrawColor(view->renderer, COLOR_BULLET_PLAYER);
+        SDL_RenderFillRect(view->renderer, &b);
       }
     }
   }
-  for (int i = 0; i < ENEMY_BULLETS; i++)
-    if (model->enemy_bullets[i].alive) {
-      SDL_FRect b = {(float)model->enemy_bullets[i].hitbox.x,
-                     (float)model->enemy_bullets[i].hitbox.y,
-                     (float)model->enemy_bullets[i].hitbox.width,
-                     (float)model->enemy_bullets[i].hitbox.height};
-      // Different visuals for bullet types
-      if (model->enemy_bullets[i].type == 2) { // Laser/Orb
-        SDL_FRect orb = {b.x - 2, b.y, b.w + 6, b.h + 4};
-        if (view->bullet_laser_tex) {
-          SDL_RenderTexture(view->renderer, view->bullet_laser_tex, NULL, &orb);
-        } else {
-          SDL_SetRenderDrawColor(view->renderer, 255, 0, 255, 255);
-          SDL_RenderFillRect(view->renderer, &orb);
-        }
-        draw_particle_effect(view, b.x + b.w / 2, b.y + b.h, 15.0f, 0xFF00FF);
-      } else if (model->enemy_bullets[i].type == 1) { // ZigZag
-        SDL_FRect zz = {b.x - 1, b.y, b.w + 4, b.h + 2};
-        if (view->bullet_zigzag_tex) {
-          SDL_RenderTexture(view->renderer, view->bullet_zigzag_tex, NULL, &zz);
-        } else {
-          SDL_SetRenderDrawColor(view->renderer, 255, 255, 0, 255); // Yellow
-          SDL_RenderFillRect(view->renderer, &zz);
-        }
-      } else { // Standard
-        if (view->bullet_enemy_tex)
-          SDL_RenderTexture(view->renderer, view->bullet_enemy_tex, NULL, &b);
-        else {
-          SDL_SetRenderDrawColor(view->renderer, COLOR_BULLET_ENEMY);
-          SDL_RenderFillRect(view->renderer, &b);
-        }
+  const BulletPool *enemy_pool = &model->enemy_bullets;
+  for (int k = 0; k < enemy_pool->live_count; k++) {
+    const Bullet *eb = &enemy_pool->items[enemy_pool->live[k]];
+    SDL_FRect b = {(float)eb->hitbox.x, (float)eb->hitbox.y,
+                   (float)eb->hitbox.width, (float)eb->hitbox.height};
+    // Different visuals for bullet types
+    if (eb->type == 2) { // Laser/Orb
+      SDL_FRect orb = {b.x - 2, b.y, b.w + 6, b.h + 4};
+      if (view->bullet_laser_tex) {
+        SDL_RenderTexture(view->renderer, view->bullet_laser_tex, NULL, &orb);
+      } else {
+        SDL_SetRenderDrawColor(view->renderer, 255, 0, 255, 255);
+        SDL_RenderFillRect(view->renderer, &orb);
+      }
+      draw_particle_effect(view, b.x + b.w / 2, b.y + b.h, 15.0f, 0xFF00FF);
+    } else if (eb->type == 1) { // ZigZag
+      SDL_FRect zz = {b.x - 1, b.y, b.w + 4, b.h + 2};
+      if (view->bullet_zigzag_tex) {
+        SDL_RenderTexture(view->renderer, view->bullet_zigzag_tex, NULL, &zz);
+      } else {
+        SDL_SetRenderDrawColor(view->renderer, 255, 255, 0, 255); // Yellow
+        SDL_RenderFillRect(view->renderer, &zz);
+      }
+    } else { // Standard
+      if (view->bullet_enemy_tex)
+        SDL_RenderTexture(view->renderer, view->bullet_enemy_tex, NULL, &b);
+      else {
+        SDL_SetRenderDrawColor(view->renderer, COLOR_BULLET_ENEMY);
+        SDL_RenderFillRect(view->renderer, &b);
       }
     }
+  }
 
   // Powerups
   for (int i = 0; i < 10; i++) {
@@ -1040,11 +1088,11 @@ void sdl_view_render_game_scene(SDLView *view, const GameModel *model) {
         const Invader *inv = &model->invaders.invaders[i][j];
         if (inv->alive) {
           float i_scale = 1.3f;
-          SDL_FRect idst = {
-              (float)inv->hitbox.x - (inv->hitbox.width * (i_scale - 1) / 2),
-              (float)inv->hitbox.y - (inv->hitbox.height * (i_scale - 1) / 2),
-              (float)inv->hitbox.width * i_scale,
-              (float)inv->hitbox.height * i_scale};
+          Rect r = invader_grid_rect(&model->invaders, inv);
+          SDL_FRect idst = {(float)r.x - (r.width * (i_scale - 1) / 2),
+                            (float)r.y - (r.height * (i_scale - 1) / 2),
+                            (float)r.width * i_scale,
+                            (float)r.height * i_scale};
           if (inv->dying_timer > 0) {
             if (view->explosion_tex)
               SDL_RenderTexture(view->renderer, view->explosion_tex, NULL,
@@ -1108,114 +1156,173 @@ void sdl_view_render_game_scene(SDLView *view, const GameModel *model) {
   sdl_view_draw_hud(view, model);
 }
 
-void sdl_view_render(SDLView *view, const GameModel *model) {
-  if (!view || !view->renderer || !model)
+/* --- Render Interpolation --- */
+
+// Moves larger than this between two ticks are respawns, not motion
+#define INTERP_MAX_JUMP 64.0f
+
+void sdl_view_set_interpolation(SDLView *view, const GameModel *previous,
+                                float alpha) {
+  if (!view)
     return;
+  view->interp_previous = previous;
+  view->interp_alpha = alpha;
+}
+
+void sdl_view_set_frame_timer(SDLView *view, const FrameTimer *timer) {
+  view->frame_timer = timer;
+}
 
-  // Apply music volume from settings
-  ma_sound_set_volume(&view->music_game, model->music_volume);
-  ma_sound_set_volume(&view->music_boss, model->music_volume);
-  ma_sound_set_volume(&view->music_victory, model->music_volume);
+void sdl_view_set_flight_recorder(SDLView *view, FlightRecorder *rec) {
+  view->flight_recorder = rec;
+}
 
-  // Also apply volume to SFX for consistency (since there is no separate SFX slider yet)
-  ma_sound_set_volume(&view->sfx_shoot, model->music_volume);
-  ma_sound_set_volume(&view->sfx_death, model->music_volume);
-  ma_sound_set_volume(&view->sfx_enemy_bullet, model->music_volume);
-  ma_sound_set_volume(&view->sfx_gameover, model->music_volume);
-  ma_sound_set_volume(&view->sfx_damage, model->music_volume);
-  ma_sound_set_volume(&view->sfx_select, model->music_volume);
+static float lerp_coord(float prev, float cur, float alpha) {
+  float d = cur - prev;
+  if (d > INTERP_MAX_JUMP || d < -INTERP_MAX_JUMP)
+    return cur;
+  return prev + d * alpha;
+}
 
-  // Reset audio tracking when starting new game from menu
-  static GameState last_state = STATE_MENU;
-  if (last_state == STATE_MENU && model->state == STATE_PLAYING) {
-    view->last_shots_fired = 0;
-    view->last_score = 0;
-    view->last_enemy_bullet_count = 0;
-    view->last_player_lives = model->players[0].lives;
+static void lerp_rect(Rect *cur, const Rect *prev, float alpha) {
+  cur->x = lerp_coord(prev->x, cur->x, alpha);
+  cur->y = lerp_coord(prev->y, cur->y, alpha);
+}
+
+// Returns the model to draw: positions blended between the previous tick
+// and the current one by the accumulator fraction.
+static const GameModel *sdl_view_interpolated_model(SDLView *view,
+                                                    const GameModel *model) {
+  const GameModel *prev = view->interp_previous;
+  float alpha = view->interp_alpha;
+  if (!prev || alpha >= 1.0f || model->state != STATE_PLAYING ||
+      prev->state != STATE_PLAYING)
+    return model;
+
+  GameModel *out = &view->interp_model;
+  *out = *model;
+
+  for (int p = 0; p < 2; p++)
+    lerp_rect(&out->players[p].hitbox, &prev->players[p].hitbox, alpha);
+
+  // The formation moves through its origin; only drifting invaders have
+  // offsets that change between ticks
+  out->invaders.origin_x =
+      lerp_coord(prev->invaders.origin_x, model->invaders.origin_x, alpha);
+  out->invaders.origin_y =
+      lerp_coord(prev->invaders.origin_y, model->invaders.origin_y, alpha);
+  for (int i = 0; i < INVADER_ROWS; i++)
+    for (int j = 0; j < INVADER_COLS; j++)
+      if (prev->invaders.invaders[i][j].alive &&
+          (model->invaders.custom_speed_mask[i] & (1u << j)))
+        lerp_rect(&out->invaders.invaders[i][j].offset,
+                  &prev->invaders.invaders[i][j].offset, alpha);
+  if (prev->invaders.big_invader.alive)
+    lerp_rect(&out->invaders.big_invader.hitbox,
+              &prev->invaders.big_invader.hitbox, alpha);
+  if (prev->boss.alive)
+    lerp_rect(&out->boss.hitbox, &prev->boss.hitbox, alpha);
+  if (prev->saucer.alive)
+    lerp_rect(&out->saucer.hitbox, &prev->saucer.hitbox, alpha);
+
+  // Pool slots are stable while a bullet lives; a slot reused within one
+  // tick is caught by the INTERP_MAX_JUMP check
+  for (int p = 0; p < 2; p++)
+    for (int i = 0; i < out->player_bullets[p].capacity; i++)
+      if (prev->player_bullets[p].items[i].alive)
+        lerp_rect(&out->player_bullets[p].items[i].hitbox,
+                  &prev->player_bullets[p].items[i].hitbox, alpha);
+  for (int i = 0; i < out->enemy_bullets.capacity; i++)
+    if (prev->enemy_bullets.items[i].alive)
+      lerp_rect(&out->enemy_bullets.items[i].hitbox,
+                &prev->enemy_bullets.items[i].hitbox, alpha);
+  for (int i = 0; i < 10; i++)
+    if (prev->powerups[i].alive)
+      lerp_rect(&out->powerups[i].hitbox, &prev->powerups[i].hitbox, alpha);
+
+  return out;
+}
+
+// How far left/right effects may pan, 1.0 = fully to one speaker
+#define SFX_PAN_RANGE 0.6f
+
+static ma_sound *sfx_for_event(SDLView *view, GameEventType type) {
+  switch (type) {
+  case EVENT_PLAYER_SHOT:
+    return &view->sfx_shoot;
+  case EVENT_ENEMY_SHOT:
+    return &view->sfx_enemy_bullet;
+  case EVENT_KILL:
+    return &view->sfx_death;
+  case EVENT_PLAYER_HIT:
+    return &view->sfx_damage;
+  case EVENT_GAME_OVER:
+    return &view->sfx_gameover;
+  default:
+    return NULL;
+  }
+}
+
+void sdl_view_render(SDLView *view, const GameModel *model) {
+  if (!view || !view->renderer || !model)
+    return;
+  TRACE_SCOPE("sdl_view_render");
+
+  // Apply music volume from settings, only when it changed
+  if (model->ui.music_volume != view->applied_volume) {
+    ma_sound *sounds[] = {&view->music_game,   &view->music_boss,
+                          &view->music_victory, &view->sfx_shoot,
+                          &view->sfx_death,    &view->sfx_enemy_bullet,
+                          &view->sfx_gameover, &view->sfx_damage,
+                          &view->sfx_select};
+    // No separate SFX slider yet, so effects follow the music volume
+    for (size_t i = 0; i < sizeof(sounds) / sizeof(sounds[0]); i++)
+      ma_sound_set_volume(sounds[i], model->ui.music_volume);
+    view->applied_volume = model->ui.music_volume;
   }
 
   // Menu Navigation Sound
   if (model->state == STATE_MENU) {
-    if (model->menu_selection != view->last_menu_selection ||
-        model->menu_state != view->last_menu_state) {
+    if (model->ui.menu_selection != view->last_menu_selection ||
+        model->ui.menu_state != view->last_menu_state) {
       ma_sound_seek_to_pcm_frame(&view->sfx_select, 0);
       ma_sound_start(&view->sfx_select);
-      view->last_menu_selection = model->menu_selection;
-      view->last_menu_state = model->menu_state;
+      view->last_menu_selection = model->ui.menu_selection;
+      view->last_menu_state = model->ui.menu_state;
     }
   }
 
-  last_state = model->state;
-
   // --- AUDIO LOGIC ---
-  // Only play sounds during active gameplay
-  if (model->state == STATE_PLAYING) {
-    // 1. Detect Shot (Rewind and Play)
-    // 1. Detect Shot (Rewind and Play)
-    int total_shots =
-        model->players[0].shots_fired + model->players[1].shots_fired;
-    if (total_shots > (int)view->last_shots_fired) {
-      if (ma_sound_is_playing(&view->sfx_shoot)) {
-        ma_sound_seek_to_pcm_frame(&view->sfx_shoot, 0);
-      } else {
-        ma_sound_start(&view->sfx_shoot);
-      }
-      view->last_shots_fired = total_shots;
-    }
-
-    // 2. Detect Enemy Death (Score change)
-    // 2. Detect Enemy Death (Score change)
-    int total_score = model->players[0].score + model->players[1].score;
-    if (total_score > view->last_score) {
-      if (ma_sound_is_playing(&view->sfx_death)) {
-        ma_sound_seek_to_pcm_frame(&view->sfx_death, 0);
-      } else {
-        ma_sound_start(&view->sfx_death);
-      }
-      view->last_score = total_score;
-    }
-  }
-
-  // 3. Detect Enemy Bullets (count active enemy bullets)
-  int current_enemy_bullets = 0;
-  for (int i = 0; i < ENEMY_BULLETS; i++) {
-    if (model->enemy_bullets[i].alive)
-      current_enemy_bullets++;
-  }
-  if (current_enemy_bullets > view->last_enemy_bullet_count) {
-    if (ma_sound_is_playing(&view->sfx_enemy_bullet)) {
-      ma_sound_seek_to_pcm_frame(&view->sfx_enemy_bullet, 0);
-    } else {
-      ma_sound_start(&view->sfx_enemy_bullet);
-    }
+  // Sounds follow the model's event stream: each effect restarts at most once
+  // per frame, panned towards the latest event that triggered it
+  ma_sound *triggered[EVENT_WIN + 1] = {0};
+  float pan[EVENT_WIN + 1] = {0};
+  const GameEvent *e;
+  while ((e = model_next_event(model, &view->event_cursor)) != NULL) {
+    ma_sound *sound = sfx_for_event(view, (GameEventType)e->type);
+    if (!sound)
+      continue;
+    triggered[e->type] = sound;
+    pan[e->type] = SFX_PAN_RANGE * (e->x / GAME_AREA_WIDTH * 2.0f - 1.0f);
   }
-  view->last_enemy_bullet_count = current_enemy_bullets;
-
-  // 4. Detect Player Damage (life decrease)
-  int current_lives = model->players[0].lives + model->players[1].lives;
-  if (current_lives < view->last_player_lives) {
-    if (ma_sound_is_playing(&view->sfx_damage)) {
-      ma_sound_seek_to_pcm_frame(&view->sfx_damage, 0);
+  for (int t = 0; t <= EVENT_WIN; t++) {
+    if (!triggered[t])
+      continue;
+    Uint64 sound_start = SDL_GetTicksNS();
+    ma_sound_set_pan(triggered[t], t == EVENT_GAME_OVER ? 0.0f : pan[t]);
+    if (ma_sound_is_playing(triggered[t])) {
+      ma_sound_seek_to_pcm_frame(triggered[t], 0);
     } else {
-      ma_sound_start(&view->sfx_damage);
+      ma_sound_start(triggered[t]);
     }
-    view->last_player_lives = current_lives;
-  }
-  if (current_lives > view->last_player_lives) {
-    view->last_player_lives = current_lives;
-  }
-
-  // 5. Detect Game Over
-  if (model->state == STATE_GAME_OVER && !view->game_over_played) {
-    ma_sound_start(&view->sfx_gameover);
-    view->game_over_played = true;
-  }
-  // Reset flag when not in game over state
-  if (model->state != STATE_GAME_OVER) {
-    view->game_over_played = false;
+    if (view->flight_recorder)
+      flight_recorder_note(view->flight_recorder, FLIGHT_EVENT_SOUND, t,
+                           (uint32_t)((SDL_GetTicksNS() - sound_start) / 1000));
   }
 
   // 6. Music Switching Logic
+  int music_track = view->current_music_track;
+  Uint64 music_start = SDL_GetTicksNS();
   // Start menu music on initial load or when returning to menu
   if (model->state == STATE_MENU && view->current_music_track == 0) {
     printf("AUDIO: Starting game music on menu (track was 0)...\n");
@@ -1258,9 +1365,6 @@ void sdl_view_render(SDLView *view, const GameModel *model) {
   else if (model->state == STATE_PLAYING && view->current_music_track == 0) {
     ma_sound_start(&view->music_game);
     view->current_music_track = 1;
-    view->last_player_lives =
-        model->players[0].lives +
-        model->players[1].lives; // Sync lives on game start
   }
   // Start/Resume menu music when in menu
   else if (model->state == STATE_MENU && view->current_music_track == 0) {
@@ -1278,8 +1382,13 @@ void sdl_view_render(SDLView *view, const GameModel *model) {
     }
     view->current_music_track = 1;
   }
+  if (view->flight_recorder && view->current_music_track != music_track)
+    flight_recorder_note(view->flight_recorder, FLIGHT_EVENT_MUSIC,
+                         view->current_music_track,
+                         (uint32_t)((SDL_GetTicksNS() - music_start) / 1000));
 
   // --- RENDER LOGIC ---
+  model = sdl_view_interpolated_model(view, model);
   SDL_SetRenderDrawColor(view->renderer, 0, 0, 0, 255);
   SDL_RenderClear(view->renderer);
 
@@ -1338,7 +1447,7 @@ void sdl_view_render(SDLView *view, const GameModel *model) {
   switch (model->state) {
   case STATE_MENU: {
     //  Render the appropriate menu based on menu_state
-    switch (model->menu_state) {
+    switch (model->ui.menu_state) {
     case MENU_MAIN:
       sdl_view_render_main_menu(view, model);
       break;
@@ -1407,6 +1516,10 @@ void sdl_view_render(SDLView *view, const GameModel *model) {
   }
   }
 
-  SDL_RenderPresent(view->renderer);
+  {
+    TRACE_SCOPE("SDL_RenderPresent");
+    PERF_SCOPE(PERF_PHASE_PRESENT);
+    SDL_RenderPresent(view->renderer);
+  }
   view->frame_count++;
 }
\ No newline at end of file
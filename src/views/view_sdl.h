@@ -2,6 +2,8 @@
 #define VIEW_SDL_H
 
 #include "../core/model.h"
+#include "../utils/flight_recorder.h"
+#include "../utils/frame_timer.h"
 #include "../utils/miniaudio.h"
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
@@ -43,15 +45,13 @@ typedef struct SDLView {
   ma_sound music_victory;    // Victory music
 
   // Audio State Tracking
-  unsigned int last_shots_fired;
-  int last_score;
-  int last_enemy_bullet_count;
-  int last_player_lives;
-  bool game_over_played;
+  uint32_t event_cursor;   // Next model event to play sounds for
+  float applied_volume;    // Volume last pushed to the sounds, -1 = none
   int current_music_track; // 0=none, 1=game, 2=boss, 3=victory
   int last_menu_selection;
   MenuState last_menu_state;
   int last_state;
+  FlightRecorder *flight_recorder; // Told about music and sounds, or NULL
 
   // Fonts
   TTF_Font *font_large;
@@ -61,6 +61,12 @@ typedef struct SDLView {
   Uint32 frame_count;
   Uint32 fps;
   Uint32 last_frame_time;
+  const FrameTimer *frame_timer; // Timing overlay in the HUD, NULL when off
+
+  // Render interpolation between the last two simulation ticks
+  const GameModel *interp_previous;
+  float interp_alpha;
+  GameModel interp_model;
 
   // Background Stars
   struct {
@@ -76,5 +82,11 @@ void sdl_view_destroy(SDLView *view);
 bool sdl_view_init(SDLView *view, int width, int height);
 bool sdl_view_poll_event(SDLView *view, SDL_Event *event);
 void sdl_view_render(SDLView *view, const GameModel *model);
+void sdl_view_set_interpolation(SDLView *view, const GameModel *previous,
+                                float alpha);
+// Shows the per-phase timing of `timer` in the HUD panel (NULL hides it)
+void sdl_view_set_frame_timer(SDLView *view, const FrameTimer *timer);
+// Notes music switches and sound starts, with their cost, in `rec`
+void sdl_view_set_flight_recorder(SDLView *view, FlightRecorder *rec);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/model.h"
+#include "core/rng.h"
+
+/*
+ * Microbenchmarks for the model hot paths (make benchmark).
+ *
+ * Every benchmark starts from a state built with a fixed seed and restored
+ * before each sample, so each sample replays exactly the same work. A
+ * sample times `batch` operations; after the warmup samples, the median and
+ * p99 of the per-operation times are reported as JSON, for comparing a
+ * change to src/core against the tree it started from.
+ */
+
+#define BENCH_DEFAULT_SAMPLES 200
+#define BENCH_DEFAULT_WARMUP 20
+#define BENCH_SEED 0x5eed0001u
+#define BENCH_TICK (1.0f / SIM_TICK_RATE)
+
+typedef struct {
+    GameModel start; // Restored before each sample
+    GameModel model; // Worked on by the operations
+    ModelConfig config;
+} BenchState;
+
+typedef struct {
+    const char* name;
+    int batch; // Operations per timed sample
+    int param; // Difficulty, bullet load, ... depending on the benchmark
+    void (*setup)(BenchState* s, int param); // Builds s->start, once
+    void (*op)(BenchState* s, int param);
+} Benchmark;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void base_config(BenchState* s) {
+    s->config = model_default_config();
+    s->config.persist_high_score = false;
+    s->config.seed = BENCH_SEED;
+}
+
+// A game in `difficulty`, past its opening so invaders are firing
+static void start_game(BenchState* s, Difficulty difficulty, int warm_ticks) {
+    GameModel* m = &s->start;
+    model_init_with_config(m, &s->config);
+    m->difficulty = difficulty;
+    model_start_game(m, BENCH_SEED);
+    for (int t = 0; t < warm_ticks && m->state == STATE_PLAYING; t++) {
+        model_player_shoot(m, 0);
+        model_update(m, BENCH_TICK);
+    }
+}
+
+// --- model_update: one tick of play, the player firing ---
+
+static void setup_update(BenchState* s, int difficulty) {
+    base_config(s);
+    start_game(s, (Difficulty)difficulty, SIM_TICK_RATE * 2);
+}
+
+static void op_update(BenchState* s, int param) {
+    (void)param;
+    model_player_shoot(&s->model, 0);
+    model_update(&s->model, BENCH_TICK);
+}
+
+// --- model_check_bullet_collisions: `load` enemy bullets, all misses ---
+
+static bool overlaps_target(const GameModel* m, Rect r) {
+    if (model_check_collision(r, m->players[0].hitbox))
+        return true;
+    const InvaderGrid* g = &m->invaders;
+    for (int i = 0; i < INVADER_ROWS; i++)
+        for (int j = 0; j < INVADER_COLS; j++)
+            if ((g->row_mask[i] >> j & 1u) &&
+                model_check_collision(r, invader_grid_rect(g, &g->invaders[i][j])))
+                return true;
+    return false;
+}
+
+// Scatters a pool's bullets over the play area, clear of anything they
+// could hit, so the check leaves the state untouched
+static void scatter_bullets(GameModel* m, BulletPool* pool, int count,
+                            bool player, Rng* rng) {
+    for (int k = 0; k < count; k++) {
+        Bullet* b = bullet_pool_spawn(pool);
+        if (!b)
+            return;
+        b->is_player_bullet = player;
+        b->hitbox.width = BULLET_WIDTH;
+        b->hitbox.height = BULLET_HEIGHT;
+        do {
+            b->hitbox.x = (float)rng_range(rng, GAME_AREA_WIDTH - BULLET_WIDTH);
+            b->hitbox.y = (float)rng_range(rng, SCREEN_HEIGHT - BULLET_HEIGHT);
+        } while (overlaps_target(m, b->hitbox));
+    }
+}
+
+static void setup_collisions(BenchState* s, int load) {
+    base_config(s);
+    s->config.enemy_bullet_capacity = load;
+    start_game(s, DIFFICULTY_NORMAL, 0);
+    GameModel* m = &s->start;
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED, (uint64_t)load);
+    scatter_bullets(m, &m->enemy_bullets, load, false, &rng);
+    int shots = load < PLAYER_BULLETS ? load : PLAYER_BULLETS;
+    scatter_bullets(m, &m->player_bullets[0], shots, true, &rng);
+}
+
+static void op_collisions(BenchState* s, int param) {
+    (void)param;
+    model_check_bullet_collisions(&s->model);
+}
+
+// --- model_update_invaders: the formation marching and firing ---
+
+static void setup_invaders(BenchState* s, int param) {
+    (void)param;
+    base_config(s);
+    start_game(s, DIFFICULTY_NORMAL, 0);
+}
+
+static void op_invaders(BenchState* s, int param) {
+    (void)param;
+    model_update_invaders(&s->model, BENCH_TICK);
+}
+
+// --- model_update_boss: one attack burst per operation ---
+
+static void setup_boss(BenchState* s, int pattern) {
+    base_config(s);
+    s->config.enemy_bullet_capacity = BULLET_POOL_MAX; // Room for every burst
+    start_game(s, DIFFICULTY_NORMAL, 0);
+    GameModel* m = &s->start;
+    while (!m->boss.alive && m->state != STATE_WIN)
+        model_next_level(m);
+    m->state = STATE_PLAYING;
+    m->boss.attack_pattern = pattern;
+}
+
+static void op_boss(BenchState* s, int param) {
+    (void)param;
+    Boss* boss = &s->model.boss;
+    // Due to fire on this update, without reaching the pattern switch
+    boss->shoot_timer = SIM_TICK_RATE / 2;
+    model_update_boss(&s->model, BENCH_TICK);
+}
+
+// --- model_player_shoot: a triple shot, released again afterwards ---
+
+static void setup_shoot(BenchState* s, int param) {
+    (void)param;
+    base_config(s);
+    start_game(s, DIFFICULTY_NORMAL, 0);
+    s->start.players[0].active_powerup = PWR_TRIPLE_SHOT;
+}
+
+static void op_shoot(BenchState* s, int param) {
+    (void)param;
+    GameModel* m = &s->model;
+    model_player_shoot(m, 0);
+    // Back to an empty pool and a ready gun for the next operation
+    BulletPool* pool = &m->player_bullets[0];
+    while (pool->live_count > 0)
+        bullet_pool_release(pool, bullet_pool_at(pool, 0));
+    m->players[0].shoot_timer = 0;
+}
+
+// --- model_init and model_next_level ---
+
+static void setup_init(BenchState* s, int param) {
+    (void)param;
+    base_config(s);
+    start_game(s, DIFFICULTY_NORMAL, 0);
+}
+
+static void op_init(BenchState* s, int param) {
+    (void)param;
+    model_init_with_config(&s->model, &s->config);
+}
+
+static void op_next_level(BenchState* s, int param) {
+    (void)param;
+    GameModel* m = &s->model;
+    m->players[0].level = 1; // Always the 1 -> 2 transition
+    model_next_level(m);
+}
+
+static const Benchmark benchmarks[] = {
+    {"model_update/easy", 256, DIFFICULTY_EASY, setup_update, op_update},
+    {"model_update/normal", 256, DIFFICULTY_NORMAL, setup_update, op_update},
+    {"model_update/hard", 256, DIFFICULTY_HARD, setup_update, op_update},
+    {"model_update/rogue", 256, DIFFICULTY_ROGUE, setup_update, op_update},
+    {"model_check_bullet_collisions/10", 256, 10, setup_collisions,
+     op_collisions},
+    {"model_check_bullet_collisions/64", 256, 64, setup_collisions,
+     op_collisions},
+    {"model_check_bullet_collisions/256", 64, 256, setup_collisions,
+     op_collisions},
+    {"model_update_invaders", 256, 0, setup_invaders, op_invaders},
+    {"model_update_boss/orb_burst", 16, 0, setup_boss, op_boss},
+    {"model_update_boss/bullet_rain", 16, 1, setup_boss, op_boss},
+    {"model_player_shoot", 256, 0, setup_shoot, op_shoot},
+    {"model_init", 16, 0, setup_init, op_init},
+    {"model_next_level", 64, 0, setup_init, op_next_level},
+};
+
+#define BENCH_COUNT (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+typedef struct {
+    int samples;
+    int warmup;
+    const char* filter; // Substring of the names to run, NULL for all
+    const char* json_path; // NULL: stdout
+    bool list;
+} BenchOptions;
+
+typedef struct {
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+} BenchResult;
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static BenchResult run_benchmark(BenchState* s, const Benchmark* b,
+                                 const BenchOptions* opts, double* times) {
+    b->setup(s, b->param);
+    for (int i = 0; i < opts->warmup + opts->samples; i++) {
+        memcpy(&s->model, &s->start, sizeof(GameModel));
+        double t0 = now_ns();
+        for (int k = 0; k < b->batch; k++)
+            b->op(s, b->param);
+        double ns = (now_ns() - t0) / b->batch;
+        if (i >= opts->warmup)
+            times[i - opts->warmup] = ns;
+    }
+    qsort(times, (size_t)opts->samples, sizeof(double), compare_double);
+    int p99 = (opts->samples * 99 + 99) / 100 - 1;
+    BenchResult r = {
+        .median_ns = times[opts->samples / 2],
+        .p99_ns = times[p99],
+        .min_ns = times[0],
+    };
+    return r;
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --samples N    Timed samples per benchmark (default %d)\n",
+           BENCH_DEFAULT_SAMPLES);
+    printf("  --warmup N     Untimed samples first (default %d)\n",
+           BENCH_DEFAULT_WARMUP);
+    printf("  --filter TEXT  Only benchmarks whose name contains TEXT\n");
+    printf("  --json FILE    Write the results there instead of stdout\n");
+    printf("  --list         List the benchmarks and exit\n");
+}
+
+static bool parse_options(int argc, char* argv[], BenchOptions* opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->samples = BENCH_DEFAULT_SAMPLES;
+    opts->warmup = BENCH_DEFAULT_WARMUP;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--samples") == 0 && has_value) {
+            opts->samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+            opts->warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            opts->filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && has_value) {
+            opts->json_path = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            opts->list = true;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return opts->samples > 0 && opts->warmup >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opts;
+    if (!parse_options(argc, argv, &opts))
+        return 1;
+    if (opts.list) {
+        for (int i = 0; i < BENCH_COUNT; i++)
+            printf("%s\n", benchmarks[i].name);
+        return 0;
+    }
+
+    FILE* out = stdout;
+    if (opts.json_path && !(out = fopen(opts.json_path, "w"))) {
+        perror(opts.json_path);
+        return 1;
+    }
+    BenchState* state = malloc(sizeof(BenchState));
+    double* times = malloc((size_t)opts.samples * sizeof(double));
+    if (!state || !times) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"suite\": \"model\",\n  \"seed\": %u,\n"
+                 "  \"samples\": %d,\n  \"warmup\": %d,\n"
+                 "  \"benchmarks\": [",
+            BENCH_SEED, opts.samples, opts.warmup);
+    int run = 0;
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        const Benchmark* b = &benchmarks[i];
+        if (opts.filter && !strstr(b->name, opts.filter))
+            continue;
+        BenchResult r = run_benchmark(state, b, &opts, times);
+        // Progress on stderr, so stdout stays valid JSON
+        fprintf(stderr, "%-36s median %10.1f ns/op   p99 %10.1f ns/op\n",
+                b->name, r.median_ns, r.p99_ns);
+        fprintf(out,
+                "%s\n    {\"name\": \"%s\", \"batch\": %d, "
+                "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f}",
+                run++ ? "," : "", b->name, b->batch, r.median_ns, r.p99_ns,
+                r.min_ns);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    free(times);
+    free(state);
+    if (out != stdout && fclose(out) != 0) {
+        perror(opts.json_path);
+        return 1;
+    }
+    return 0;
+}
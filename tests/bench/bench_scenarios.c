@@ -0,0 +1,591 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/model.h"
+#include "core/rng.h"
+
+/*
+ * Performance regression gate (make perf-gate).
+ *
+ * Whole games played headless by a built-in player, from a fixed seed, so
+ * every run simulates exactly the same ticks: levels 1-3, the boss fight,
+ * rogue mode up to level 20, and hard levels under a constant rain of
+ * enemy bullets. A tick takes a couple of hundred ns, too close to the cost
+ * of reading the clock to time one by one: samples are batches of ticks
+ * (player included, level skips left out) lasting some 5 us, long next to
+ * the clock and short next to the scheduler's interruptions, and the p99
+ * and median are those of the batches' time per tick. Times are the
+ * thread's CPU time, so the machine serving other work in between does not
+ * count. After a few untimed warmup runs, each scenario runs several times,
+ * the runs going round the scenarios, and reports the median over its runs
+ * of each figure. A best run would follow the rare runs the machine happens to
+ * speed up, and get better the more runs there are.
+ *
+ * With --baseline, the figures are compared to a file written earlier by
+ * --json (tests/bench/baseline.json, regenerated with make perf-baseline on
+ * the machine that runs the gate, with the same --runs); the exit status is
+ * 1 when a scenario lost more than --threshold percent, once the figures are
+ * scaled by how much slower a reference loop timed after each run got
+ * since the baseline. A scenario over the
+ * threshold is measured again with a fresh round of runs, up to
+ * GATE_RETRIES times and after a pause, before it counts.
+ */
+
+#define GATE_DEFAULT_RUNS 20
+#define GATE_DEFAULT_WARMUP 5
+#define GATE_DEFAULT_THRESHOLD 15.0
+#define GATE_RETRIES 3           // Measurements again over the threshold
+#define GATE_RETRY_PAUSE_MS 1000 // Lets a burst of load on the machine pass
+#define GATE_LAYOUT_SPAN 4096    // Range of the per-run memory shifts
+#define GATE_SEED 0x5eed0002u
+#define GATE_TICK (1.0f / SIM_TICK_RATE)
+#define GATE_MINUTE (SIM_TICK_RATE * 60)
+#define REFERENCE_POINTS 2048
+#define REFERENCE_STEPS 100
+
+typedef struct {
+    const char* name;
+    Difficulty difficulty;
+    int start_level;   // Reached with model_next_level before the first tick
+    int stop_level;    // Ends on reaching it; 0 to play max_ticks
+    int level_ticks;   // Longest time spent in one level
+    int max_ticks;
+    int enemy_bullets; // Enemy pool capacity, 0 for the default
+    int bullet_rain;   // Enemy bullets kept in flight, on top of the game's
+    int batch_ticks;   // Ticks timed together as one sample
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"levels_1_3", DIFFICULTY_NORMAL, 1, 4, GATE_MINUTE, 10 * GATE_MINUTE, 0,
+     0, 20},
+    {"boss", DIFFICULTY_NORMAL, 4, 5, 3 * GATE_MINUTE, 5 * GATE_MINUTE, 0, 0,
+     20},
+    {"rogue_1_20", DIFFICULTY_ROGUE, 1, 20, GATE_MINUTE, 30 * GATE_MINUTE, 0,
+     0, 20},
+    {"bullet_stress", DIFFICULTY_HARD, 1, 4, GATE_MINUTE / 2, 2 * GATE_MINUTE,
+     BULLET_POOL_MAX, 200, 1},
+};
+
+#define SCENARIO_COUNT (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct {
+    int runs; // Measured so far
+    int ticks;
+    // Per run of the latest round
+    double* run_rates;
+    double* run_p99s;
+    double* run_medians;
+    double* run_references;
+    // Medians over the runs, set by summarise
+    double ticks_per_sec;
+    double p99_ns;       // Per tick
+    double median_ns;    // Per tick
+    double reference_ns; // The reference loop, timed after each run
+} GateResult;
+
+// One run: time per tick of each batch, in the order played
+typedef struct {
+    int ticks;
+    int samples;
+    double total_ns;
+    double* times;
+} RunTiming;
+
+typedef struct {
+    int runs;
+    int warmup;
+    double threshold; // Percent
+    const char* filter;
+    const char* json_path;
+    const char* baseline_path;
+    bool list;
+} GateOptions;
+
+// CPU time of this thread: the time the machine gives to other work, which
+// comes and goes on a shared host, is not counted against the game
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// --- Reference loop: how fast the machine runs at the moment ---
+
+typedef struct {
+    float x, y;
+    float vx, vy;
+} ReferencePoint;
+
+static ReferencePoint reference_points[REFERENCE_POINTS];
+static volatile uint32_t reference_sink;
+
+// A fixed amount of work much like a tick's, bouncing points about the
+// screen, that no change to the game touches. On a shared host the whole
+// machine has spells some 25% slower that last seconds; the game and this
+// loop slow down together, so the gate weighs the game against it.
+static double reference_ns(void) {
+    uint32_t state = GATE_SEED;
+    uint32_t hits = 0;
+    double start = now_ns();
+    for (int i = 0; i < REFERENCE_POINTS; i++)
+        reference_points[i] = (ReferencePoint){
+            (float)(i % 97) * 8, (float)(i % 61) * 8, 1.5f, -0.5f};
+    for (int step = 0; step < REFERENCE_STEPS; step++) {
+        for (int i = 0; i < REFERENCE_POINTS; i++) {
+            ReferencePoint* p = &reference_points[i];
+            p->x += p->vx;
+            p->y += p->vy;
+            if (p->x < 0 || p->x > GAME_AREA_WIDTH)
+                p->vx = -p->vx;
+            if (p->y < 0 || p->y > SCREEN_HEIGHT)
+                p->vy = -p->vy;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            hits += (state & 1023) == 0;
+        }
+    }
+    reference_sink = hits;
+    return now_ns() - start;
+}
+
+// Chases the nearest shootable target and keeps firing, as the headless
+// build's player does
+static void bot_play(GameModel* m) {
+    const Player* p = &m->players[0];
+    float px = p->hitbox.x + p->hitbox.width / 2;
+    float target = px;
+    float best = -1.0f;
+    if (m->boss.alive) {
+        target = m->boss.hitbox.x + m->boss.hitbox.width / 2;
+    } else {
+        const InvaderGrid* g = &m->invaders;
+        for (int i = 0; i < INVADER_ROWS; i++) {
+            for (uint32_t bits = g->row_mask[i]; bits; bits &= bits - 1) {
+                Rect r = invader_grid_rect(
+                    g, &g->invaders[i][__builtin_ctz(bits)]);
+                float cx = r.x + r.width / 2;
+                float dist = cx > px ? cx - px : px - cx;
+                if (best < 0 || dist < best) {
+                    best = dist;
+                    target = cx;
+                }
+            }
+        }
+    }
+    if (target < px - 4.0f)
+        model_move_player(m, 0, DIR_LEFT);
+    else if (target > px + 4.0f)
+        model_move_player(m, 0, DIR_RIGHT);
+    model_player_shoot(m, 0);
+}
+
+// Tops the enemy pool up to `count` live bullets falling from the top edge
+static void rain_bullets(GameModel* m, int count, Rng* rng) {
+    while (m->enemy_bullets.live_count < count) {
+        Bullet* b = bullet_pool_spawn(&m->enemy_bullets);
+        if (!b)
+            return;
+        b->player_id = -1;
+        b->hitbox.x = (float)rng_range(rng, GAME_AREA_WIDTH - BULLET_WIDTH);
+        b->hitbox.y = (float)rng_range(rng, SCREEN_HEIGHT / 4);
+        b->hitbox.width = BULLET_WIDTH;
+        b->hitbox.height = BULLET_HEIGHT;
+        b->speed_y = 250.0f;
+    }
+}
+
+static void setup_scenario(GameModel* m, const Scenario* s) {
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    config.seed = GATE_SEED;
+    if (s->enemy_bullets)
+        config.enemy_bullet_capacity = s->enemy_bullets;
+    model_init_with_config(m, &config);
+    m->difficulty = s->difficulty;
+    model_start_game(m, GATE_SEED);
+    while (m->players[0].level < s->start_level && m->state != STATE_WIN)
+        model_next_level(m);
+    m->state = STATE_PLAYING;
+}
+
+// Closes the batch in progress, if any, as one sample
+static void end_batch(RunTiming* run, int* batch, double start) {
+    if (*batch == 0)
+        return;
+    double elapsed = now_ns() - start;
+    run->times[run->samples++] = elapsed / *batch;
+    run->total_ns += elapsed;
+    *batch = 0;
+}
+
+// One run, timed into `run`. A level the player loses, or has not cleared
+// after level_ticks, is skipped with model_next_level, so every run covers
+// the whole level range.
+static void run_scenario(GameModel* m, const Scenario* s, RunTiming* run) {
+    setup_scenario(m, s);
+    Rng rng;
+    rng_seed(&rng, GATE_SEED, 1);
+    run->ticks = 0;
+    run->samples = 0;
+    run->total_ns = 0;
+    int level = m->players[0].level;
+    int level_start = 0;
+    int batch = 0;
+    double start = 0;
+    while (run->ticks < s->max_ticks && m->state != STATE_WIN) {
+        if (m->players[0].level != level) {
+            level = m->players[0].level;
+            level_start = run->ticks;
+        }
+        if (s->stop_level && level >= s->stop_level)
+            break;
+        if (m->state == STATE_GAME_OVER ||
+            run->ticks - level_start >= s->level_ticks) {
+            end_batch(run, &batch, start);
+            m->state = STATE_PLAYING;
+            model_next_level(m);
+            continue;
+        }
+        if (batch == 0)
+            start = now_ns();
+        // What the shoot button does between levels
+        if (m->state == STATE_LEVEL_TRANSITION)
+            m->state = STATE_PLAYING;
+        m->players[0].lives = 3; // Hits cost time, never the level
+        bot_play(m);
+        rain_bullets(m, s->bullet_rain, &rng);
+        model_update(m, GATE_TICK);
+        run->ticks++;
+        if (++batch == s->batch_ticks)
+            end_batch(run, &batch, start);
+    }
+    end_batch(run, &batch, start);
+}
+
+// Where the model and model_update's stack frames fall relative to each
+// other moves the timings by up to a third (cache set and 4K aliasing
+// conflicts), and the loader picks that anew for every process. Each run
+// shifts both by a different amount, so the median of the runs does not
+// depend on the pick.
+static void run_shifted(char* arena, const Scenario* s, RunTiming* timing,
+                        int run) {
+    size_t stack_shift = (size_t)run * 272 % GATE_LAYOUT_SPAN;
+    GameModel* m = (GameModel*)(arena + (size_t)run * 528 % GATE_LAYOUT_SPAN);
+    volatile char pad[stack_shift + 1];
+    pad[stack_shift] = 0;
+    (void)pad[stack_shift];
+    run_scenario(m, s, timing);
+}
+
+// Adds one run to `r`. `arena` holds a GameModel plus GATE_LAYOUT_SPAN
+// bytes.
+static void measure_run(char* arena, const Scenario* s, RunTiming* timing,
+                        GateResult* r) {
+    run_shifted(arena, s, timing, r->runs);
+    int n = timing->samples;
+    double* times = timing->times;
+    qsort(times, (size_t)n, sizeof(double), compare_double);
+    r->ticks = timing->ticks;
+    r->run_rates[r->runs] = timing->total_ns > 0
+                                ? timing->ticks / (timing->total_ns / 1e9)
+                                : 0;
+    r->run_p99s[r->runs] = n ? times[(n * 99 + 99) / 100 - 1] : 0;
+    r->run_medians[r->runs] = n ? times[n / 2] : 0;
+    r->run_references[r->runs] = reference_ns();
+    r->runs++;
+}
+
+// Sorts values in place
+static double median(double* values, int n) {
+    qsort(values, (size_t)n, sizeof(double), compare_double);
+    return n ? values[n / 2] : 0;
+}
+
+static void summarise(GateResult* r) {
+    r->ticks_per_sec = median(r->run_rates, r->runs);
+    r->p99_ns = median(r->run_p99s, r->runs);
+    r->median_ns = median(r->run_medians, r->runs);
+    r->reference_ns = median(r->run_references, r->runs);
+}
+
+// --- Baseline: the lines --json writes, one scenario per line ---
+
+typedef struct {
+    char name[64];
+    int ticks;
+    double ticks_per_sec;
+    double p99_ns;
+    double reference_ns; // 0 in baselines written before it was measured
+} BaselineEntry;
+
+// Also sets *runs to the run count the baseline was measured with
+static int load_baseline(const char* path, BaselineEntry* entries, int max,
+                         int* runs) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    int n = 0;
+    char line[512];
+    while (n < max && fgets(line, sizeof(line), f)) {
+        sscanf(line, " \"runs\": %d", runs);
+        const char* p = strstr(line, "{\"name\"");
+        BaselineEntry* e = &entries[n];
+        e->reference_ns = 0;
+        if (p && sscanf(p,
+                        "{\"name\": \"%63[^\"]\", \"ticks\": %d, "
+                        "\"ticks_per_sec\": %lf, \"p99_ns\": %lf, "
+                        "\"median_ns\": %*f, \"reference_ns\": %lf",
+                        e->name, &e->ticks, &e->ticks_per_sec, &e->p99_ns,
+                        &e->reference_ns) >= 4)
+            n++;
+    }
+    fclose(f);
+    if (n == 0)
+        fprintf(stderr, "%s: no scenarios in the baseline\n", path);
+    return n;
+}
+
+static const BaselineEntry* find_baseline(const BaselineEntry* entries,
+                                          int count, const char* name) {
+    for (int i = 0; i < count; i++)
+        if (strcmp(entries[i].name, name) == 0)
+            return &entries[i];
+    return NULL;
+}
+
+// How much slower the machine runs than when the baseline was measured, by
+// the reference loop
+static double machine_slowdown(const GateResult* r,
+                               const BaselineEntry* base) {
+    if (base->reference_ns <= 0 || r->reference_ns <= 0)
+        return 1;
+    return r->reference_ns / base->reference_ns;
+}
+
+static bool regressed(const GateResult* r, const BaselineEntry* base,
+                      double threshold) {
+    if (!base)
+        return false;
+    double slowdown = machine_slowdown(r, base);
+    return r->ticks_per_sec * slowdown <
+               base->ticks_per_sec * (1 - threshold / 100) ||
+           r->p99_ns / slowdown > base->p99_ns * (1 + threshold / 100);
+}
+
+// Prints the comparison line; true when the scenario regressed
+static bool compare(const char* name, const GateResult* r,
+                    const BaselineEntry* base, double threshold) {
+    if (!base) {
+        printf("%-16s not in the baseline, skipped\n", name);
+        return false;
+    }
+    // The changes are those left once the machine's own is taken out
+    double slowdown = machine_slowdown(r, base);
+    double rate_change =
+        (r->ticks_per_sec * slowdown / base->ticks_per_sec - 1) * 100;
+    double p99_change = (r->p99_ns / slowdown / base->p99_ns - 1) * 100;
+    bool regressed_now = regressed(r, base, threshold);
+    printf("%-16s %10.0f ticks/s %+6.1f%%   p99 %8.0f ns %+6.1f%%   "
+           "machine %+6.1f%%   %s\n",
+           name, r->ticks_per_sec, rate_change, r->p99_ns, p99_change,
+           (slowdown - 1) * 100, regressed_now ? "REGRESSION" : "ok");
+    if (r->ticks != base->ticks)
+        printf("%-16s %d ticks instead of %d: the simulation changed, "
+               "regenerate the baseline\n",
+               "", r->ticks, base->ticks);
+    return regressed_now;
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --runs N         Runs per scenario (default %d)\n",
+           GATE_DEFAULT_RUNS);
+    printf("  --warmup N       Untimed runs first (default %d)\n",
+           GATE_DEFAULT_WARMUP);
+    printf("  --filter TEXT    Only scenarios whose name contains TEXT\n");
+    printf("  --json FILE      Write the results there\n");
+    printf("  --baseline FILE  Compare with results written by --json\n");
+    printf("  --threshold PCT  Allowed loss against the baseline "
+           "(default %.0f)\n",
+           GATE_DEFAULT_THRESHOLD);
+    printf("  --list           List the scenarios and exit\n");
+}
+
+static bool parse_options(int argc, char* argv[], GateOptions* opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->runs = GATE_DEFAULT_RUNS;
+    opts->warmup = GATE_DEFAULT_WARMUP;
+    opts->threshold = GATE_DEFAULT_THRESHOLD;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--runs") == 0 && has_value) {
+            opts->runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+            opts->warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            opts->filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && has_value) {
+            opts->json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+            opts->baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && has_value) {
+            opts->threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            opts->list = true;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return opts->runs > 0 && opts->warmup >= 0 && opts->threshold >= 0;
+}
+
+int main(int argc, char* argv[]) {
+    GateOptions opts;
+    if (!parse_options(argc, argv, &opts))
+        return 1;
+    if (opts.list) {
+        for (int i = 0; i < SCENARIO_COUNT; i++)
+            printf("%s\n", scenarios[i].name);
+        return 0;
+    }
+
+    BaselineEntry baseline[SCENARIO_COUNT * 2];
+    int baseline_count = 0;
+    if (opts.baseline_path) {
+        int baseline_runs = 0;
+        baseline_count = load_baseline(opts.baseline_path, baseline,
+                                       SCENARIO_COUNT * 2, &baseline_runs);
+        if (baseline_count <= 0)
+            return 1;
+        // Medians over different numbers of runs do not spread alike
+        if (baseline_runs != opts.runs)
+            printf("Warning: the baseline was measured over %d runs, this "
+                   "gate over %d; regenerate it with --runs %d\n",
+                   baseline_runs, opts.runs, opts.runs);
+    }
+
+    int max_ticks = 0;
+    for (int i = 0; i < SCENARIO_COUNT; i++)
+        if (scenarios[i].max_ticks > max_ticks)
+            max_ticks = scenarios[i].max_ticks;
+    char* arena = malloc(sizeof(GameModel) + GATE_LAYOUT_SPAN);
+    // Every sample holds at least one tick
+    RunTiming timing = {0};
+    timing.times = malloc((size_t)max_ticks * sizeof(double));
+    size_t max_runs = (size_t)opts.runs;
+    if (max_runs < (size_t)opts.warmup)
+        max_runs = (size_t)opts.warmup;
+    double* per_run = malloc((SCENARIO_COUNT + 1) * 4 * max_runs *
+                             sizeof(double));
+    GateResult results[SCENARIO_COUNT + 1]; // The last one for warmups
+    bool ran[SCENARIO_COUNT] = {false};
+    if (!arena || !timing.times || !per_run) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i <= SCENARIO_COUNT; i++) {
+        double* runs = per_run + (size_t)i * 4 * max_runs;
+        results[i] = (GateResult){
+            .run_rates = runs,
+            .run_p99s = runs + max_runs,
+            .run_medians = runs + 2 * max_runs,
+            .run_references = runs + 3 * max_runs,
+        };
+    }
+
+    GateResult* warmup = &results[SCENARIO_COUNT];
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        ran[i] = !opts.filter || strstr(scenarios[i].name, opts.filter);
+        for (warmup->runs = 0; ran[i] && warmup->runs < opts.warmup;)
+            measure_run(arena, &scenarios[i], &timing, warmup);
+    }
+    // The runs go round the scenarios, so each one's median is taken over the
+    // whole measurement rather than over a burst of load on the machine
+    for (int run = 0; run < opts.runs; run++)
+        for (int i = 0; i < SCENARIO_COUNT; i++)
+            if (ran[i])
+                measure_run(arena, &scenarios[i], &timing, &results[i]);
+    for (int i = 0; i < SCENARIO_COUNT; i++)
+        summarise(&results[i]);
+
+    int regressions = 0;
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        if (!ran[i])
+            continue;
+        const Scenario* s = &scenarios[i];
+        GateResult* r = &results[i];
+        const BaselineEntry* base =
+            find_baseline(baseline, baseline_count, s->name);
+        for (int retry = 0;
+             retry < GATE_RETRIES && regressed(r, base, opts.threshold);
+             retry++) {
+            struct timespec pause = {GATE_RETRY_PAUSE_MS / 1000,
+                                     GATE_RETRY_PAUSE_MS % 1000 * 1000000L};
+            nanosleep(&pause, NULL);
+            // A fresh round replaces the one measured in the slow spell
+            r->runs = 0;
+            for (int run = 0; run < opts.runs; run++)
+                measure_run(arena, s, &timing, r);
+            summarise(r);
+        }
+        if (opts.baseline_path)
+            regressions += compare(s->name, r, base, opts.threshold);
+        else
+            printf("%-16s %7d ticks %10.0f ticks/s   median %8.0f ns   "
+                   "p99 %8.0f ns\n",
+                   s->name, r->ticks, r->ticks_per_sec, r->median_ns,
+                   r->p99_ns);
+    }
+    free(per_run);
+    free(timing.times);
+    free(arena);
+
+    if (opts.json_path) {
+        FILE* out = fopen(opts.json_path, "w");
+        if (!out) {
+            perror(opts.json_path);
+            return 1;
+        }
+        fprintf(out, "{\n  \"suite\": \"scenarios\",\n  \"seed\": %u,\n"
+                     "  \"runs\": %d,\n  \"warmup\": %d,\n"
+                     "  \"scenarios\": [",
+                GATE_SEED, opts.runs, opts.warmup);
+        int written = 0;
+        for (int i = 0; i < SCENARIO_COUNT; i++) {
+            if (!ran[i])
+                continue;
+            const GateResult* r = &results[i];
+            fprintf(out,
+                    "%s\n    {\"name\": \"%s\", \"ticks\": %d, "
+                    "\"ticks_per_sec\": %.1f, \"p99_ns\": %.1f, "
+                    "\"median_ns\": %.1f, \"reference_ns\": %.1f}",
+                    written++ ? "," : "", scenarios[i].name, r->ticks,
+                    r->ticks_per_sec, r->p99_ns, r->median_ns,
+                    r->reference_ns);
+        }
+        fprintf(out, "\n  ]\n}\n");
+        if (fclose(out) != 0) {
+            perror(opts.json_path);
+            return 1;
+        }
+    }
+
+    if (regressions) {
+        printf("%d scenario%s slower than the baseline by more than %.0f%%\n",
+               regressions, regressions > 1 ? "s" : "", opts.threshold);
+        return 1;
+    }
+    return 0;
+}
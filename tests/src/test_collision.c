@@ -0,0 +1,97 @@
+#include "test_utils.h"
+#include "../core/collision.h"
+#include <string.h>
+
+bool test_collision_grid_query(void) {
+    static CollisionGrid grid;
+    uint16_t out[COLLISION_MAX_IDS];
+    collision_grid_clear(&grid);
+
+    Rect a = {10, 10, 30, 30};   // Top-left cell(s)
+    Rect b = {300, 300, 30, 30}; // Middle of the area
+    Rect c = {35, 35, 10, 10};   // Straddles the first cell corner
+    collision_grid_insert(&grid, a, 7);
+    collision_grid_insert(&grid, b, 3);
+    collision_grid_insert(&grid, c, 1);
+
+    // Near the top-left: a and c, ascending and without duplicates
+    Rect q = {20, 20, 30, 30};
+    int n = collision_grid_query(&grid, q, out, COLLISION_MAX_IDS);
+    TEST_ASSERT_EQ(n, 2);
+    TEST_ASSERT_EQ(out[0], 1);
+    TEST_ASSERT_EQ(out[1], 7);
+
+    // Far away from everything
+    Rect far = {500, 20, 10, 10};
+    TEST_ASSERT_EQ(collision_grid_query(&grid, far, out, COLLISION_MAX_IDS), 0);
+
+    // Off-screen rects are clamped into border cells, not lost
+    Rect off = {-40, 310, 10, 10};
+    collision_grid_insert(&grid, off, 9);
+    Rect q_off = {-20, 300, 10, 10};
+    n = collision_grid_query(&grid, q_off, out, COLLISION_MAX_IDS);
+    TEST_ASSERT_EQ(n, 1);
+    TEST_ASSERT_EQ(out[0], 9);
+    return true;
+}
+
+bool test_collision_grid_oversize(void) {
+    static CollisionGrid grid;
+    uint16_t out[COLLISION_MAX_IDS];
+    collision_grid_clear(&grid);
+
+    // A rect covering most of the area is returned by every query
+    Rect huge = {0, 0, GAME_AREA_WIDTH, SCREEN_HEIGHT};
+    collision_grid_insert(&grid, huge, 42);
+    Rect small = {580, 580, 5, 5};
+    collision_grid_insert(&grid, small, 5);
+
+    Rect q = {570, 570, 20, 20};
+    int n = collision_grid_query(&grid, q, out, COLLISION_MAX_IDS);
+    TEST_ASSERT_EQ(n, 2);
+    TEST_ASSERT_EQ(out[0], 5);
+    TEST_ASSERT_EQ(out[1], 42);
+
+    // Clearing drops everything
+    collision_grid_clear(&grid);
+    TEST_ASSERT_EQ(collision_grid_query(&grid, q, out, COLLISION_MAX_IDS), 0);
+    return true;
+}
+
+bool test_collision_batch_overlap(void) {
+    static CollisionBatch batch;
+    uint32_t hits[COLLISION_MASK_WORDS(COLLISION_BATCH_MAX)];
+    Rng rng;
+    rng_seed(&rng, 99, 0);
+
+    // Same answers as model_check_collision, including the scalar tail
+    for (int round = 0; round < 50; round++) {
+        collision_batch_clear(&batch);
+        Rect targets[COLLISION_BATCH_MAX];
+        int count = 1 + rng_range(&rng, COLLISION_BATCH_MAX);
+        for (int i = 0; i < count; i++) {
+            targets[i] = (Rect){(float)rng_range(&rng, 600), (float)rng_range(&rng, 600),
+                                (float)(1 + rng_range(&rng, 40)), (float)(1 + rng_range(&rng, 40))};
+            TEST_ASSERT_EQ(collision_batch_add(&batch, targets[i]), i);
+        }
+        Rect probe = {(float)rng_range(&rng, 600), (float)rng_range(&rng, 600), 60, 45};
+        int found = collision_batch_overlap(&batch, probe, hits);
+
+        int expected = 0;
+        for (int i = 0; i < count; i++) {
+            bool hit = model_check_collision(probe, targets[i]);
+            TEST_ASSERT(collision_mask_test(hits, i) == hit);
+            expected += hit;
+        }
+        TEST_ASSERT_EQ(found, expected);
+    }
+
+    // Touching edges do not overlap; a full batch rejects more targets
+    collision_batch_clear(&batch);
+    Rect a = {0, 0, 5, 5};
+    collision_batch_add(&batch, (Rect){5, 0, 5, 5});
+    TEST_ASSERT_EQ(collision_batch_overlap(&batch, a, hits), 0);
+    batch.count = COLLISION_BATCH_MAX;
+    TEST_ASSERT_EQ(collision_batch_add(&batch, a), -1);
+    return true;
+}
@@ -0,0 +1,202 @@
+#include "test_utils.h"
+#include "../env/raster.h"
+#include "../env/si_env.h"
+#include <math.h>
+#include <string.h>
+
+#define TEST_ENVS 3
+
+static int32_t test_env_action(int step, int env) {
+    return (int32_t)((step / 5 + env) % SI_ENV_ACTION_COUNT);
+}
+
+bool test_env_batched_step(void) {
+    static float obs_a[TEST_ENVS * SI_ENV_OBS_SIZE];
+    static float obs_b[TEST_ENVS * SI_ENV_OBS_SIZE];
+    float reward_a[TEST_ENVS], reward_b[TEST_ENVS];
+    uint8_t done_a[TEST_ENVS], done_b[TEST_ENVS];
+    int32_t actions[TEST_ENVS];
+
+    TEST_ASSERT(env_create(0, 1) == NULL);
+    SiEnv* a = env_create(TEST_ENVS, 42);
+    SiEnv* b = env_create(TEST_ENVS, 42);
+    TEST_ASSERT(a != NULL && b != NULL);
+    TEST_ASSERT_EQ(env_num_envs(a), TEST_ENVS);
+    env_reset(a, obs_a);
+    env_reset(b, obs_b);
+
+    // A fresh game: full formation, full lives, nothing in the air
+    for (int k = 8; k < 58; k++)
+        TEST_ASSERT_EQ(obs_a[k], 1.0f);
+    TEST_ASSERT_EQ(obs_a[1], 1.0f);
+    TEST_ASSERT_EQ(obs_a[2], 0.0f);
+
+    // Same seed and actions: same episodes. Rewards add up to the score.
+    float returns[TEST_ENVS] = {0};
+    int episodes = 0;
+    for (int step = 0; step < 20000 && episodes < 2; step++) {
+        for (int i = 0; i < TEST_ENVS; i++)
+            actions[i] = test_env_action(step, i);
+        env_step(a, actions, obs_a, reward_a, done_a);
+        env_step(b, actions, obs_b, reward_b, done_b);
+        TEST_ASSERT(memcmp(obs_a, obs_b, sizeof(obs_a)) == 0);
+        TEST_ASSERT(memcmp(reward_a, reward_b, sizeof(reward_a)) == 0);
+        for (int i = 0; i < TEST_ENVS; i++) {
+            TEST_ASSERT(reward_a[i] >= 0.0f);
+            TEST_ASSERT(obs_a[i * SI_ENV_OBS_SIZE] >= 0.0f &&
+                        obs_a[i * SI_ENV_OBS_SIZE] <= 1.0f);
+            returns[i] += reward_a[i];
+            if (done_a[i]) {
+                // Auto-reset: the observation already starts the next game
+                TEST_ASSERT_EQ((int)returns[i], env_last_score(a, i));
+                TEST_ASSERT_EQ(obs_a[i * SI_ENV_OBS_SIZE + 1], 1.0f);
+                returns[i] = 0;
+                episodes++;
+            }
+        }
+    }
+    TEST_ASSERT(episodes >= 2);
+
+    // Out-of-range actions do nothing rather than fail
+    for (int i = 0; i < TEST_ENVS; i++)
+        actions[i] = -1;
+    env_step(a, actions, obs_a, reward_a, done_a);
+    env_destroy(a);
+    env_destroy(b);
+    return true;
+}
+
+// Naive reference: test every pixel against every rect with the rule
+// documented in raster.h
+static void reference_rect(uint8_t* plane, int w, int h, Rect r,
+                           uint8_t value) {
+    float sx = (float)w / GAME_AREA_WIDTH, sy = (float)h / SCREEN_HEIGHT;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            bool in = r.width > 0 && r.height > 0 &&
+                      x >= (int)floorf(r.x * sx) &&
+                      x < (int)ceilf((r.x + r.width) * sx) &&
+                      y >= (int)floorf(r.y * sy) &&
+                      y < (int)ceilf((r.y + r.height) * sy);
+            if (in && plane[y * w + x] < value)
+                plane[y * w + x] = value;
+        }
+}
+
+static void reference_pool(uint8_t* plane, int w, int h,
+                           const BulletPool* pool, uint8_t value) {
+    for (int i = 0; i < pool->capacity; i++)
+        if (pool->items[i].alive)
+            reference_rect(plane, w, h, pool->items[i].hitbox, value);
+}
+
+static void reference_draw(const GameModel* m, int w, int h, RasterMode mode,
+                           uint8_t* out) {
+    memset(out, 0, raster_image_size(w, h, mode));
+    bool planar = mode == RASTER_MULTI_PLANE;
+    size_t size = (size_t)w * h;
+    uint8_t* players = planar ? out + RASTER_PLANE_PLAYERS * size : out;
+    uint8_t* invaders = planar ? out + RASTER_PLANE_INVADERS * size : out;
+    uint8_t* enemy = planar ? out + RASTER_PLANE_ENEMY_BULLETS * size : out;
+    uint8_t* shots = planar ? out + RASTER_PLANE_PLAYER_BULLETS * size : out;
+    uint8_t v_inv = planar ? 255 : RASTER_GRAY_INVADERS;
+
+    const InvaderGrid* g = &m->invaders;
+    for (int i = 0; i < INVADER_ROWS; i++)
+        for (int j = 0; j < INVADER_COLS; j++)
+            if (g->row_mask[i] & (1u << j))
+                reference_rect(invaders, w, h,
+                               invader_grid_rect(g, &g->invaders[i][j]), v_inv);
+    if (g->big_invader.alive)
+        reference_rect(invaders, w, h, g->big_invader.hitbox, v_inv);
+    if (m->boss.alive)
+        reference_rect(invaders, w, h, m->boss.hitbox, v_inv);
+    if (m->saucer.alive)
+        reference_rect(invaders, w, h, m->saucer.hitbox, v_inv);
+    reference_pool(enemy, w, h, &m->enemy_bullets,
+                   planar ? 255 : RASTER_GRAY_ENEMY_BULLETS);
+    for (int p = 0; p < 2; p++)
+        reference_pool(shots, w, h, &m->player_bullets[p],
+                       planar ? 255 : RASTER_GRAY_PLAYER_BULLETS);
+    for (int p = 0; p < 2; p++) {
+        const Player* player = &m->players[p];
+        if ((p == 0 || player->is_active) && player->lives > 0)
+            reference_rect(players, w, h, player->hitbox,
+                           planar ? 255 : RASTER_GRAY_PLAYERS);
+    }
+}
+
+bool test_env_raster(void) {
+    static GameModel model;
+    static uint8_t image[RASTER_PLANES * 210 * 160];
+    static uint8_t expected[RASTER_PLANES * 210 * 160];
+    static const int sizes[][2] = {{84, 84}, {17, 13}, {160, 210}};
+
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(&model, &config);
+    model_start_game(&model, 7);
+    TEST_ASSERT(!raster_draw(&model, 0, 84, RASTER_GRAYSCALE, image));
+    TEST_ASSERT(!raster_draw(&model, 84, RASTER_MAX_SIZE + 1,
+                             RASTER_GRAYSCALE, image));
+
+    // Same pixels as the reference, as the game goes on and bullets fly
+    for (int t = 0; t <= 600; t++) {
+        if (t % 150 == 0) {
+            for (int k = 0; k < 3; k++) {
+                const int w = sizes[k][0], h = sizes[k][1];
+                for (int mode = RASTER_MULTI_PLANE; mode <= RASTER_GRAYSCALE;
+                     mode++) {
+                    size_t n = raster_image_size(w, h, (RasterMode)mode);
+                    TEST_ASSERT(raster_draw(&model, w, h, (RasterMode)mode,
+                                            image));
+                    reference_draw(&model, w, h, (RasterMode)mode, expected);
+                    TEST_ASSERT(memcmp(image, expected, n) == 0);
+                }
+            }
+        }
+        model_player_shoot(&model, 0);
+        model_update(&model, 1.0f / 60.0f);
+    }
+    TEST_ASSERT(model.state == STATE_PLAYING);
+
+    // The player is on its plane; a hit invader leaves the invader plane
+    const int w = 160, h = 210;
+    const size_t size = (size_t)w * h;
+    float sx = (float)w / GAME_AREA_WIDTH, sy = (float)h / SCREEN_HEIGHT;
+    Rect pr = model.players[0].hitbox;
+    int px = (int)((pr.x + pr.width / 2) * sx);
+    int py = (int)((pr.y + pr.height / 2) * sy);
+    TEST_ASSERT(raster_draw(&model, w, h, RASTER_MULTI_PLANE, image));
+    TEST_ASSERT_EQ(image[RASTER_PLANE_PLAYERS * size + py * w + px], 255);
+    TEST_ASSERT_EQ(image[RASTER_PLANE_INVADERS * size + py * w + px], 0);
+
+    InvaderGrid* g = &model.invaders;
+    int row = g->bottom_row, col = __builtin_ctz(g->row_mask[row]);
+    Rect ir = invader_grid_rect(g, &g->invaders[row][col]);
+    int ix = (int)((ir.x + ir.width / 2) * sx);
+    int iy = (int)((ir.y + ir.height / 2) * sy);
+    uint8_t* invaders = image + RASTER_PLANE_INVADERS * size;
+    TEST_ASSERT_EQ(invaders[iy * w + ix], 255);
+    g->row_mask[row] &= (uint16_t)~(1u << col);
+    TEST_ASSERT(raster_draw(&model, w, h, RASTER_MULTI_PLANE, image));
+    TEST_ASSERT_EQ(invaders[iy * w + ix], 0);
+
+    // env_render lays the environments out one after the other
+    static uint8_t batch[TEST_ENVS * RASTER_PLANES * 84 * 84];
+    SiEnv* env = env_create(TEST_ENVS, 42);
+    TEST_ASSERT(env != NULL);
+    TEST_ASSERT(!env_render(env, 84, 0, 0, batch));
+    TEST_ASSERT(env_render(env, 84, 84, 0, batch));
+    TEST_ASSERT(env_render(env, 84, 84, 1, batch + sizeof(batch) / 2));
+    size_t planes = raster_image_size(84, 84, RASTER_MULTI_PLANE);
+    for (int i = 0; i < TEST_ENVS; i++) {
+        const uint8_t* players = batch + i * planes;
+        int lit = 0;
+        for (size_t k = 0; k < 84 * 84; k++)
+            lit += players[k] == 255;
+        TEST_ASSERT(lit > 0);
+    }
+    env_destroy(env);
+    return true;
+}
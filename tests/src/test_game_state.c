@@ -49,4 +49,41 @@ bool test_game_state_transitions(void) {
     
     game_context_destroy(context);
     return true;
-}
\ No newline at end of file
+}
+bool test_game_state_fixed_step(void) {
+    GameContext* context = game_context_create();
+    TEST_ASSERT(context != NULL);
+    game_context_set_tick_rate(context, 60);
+    game_context_start_clock(context, 1000);
+
+    // 60 ms of real time = 3 ticks of 16.7 ms, remainder carried over
+    TEST_ASSERT_EQ(game_context_advance(context, 1060), 3);
+    float alpha = game_context_interpolation(context);
+    TEST_ASSERT(alpha > 0.0f && alpha < 1.0f);
+
+    // A frame shorter than a tick runs no tick
+    TEST_ASSERT_EQ(game_context_advance(context, 1061), 0);
+
+    // Long stalls are clamped instead of spiralling
+    int ticks = game_context_advance(context, 11061);
+    TEST_ASSERT(ticks <= (int)(GAME_MAX_FRAME_TIME * 60) + 1);
+
+    // Half a second of held movement covers the same distance at any rate
+    GameModel* model = context->model;
+    model->state = STATE_PLAYING;
+    model->players[0].hitbox.x = GAME_AREA_WIDTH - PLAYER_WIDTH;
+    for (int t = 0; t < 30; t++)
+        model_move_player(model, 0, DIR_LEFT);
+    float moved_60hz = (GAME_AREA_WIDTH - PLAYER_WIDTH) - model->players[0].hitbox.x;
+
+    game_context_set_tick_rate(context, 30);
+    model->players[0].hitbox.x = GAME_AREA_WIDTH - PLAYER_WIDTH;
+    for (int t = 0; t < 15; t++)
+        model_move_player(model, 0, DIR_LEFT);
+    float moved_30hz = (GAME_AREA_WIDTH - PLAYER_WIDTH) - model->players[0].hitbox.x;
+    TEST_ASSERT(moved_60hz > 191.0f && moved_60hz < 193.0f);
+    TEST_ASSERT(moved_30hz > 191.0f && moved_30hz < 193.0f);
+
+    game_context_destroy(context);
+    return true;
+}
@@ -7,12 +7,35 @@ bool test_model_player_movement(void);
 bool test_model_shooting(void);
 bool test_model_collisions(void);
 bool test_model_level_transition(void);
+bool test_model_rng_determinism(void);
+bool test_model_sim_clock(void);
+bool test_model_bullet_pool(void);
+bool test_model_formation_masks(void);
+bool test_model_formation_origin(void);
+bool test_model_events(void);
+bool test_model_snapshot(void);
+bool test_model_state_hash(void);
+bool test_model_delta_codec(void);
 bool test_controller_creation(void);
 bool test_controller_commands(void);
 bool test_input_handler_creation(void);
 bool test_input_handler_keybindings(void);
 bool test_game_state_creation(void);
 bool test_game_state_transitions(void);
+bool test_game_state_fixed_step(void);
+bool test_collision_grid_query(void);
+bool test_collision_grid_oversize(void);
+bool test_collision_batch_overlap(void);
+bool test_replay_round_trip(void);
+bool test_replay_rejects_bad_file(void);
+bool test_replay_detects_divergence(void);
+bool test_replay_records_final_hash(void);
+bool test_netplay_loopback_rollback(void);
+bool test_arena_alloc(void);
+bool test_server_session_lifecycle(void);
+bool test_spectate_ring(void);
+bool test_env_batched_step(void);
+bool test_env_raster(void);
 
 // Test suite
 test_case_t model_tests[] = {
@@ -21,6 +44,15 @@ test_case_t model_tests[] = {
     {"model_shooting", test_model_shooting},
     {"model_collisions", test_model_collisions},
     {"model_level_transition", test_model_level_transition},
+    {"model_rng_determinism", test_model_rng_determinism},
+    {"model_sim_clock", test_model_sim_clock},
+    {"model_bullet_pool", test_model_bullet_pool},
+    {"model_formation_masks", test_model_formation_masks},
+    {"model_formation_origin", test_model_formation_origin},
+    {"model_events", test_model_events},
+    {"model_snapshot", test_model_snapshot},
+    {"model_state_hash", test_model_state_hash},
+    {"model_delta_codec", test_model_delta_codec},
 };
 
 test_case_t controller_tests[] = {
@@ -36,6 +68,38 @@ test_case_t input_tests[] = {
 test_case_t game_state_tests[] = {
     {"game_state_creation", test_game_state_creation},
     {"game_state_transitions", test_game_state_transitions},
+    {"game_state_fixed_step", test_game_state_fixed_step},
+};
+
+test_case_t collision_tests[] = {
+    {"collision_grid_query", test_collision_grid_query},
+    {"collision_grid_oversize", test_collision_grid_oversize},
+    {"collision_batch_overlap", test_collision_batch_overlap},
+};
+
+test_case_t replay_tests[] = {
+    {"replay_round_trip", test_replay_round_trip},
+    {"replay_rejects_bad_file", test_replay_rejects_bad_file},
+    {"replay_detects_divergence", test_replay_detects_divergence},
+    {"replay_records_final_hash", test_replay_records_final_hash},
+};
+
+test_case_t netplay_tests[] = {
+    {"netplay_loopback_rollback", test_netplay_loopback_rollback},
+};
+
+test_case_t server_tests[] = {
+    {"arena_alloc", test_arena_alloc},
+    {"server_session_lifecycle", test_server_session_lifecycle},
+};
+
+test_case_t spectate_tests[] = {
+    {"spectate_ring", test_spectate_ring},
+};
+
+test_case_t env_tests[] = {
+    {"env_batched_step", test_env_batched_step},
+    {"env_raster", test_env_raster},
 };
 
 int main(void) {
@@ -72,6 +136,48 @@ int main(void) {
     total_failed += state_failed;
     total_passed += sizeof(game_state_tests) / sizeof(test_case_t) - state_failed;
     
+    // Run collision tests
+    printf("\n=== Collision Tests ===\n");
+    int collision_failed = run_test_suite("Collision", collision_tests, 
+                                        sizeof(collision_tests) / sizeof(test_case_t));
+    total_failed += collision_failed;
+    total_passed += sizeof(collision_tests) / sizeof(test_case_t) - collision_failed;
+    
+    // Run replay tests
+    printf("\n=== Replay Tests ===\n");
+    int replay_failed = run_test_suite("Replay", replay_tests, 
+                                     sizeof(replay_tests) / sizeof(test_case_t));
+    total_failed += replay_failed;
+    total_passed += sizeof(replay_tests) / sizeof(test_case_t) - replay_failed;
+    
+    // Run netplay tests
+    printf("\n=== Netplay Tests ===\n");
+    int netplay_failed = run_test_suite("Netplay", netplay_tests, 
+                                      sizeof(netplay_tests) / sizeof(test_case_t));
+    total_failed += netplay_failed;
+    total_passed += sizeof(netplay_tests) / sizeof(test_case_t) - netplay_failed;
+    
+    // Run server tests
+    printf("\n=== Server Tests ===\n");
+    int server_failed = run_test_suite("Server", server_tests, 
+                                     sizeof(server_tests) / sizeof(test_case_t));
+    total_failed += server_failed;
+    total_passed += sizeof(server_tests) / sizeof(test_case_t) - server_failed;
+    
+    // Run spectator tests
+    printf("\n=== Spectate Tests ===\n");
+    int spectate_failed = run_test_suite("Spectate", spectate_tests, 
+                                       sizeof(spectate_tests) / sizeof(test_case_t));
+    total_failed += spectate_failed;
+    total_passed += sizeof(spectate_tests) / sizeof(test_case_t) - spectate_failed;
+    
+    // Run RL environment tests
+    printf("\n=== Env Tests ===\n");
+    int env_failed = run_test_suite("Env", env_tests, 
+                                  sizeof(env_tests) / sizeof(test_case_t));
+    total_failed += env_failed;
+    total_passed += sizeof(env_tests) / sizeof(test_case_t) - env_failed;
+    
     // Summary
     printf("\n=== Test Summary ===\n");
     printf("Total Tests: %d\n", total_passed + total_failed);
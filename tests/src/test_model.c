@@ -1,6 +1,9 @@
 #include "test_utils.h"
 #include "mock_platform.h"
 #include "../core/model.h"
+#include "../core/snapshot.h"
+#include "../core/delta.h"
+#include <math.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -29,19 +32,17 @@ bool test_model_init(void) {
         }
     }
     
-    // Test bullets are not alive (Player 1)
-    for (int i = 0; i < PLAYER_BULLETS; i++) {
-        TEST_ASSERT(model.player_bullets[0][i].alive == false);
-    }
-    
-    // Test bullets are not alive (Player 2)
-    for (int i = 0; i < PLAYER_BULLETS; i++) {
-        TEST_ASSERT(model.player_bullets[1][i].alive == false);
+    // Test bullet pools are empty with default capacity
+    for (int p = 0; p < 2; p++) {
+        TEST_ASSERT_EQ(model.player_bullets[p].live_count, 0);
+        TEST_ASSERT_EQ(model.player_bullets[p].capacity, PLAYER_BULLETS);
+        for (int i = 0; i < PLAYER_BULLETS; i++) {
+            TEST_ASSERT(model.player_bullets[p].items[i].alive == false);
+        }
     }
     
-    for (int i = 0; i < ENEMY_BULLETS; i++) {
-        TEST_ASSERT(model.enemy_bullets[i].alive == false);
-    }
+    TEST_ASSERT_EQ(model.enemy_bullets.live_count, 0);
+    TEST_ASSERT_EQ(model.enemy_bullets.capacity, ENEMY_BULLETS);
     
     return true;
 }
@@ -87,17 +88,12 @@ bool test_model_shooting(void) {
     TEST_ASSERT_EQ(model.players[0].shots_fired, initial_shots + 1);
     
     // Check one bullet is alive
-    bool bullet_found = false;
-    for (int i = 0; i < PLAYER_BULLETS; i++) {
-        if (model.player_bullets[0][i].alive) {
-            bullet_found = true;
-            TEST_ASSERT_EQ(model.player_bullets[0][i].hitbox.x, 
-                          model.players[0].hitbox.x + (PLAYER_WIDTH/2) - (BULLET_WIDTH/2));
-            TEST_ASSERT_EQ(model.player_bullets[0][i].hitbox.y, model.players[0].hitbox.y);
-            break;
-        }
-    }
-    TEST_ASSERT(bullet_found);
+    TEST_ASSERT_EQ(model.player_bullets[0].live_count, 1);
+    Bullet* bullet = bullet_pool_at(&model.player_bullets[0], 0);
+    TEST_ASSERT(bullet->alive);
+    TEST_ASSERT_EQ(bullet->hitbox.x, 
+                  model.players[0].hitbox.x + (PLAYER_WIDTH/2) - (BULLET_WIDTH/2));
+    TEST_ASSERT_EQ(bullet->hitbox.y, model.players[0].hitbox.y);
     
     // Fire all bullets
     for (int i = 0; i < PLAYER_BULLETS; i++) {
@@ -112,9 +108,10 @@ bool test_model_shooting(void) {
     // Only 1 bullet should be alive now (due to 1-bullet limit and cooldown)
     int alive_bullets = 0;
     for (int i = 0; i < PLAYER_BULLETS; i++) {
-        if (model.player_bullets[0][i].alive) alive_bullets++;
+        if (model.player_bullets[0].items[i].alive) alive_bullets++;
     }
     TEST_ASSERT_EQ(alive_bullets, 1);
+    TEST_ASSERT_EQ(model.player_bullets[0].live_count, 1);
     
     return true;
 }
@@ -159,8 +156,417 @@ bool test_model_level_transition(void) {
     
     // Test bullets are cleared
     for (int i = 0; i < PLAYER_BULLETS; i++) {
-        TEST_ASSERT(model.player_bullets[0][i].alive == false);
+        TEST_ASSERT(model.player_bullets[0].items[i].alive == false);
     }
+    TEST_ASSERT_EQ(model.player_bullets[0].live_count, 0);
+    TEST_ASSERT_EQ(model.enemy_bullets.live_count, 0);
     
     return true;
-}
\ No newline at end of file
+}
+
+static void run_seeded_game(GameModel* model, uint64_t seed, int ticks) {
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    config.seed = seed;
+    model_init_with_config(model, &config);
+    model->difficulty = DIFFICULTY_HARD;
+    model_reset_game(model);
+    for (int t = 0; t < ticks && model->state == STATE_PLAYING; t++) {
+        model_player_shoot(model, 0);
+        model_update(model, 1.0f / 60.0f);
+    }
+}
+
+bool test_model_rng_determinism(void) {
+    static GameModel a, b, c;
+    run_seeded_game(&a, 1234, 600);
+    run_seeded_game(&b, 1234, 600);
+    run_seeded_game(&c, 4321, 600);
+
+    // Same seed and inputs: identical random stream and outcome
+    TEST_ASSERT(a.seed == b.seed);
+    TEST_ASSERT(a.rng.state == b.rng.state);
+    TEST_ASSERT_EQ(a.players[0].score, b.players[0].score);
+    TEST_ASSERT_EQ(a.players[0].lives, b.players[0].lives);
+    TEST_ASSERT_EQ(a.enemy_bullets.live_count, b.enemy_bullets.live_count);
+    for (int i = 0; i < ENEMY_BULLETS; i++) {
+        TEST_ASSERT(a.enemy_bullets.items[i].alive == b.enemy_bullets.items[i].alive);
+        TEST_ASSERT(a.enemy_bullets.items[i].hitbox.x == b.enemy_bullets.items[i].hitbox.x);
+    }
+
+    // A different seed gives a different stream
+    TEST_ASSERT(a.seed != c.seed);
+    TEST_ASSERT(a.rng.state != c.rng.state);
+    return true;
+}
+
+bool test_model_sim_clock(void) {
+    GameModel model;
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(&model, &config);
+    model.state = STATE_PLAYING;
+    TEST_ASSERT_EQ(model_get_sim_time(&model), 0);
+
+    // One simulated second, however fast it actually runs
+    for (int t = 0; t < 60; t++)
+        model_update(&model, 1.0f / 60.0f);
+    TEST_ASSERT(model_get_sim_time(&model) >= 999);
+    TEST_ASSERT(model_get_sim_time(&model) <= 1001);
+
+    // Paused time does not count
+    uint32_t before_pause = model_get_sim_time(&model);
+    model.state = STATE_PAUSED;
+    model_update(&model, 1.0f);
+    TEST_ASSERT_EQ(model_get_sim_time(&model), before_pause);
+    model.state = STATE_PLAYING;
+
+    // Combo expires after 2 simulated seconds without a kill
+    model.players[0].combo_count = 3;
+    model.players[0].last_kill_time = model_get_sim_time(&model);
+    model_update(&model, 1.5f);
+    TEST_ASSERT_EQ(model.players[0].combo_count, 3);
+    model_update(&model, 0.6f);
+    TEST_ASSERT_EQ(model.players[0].combo_count, 0);
+    return true;
+}
+
+bool test_model_bullet_pool(void) {
+    static BulletPool pool;
+    bullet_pool_init(&pool, 4);
+    TEST_ASSERT_EQ(pool.capacity, 4);
+
+    // Fill to capacity, then spawning fails
+    Bullet* spawned[4];
+    for (int i = 0; i < 4; i++) {
+        spawned[i] = bullet_pool_spawn(&pool);
+        TEST_ASSERT(spawned[i] != NULL);
+        TEST_ASSERT(spawned[i]->alive);
+    }
+    TEST_ASSERT_EQ(pool.live_count, 4);
+    TEST_ASSERT(bullet_pool_spawn(&pool) == NULL);
+
+    // Releasing from the middle keeps the live list dense
+    bullet_pool_release(&pool, spawned[1]);
+    TEST_ASSERT_EQ(pool.live_count, 3);
+    for (int k = 0; k < pool.live_count; k++) {
+        TEST_ASSERT(bullet_pool_at(&pool, k) != spawned[1]);
+        TEST_ASSERT(bullet_pool_at(&pool, k)->alive);
+    }
+
+    // Double release is ignored, and the freed slot is reused
+    bullet_pool_release(&pool, spawned[1]);
+    TEST_ASSERT_EQ(pool.live_count, 3);
+    TEST_ASSERT(bullet_pool_spawn(&pool) == spawned[1]);
+
+    // Capacity comes from the config, clamped to BULLET_POOL_MAX
+    static GameModel model;
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    config.enemy_bullet_capacity = BULLET_POOL_MAX * 2;
+    config.player_bullet_capacity = 3;
+    model_init_with_config(&model, &config);
+    TEST_ASSERT_EQ(model.enemy_bullets.capacity, BULLET_POOL_MAX);
+    TEST_ASSERT_EQ(model.player_bullets[1].capacity, 3);
+    model_reset_game(&model);
+    TEST_ASSERT_EQ(model.player_bullets[0].capacity, 3);
+    return true;
+}
+
+static void hit_invader(GameModel* model, int row, int col) {
+    Bullet* b = bullet_pool_spawn(&model->player_bullets[0]);
+    b->hitbox = invader_grid_rect(&model->invaders,
+                                  &model->invaders.invaders[row][col]);
+    model_check_bullet_collisions(model);
+}
+
+bool test_model_formation_masks(void) {
+    static GameModel model;
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(&model, &config);
+    model.state = STATE_PLAYING;
+    InvaderGrid* g = &model.invaders;
+
+    TEST_ASSERT_EQ(g->left_col, 0);
+    TEST_ASSERT_EQ(g->right_col, INVADER_COLS - 1);
+    TEST_ASSERT_EQ(g->bottom_row, INVADER_ROWS - 1);
+
+    // A hit invader leaves the live masks right away, while it explodes
+    hit_invader(&model, INVADER_ROWS - 1, 0);
+    TEST_ASSERT(g->invaders[INVADER_ROWS - 1][0].alive);
+    TEST_ASSERT((g->col_mask[0] & (1u << (INVADER_ROWS - 1))) == 0);
+    TEST_ASSERT((g->row_mask[INVADER_ROWS - 1] & 1u) == 0);
+    TEST_ASSERT_EQ(g->left_col, 0);
+
+    // Clearing the first column moves the left extent
+    for (int i = 0; i < INVADER_ROWS - 1; i++)
+        hit_invader(&model, i, 0);
+    TEST_ASSERT_EQ(g->col_mask[0], 0);
+    TEST_ASSERT_EQ(g->left_col, 1);
+
+    // Clearing the bottom row moves the bottom extent
+    for (int j = 1; j < INVADER_COLS; j++)
+        hit_invader(&model, INVADER_ROWS - 1, j);
+    TEST_ASSERT_EQ(g->row_mask[INVADER_ROWS - 1], 0);
+    TEST_ASSERT_EQ(g->bottom_row, INVADER_ROWS - 2);
+    TEST_ASSERT_EQ(g->killed, INVADER_ROWS + INVADER_COLS - 1);
+
+    // Reaching the bottom line is decided by the lowest live row
+    g->origin_y = SCREEN_HEIGHT - 60 - g->invaders[INVADER_ROWS - 2][0].offset.y;
+    model_check_player_invader_collision(&model);
+    TEST_ASSERT_EQ(model.state, STATE_GAME_OVER);
+    return true;
+}
+
+bool test_model_formation_origin(void) {
+    static GameModel model;
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(&model, &config);
+    model.state = STATE_PLAYING;
+    InvaderGrid* g = &model.invaders;
+
+    Rect start = invader_grid_rect(g, &g->invaders[2][3]);
+    Rect fast_start = invader_grid_rect(g, &g->invaders[1][1]);
+    invader_grid_set_speed_modifier(g, 1, 1, 2.0f);
+    TEST_ASSERT(g->custom_speed_mask[1] == (1u << 1));
+
+    // Marching moves the origin only; lattice offsets are untouched
+    float dt = 1.0f / 60.0f;
+    model_update_invaders(&model, dt);
+    float shift = g->speed * dt;
+    Rect moved = invader_grid_rect(g, &g->invaders[2][3]);
+    TEST_ASSERT(moved.x - start.x > shift * 0.99f);
+    TEST_ASSERT(moved.x - start.x < shift * 1.01f);
+    TEST_ASSERT_EQ(g->invaders[2][3].offset.x, start.x);
+
+    // The custom-speed invader drifts at its own speed
+    Rect fast = invader_grid_rect(g, &g->invaders[1][1]);
+    TEST_ASSERT(fast.x - fast_start.x > 2.0f * shift * 0.99f);
+    TEST_ASSERT(fast.x - fast_start.x < 2.0f * shift * 1.01f);
+
+    // Hitting the edge drops the whole formation through the origin
+    g->origin_x = GAME_AREA_WIDTH;
+    float y_before = invader_grid_rect(g, &g->invaders[0][0]).y;
+    model_update_invaders(&model, dt);
+    TEST_ASSERT_EQ(g->direction, DIR_LEFT);
+    TEST_ASSERT_EQ(invader_grid_rect(g, &g->invaders[0][0]).y, y_before + 15);
+    return true;
+}
+
+bool test_model_events(void) {
+    static GameModel model;
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(&model, &config);
+    model.state = STATE_PLAYING;
+    uint32_t cursor = model_event_head(&model);
+
+    model_player_shoot(&model, 0);
+    const GameEvent* e = model_next_event(&model, &cursor);
+    TEST_ASSERT(e != NULL);
+    TEST_ASSERT_EQ(e->type, EVENT_PLAYER_SHOT);
+    TEST_ASSERT_EQ(e->player_id, 0);
+    TEST_ASSERT(model_next_event(&model, &cursor) == NULL);
+
+    // Kills carry the entity, its points and where it died
+    int score = model.players[0].score;
+    Rect target = invader_grid_rect(&model.invaders,
+                                    &model.invaders.invaders[0][2]);
+    hit_invader(&model, 0, 2);
+    e = model_next_event(&model, &cursor);
+    TEST_ASSERT(e != NULL);
+    TEST_ASSERT_EQ(e->type, EVENT_KILL);
+    TEST_ASSERT_EQ(e->entity, ENTITY_INVADER);
+    TEST_ASSERT_EQ(e->value, model.players[0].score - score);
+    TEST_ASSERT_EQ(e->x, target.x + target.width / 2);
+
+    // A consumer that falls behind resumes at the oldest stored event
+    for (int i = 0; i < GAME_EVENT_CAPACITY + 10; i++) {
+        bullet_pool_init(&model.player_bullets[0], PLAYER_BULLETS);
+        model.players[0].shoot_timer = 0;
+        model_player_shoot(&model, 0);
+    }
+    int drained = 0;
+    while (model_next_event(&model, &cursor))
+        drained++;
+    TEST_ASSERT_EQ(drained, GAME_EVENT_CAPACITY);
+    TEST_ASSERT_EQ(cursor, model_event_head(&model));
+
+    // Game over is an event too, and the ring survives a reset
+    model_game_over(&model);
+    model_reset_game(&model);
+    e = model_next_event(&model, &cursor);
+    TEST_ASSERT(e != NULL);
+    TEST_ASSERT_EQ(e->type, EVENT_GAME_OVER);
+
+    // A tick where the last life is shot away as the formation lands ends
+    // the game once
+    model_init_with_config(&model, &config);
+    model.state = STATE_PLAYING;
+    model.players[0].lives = 1;
+    model.players[0].invincibility_timer = 0;
+    Bullet* b = bullet_pool_spawn(&model.enemy_bullets);
+    TEST_ASSERT(b != NULL);
+    b->player_id = -1;
+    b->hitbox = model.players[0].hitbox;
+    b->speed_y = 0;
+    model.invaders.origin_y = SCREEN_HEIGHT;
+    cursor = model_event_head(&model);
+    model_update(&model, 1.0f / 60.0f);
+    TEST_ASSERT_EQ(model.state, STATE_GAME_OVER);
+    TEST_ASSERT_EQ(model.players[0].lives, 0);
+    int game_overs = 0;
+    while ((e = model_next_event(&model, &cursor)))
+        game_overs += e->type == EVENT_GAME_OVER;
+    TEST_ASSERT_EQ(game_overs, 1);
+    return true;
+}
+
+static void play_ticks(GameModel* model, int ticks) {
+    for (int t = 0; t < ticks && model->state == STATE_PLAYING; t++) {
+        model_player_shoot(model, 0);
+        model_update(model, 1.0f / 60.0f);
+    }
+}
+
+bool test_model_snapshot(void) {
+    static GameModel a, b;
+    static uint8_t image[MODEL_SNAPSHOT_MAX_SIZE];
+    static uint8_t after_a[MODEL_SNAPSHOT_MAX_SIZE];
+    static uint8_t after_b[MODEL_SNAPSHOT_MAX_SIZE];
+    run_seeded_game(&a, 99, 300);
+    TEST_ASSERT(a.state == STATE_PLAYING);
+
+    size_t size = model_snapshot(&a, image);
+    TEST_ASSERT(size > 0 && size < sizeof(GameModel) / 4);
+
+    // A restored copy carries on exactly like the original
+    model_init(&b);
+    b.ui.music_volume = 0.3f;
+    TEST_ASSERT(model_restore(&b, image, size));
+    TEST_ASSERT_EQ(b.ui.music_volume, 0.3f);
+    play_ticks(&a, 300);
+    play_ticks(&b, 300);
+    size_t size_a = model_snapshot(&a, after_a);
+    size_t size_b = model_snapshot(&b, after_b);
+    TEST_ASSERT_EQ(size_a, size_b);
+    TEST_ASSERT(memcmp(after_a, after_b, size_a) == 0);
+    TEST_ASSERT_EQ(a.players[0].score, b.players[0].score);
+
+    // Rewinding the original to the first image works the same way
+    TEST_ASSERT(model_restore(&a, image, size));
+    play_ticks(&a, 300);
+    TEST_ASSERT(memcmp(after_a, after_b, model_snapshot(&a, after_a)) == 0);
+
+    // Truncated, resized or corrupted images are refused
+    TEST_ASSERT(!model_restore(&b, image, size - 1));
+    image[4]++; // Version
+    TEST_ASSERT(!model_restore(&b, image, size));
+    image[4]--;
+    memset(image + 12, 0xff, size - 12); // Pool capacities out of range
+    TEST_ASSERT(!model_restore(&b, image, size));
+
+    // So are formation masks that disagree with the invaders, and a refused
+    // image leaves the model as it was
+    uint64_t held = model_state_hash(&b);
+    int bottom_row = a.invaders.bottom_row;
+    a.invaders.bottom_row = INVADER_ROWS;
+    TEST_ASSERT(!model_restore(&b, image, model_snapshot(&a, image)));
+    a.invaders.bottom_row = bottom_row;
+    a.invaders.row_mask[0] |= (uint16_t)(1u << INVADER_COLS);
+    TEST_ASSERT(!model_restore(&b, image, model_snapshot(&a, image)));
+    TEST_ASSERT_EQ(model_state_hash(&b), held);
+    return true;
+}
+
+bool test_model_state_hash(void) {
+    static GameModel a, b;
+    static uint8_t image[MODEL_SNAPSHOT_MAX_SIZE];
+    run_seeded_game(&a, 5, 400);
+    run_seeded_game(&b, 5, 400);
+    uint64_t hash = model_state_hash(&a);
+    TEST_ASSERT_EQ(model_state_hash(&b), hash);
+
+    // UI state is not part of the simulation
+    b.ui.menu_selection = 3;
+    b.ui.music_volume = 7;
+    TEST_ASSERT_EQ(model_state_hash(&b), hash);
+
+    // Any gameplay field changes it, and restoring brings it back
+    size_t size = model_snapshot(&b, image);
+    b.players[0].hitbox.x += 1.0f;
+    TEST_ASSERT_NE(model_state_hash(&b), hash);
+    TEST_ASSERT(model_restore(&b, image, size));
+    b.invaders.invaders[2][4].health++;
+    TEST_ASSERT_NE(model_state_hash(&b), hash);
+    TEST_ASSERT(model_restore(&b, image, size));
+    TEST_ASSERT_EQ(model_state_hash(&b), hash);
+
+    // And it keeps tracking the game tick by tick
+    play_ticks(&a, 1);
+    TEST_ASSERT_NE(model_state_hash(&a), hash);
+    play_ticks(&b, 1);
+    TEST_ASSERT_EQ(model_state_hash(&b), model_state_hash(&a));
+    return true;
+}
+
+bool test_model_delta_codec(void) {
+    static GameModel game, baseline, client;
+    static uint8_t frame[DELTA_FRAME_MAX_SIZE];
+    const float step = 1.0f / DELTA_POSITION_SCALE;
+    run_seeded_game(&game, 21, 1);
+    model_init(&baseline);
+    model_init(&client);
+
+    // The first frame must be a key frame, and brings the client in sync
+    size_t size = delta_encode(&baseline, &game, true, frame);
+    TEST_ASSERT_EQ(frame[0], DELTA_FRAME_KEY);
+    TEST_ASSERT(delta_decode(&client, frame, size));
+    TEST_ASSERT_EQ(model_state_hash(&client), model_state_hash(&baseline));
+
+    // Then small deltas keep both copies identical, close to the real game
+    size_t delta_bytes = 0;
+    int deltas = 0;
+    for (int t = 0; t < 400 && game.state == STATE_PLAYING; t++) {
+        play_ticks(&game, 1);
+        size = delta_encode(&baseline, &game, false, frame);
+        TEST_ASSERT(delta_decode(&client, frame, size));
+        TEST_ASSERT_EQ(model_state_hash(&client), model_state_hash(&baseline));
+        if (frame[0] == DELTA_FRAME_DELTA) {
+            delta_bytes += size;
+            deltas++;
+        }
+        TEST_ASSERT(fabsf(client.players[0].hitbox.x -
+                          game.players[0].hitbox.x) <= step);
+        TEST_ASSERT_EQ(client.players[0].score, game.players[0].score);
+        TEST_ASSERT_EQ(client.player_bullets[0].live_count,
+                       game.player_bullets[0].live_count);
+        TEST_ASSERT_EQ(client.enemy_bullets.live_count,
+                       game.enemy_bullets.live_count);
+        TEST_ASSERT(memcmp(client.invaders.row_mask, game.invaders.row_mask,
+                           sizeof(game.invaders.row_mask)) == 0);
+    }
+    TEST_ASSERT(deltas > 100);
+    TEST_ASSERT(delta_bytes / deltas < model_snapshot(&game, frame) / 20);
+
+    // A new game cannot be a delta
+    model_reset_game(&game);
+    size = delta_encode(&baseline, &game, false, frame);
+    TEST_ASSERT_EQ(frame[0], DELTA_FRAME_KEY);
+    TEST_ASSERT(delta_decode(&client, frame, size));
+
+    // Truncated, padded or unknown frames are refused and change nothing
+    uint64_t held = model_state_hash(&client);
+    play_ticks(&game, 1);
+    size = delta_encode(&baseline, &game, false, frame);
+    TEST_ASSERT_EQ(frame[0], DELTA_FRAME_DELTA);
+    TEST_ASSERT(!delta_decode(&client, frame, size + 1));
+    TEST_ASSERT(!delta_decode(&client, frame, size - 1));
+    TEST_ASSERT(!delta_decode(&client, frame, 1));
+    frame[0] = 7;
+    TEST_ASSERT(!delta_decode(&client, frame, size));
+    TEST_ASSERT_EQ(model_state_hash(&client), held);
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "test_utils.h"
+#include "../controller/controller.h"
+#include "../controller/netplay.h"
+#include "../core/snapshot.h"
+#include <string.h>
+
+#define TEST_NETPLAY_TICKS 600
+
+// Each side changes direction often so remote predictions keep missing
+static InputMask netplay_test_input(uint32_t tick, int player) {
+    InputMask mask = INPUT_SHOOT;
+    mask |= ((tick / (7 + 4 * player)) % 2) ? INPUT_RIGHT : INPUT_LEFT;
+    return mask;
+}
+
+static void init_netplay_model(GameModel* model) {
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(model, &config);
+}
+
+static bool netplay_settled(const NetplaySession* a, const NetplaySession* b) {
+    return netplay_confirmed(a) && netplay_confirmed(b) &&
+           a->remote_ack >= a->local_count && b->remote_ack >= b->local_count;
+}
+
+bool test_netplay_loopback_rollback(void) {
+    static GameModel host_model, guest_model;
+    init_netplay_model(&host_model);
+    init_netplay_model(&guest_model);
+    host_model.difficulty = DIFFICULTY_HARD;
+    Controller* host_controller = controller_create(&host_model);
+    Controller* guest_controller = controller_create(&guest_model);
+    TEST_ASSERT(host_controller != NULL && guest_controller != NULL);
+
+    // Lossy link on loopback, no extra latency to keep the test fast
+    NetplayConfig config = {1, 0, 20};
+    static NetplaySession host, guest;
+    TEST_ASSERT(netplay_listen(&host, 0, &config));
+    TEST_ASSERT(netplay_connect(&guest, "127.0.0.1", netplay_local_port(&host),
+                                &config));
+    for (int i = 0; i < 5000 && (host.state != NETPLAY_RUNNING ||
+                                 guest.state != NETPLAY_RUNNING); i++) {
+        netplay_poll(&host, &host_model, host_controller);
+        netplay_poll(&guest, &guest_model, guest_controller);
+        netplay_wait(&host, 1);
+    }
+    TEST_ASSERT(host.state == NETPLAY_RUNNING);
+    TEST_ASSERT(guest.state == NETPLAY_RUNNING);
+
+    // The guest plays the host's game
+    TEST_ASSERT_EQ(guest_model.seed, host_model.seed);
+    TEST_ASSERT(guest_model.difficulty == DIFFICULTY_HARD);
+    TEST_ASSERT(guest_model.two_player_mode);
+
+    for (int i = 0; i < 20000 && (host.tick < TEST_NETPLAY_TICKS ||
+                                  guest.tick < TEST_NETPLAY_TICKS); i++) {
+        bool moved = false;
+        if (host.tick < TEST_NETPLAY_TICKS)
+            moved |= netplay_advance(&host, &host_model, host_controller,
+                                     netplay_test_input(host.tick, 0));
+        if (guest.tick < TEST_NETPLAY_TICKS)
+            moved |= netplay_advance(&guest, &guest_model, guest_controller,
+                                     netplay_test_input(guest.tick, 1));
+        if (!moved)
+            netplay_wait(&host, 1);
+    }
+    TEST_ASSERT_EQ(host.tick, TEST_NETPLAY_TICKS);
+    TEST_ASSERT_EQ(guest.tick, TEST_NETPLAY_TICKS);
+
+    // Once every input is through, both sides hold the same game
+    for (int i = 0; i < 5000 && !netplay_settled(&host, &guest); i++) {
+        netplay_poll(&host, &host_model, host_controller);
+        netplay_poll(&guest, &guest_model, guest_controller);
+        netplay_wait(&guest, 1);
+    }
+    TEST_ASSERT(netplay_settled(&host, &guest));
+    TEST_ASSERT_EQ(model_state_hash(&host_model), model_state_hash(&guest_model));
+    TEST_ASSERT(host.stats.rollbacks + guest.stats.rollbacks > 0);
+    TEST_ASSERT(host.stats.max_rollback <= NETPLAY_MAX_ROLLBACK);
+    TEST_ASSERT(host.stats.hashes_checked > 0);
+    TEST_ASSERT(!host.stats.desynced && !guest.stats.desynced);
+
+    netplay_close(&host);
+    netplay_close(&guest);
+    controller_destroy(host_controller);
+    controller_destroy(guest_controller);
+    return true;
+}
@@ -0,0 +1,206 @@
+#include "test_utils.h"
+#include "../controller/controller.h"
+#include "../controller/replay.h"
+#include "../core/snapshot.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_REPLAY_FILENAME "test_replay.rep"
+
+// Scripted inputs: sweep left and right while shooting, with a pause
+static InputMask scripted_mask(uint32_t tick) {
+    if (tick == 200 || tick == 260)
+        return INPUT_PAUSE;
+    InputMask mask = INPUT_SHOOT;
+    mask |= ((tick / 90) % 2) ? INPUT_RIGHT : INPUT_LEFT;
+    return mask;
+}
+
+static void init_test_model(GameModel* model, uint64_t seed) {
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    config.seed = seed;
+    model_init_with_config(model, &config);
+}
+
+bool test_replay_round_trip(void) {
+    static GameModel recorded, replayed;
+    static uint8_t image_a[MODEL_SNAPSHOT_MAX_SIZE];
+    static uint8_t image_b[MODEL_SNAPSHOT_MAX_SIZE];
+    const float dt = 1.0f / SIM_TICK_RATE;
+
+    // Two games of a session: the first is cut short by a reset
+    init_test_model(&recorded, 77);
+    Controller* controller = controller_create(&recorded);
+    TEST_ASSERT(controller != NULL);
+    ReplayRecorder rec;
+    TEST_ASSERT(replay_recorder_open(&rec, TEST_REPLAY_FILENAME, &recorded));
+    uint32_t ticks = 0;
+    for (int game = 0; game < 2; game++) {
+        recorded.difficulty = game == 0 ? DIFFICULTY_NORMAL : DIFFICULTY_HARD;
+        model_reset_game(&recorded);
+        for (int t = 0; t < 900; t++, ticks++) {
+            InputMask mask = scripted_mask(ticks);
+            replay_recorder_tick(&rec, &recorded, mask);
+            controller_apply_input_mask(controller, mask);
+            model_update(&recorded, dt);
+        }
+    }
+    TEST_ASSERT(replay_recorder_close(&rec));
+    controller_destroy(controller);
+
+    // Playback restarts each game from its recorded seed and ends in the
+    // same state, whatever seed the playing model started from
+    init_test_model(&replayed, MODEL_DEFAULT_SEED);
+    controller = controller_create(&replayed);
+    ReplayPlayer player;
+    TEST_ASSERT(replay_player_open(&player, TEST_REPLAY_FILENAME));
+    replay_player_configure(&player, &replayed);
+    InputMask mask;
+    while (replay_player_next(&player, &replayed, &mask)) {
+        controller_apply_input_mask(controller, mask);
+        model_update(&replayed, dt);
+    }
+    TEST_ASSERT_EQ(player.games, 2);
+    TEST_ASSERT_EQ(player.ticks, (uint64_t)rec.ticks);
+    TEST_ASSERT(player.hashes_checked >= rec.ticks / REPLAY_HASH_INTERVAL);
+    TEST_ASSERT(!player.diverged);
+    replay_player_close(&player);
+    controller_destroy(controller);
+
+    size_t size = model_snapshot(&recorded, image_a);
+    TEST_ASSERT_EQ(model_snapshot(&replayed, image_b), size);
+    TEST_ASSERT(memcmp(image_a, image_b, size) == 0);
+    remove(TEST_REPLAY_FILENAME);
+    return true;
+}
+
+bool test_replay_rejects_bad_file(void) {
+    static const char junk[] = "not a replay at all";
+    ReplayPlayer player;
+    FILE* f = fopen(TEST_REPLAY_FILENAME, "wb");
+    TEST_ASSERT(f != NULL);
+    fwrite(junk, 1, sizeof(junk), f);
+    fclose(f);
+    TEST_ASSERT(!replay_player_open(&player, TEST_REPLAY_FILENAME));
+    remove(TEST_REPLAY_FILENAME);
+    TEST_ASSERT(!replay_player_open(&player, TEST_REPLAY_FILENAME));
+    return true;
+}
+
+bool test_replay_detects_divergence(void) {
+    static GameModel model;
+    const float dt = 1.0f / SIM_TICK_RATE;
+    const uint32_t changed_tick = 300;
+
+    init_test_model(&model, 9);
+    Controller* controller = controller_create(&model);
+    TEST_ASSERT(controller != NULL);
+    ReplayRecorder rec;
+    TEST_ASSERT(replay_recorder_open(&rec, TEST_REPLAY_FILENAME, &model));
+    model_reset_game(&model);
+    for (uint32_t t = 0; t < 600; t++) {
+        InputMask mask = scripted_mask(t);
+        replay_recorder_tick(&rec, &model, mask);
+        controller_apply_input_mask(controller, mask);
+        model_update(&model, dt);
+    }
+    TEST_ASSERT(replay_recorder_close(&rec));
+
+    // One tick played with different inputs shows up at the next check
+    init_test_model(&model, 9);
+    ReplayPlayer player;
+    TEST_ASSERT(replay_player_open(&player, TEST_REPLAY_FILENAME));
+    replay_player_configure(&player, &model);
+    InputMask mask;
+    while (replay_player_next(&player, &model, &mask)) {
+        if (player.ticks == changed_tick + 1)
+            mask ^= INPUT_LEFT | INPUT_RIGHT;
+        controller_apply_input_mask(controller, mask);
+        model_update(&model, dt);
+    }
+    TEST_ASSERT(player.diverged);
+    TEST_ASSERT_EQ(player.diverged_tick,
+                   (uint64_t)(changed_tick / REPLAY_HASH_INTERVAL + 1) *
+                       REPLAY_HASH_INTERVAL);
+    replay_player_close(&player);
+    controller_destroy(controller);
+    remove(TEST_REPLAY_FILENAME);
+    return true;
+}
+
+static bool read_varint(FILE* f, uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        int c = getc(f);
+        if (c == EOF)
+            return false;
+        result |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool test_replay_records_final_hash(void) {
+    static GameModel model;
+    const float dt = 1.0f / SIM_TICK_RATE;
+    uint64_t final_hash[2], final_tick[2];
+
+    // Games cut short as the headless runner does: the next one starts
+    // before the recorder sees the previous one end
+    init_test_model(&model, 31);
+    Controller* controller = controller_create(&model);
+    TEST_ASSERT(controller != NULL);
+    ReplayRecorder rec;
+    TEST_ASSERT(replay_recorder_open(&rec, TEST_REPLAY_FILENAME, &model));
+    for (int game = 0; game < 2; game++) {
+        model_reset_game(&model);
+        for (int t = 0; t < 250 + 100 * game; t++) {
+            InputMask mask = scripted_mask(t);
+            replay_recorder_tick(&rec, &model, mask);
+            controller_apply_input_mask(controller, mask);
+            model_update(&model, dt);
+        }
+        replay_recorder_end_game(&rec, &model);
+        final_hash[game] = model_state_hash(&model);
+        final_tick[game] = rec.ticks;
+    }
+    TEST_ASSERT(replay_recorder_close(&rec));
+    controller_destroy(controller);
+
+    // The record before the next game's start, or the end of the file, is
+    // the hash of the final state
+    FILE* f = fopen(TEST_REPLAY_FILENAME, "rb");
+    TEST_ASSERT(f != NULL);
+    TEST_ASSERT(fseek(f, 12, SEEK_SET) == 0); // Header
+    int game = -1;
+    bool last_is_hash = false;
+    uint64_t key, value, tick = 0, hash = 0;
+    while (read_varint(f, &key) && read_varint(f, &value)) {
+        if ((key & 1u) == 0) {
+            last_is_hash = false;
+        } else if ((key >> 1) == REPLAY_RECORD_STATE_HASH) {
+            TEST_ASSERT(read_varint(f, &tick) && read_varint(f, &hash));
+            last_is_hash = true;
+        } else {
+            if (game >= 0) {
+                TEST_ASSERT(last_is_hash);
+                TEST_ASSERT_EQ(tick, final_tick[game]);
+                TEST_ASSERT_EQ(hash, final_hash[game]);
+            }
+            game++;
+            last_is_hash = false;
+            fseek(f, (long)value, SEEK_CUR);
+        }
+    }
+    fclose(f);
+    TEST_ASSERT_EQ(game, 1);
+    TEST_ASSERT(last_is_hash);
+    TEST_ASSERT_EQ(tick, final_tick[1]);
+    TEST_ASSERT_EQ(hash, final_hash[1]);
+    remove(TEST_REPLAY_FILENAME);
+    return true;
+}
@@ -0,0 +1,155 @@
+#include "test_utils.h"
+#include "../server/arena.h"
+#include "../server/server.h"
+#include "../core/delta.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+bool test_arena_alloc(void) {
+    static uint8_t block[256];
+    Arena arena;
+    // Unaligned block: allocations still come out aligned
+    arena_init(&arena, block + 1, sizeof(block) - 1);
+
+    uint8_t* a = arena_alloc(&arena, 3, 1);
+    uint64_t* b = arena_alloc(&arena, 4 * sizeof(uint64_t), 8);
+    TEST_ASSERT(a != NULL && b != NULL);
+    TEST_ASSERT_EQ((uintptr_t)b % 8, 0);
+    TEST_ASSERT((uint8_t*)b >= a + 3);
+
+    // Full: NULL, and smaller requests still succeed
+    TEST_ASSERT(arena_alloc(&arena, sizeof(block), 1) == NULL);
+    uint8_t* c = arena_calloc(&arena, 16, 16);
+    TEST_ASSERT(c != NULL);
+    TEST_ASSERT_EQ((uintptr_t)c % 16, 0);
+    TEST_ASSERT_EQ(c[0], 0);
+
+    size_t used = arena.used;
+    arena_reset(&arena);
+    TEST_ASSERT_EQ(arena.used, 0);
+    TEST_ASSERT_EQ(arena.high_water, used);
+    TEST_ASSERT(arena_alloc(&arena, 3, 1) == a);
+    return true;
+}
+
+static bool recv_exact(int fd, void* buf, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = recv(fd, (uint8_t*)buf + got, size - got, 0);
+        if (n <= 0)
+            return false;
+        got += (size_t)n;
+    }
+    return true;
+}
+
+// Reads one message; returns its type, payload in `payload`
+static int recv_message(int fd, uint8_t* payload, size_t* size) {
+    uint8_t header[SERVER_FRAME_HEADER];
+    uint32_t length;
+    if (!recv_exact(fd, header, sizeof(header)))
+        return -1;
+    memcpy(&length, header, sizeof(length));
+    if (length < 1 || length > SERVER_FRAME_MAX)
+        return -1;
+    *size = length - 1;
+    if (!recv_exact(fd, payload, *size))
+        return -1;
+    return header[4];
+}
+
+static int connect_client(int port) {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        return -1;
+    struct timeval timeout = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static int server_session_count(GameServer* server) {
+    ServerStats stats;
+    server_stats(server, &stats);
+    return stats.sessions;
+}
+
+bool test_server_session_lifecycle(void) {
+    static GameServer server;
+    static uint8_t payload[SERVER_FRAME_MAX];
+    static GameModel model;
+    ServerConfig config = server_default_config();
+    config.port = 0;
+    config.workers = 2;
+    config.max_sessions = 4;
+    TEST_ASSERT(server_start(&server, &config));
+
+    int fd = connect_client(server_port(&server));
+    TEST_ASSERT(fd >= 0);
+    for (int i = 0; i < 100 && server_session_count(&server) == 0; i++)
+        server_poll(&server, 10);
+    TEST_ASSERT_EQ(server_session_count(&server), 1);
+
+    size_t size = 0;
+    TEST_ASSERT_EQ(recv_message(fd, payload, &size), SERVER_MSG_WELCOME);
+    uint16_t tick_rate;
+    memcpy(&tick_rate, payload + 4, sizeof(tick_rate));
+    TEST_ASSERT_EQ(tick_rate, SIM_TICK_RATE);
+
+    // The client steers its own game
+    uint8_t input[SERVER_INPUT_SIZE];
+    InputMask mask = INPUT_LEFT | INPUT_SHOOT;
+    server_frame_header(input, SERVER_MSG_INPUT, sizeof(mask));
+    memcpy(input + SERVER_FRAME_HEADER, &mask, sizeof(mask));
+    TEST_ASSERT_EQ(send(fd, input, sizeof(input), 0), (ssize_t)sizeof(input));
+    for (int i = 0; i < 100 && server.sessions[0].input != mask; i++)
+        server_poll(&server, 10);
+    TEST_ASSERT_EQ(server.sessions[0].input, mask);
+
+    // One state per tick: a key frame, then deltas against it
+    uint32_t first_tick = 0, tick = 0;
+    model_init(&model);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQ(recv_message(fd, payload, &size), SERVER_MSG_STATE);
+        memcpy(&tick, payload, sizeof(tick));
+        if (i == 0) {
+            first_tick = tick;
+            TEST_ASSERT_EQ(payload[4], DELTA_FRAME_KEY);
+        } else {
+            TEST_ASSERT_EQ(payload[4], DELTA_FRAME_DELTA);
+        }
+        TEST_ASSERT(delta_decode(&model, payload + 4, size - 4));
+    }
+    TEST_ASSERT_EQ(tick, first_tick + 4);
+    TEST_ASSERT(model.state == STATE_PLAYING);
+
+    // Hanging up frees the slot and its arena for the next client
+    close(fd);
+    for (int i = 0; i < 100 && server_session_count(&server) != 0; i++)
+        server_poll(&server, 10);
+    TEST_ASSERT_EQ(server_session_count(&server), 0);
+    TEST_ASSERT_EQ(server.sessions[0].arena.used, 0);
+
+    fd = connect_client(server_port(&server));
+    TEST_ASSERT(fd >= 0);
+    for (int i = 0; i < 100 && server_session_count(&server) == 0; i++)
+        server_poll(&server, 10);
+    TEST_ASSERT_EQ(recv_message(fd, payload, &size), SERVER_MSG_WELCOME);
+    TEST_ASSERT(server.sessions[0].arena.used > 0);
+    TEST_ASSERT_EQ(server.sessions[0].input, 0);
+
+    ServerStats stats;
+    server_stats(&server, &stats);
+    TEST_ASSERT_EQ(stats.accepted, 2);
+    TEST_ASSERT(stats.arena_high_water <= SERVER_SESSION_ARENA_SIZE);
+    close(fd);
+    server_stop(&server);
+    return true;
+}
@@ -0,0 +1,62 @@
+#include "test_utils.h"
+#include "../controller/spectate.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static void init_spectate_model(GameModel* model, uint64_t seed) {
+    ModelConfig config = model_default_config();
+    config.persist_high_score = false;
+    model_init_with_config(model, &config);
+    model_start_game(model, seed);
+}
+
+bool test_spectate_ring(void) {
+    static SpectatePublisher pub;
+    static SpectateViewer viewer;
+    static GameModel game, view;
+    char name[32];
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    init_spectate_model(&game, 31);
+    model_init(&view);
+
+    // Names become paths under /dev/shm: no separators
+    TEST_ASSERT(!spectate_publisher_open(&pub, "a/b"));
+    TEST_ASSERT(!spectate_viewer_open(&viewer, name));
+
+    TEST_ASSERT(spectate_publisher_open(&pub, name));
+    TEST_ASSERT(spectate_viewer_open(&viewer, name));
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_NO_FRAME);
+
+    // The viewer shows the latest tick, even after the ring wrapped
+    for (int t = 1; t <= 3 * SPECTATE_SLOTS + 1; t++) {
+        model_player_shoot(&game, 0);
+        model_update(&game, 1.0f / 60.0f);
+        spectate_publish(&pub, &game, (uint64_t)t);
+    }
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_NEW_FRAME);
+    TEST_ASSERT_EQ(viewer.last_tick, 3 * SPECTATE_SLOTS + 1);
+    TEST_ASSERT_EQ(model_state_hash(&view), model_state_hash(&game));
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_NO_FRAME);
+
+    // A frame caught mid-write is never shown
+    model_update(&game, 1.0f / 60.0f);
+    spectate_publish(&pub, &game, 100);
+    SpectateSlot* slot = &pub.ring->slots[(pub.frames - 1) % SPECTATE_SLOTS];
+    uint64_t seq = slot->seq;
+    slot->seq = seq - 1;
+    uint64_t hash = model_state_hash(&view);
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_NO_FRAME);
+    TEST_ASSERT(viewer.retries > 0);
+    TEST_ASSERT_EQ(model_state_hash(&view), hash);
+    slot->seq = seq;
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_NEW_FRAME);
+    TEST_ASSERT_EQ(viewer.last_tick, 100);
+
+    // Closing tells the viewers, and removes the broadcast
+    spectate_publisher_close(&pub);
+    TEST_ASSERT_EQ(spectate_viewer_poll(&viewer, &view), SPECTATE_ENDED);
+    spectate_viewer_close(&viewer);
+    TEST_ASSERT(!spectate_viewer_open(&viewer, name));
+    return true;
+}